@@ -3,6 +3,7 @@
 
 #include <gdk/gdk.h>
 #include "gdk/gdkinternals.h"
+#include "gdk/gdkprofilerprivate.h"
 
 #define GDK_PRIVATE_CALL(symbol)        (gdk__private__ ()->symbol)
 
@@ -56,6 +57,11 @@ typedef struct {
   gboolean         (* gdk_display_get_debug_updates) (GdkDisplay *display);
   void             (* gdk_display_set_debug_updates) (GdkDisplay *display,
                                                       gboolean    debug_updates);
+
+  gboolean (* gdk_profiler_is_running) (void);
+  void     (* gdk_profiler_end_mark)   (gint64      start,
+                                        const char *name,
+                                        const char *message);
 } GdkPrivateVTable;
 
 GDK_AVAILABLE_IN_ALL
@@ -31,6 +31,7 @@
 #include "gdkintl.h"
 
 #include "gdk-private.h"
+#include "gdkprofilerprivate.h"
 
 #ifndef HAVE_XCONVERTCASE
 #include "gdkkeysyms.h"
@@ -268,6 +269,7 @@ gdk_pre_parse (void)
 {
   const char *rendering_mode;
   const gchar *gl_string;
+  const gchar *trace_filename;
 
   gdk_initialized = TRUE;
 
@@ -294,6 +296,10 @@ gdk_pre_parse (void)
                                           (GDebugKey *) gdk_gl_keys,
                                           G_N_ELEMENTS (gdk_gl_keys));
 
+  trace_filename = g_getenv ("GDK_TRACE");
+  if (trace_filename != NULL && trace_filename[0] != '\0')
+    gdk_profiler_start (trace_filename);
+
   if (getenv ("GDK_NATIVE_WINDOWS"))
     {
       g_warning ("The GDK_NATIVE_WINDOWS environment variable is not supported in GTK3.\n"
@@ -27,6 +27,7 @@
 #include "gdkinternals.h"
 #include "gdkframeclockprivate.h"
 #include "gdkframeclockidle.h"
+#include "gdkprofilerprivate.h"
 #include "gdk.h"
 
 #ifdef G_OS_WIN32
@@ -298,6 +299,7 @@ gdk_frame_clock_flush_idle (void *data)
   GdkFrameClock *clock = GDK_FRAME_CLOCK (data);
   GdkFrameClockIdle *clock_idle = GDK_FRAME_CLOCK_IDLE (clock);
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 before;
 
   priv->flush_idle_id = 0;
 
@@ -307,7 +309,9 @@ gdk_frame_clock_flush_idle (void *data)
   priv->phase = GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
 
+  before = GDK_PROFILER_CURRENT_TIME;
   g_signal_emit_by_name (G_OBJECT (clock), "flush-events");
+  gdk_profiler_end_mark (before, "flush-events", NULL);
 
   if ((priv->requested & ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS) != 0 ||
       priv->updating_count > 0)
@@ -326,6 +330,9 @@ gdk_frame_clock_paint_idle (void *data)
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
   gboolean skip_to_resume_events;
   GdkFrameTimings *timings = NULL;
+  gint64 frame_start, before;
+
+  frame_start = GDK_PROFILER_CURRENT_TIME;
 
   priv->paint_idle_id = 0;
   priv->in_paint_idle = TRUE;
@@ -366,7 +373,9 @@ gdk_frame_clock_paint_idle (void *data)
                * in them.
                */
               priv->requested &= ~GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
+              before = GDK_PROFILER_CURRENT_TIME;
               g_signal_emit_by_name (G_OBJECT (clock), "before-paint");
+              gdk_profiler_end_mark (before, "before-paint", NULL);
               priv->phase = GDK_FRAME_CLOCK_PHASE_UPDATE;
             }
           /* fallthrough */
@@ -377,7 +386,9 @@ gdk_frame_clock_paint_idle (void *data)
                   priv->updating_count > 0)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_UPDATE;
+                  before = GDK_PROFILER_CURRENT_TIME;
                   g_signal_emit_by_name (G_OBJECT (clock), "update");
+                  gdk_profiler_end_mark (before, "update", NULL);
                 }
             }
           /* fallthrough */
@@ -405,7 +416,9 @@ gdk_frame_clock_paint_idle (void *data)
 		     priv->freeze_count == 0 && iter++ < 4)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_LAYOUT;
+                  before = GDK_PROFILER_CURRENT_TIME;
                   g_signal_emit_by_name (G_OBJECT (clock), "layout");
+                  gdk_profiler_end_mark (before, "layout", NULL);
                 }
 	      if (iter == 5)
 		g_warning ("gdk-frame-clock: layout continuously requested, giving up after 4 tries");
@@ -427,7 +440,9 @@ gdk_frame_clock_paint_idle (void *data)
               if (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_PAINT;
+                  before = GDK_PROFILER_CURRENT_TIME;
                   g_signal_emit_by_name (G_OBJECT (clock), "paint");
+                  gdk_profiler_end_mark (before, "paint", NULL);
                 }
             }
           /* fallthrough */
@@ -435,7 +450,9 @@ gdk_frame_clock_paint_idle (void *data)
           if (priv->freeze_count == 0)
             {
               priv->requested &= ~GDK_FRAME_CLOCK_PHASE_AFTER_PAINT;
+              before = GDK_PROFILER_CURRENT_TIME;
               g_signal_emit_by_name (G_OBJECT (clock), "after-paint");
+              gdk_profiler_end_mark (before, "after-paint", NULL);
               /* the ::after-paint phase doesn't get repeated on freeze/thaw,
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
@@ -462,7 +479,18 @@ gdk_frame_clock_paint_idle (void *data)
   if (priv->requested & GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS)
     {
       priv->requested &= ~GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS;
+      before = GDK_PROFILER_CURRENT_TIME;
       g_signal_emit_by_name (G_OBJECT (clock), "resume-events");
+      gdk_profiler_end_mark (before, "resume-events", NULL);
+    }
+
+  if (frame_start != 0 && timings != NULL)
+    {
+      gchar *message;
+
+      message = g_strdup_printf ("%" G_GINT64_FORMAT, timings->frame_counter);
+      gdk_profiler_end_mark (frame_start, "frame", message);
+      g_free (message);
     }
 
   if (priv->freeze_count == 0)
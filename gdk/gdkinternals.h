@@ -231,6 +231,8 @@ struct _GdkWindow
     gboolean use_gl;
   } current_paint;
   GdkGLContext *gl_paint_context;
+  /* Set if creating gl_paint_context failed, so we don't retry on every paint */
+  GError *gl_paint_context_error;
 
   cairo_region_t *update_area;
   guint update_freeze_count;
@@ -0,0 +1,272 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * gdkprofiler.c: lightweight frame profiling marks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The profiler keeps the most recent marks in a fixed size ring
+ * buffer, so that it can be left enabled in long running processes
+ * without growing. Each mark is a (start, duration, name, message)
+ * tuple; marks that are recorded inside other marks show up nested
+ * when the trace is loaded, since they share the same thread and
+ * their time spans are contained in the outer one.
+ *
+ * Setting GDK_TRACE=filename in the environment starts the profiler
+ * at initialization time and writes the trace, in the Chrome trace
+ * event JSON format, to that file when the process exits.
+ */
+
+#include "config.h"
+
+#include "gdkprofilerprivate.h"
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+#include <process.h>
+#endif
+
+#define GDK_PROFILER_N_MARKS 16384
+
+typedef struct {
+  gint64 start;
+  gint64 duration;
+  const char *name;
+  char *message;
+} GdkProfilerMark;
+
+gboolean _gdk_profiler_running = FALSE;
+
+static GdkProfilerMark *marks;
+static guint n_marks;
+static guint next_mark;
+static char *trace_filename;
+static gboolean exit_handler_installed;
+
+G_LOCK_DEFINE_STATIC (profiler);
+
+static void
+gdk_profiler_exit_handler (void)
+{
+  gdk_profiler_stop ();
+}
+
+void
+gdk_profiler_start (const char *filename)
+{
+  G_LOCK (profiler);
+
+  if (!_gdk_profiler_running)
+    {
+      marks = g_new0 (GdkProfilerMark, GDK_PROFILER_N_MARKS);
+      n_marks = 0;
+      next_mark = 0;
+
+      g_free (trace_filename);
+      trace_filename = g_strdup (filename);
+
+      _gdk_profiler_running = TRUE;
+    }
+
+  G_UNLOCK (profiler);
+
+  if (filename != NULL && !exit_handler_installed)
+    {
+      exit_handler_installed = TRUE;
+      atexit (gdk_profiler_exit_handler);
+    }
+}
+
+static void
+gdk_profiler_clear_marks (void)
+{
+  guint i;
+
+  for (i = 0; i < n_marks; i++)
+    g_free (marks[i].message);
+
+  g_free (marks);
+  marks = NULL;
+  n_marks = 0;
+  next_mark = 0;
+}
+
+void
+gdk_profiler_stop (void)
+{
+  GError *error = NULL;
+
+  if (!_gdk_profiler_running)
+    return;
+
+  if (trace_filename != NULL &&
+      !gdk_profiler_dump (trace_filename, &error))
+    {
+      g_warning ("Failed to write trace to %s: %s", trace_filename, error->message);
+      g_error_free (error);
+    }
+
+  G_LOCK (profiler);
+
+  _gdk_profiler_running = FALSE;
+  gdk_profiler_clear_marks ();
+  g_clear_pointer (&trace_filename, g_free);
+
+  G_UNLOCK (profiler);
+}
+
+gboolean
+gdk_profiler_is_running (void)
+{
+  return _gdk_profiler_running;
+}
+
+void
+gdk_profiler_add_mark (gint64      start,
+                       gint64      duration,
+                       const char *name,
+                       const char *message)
+{
+  GdkProfilerMark *mark;
+
+  if (!_gdk_profiler_running)
+    return;
+
+  G_LOCK (profiler);
+
+  if (marks != NULL)
+    {
+      mark = &marks[next_mark];
+
+      if (n_marks == GDK_PROFILER_N_MARKS)
+        g_free (mark->message);
+      else
+        n_marks++;
+
+      mark->start = start;
+      mark->duration = duration;
+      mark->name = g_intern_string (name);
+      mark->message = g_strdup (message);
+
+      next_mark = (next_mark + 1) % GDK_PROFILER_N_MARKS;
+    }
+
+  G_UNLOCK (profiler);
+}
+
+/* Records a mark spanning from @start to now; @start is expected to
+ * come from GDK_PROFILER_CURRENT_TIME, and a 0 value means that the
+ * profiler was not running when the measured section was entered.
+ */
+void
+gdk_profiler_end_mark (gint64      start,
+                       const char *name,
+                       const char *message)
+{
+  if (start == 0 || !_gdk_profiler_running)
+    return;
+
+  gdk_profiler_add_mark (start, g_get_monotonic_time () - start, name, message);
+}
+
+static void
+append_escaped (GString    *string,
+                const char *text)
+{
+  const char *p;
+
+  for (p = text; *p; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (string, "\\\"");
+          break;
+        case '\\':
+          g_string_append (string, "\\\\");
+          break;
+        case '\n':
+          g_string_append (string, "\\n");
+          break;
+        case '\t':
+          g_string_append (string, "\\t");
+          break;
+        default:
+          if ((guchar) *p < 0x20)
+            g_string_append_printf (string, "\\u%04x", (guint) *p);
+          else
+            g_string_append_c (string, *p);
+        }
+    }
+}
+
+/**
+ * gdk_profiler_dump:
+ * @filename: the file to write to
+ * @error: return location for an error
+ *
+ * Writes the marks currently held in the ring buffer, oldest first,
+ * as a Chrome trace event JSON file. The buffer is not cleared.
+ *
+ * Returns: %TRUE if the file was written
+ */
+gboolean
+gdk_profiler_dump (const char  *filename,
+                   GError     **error)
+{
+  GString *string;
+  gboolean result;
+  guint pid;
+  guint first, i;
+
+  string = g_string_new ("{\"traceEvents\":[\n");
+  pid = (guint) getpid ();
+
+  G_LOCK (profiler);
+
+  first = n_marks == GDK_PROFILER_N_MARKS ? next_mark : 0;
+  for (i = 0; i < n_marks; i++)
+    {
+      GdkProfilerMark *mark = &marks[(first + i) % GDK_PROFILER_N_MARKS];
+
+      g_string_append (string, "{\"cat\":\"gdk\",\"ph\":\"X\",\"name\":\"");
+      append_escaped (string, mark->name);
+      g_string_append_printf (string,
+                              "\",\"pid\":%u,\"tid\":%u,"
+                              "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+                              pid, pid, mark->start, mark->duration);
+      if (mark->message)
+        {
+          g_string_append (string, ",\"args\":{\"message\":\"");
+          append_escaped (string, mark->message);
+          g_string_append (string, "\"}");
+        }
+      g_string_append (string, i + 1 < n_marks ? "},\n" : "}\n");
+    }
+
+  G_UNLOCK (profiler);
+
+  g_string_append (string, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  result = g_file_set_contents (filename, string->str, string->len, error);
+
+  g_string_free (string, TRUE);
+
+  return result;
+}
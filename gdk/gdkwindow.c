@@ -43,6 +43,7 @@
 #include "gdk-private.h"
 
 #include <math.h>
+#include <string.h>
 
 #include <epoxy/gl.h>
 
@@ -142,6 +143,16 @@
 /* This adds a local value to the GdkVisibilityState enum */
 #define GDK_VISIBILITY_NOT_VIEWABLE 3
 
+/* Update areas that fragment into more rectangles than this are
+ * candidates for being collapsed into their bounding box, see
+ * coalesce_update_area().
+ */
+#define UPDATE_AREA_MAX_RECTANGLES 32
+/* Above this many rectangles the update area is always collapsed */
+#define UPDATE_AREA_HARD_MAX_RECTANGLES 256
+/* Estimated fixed cost of painting one more rectangle, in pixels */
+#define UPDATE_AREA_RECTANGLE_COST 2048
+
 enum {
   PICK_EMBEDDED_CHILD, /* only called if children are embedded */
   TO_EMBEDDER,
@@ -157,6 +168,32 @@ enum {
 
 /* Global info */
 
+#ifdef G_ENABLE_DEBUG
+static struct {
+  guint n_coalesced;
+  guint n_rectangles_saved;
+  guint64 overpainted_area;
+  guint n_children_culled;
+} update_stats;
+#endif
+
+static guint64
+region_area (const cairo_region_t *region)
+{
+  cairo_rectangle_int_t r;
+  guint64 area = 0;
+  int i, n;
+
+  n = cairo_region_num_rectangles (region);
+  for (i = 0; i < n; i++)
+    {
+      cairo_region_get_rectangle (region, i, &r);
+      area += (guint64) r.width * r.height;
+    }
+
+  return area;
+}
+
 static void gdk_window_finalize   (GObject              *object);
 
 static void gdk_window_set_property (GObject      *object,
@@ -1426,7 +1463,15 @@ gdk_window_new (GdkWindow     *parent,
 
       if (gdk_window_get_paint_gl_context (window, &error) == NULL)
         {
-          g_warning ("Unable to force GL enabled: %s\n", error->message);
+          static gboolean warned = FALSE;
+
+          /* Keep compositing in software; this is what we do for
+           * every window anyway when GL isn't forced on.
+           */
+          if (!warned)
+            g_warning ("Unable to force GL enabled, falling back to software compositing: %s",
+                       error->message);
+          warned = TRUE;
           g_error_free (error);
         }
     }
@@ -1996,6 +2041,7 @@ _gdk_window_destroy_hierarchy (GdkWindow *window,
               g_object_unref (window->gl_paint_context);
               window->gl_paint_context = NULL;
             }
+          g_clear_error (&window->gl_paint_context_error);
 
           if (window->frame_clock)
             {
@@ -2734,25 +2780,54 @@ gdk_window_get_paint_gl_context (GdkWindow *window, GError **error)
       return NULL;
     }
 
+  /* Creating a context can be expensive even when it fails, e.g. on
+   * hosts without a GPU, so remember the failure and let callers use
+   * the cairo compositing path instead.
+   */
+  if (window->impl_window->gl_paint_context_error != NULL)
+    {
+      if (error)
+        *error = g_error_copy (window->impl_window->gl_paint_context_error);
+      return NULL;
+    }
+
   if (window->impl_window->gl_paint_context == NULL)
     {
+      GError *internal_error = NULL;
+
       window->impl_window->gl_paint_context =
         GDK_WINDOW_IMPL_GET_CLASS (window->impl)->create_gl_context (window,
                                                                      TRUE,
                                                                      GDK_GL_PROFILE_3_2_CORE,
                                                                      NULL,
-                                                                     error);
+                                                                     &internal_error);
       if (window->impl_window->gl_paint_context == NULL &&
-          g_error_matches (*error, GDK_GL_ERROR,
+          g_error_matches (internal_error, GDK_GL_ERROR,
                            GDK_GL_ERROR_UNSUPPORTED_PROFILE))
         {
-          g_clear_error (error);
+          g_clear_error (&internal_error);
           window->impl_window->gl_paint_context =
             GDK_WINDOW_IMPL_GET_CLASS (window->impl)->create_gl_context (window,
                                                                          TRUE,
                                                                          GDK_GL_PROFILE_DEFAULT,
                                                                          NULL,
-                                                                         error);
+                                                                         &internal_error);
+        }
+
+      if (window->impl_window->gl_paint_context == NULL)
+        {
+          if (internal_error == NULL)
+            internal_error = g_error_new_literal (GDK_GL_ERROR,
+                                                  GDK_GL_ERROR_NOT_AVAILABLE,
+                                                  _("No GL implementation is available"));
+
+          GDK_NOTE (OPENGL,
+                    g_message ("Using software compositing for window %p: %s",
+                               window->impl_window, internal_error->message));
+
+          window->impl_window->gl_paint_context_error = internal_error;
+          if (error)
+            *error = g_error_copy (internal_error);
         }
     }
 
@@ -3051,6 +3126,7 @@ gdk_window_end_paint (GdkWindow *window)
   GdkWindowImplClass *impl_class;
   GdkRectangle clip_box = { 0, };
   cairo_t *cr;
+  gint64 before;
 
   g_return_if_fail (GDK_IS_WINDOW (window));
 
@@ -3064,6 +3140,8 @@ gdk_window_end_paint (GdkWindow *window)
       return;
     }
 
+  before = GDK_PROFILER_CURRENT_TIME;
+
   impl_class = GDK_WINDOW_IMPL_GET_CLASS (window->impl);
 
   if (impl_class->end_paint)
@@ -3144,6 +3222,8 @@ gdk_window_end_paint (GdkWindow *window)
 	  break;
 	}
     }
+
+  gdk_profiler_end_mark (before, "end paint", NULL);
 }
 
 /**
@@ -3639,6 +3719,21 @@ gdk_window_process_updates_internal (GdkWindow *window)
       window->active_update_area = window->update_area;
       window->update_area = NULL;
 
+#ifdef G_ENABLE_DEBUG
+      GDK_NOTE (DRAW,
+                g_message ("update area of %p: %d rectangles, %" G_GUINT64_FORMAT " pixels; "
+                           "coalesced %u times saving %u rectangles, overpainted %" G_GUINT64_FORMAT " pixels; "
+                           "%u child windows culled",
+                           window,
+                           cairo_region_num_rectangles (window->active_update_area),
+                           region_area (window->active_update_area),
+                           update_stats.n_coalesced,
+                           update_stats.n_rectangles_saved,
+                           update_stats.overpainted_area,
+                           update_stats.n_children_culled);
+                memset (&update_stats, 0, sizeof (update_stats)));
+#endif
+
       if (gdk_window_is_viewable (window))
 	{
 	  cairo_region_t *expose_region;
@@ -4000,12 +4095,51 @@ draw_ugly_color (GdkWindow       *window,
   cairo_destroy (cr);
 }
 
+/* Widgets that queue many small redraws per frame can leave the
+ * update area fragmented into thousands of tiny rectangles, which
+ * makes every further union and intersection, and eventually the
+ * repaint itself, expensive. Once the rectangle count gets large we
+ * replace the area with its bounding box if the extra pixels that
+ * would be painted cost less than the per-rectangle overhead, or
+ * unconditionally when the count gets out of hand.
+ */
+static void
+coalesce_update_area (cairo_region_t *region)
+{
+  cairo_rectangle_int_t extents;
+  guint64 area, extents_area;
+  int n_rects;
+
+  n_rects = cairo_region_num_rectangles (region);
+  if (n_rects <= UPDATE_AREA_MAX_RECTANGLES)
+    return;
+
+  cairo_region_get_extents (region, &extents);
+  extents_area = (guint64) extents.width * extents.height;
+  area = region_area (region);
+
+  if (n_rects <= UPDATE_AREA_HARD_MAX_RECTANGLES &&
+      extents_area > area + (guint64) n_rects * UPDATE_AREA_RECTANGLE_COST)
+    return;
+
+  cairo_region_union_rectangle (region, &extents);
+
+#ifdef G_ENABLE_DEBUG
+  update_stats.n_coalesced++;
+  update_stats.n_rectangles_saved += n_rects - 1;
+  update_stats.overpainted_area += extents_area - area;
+#endif
+}
+
 static void
 impl_window_add_update_area (GdkWindow *impl_window,
 			     cairo_region_t *region)
 {
   if (impl_window->update_area)
-    cairo_region_union (impl_window->update_area, region);
+    {
+      cairo_region_union (impl_window->update_area, region);
+      coalesce_update_area (impl_window->update_area);
+    }
   else
     {
       gdk_window_add_update_window (impl_window);
@@ -4027,6 +4161,7 @@ invalidate_impl_subwindows (GdkWindow            *window,
 			    gpointer              user_data,
 			    int dx, int dy)
 {
+  cairo_rectangle_int_t child_rect;
   GList *tmp_list;
 
   tmp_list = window->children;
@@ -4040,6 +4175,22 @@ invalidate_impl_subwindows (GdkWindow            *window,
 	  !window->viewable)
 	continue;
 
+      /* Children are clipped to their parent, so a child that lies
+       * outside the invalidated area can be skipped together with
+       * its whole subtree without any region arithmetic.
+       */
+      child_rect.x = dx + child->x;
+      child_rect.y = dy + child->y;
+      child_rect.width = child->width;
+      child_rect.height = child->height;
+      if (cairo_region_contains_rectangle (region, &child_rect) == CAIRO_REGION_OVERLAP_OUT)
+        {
+#ifdef G_ENABLE_DEBUG
+          update_stats.n_children_culled++;
+#endif
+          continue;
+        }
+
       if (child_func && (*child_func) ((GdkWindow *)child, user_data))
 	{
 	  if (gdk_window_has_impl (child))
@@ -9473,9 +9624,15 @@ gdk_window_create_similar_surface (GdkWindow *     window,
       }
       break;
     case GDK_RENDERING_MODE_IMAGE:
-      surface = cairo_image_surface_create (content == CAIRO_CONTENT_COLOR ? CAIRO_FORMAT_RGB24 :
-                                            content == CAIRO_CONTENT_ALPHA ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_ARGB32,
-                                            width * sx, height * sy);
+      /* Let the backend hand out the image, so that e.g. cairo-xlib
+       * can back it with a pooled MIT-SHM segment and upload damaged
+       * areas with XShmPutImage() instead of pushing the pixels
+       * through the protocol stream.
+       */
+      surface = cairo_surface_create_similar_image (window_surface,
+                                                    content == CAIRO_CONTENT_COLOR ? CAIRO_FORMAT_RGB24 :
+                                                    content == CAIRO_CONTENT_ALPHA ? CAIRO_FORMAT_A8 : CAIRO_FORMAT_ARGB32,
+                                                    width * sx, height * sy);
       cairo_surface_set_device_scale (surface, sx, sy);
       break;
     case GDK_RENDERING_MODE_SIMILAR:
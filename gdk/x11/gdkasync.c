@@ -756,3 +756,495 @@ _gdk_x11_roundtrip_async (GdkDisplay           *display,
   UnlockDisplay(dpy);
   SyncHandle();
 }
+
+/* Request batches
+ *
+ * A batch collects GetProperty, GetGeometry and TranslateCoordinates
+ * requests, possibly for many different windows, and sends them in
+ * one go, followed by a GetInputFocus request to wait on. The replies
+ * of the real requests are all picked up by an async handler, so the
+ * whole batch costs a single round trip instead of one per request.
+ * Errors, such as BadWindow for windows that went away, are consumed
+ * and only mark the corresponding request as failed.
+ *
+ * Batches only help where several independent replies are needed at
+ * the same point. Most reads in the X11 backend, like gdk_property_get()
+ * or the geometry and mwm hints reads in gdkwindow-x11.c, are single
+ * requests whose reply is needed right away, so they stay synchronous.
+ */
+
+typedef enum {
+  BATCH_GET_PROPERTY,
+  BATCH_GET_GEOMETRY,
+  BATCH_TRANSLATE_COORDINATES
+} BatchRequestType;
+
+typedef struct _BatchRequest BatchRequest;
+
+struct _BatchRequest
+{
+  BatchRequestType type;
+  gulong seq;
+  Window window;
+  gboolean success;
+
+  union {
+    struct {
+      Atom property;
+      Atom type;
+      glong length;
+      Atom actual_type;
+      gint format;
+      gulong nitems;
+      guchar *data;
+    } property;
+    struct {
+      Window root;
+      gint x;
+      gint y;
+      guint width;
+      guint height;
+    } geometry;
+    struct {
+      Window dest_window;
+      gint src_x;
+      gint src_y;
+      gint dest_x;
+      gint dest_y;
+      Window child;
+    } translate;
+  } u;
+};
+
+struct _GdkX11RequestBatch
+{
+  GdkDisplay *display;
+  GArray *requests;
+  guint current_request;
+  gboolean sent;
+};
+
+GdkX11RequestBatch *
+_gdk_x11_request_batch_new (GdkDisplay *display)
+{
+  GdkX11RequestBatch *batch;
+
+  batch = g_new0 (GdkX11RequestBatch, 1);
+  batch->display = display;
+  batch->requests = g_array_new (FALSE, TRUE, sizeof (BatchRequest));
+
+  return batch;
+}
+
+void
+_gdk_x11_request_batch_free (GdkX11RequestBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->requests->len; i++)
+    {
+      BatchRequest *request = &g_array_index (batch->requests, BatchRequest, i);
+
+      if (request->type == BATCH_GET_PROPERTY)
+        g_free (request->u.property.data);
+    }
+
+  g_array_free (batch->requests, TRUE);
+  g_free (batch);
+}
+
+static BatchRequest *
+batch_add_request (GdkX11RequestBatch *batch,
+                   BatchRequestType    type,
+                   Window              window,
+                   guint              *id)
+{
+  BatchRequest *request;
+
+  g_return_val_if_fail (!batch->sent, NULL);
+
+  *id = batch->requests->len;
+  g_array_set_size (batch->requests, batch->requests->len + 1);
+
+  request = &g_array_index (batch->requests, BatchRequest, *id);
+  request->type = type;
+  request->window = window;
+
+  return request;
+}
+
+guint
+_gdk_x11_request_batch_add_get_property (GdkX11RequestBatch *batch,
+                                         Window              window,
+                                         Atom                property,
+                                         Atom                type,
+                                         glong               length)
+{
+  BatchRequest *request;
+  guint id;
+
+  request = batch_add_request (batch, BATCH_GET_PROPERTY, window, &id);
+  request->u.property.property = property;
+  request->u.property.type = type;
+  request->u.property.length = length;
+
+  return id;
+}
+
+guint
+_gdk_x11_request_batch_add_get_geometry (GdkX11RequestBatch *batch,
+                                         Window              window)
+{
+  guint id;
+
+  batch_add_request (batch, BATCH_GET_GEOMETRY, window, &id);
+
+  return id;
+}
+
+guint
+_gdk_x11_request_batch_add_translate_coordinates (GdkX11RequestBatch *batch,
+                                                  Window              src_window,
+                                                  Window              dest_window,
+                                                  gint                src_x,
+                                                  gint                src_y)
+{
+  BatchRequest *request;
+  guint id;
+
+  request = batch_add_request (batch, BATCH_TRANSLATE_COORDINATES, src_window, &id);
+  request->u.translate.dest_window = dest_window;
+  request->u.translate.src_x = src_x;
+  request->u.translate.src_y = src_y;
+
+  return id;
+}
+
+static void
+handle_batch_property_reply (Display      *dpy,
+                             BatchRequest *request,
+                             xReply       *rep,
+                             char         *buf,
+                             int           len)
+{
+  xGetPropertyReply replbuf;
+  xGetPropertyReply *repl;
+  gulong nbytes;
+
+  repl = (xGetPropertyReply *)
+    _XGetAsyncReply (dpy, (char *)&replbuf, rep, buf, len,
+                     (sizeof (xGetPropertyReply) - sizeof (xReply)) >> 2,
+                     False);
+
+  request->u.property.actual_type = repl->propertyType;
+  request->u.property.format = repl->format;
+  request->u.property.nitems = 0;
+
+  if (repl->propertyType == None ||
+      (repl->format != 8 && repl->format != 16 && repl->format != 32))
+    {
+      _XGetAsyncData (dpy, NULL, buf, len, sizeof (xGetPropertyReply),
+                      0, repl->length << 2);
+      request->success = repl->propertyType == None;
+      return;
+    }
+
+  nbytes = (gulong) repl->nItems * (repl->format / 8);
+  if (nbytes > ((gulong) repl->length << 2))
+    {
+      /* Malformed reply, just skip over it */
+      _XGetAsyncData (dpy, NULL, buf, len, sizeof (xGetPropertyReply),
+                      0, repl->length << 2);
+      return;
+    }
+
+  if (repl->format == 32)
+    {
+      CARD32 *raw;
+      gulong *data;
+      gulong i;
+
+      /* Match what XGetWindowProperty() returns: 32 bit items are
+       * stored as longs
+       */
+      raw = g_malloc (nbytes + 1);
+      _XGetAsyncData (dpy, (char *) raw, buf, len, sizeof (xGetPropertyReply),
+                      nbytes, repl->length << 2);
+
+      data = g_new (gulong, repl->nItems + 1);
+      for (i = 0; i < repl->nItems; i++)
+        data[i] = raw[i];
+      data[repl->nItems] = 0;
+      g_free (raw);
+
+      request->u.property.data = (guchar *) data;
+    }
+  else
+    {
+      request->u.property.data = g_malloc (nbytes + 1);
+      _XGetAsyncData (dpy, (char *) request->u.property.data, buf, len,
+                      sizeof (xGetPropertyReply), nbytes, repl->length << 2);
+      request->u.property.data[nbytes] = '\0';
+    }
+
+  request->u.property.nitems = repl->nItems;
+  request->success = TRUE;
+}
+
+static Bool
+request_batch_handler (Display *dpy,
+                       xReply  *rep,
+                       char    *buf,
+                       int      len,
+                       XPointer data)
+{
+  GdkX11RequestBatch *batch = (GdkX11RequestBatch *)data;
+  BatchRequest *request;
+
+  if (batch->current_request >= batch->requests->len)
+    return False;
+
+  request = &g_array_index (batch->requests, BatchRequest, batch->current_request);
+  if (dpy->last_request_read != request->seq)
+    return False;
+
+  batch->current_request++;
+
+  if (rep->generic.type == X_Error)
+    {
+      request->success = FALSE;
+      return True;
+    }
+
+  switch (request->type)
+    {
+    case BATCH_GET_PROPERTY:
+      handle_batch_property_reply (dpy, request, rep, buf, len);
+      break;
+    case BATCH_GET_GEOMETRY:
+      {
+        xGetGeometryReply replbuf;
+        xGetGeometryReply *repl;
+
+        repl = (xGetGeometryReply *)
+          _XGetAsyncReply (dpy, (char *)&replbuf, rep, buf, len,
+                           (sizeof (xGetGeometryReply) - sizeof (xReply)) >> 2,
+                           True);
+
+        request->u.geometry.root = repl->root;
+        request->u.geometry.x = cvtINT16toInt (repl->x);
+        request->u.geometry.y = cvtINT16toInt (repl->y);
+        request->u.geometry.width = repl->width;
+        request->u.geometry.height = repl->height;
+        request->success = TRUE;
+      }
+      break;
+    case BATCH_TRANSLATE_COORDINATES:
+      {
+        xTranslateCoordsReply replbuf;
+        xTranslateCoordsReply *repl;
+
+        repl = (xTranslateCoordsReply *)
+          _XGetAsyncReply (dpy, (char *)&replbuf, rep, buf, len,
+                           (sizeof (xTranslateCoordsReply) - sizeof (xReply)) >> 2,
+                           True);
+
+        request->u.translate.dest_x = cvtINT16toInt (repl->dstX);
+        request->u.translate.dest_y = cvtINT16toInt (repl->dstY);
+        request->u.translate.child = repl->child;
+        /* Coordinates are meaningless across screens */
+        request->success = repl->sameScreen;
+      }
+      break;
+    }
+
+  return True;
+}
+
+/* Sends all requests of @batch and waits for their replies. Returns
+ * %FALSE if the round trip itself failed; the success of the single
+ * requests is reported by the getters.
+ */
+gboolean
+_gdk_x11_request_batch_run (GdkX11RequestBatch *batch)
+{
+  Display *dpy;
+  _XAsyncHandler async;
+  xGetInputFocusReply rep;
+  Status status;
+  guint i;
+
+  g_return_val_if_fail (!batch->sent, FALSE);
+
+  batch->sent = TRUE;
+
+  if (batch->requests->len == 0)
+    return TRUE;
+
+  dpy = GDK_DISPLAY_XDISPLAY (batch->display);
+
+  LockDisplay(dpy);
+
+  async.next = dpy->async_handlers;
+  async.handler = request_batch_handler;
+  async.data = (XPointer) batch;
+  dpy->async_handlers = &async;
+
+  for (i = 0; i < batch->requests->len; i++)
+    {
+      BatchRequest *request = &g_array_index (batch->requests, BatchRequest, i);
+
+      switch (request->type)
+        {
+        case BATCH_GET_PROPERTY:
+          {
+            xGetPropertyReq *prop_req;
+
+            GetReq (GetProperty, prop_req);
+            prop_req->window = request->window;
+            prop_req->property = request->u.property.property;
+            prop_req->type = request->u.property.type;
+            prop_req->delete = False;
+            prop_req->longOffset = 0;
+            prop_req->longLength = request->u.property.length;
+          }
+          break;
+        case BATCH_GET_GEOMETRY:
+          {
+            xResourceReq *resource_req;
+
+            GetResReq (GetGeometry, request->window, resource_req);
+          }
+          break;
+        case BATCH_TRANSLATE_COORDINATES:
+          {
+            xTranslateCoordsReq *translate_req;
+
+            GetReq (TranslateCoords, translate_req);
+            translate_req->srcWid = request->window;
+            translate_req->dstWid = request->u.translate.dest_window;
+            translate_req->srcX = request->u.translate.src_x;
+            translate_req->srcY = request->u.translate.src_y;
+          }
+          break;
+        }
+
+      request->seq = dpy->request;
+    }
+
+  /*
+   * XSync (dpy, 0)
+   */
+  {
+    G_GNUC_UNUSED xReq *req;
+
+    GetEmptyReq(GetInputFocus, req);
+  }
+  status = _XReply (dpy, (xReply *)&rep, 0, xTrue);
+
+  DeqAsyncHandler(dpy, &async);
+  UnlockDisplay(dpy);
+  SyncHandle();
+
+  return status != 0;
+}
+
+static BatchRequest *
+batch_get_result (GdkX11RequestBatch *batch,
+                  guint               id,
+                  BatchRequestType    type)
+{
+  BatchRequest *request;
+
+  g_return_val_if_fail (batch->sent, NULL);
+  g_return_val_if_fail (id < batch->requests->len, NULL);
+
+  request = &g_array_index (batch->requests, BatchRequest, id);
+  g_return_val_if_fail (request->type == type, NULL);
+
+  if (!request->success)
+    return NULL;
+
+  return request;
+}
+
+/* Like XGetWindowProperty(), but the data is owned by the batch and
+ * stays valid until it is freed.
+ */
+gboolean
+_gdk_x11_request_batch_get_property (GdkX11RequestBatch *batch,
+                                     guint               id,
+                                     Atom               *type,
+                                     gint               *format,
+                                     gulong             *nitems,
+                                     guchar            **data)
+{
+  BatchRequest *request;
+
+  request = batch_get_result (batch, id, BATCH_GET_PROPERTY);
+  if (request == NULL)
+    return FALSE;
+
+  if (type)
+    *type = request->u.property.actual_type;
+  if (format)
+    *format = request->u.property.format;
+  if (nitems)
+    *nitems = request->u.property.nitems;
+  if (data)
+    *data = request->u.property.data;
+
+  return TRUE;
+}
+
+gboolean
+_gdk_x11_request_batch_get_geometry (GdkX11RequestBatch *batch,
+                                     guint               id,
+                                     Window             *root,
+                                     gint               *x,
+                                     gint               *y,
+                                     guint              *width,
+                                     guint              *height)
+{
+  BatchRequest *request;
+
+  request = batch_get_result (batch, id, BATCH_GET_GEOMETRY);
+  if (request == NULL)
+    return FALSE;
+
+  if (root)
+    *root = request->u.geometry.root;
+  if (x)
+    *x = request->u.geometry.x;
+  if (y)
+    *y = request->u.geometry.y;
+  if (width)
+    *width = request->u.geometry.width;
+  if (height)
+    *height = request->u.geometry.height;
+
+  return TRUE;
+}
+
+gboolean
+_gdk_x11_request_batch_get_translated_coordinates (GdkX11RequestBatch *batch,
+                                                   guint               id,
+                                                   gint               *dest_x,
+                                                   gint               *dest_y,
+                                                   Window             *child)
+{
+  BatchRequest *request;
+
+  request = batch_get_result (batch, id, BATCH_TRANSLATE_COORDINATES);
+  if (request == NULL)
+    return FALSE;
+
+  if (dest_x)
+    *dest_x = request->u.translate.dest_x;
+  if (dest_y)
+    *dest_y = request->u.translate.dest_y;
+  if (child)
+    *child = request->u.translate.child;
+
+  return TRUE;
+}
@@ -25,6 +25,7 @@
 G_BEGIN_DECLS
 
 typedef struct _GdkChildInfoX11 GdkChildInfoX11;
+typedef struct _GdkX11RequestBatch GdkX11RequestBatch;
 
 typedef void (*GdkSendXEventCallback) (Window   window,
 				       gboolean success,
@@ -64,6 +65,43 @@ void _gdk_x11_roundtrip_async           (GdkDisplay           *display,
 					 GdkRoundTripCallback callback,
 					 gpointer              data);
 
+GdkX11RequestBatch *_gdk_x11_request_batch_new  (GdkDisplay         *display);
+void                _gdk_x11_request_batch_free (GdkX11RequestBatch *batch);
+
+guint    _gdk_x11_request_batch_add_get_property         (GdkX11RequestBatch *batch,
+							   Window              window,
+							   Atom                property,
+							   Atom                type,
+							   glong               length);
+guint    _gdk_x11_request_batch_add_get_geometry         (GdkX11RequestBatch *batch,
+							   Window              window);
+guint    _gdk_x11_request_batch_add_translate_coordinates (GdkX11RequestBatch *batch,
+							   Window              src_window,
+							   Window              dest_window,
+							   gint                src_x,
+							   gint                src_y);
+
+gboolean _gdk_x11_request_batch_run                      (GdkX11RequestBatch *batch);
+
+gboolean _gdk_x11_request_batch_get_property             (GdkX11RequestBatch *batch,
+							   guint               id,
+							   Atom               *type,
+							   gint               *format,
+							   gulong             *nitems,
+							   guchar            **data);
+gboolean _gdk_x11_request_batch_get_geometry             (GdkX11RequestBatch *batch,
+							   guint               id,
+							   Window             *root,
+							   gint               *x,
+							   gint               *y,
+							   guint              *width,
+							   guint              *height);
+gboolean _gdk_x11_request_batch_get_translated_coordinates (GdkX11RequestBatch *batch,
+							     guint               id,
+							     gint               *dest_x,
+							     gint               *dest_y,
+							     Window             *child);
+
 G_END_DECLS
 
 #endif /* __GDK_ASYNC_H__ */
@@ -281,6 +281,18 @@ do_net_wm_state_changes (GdkWindow *window)
   gdk_synthesize_window_state (window, unset, set);
 }
 
+static void
+gdk_update_on_all_desktops (GdkToplevelX11 *toplevel,
+                            Atom            type,
+                            gulong          nitems,
+                            guchar         *data)
+{
+  if (type != None && nitems > 0 && data)
+    toplevel->on_all_desktops = ((*(gulong *)data & 0xFFFFFFFF) == 0xFFFFFFFF);
+  else
+    toplevel->on_all_desktops = FALSE;
+}
+
 static void
 gdk_check_wm_desktop_changed (GdkWindow *window)
 {
@@ -292,9 +304,10 @@ gdk_check_wm_desktop_changed (GdkWindow *window)
   gulong nitems;
   gulong bytes_after;
   guchar *data;
-  gulong *desktop;
 
   type = None;
+  data = NULL;
+  nitems = 0;
   gdk_x11_display_error_trap_push (display);
   XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
                       GDK_WINDOW_XID (window),
@@ -304,14 +317,9 @@ gdk_check_wm_desktop_changed (GdkWindow *window)
                       &bytes_after, &data);
   gdk_x11_display_error_trap_pop_ignored (display);
 
+  gdk_update_on_all_desktops (toplevel, type, nitems, data);
   if (type != None)
-    {
-      desktop = (gulong *)data;
-      toplevel->on_all_desktops = ((*desktop & 0xFFFFFFFF) == 0xFFFFFFFF);
-      XFree (desktop);
-    }
-  else
-    toplevel->on_all_desktops = FALSE;
+    XFree (data);
 
   do_net_wm_state_changes (window);
 }
@@ -323,10 +331,11 @@ gdk_check_wm_state_changed (GdkWindow *window)
   GdkDisplay *display = GDK_WINDOW_DISPLAY (window);
   GdkScreen *screen = GDK_WINDOW_SCREEN (window);
 
+  GdkX11RequestBatch *batch;
+  guint state_req, desktop_req;
   Atom type;
   gint format;
   gulong nitems;
-  gulong bytes_after;
   guchar *data;
   Atom *atoms = NULL;
   gulong i;
@@ -340,15 +349,24 @@ gdk_check_wm_state_changed (GdkWindow *window)
   toplevel->have_focused = FALSE;
   toplevel->have_hidden = FALSE;
 
-  type = None;
-  gdk_x11_display_error_trap_push (display);
-  XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_WINDOW_XID (window),
-		      gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE"),
-		      0, G_MAXLONG, False, XA_ATOM, &type, &format, &nitems,
-		      &bytes_after, &data);
-  gdk_x11_display_error_trap_pop_ignored (display);
+  /* A window that becomes sticky also needs _NET_WM_DESKTOP, so it
+   * is asked for together with _NET_WM_STATE, in the same round trip
+   */
+  batch = _gdk_x11_request_batch_new (display);
+  state_req =
+    _gdk_x11_request_batch_add_get_property (batch, GDK_WINDOW_XID (window),
+                                             gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE"),
+                                             XA_ATOM, G_MAXLONG);
+  desktop_req =
+    _gdk_x11_request_batch_add_get_property (batch, GDK_WINDOW_XID (window),
+                                             gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_DESKTOP"),
+                                             XA_CARDINAL, G_MAXLONG);
+  _gdk_x11_request_batch_run (batch);
 
-  if (type != None)
+  type = None;
+  if (_gdk_x11_request_batch_get_property (batch, state_req,
+                                           &type, &format, &nitems, &data) &&
+      type != None && data)
     {
       Atom sticky_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE_STICKY");
       Atom maxvert_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE_MAXIMIZED_VERT");
@@ -377,8 +395,6 @@ gdk_check_wm_state_changed (GdkWindow *window)
 
           ++i;
         }
-
-      XFree (atoms);
     }
 
   if (!gdk_x11_screen_supports_net_wm_hint (screen,
@@ -389,9 +405,19 @@ gdk_check_wm_state_changed (GdkWindow *window)
    * as well.
    */
   if (toplevel->have_sticky && !had_sticky)
-    gdk_check_wm_desktop_changed (window);
-  else
-    do_net_wm_state_changes (window);
+    {
+      type = None;
+      data = NULL;
+      nitems = 0;
+      _gdk_x11_request_batch_get_property (batch, desktop_req,
+                                           &type, &format, &nitems, &data);
+      gdk_update_on_all_desktops (toplevel, type, nitems, data);
+    }
+
+  /* The property data is owned by the batch */
+  _gdk_x11_request_batch_free (batch);
+
+  do_net_wm_state_changes (window);
 }
 
 static Window
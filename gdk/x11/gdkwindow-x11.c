@@ -3088,7 +3088,6 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
   Window xwindow;
   Window xparent;
   Window root;
-  Window child;
   Window *children;
   guchar *data;
   Window *vroots;
@@ -3096,12 +3095,16 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
   guint nchildren;
   guint nvroots;
   gulong nitems_return;
-  gulong bytes_after_return;
   gint format_return;
   gint i;
   guint ww, wh, wb, wd;
   gint wx, wy;
   gboolean got_frame_extents = FALSE;
+  GdkX11RequestBatch *batch;
+  guint extents_req = G_MAXUINT;
+  guint geometry_req = G_MAXUINT;
+  guint translate_req = G_MAXUINT;
+  guint vroots_req = G_MAXUINT;
 
   g_return_if_fail (rect != NULL);
 
@@ -3132,17 +3135,42 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
   gdk_x11_display_error_trap_push (display);
 
   xwindow = GDK_WINDOW_XID (window);
+  root = GDK_WINDOW_XROOTWIN (window);
+
+  /* Queue everything we may need up front, so that the common case
+   * costs a single round trip: _NET_FRAME_EXTENTS together with the
+   * real client window geometry and, in case the WM doesn't provide
+   * the extents, _NET_VIRTUAL_ROOTS for the fallback below.
+   */
+  batch = _gdk_x11_request_batch_new (display);
 
-  /* first try: use _NET_FRAME_EXTENTS */
   if (gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
-                                           gdk_atom_intern_static_string ("_NET_FRAME_EXTENTS")) &&
-      XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), xwindow,
-                          gdk_x11_get_xatom_by_name_for_display (display,
-                                                                  "_NET_FRAME_EXTENTS"),
-                          0, G_MAXLONG, False, XA_CARDINAL, &type_return,
-                          &format_return, &nitems_return, &bytes_after_return,
-                          &data)
-      == Success)
+                                           gdk_atom_intern_static_string ("_NET_FRAME_EXTENTS")))
+    {
+      extents_req =
+        _gdk_x11_request_batch_add_get_property (batch, xwindow,
+                                                 gdk_x11_get_xatom_by_name_for_display (display,
+                                                                                        "_NET_FRAME_EXTENTS"),
+                                                 XA_CARDINAL, G_MAXLONG);
+      geometry_req = _gdk_x11_request_batch_add_get_geometry (batch, xwindow);
+      translate_req = _gdk_x11_request_batch_add_translate_coordinates (batch, xwindow, root, 0, 0);
+    }
+
+  if (gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
+                                           gdk_atom_intern_static_string ("_NET_VIRTUAL_ROOTS")))
+    vroots_req =
+      _gdk_x11_request_batch_add_get_property (batch, root,
+                                               gdk_x11_get_xatom_by_name_for_display (display,
+                                                                                      "_NET_VIRTUAL_ROOTS"),
+                                               XA_WINDOW, G_MAXLONG);
+
+  _gdk_x11_request_batch_run (batch);
+
+  /* first try: use _NET_FRAME_EXTENTS */
+  if (extents_req != G_MAXUINT &&
+      _gdk_x11_request_batch_get_property (batch, extents_req,
+                                           &type_return, &format_return,
+                                           &nitems_return, &data))
     {
       if ((type_return == XA_CARDINAL) && (format_return == 32) &&
 	  (nitems_return == 4) && (data))
@@ -3151,10 +3179,10 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
 	  got_frame_extents = TRUE;
 
 	  /* try to get the real client window geometry */
-	  if (XGetGeometry (GDK_DISPLAY_XDISPLAY (display), xwindow,
-			    &root, &wx, &wy, &ww, &wh, &wb, &wd) &&
-              XTranslateCoordinates (GDK_DISPLAY_XDISPLAY (display),
-	  			     xwindow, root, 0, 0, &wx, &wy, &child))
+	  if (_gdk_x11_request_batch_get_geometry (batch, geometry_req,
+                                                   NULL, NULL, NULL, &ww, &wh) &&
+              _gdk_x11_request_batch_get_translated_coordinates (batch, translate_req,
+                                                                 &wx, &wy, NULL))
             {
 	      rect->x = wx;
 	      rect->y = wy;
@@ -3168,9 +3196,6 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
 	  rect->width += ldata[0] + ldata[1];
 	  rect->height += ldata[2] + ldata[3];
 	}
-
-      if (data)
-	XFree (data);
     }
 
   if (got_frame_extents)
@@ -3181,17 +3206,10 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
      tree to get our window's parent which hopefully is the window frame */
 
   /* use NETWM_VIRTUAL_ROOTS if available */
-  root = GDK_WINDOW_XROOTWIN (window);
-
-  if (gdk_x11_screen_supports_net_wm_hint (GDK_WINDOW_SCREEN (window),
-                                           gdk_atom_intern_static_string ("_NET_VIRTUAL_ROOTS")) &&
-      XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), root,
-			  gdk_x11_get_xatom_by_name_for_display (display, 
-								 "_NET_VIRTUAL_ROOTS"),
-			  0, G_MAXLONG, False, XA_WINDOW, &type_return,
-			  &format_return, &nitems_return, &bytes_after_return,
-			  &data)
-      == Success)
+  if (vroots_req != G_MAXUINT &&
+      _gdk_x11_request_batch_get_property (batch, vroots_req,
+                                           &type_return, &format_return,
+                                           &nitems_return, &data))
     {
       if ((type_return == XA_WINDOW) && (format_return == 32) && (data))
 	{
@@ -3200,6 +3218,10 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
 	}
     }
 
+  /* Each step of the walk needs the parent found by the previous one,
+   * so this can't be batched. It is only needed with window managers
+   * that don't set _NET_FRAME_EXTENTS.
+   */
   xparent = GDK_WINDOW_XID (window);
 
   do
@@ -3236,8 +3258,8 @@ gdk_x11_window_get_frame_extents (GdkWindow    *window,
     }
 
  out:
-  if (vroots)
-    XFree (vroots);
+  /* vroots is owned by the batch */
+  _gdk_x11_request_batch_free (batch);
 
   rect->x /= impl->window_scale;
   rect->y /= impl->window_scale;
@@ -20,6 +20,7 @@
 #include "gtkcellrenderertext.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "gtkeditable.h"
 #include "gtkentry.h"
@@ -74,6 +75,7 @@ static void       gtk_cell_renderer_text_get_preferred_width            (GtkCell
                                                                          GtkWidget             *widget,
                                                                          gint                  *minimal_size,
                                                                          gint                  *natural_size);
+static void       size_cache_clear                                      (GtkCellRendererText   *celltext);
 static void       gtk_cell_renderer_text_get_preferred_height           (GtkCellRenderer       *cell,
                                                                          GtkWidget             *widget,
                                                                          gint                  *minimal_size,
@@ -202,8 +204,44 @@ struct _GtkCellRendererTextPrivate
   gulong focus_out_id;
   gulong populate_popup_id;
   gulong entry_menu_popdown_timeout;
+
+  /* Measured layout extents, see get_layout_extents() */
+  GHashTable   *size_cache;
+  GQueue        size_cache_lru;
+  PangoContext *size_cache_context;
+  guint         size_cache_serial;
+  gint          size_cache_char_width;
 };
 
+/* Number of measurements to keep around per renderer; a tree view
+ * usually measures the same renderer for every row of a column, so
+ * this is roughly the number of distinct cell contents that can be
+ * revalidated without shaping any text.
+ */
+#define SIZE_CACHE_MAX_ENTRIES 1024
+
+typedef struct
+{
+  /* Key */
+  gchar                *text;
+  PangoFontDescription *font;
+  PangoLanguage        *language;
+  gdouble               font_scale;
+  gint                  rise;
+  gint                  width;
+  guint                 single_paragraph : 1;
+  guint                 underline        : 4;
+  guint                 ellipsize        : 4;
+  guint                 wrap_mode        : 4;
+  guint                 align            : 4;
+  guint                 hash;
+
+  /* Value */
+  PangoRectangle        logical;
+
+  GList                 link;
+} SizeCacheEntry;
+
 G_DEFINE_TYPE_WITH_PRIVATE (GtkCellRendererText, gtk_cell_renderer_text, GTK_TYPE_CELL_RENDERER)
 
 static void
@@ -227,6 +265,7 @@ gtk_cell_renderer_text_init (GtkCellRendererText *celltext)
   priv->wrap_mode = PANGO_WRAP_CHAR;
   priv->align = PANGO_ALIGN_LEFT;
   priv->align_set = FALSE;
+  priv->size_cache_char_width = -1;
 }
 
 static void
@@ -753,6 +792,9 @@ gtk_cell_renderer_text_finalize (GObject *object)
 
   g_clear_object (&priv->entry);
 
+  size_cache_clear (celltext);
+  g_clear_object (&priv->size_cache_context);
+
   G_OBJECT_CLASS (gtk_cell_renderer_text_parent_class)->finalize (object);
 }
 
@@ -2149,6 +2191,201 @@ gtk_cell_renderer_text_set_fixed_height_from_font (GtkCellRendererText *renderer
     }
 }
 
+static guint
+size_cache_entry_hash (gconstpointer data)
+{
+  return ((const SizeCacheEntry *) data)->hash;
+}
+
+static gboolean
+size_cache_entry_equal (gconstpointer a,
+                        gconstpointer b)
+{
+  const SizeCacheEntry *ea = a;
+  const SizeCacheEntry *eb = b;
+
+  return ea->hash == eb->hash &&
+         ea->width == eb->width &&
+         ea->rise == eb->rise &&
+         ea->font_scale == eb->font_scale &&
+         ea->language == eb->language &&
+         ea->single_paragraph == eb->single_paragraph &&
+         ea->underline == eb->underline &&
+         ea->ellipsize == eb->ellipsize &&
+         ea->wrap_mode == eb->wrap_mode &&
+         ea->align == eb->align &&
+         strcmp (ea->text, eb->text) == 0 &&
+         pango_font_description_equal (ea->font, eb->font);
+}
+
+static void
+size_cache_entry_free (gpointer data)
+{
+  SizeCacheEntry *entry = data;
+
+  g_free (entry->text);
+  pango_font_description_free (entry->font);
+  g_slice_free (SizeCacheEntry, entry);
+}
+
+static void
+size_cache_clear (GtkCellRendererText *celltext)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+
+  /* The table owns the entries; the queue only links them */
+  g_queue_init (&priv->size_cache_lru);
+  g_clear_pointer (&priv->size_cache, g_hash_table_unref);
+  priv->size_cache_char_width = -1;
+}
+
+/* Makes sure cached measurements were taken with the Pango context
+ * that @widget is going to use. The context's serial changes whenever
+ * its font, font options, resolution or base direction change, and we
+ * hold a reference on it so that a new context can't show up at the
+ * same address.
+ */
+static void
+size_cache_validate (GtkCellRendererText *celltext,
+                     GtkWidget           *widget)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  PangoContext *context;
+
+  context = gtk_widget_get_pango_context (widget);
+
+  if (context == priv->size_cache_context &&
+      pango_context_get_serial (context) == priv->size_cache_serial)
+    return;
+
+  size_cache_clear (celltext);
+
+  g_clear_object (&priv->size_cache_context);
+  priv->size_cache_context = g_object_ref (context);
+  priv->size_cache_serial = pango_context_get_serial (context);
+}
+
+/* Returns the logical extents of the text laid out at @width, in
+ * Pango units, as get_layout() would produce them without a cell area.
+ * Results are cached by the text and all the properties that affect
+ * its size, with the least recently used entries evicted first, so
+ * that revalidating rows whose content was already seen doesn't need
+ * to create and shape a new layout.
+ *
+ * Renderers with extra attributes, from #GtkCellRendererText:markup or
+ * #GtkCellRendererText:attributes, are always measured directly.
+ */
+static void
+get_layout_extents (GtkCellRendererText *celltext,
+                    GtkWidget           *widget,
+                    gint                 width,
+                    PangoRectangle      *logical)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  SizeCacheEntry key, *entry;
+  PangoLayout *layout;
+  const gchar *text;
+
+  if (priv->extra_attrs)
+    {
+      layout = get_layout (celltext, widget, NULL, 0);
+      pango_layout_set_width (layout, width);
+      pango_layout_get_extents (layout, NULL, logical);
+      g_object_unref (layout);
+      return;
+    }
+
+  size_cache_validate (celltext, widget);
+
+  text = show_placeholder_text (celltext) ? priv->placeholder_text : priv->text;
+
+  key.text = (gchar *) (text ? text : "");
+  key.font = priv->font;
+  key.language = priv->language_set ? priv->language : NULL;
+  key.font_scale = priv->scale_set ? priv->font_scale : 1.0;
+  key.rise = priv->rise_set ? priv->rise : 0;
+  key.width = width;
+  key.single_paragraph = priv->single_paragraph;
+  key.underline = priv->underline_set ? priv->underline_style : PANGO_UNDERLINE_NONE;
+  key.ellipsize = priv->ellipsize_set ? priv->ellipsize : PANGO_ELLIPSIZE_NONE;
+  key.wrap_mode = priv->wrap_width != -1 ? priv->wrap_mode : PANGO_WRAP_CHAR;
+  if (priv->align_set)
+    key.align = priv->align;
+  else
+    key.align = gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL ? PANGO_ALIGN_RIGHT : PANGO_ALIGN_LEFT;
+  key.hash = g_str_hash (key.text) ^
+             pango_font_description_hash (key.font) ^
+             ((guint) width * 31);
+
+  if (priv->size_cache)
+    {
+      entry = g_hash_table_lookup (priv->size_cache, &key);
+      if (entry)
+        {
+          g_queue_unlink (&priv->size_cache_lru, &entry->link);
+          g_queue_push_head_link (&priv->size_cache_lru, &entry->link);
+          *logical = entry->logical;
+          return;
+        }
+    }
+  else
+    priv->size_cache = g_hash_table_new_full (size_cache_entry_hash,
+                                              size_cache_entry_equal,
+                                              NULL,
+                                              size_cache_entry_free);
+
+  layout = get_layout (celltext, widget, NULL, 0);
+  pango_layout_set_width (layout, width);
+  pango_layout_get_extents (layout, NULL, logical);
+  g_object_unref (layout);
+
+  if (priv->size_cache_lru.length >= SIZE_CACHE_MAX_ENTRIES)
+    {
+      GList *last = g_queue_pop_tail_link (&priv->size_cache_lru);
+
+      g_hash_table_remove (priv->size_cache, last->data);
+    }
+
+  entry = g_slice_new (SizeCacheEntry);
+  *entry = key;
+  entry->text = g_strdup (key.text);
+  entry->font = pango_font_description_copy (key.font);
+  entry->logical = *logical;
+  entry->link.data = entry;
+  entry->link.prev = entry->link.next = NULL;
+
+  g_hash_table_add (priv->size_cache, entry);
+  g_queue_push_head_link (&priv->size_cache_lru, &entry->link);
+}
+
+/* The approximate character width only depends on the widget's
+ * context, so it is kept alongside the cached extents.
+ */
+static gint
+get_char_width (GtkCellRendererText *celltext,
+                GtkWidget           *widget)
+{
+  GtkCellRendererTextPrivate *priv = celltext->priv;
+  PangoContext *context;
+  PangoFontMetrics *metrics;
+
+  size_cache_validate (celltext, widget);
+
+  if (priv->size_cache_char_width >= 0)
+    return priv->size_cache_char_width;
+
+  context = gtk_widget_get_pango_context (widget);
+  metrics = pango_context_get_metrics (context,
+                                       pango_context_get_font_description (context),
+                                       pango_context_get_language (context));
+
+  priv->size_cache_char_width = pango_font_metrics_get_approximate_char_width (metrics);
+
+  pango_font_metrics_unref (metrics);
+
+  return priv->size_cache_char_width;
+}
+
 static void
 gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
                                             GtkWidget       *widget,
@@ -2157,9 +2394,6 @@ gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
 {
   GtkCellRendererTextPrivate *priv;
   GtkCellRendererText        *celltext;
-  PangoLayout                *layout;
-  PangoContext               *context;
-  PangoFontMetrics           *metrics;
   PangoRectangle              rect;
   gint char_width, text_width, ellipsize_chars, xpad;
   gint min_width, nat_width;
@@ -2178,23 +2412,12 @@ gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
 
   gtk_cell_renderer_get_padding (cell, &xpad, NULL);
 
-  layout = get_layout (celltext, widget, NULL, 0);
-
   /* Fetch the length of the complete unwrapped text */
-  pango_layout_set_width (layout, -1);
-  pango_layout_get_extents (layout, NULL, &rect);
+  get_layout_extents (celltext, widget, -1, &rect);
   text_width = rect.width;
 
   /* Fetch the average size of a charachter */
-  context = pango_layout_get_context (layout);
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-                                       pango_context_get_language (context));
-
-  char_width = pango_font_metrics_get_approximate_char_width (metrics);
-
-  pango_font_metrics_unref (metrics);
-  g_object_unref (layout);
+  char_width = get_char_width (celltext, widget);
 
   /* enforce minimum width for ellipsized labels at ~3 chars */
   if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
@@ -2243,7 +2466,7 @@ gtk_cell_renderer_text_get_preferred_height_for_width (GtkCellRenderer *cell,
                                                        gint            *natural_height)
 {
   GtkCellRendererText *celltext;
-  PangoLayout         *layout;
+  PangoRectangle       rect;
   gint                 text_height, xpad, ypad;
 
 
@@ -2251,18 +2474,15 @@ gtk_cell_renderer_text_get_preferred_height_for_width (GtkCellRenderer *cell,
 
   gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
 
-  layout = get_layout (celltext, widget, NULL, 0);
-
-  pango_layout_set_width (layout, (width - xpad * 2) * PANGO_SCALE);
-  pango_layout_get_pixel_size (layout, NULL, &text_height);
+  get_layout_extents (celltext, widget, (width - xpad * 2) * PANGO_SCALE, &rect);
+  pango_extents_to_pixels (&rect, NULL);
+  text_height = rect.height;
 
   if (minimum_height)
     *minimum_height = text_height + ypad * 2;
 
   if (natural_height)
     *natural_height = text_height + ypad * 2;
-
-  g_object_unref (layout);
 }
 
 static void
@@ -53,6 +53,8 @@
 #include "a11y/gtkcontaineraccessibleprivate.h"
 #include "gtkpopovermenu.h"
 
+#include "gdk/gdk-private.h"
+
 /**
  * SECTION:gtkcontainer
  * @Short_description: Base class for widgets which contain other widgets
@@ -1859,6 +1861,10 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
                                    empty);
 
       _gtk_bitmask_free (empty);
+
+      if (GDK_PRIVATE_CALL (gdk_profiler_is_running) ())
+        GDK_PRIVATE_CALL (gdk_profiler_end_mark) (current_time, "style validation",
+                                                  G_OBJECT_TYPE_NAME (container));
     }
 
   /* we may be invoked with a container_resize_queue of NULL, because
@@ -1869,8 +1875,16 @@ gtk_container_idle_sizer (GdkFrameClock *clock,
    */
   if (container->priv->resize_pending)
     {
+      gint64 before = 0;
+
+      if (GDK_PRIVATE_CALL (gdk_profiler_is_running) ())
+        before = g_get_monotonic_time ();
+
       container->priv->resize_pending = FALSE;
       gtk_container_check_resize (container);
+
+      GDK_PRIVATE_CALL (gdk_profiler_end_mark) (before, "size allocation",
+                                                G_OBJECT_TYPE_NAME (container));
     }
 
   if (!container->priv->restyle_pending && !container->priv->resize_pending)
@@ -43,6 +43,20 @@
 #define MAJOR_VERSION 1
 #define MINOR_VERSION 0
 
+/* Pixel data types; the surface types hold a premultiplied ARGB32
+ * image, as used by cairo, in the byte order of the machine that
+ * wrote the cache.
+ */
+#define PIXEL_DATA_PIXDATA            0
+#define PIXEL_DATA_SURFACE_LE         1
+#define PIXEL_DATA_SURFACE_BE         2
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define PIXEL_DATA_SURFACE_NATIVE PIXEL_DATA_SURFACE_LE
+#else
+#define PIXEL_DATA_SURFACE_NATIVE PIXEL_DATA_SURFACE_BE
+#endif
+
 #define GET_UINT16(cache, offset) (GUINT16_FROM_BE (*(guint16 *)((cache) + (offset))))
 #define GET_UINT32(cache, offset) (GUINT32_FROM_BE (*(guint32 *)((cache) + (offset))))
 
@@ -52,6 +66,7 @@ struct _GtkIconCache {
 
   GMappedFile *map;
   gchar *buffer;
+  gsize size;
 
   guint32 last_chain_offset;
 };
@@ -127,7 +142,11 @@ _gtk_icon_cache_new_for_path (const gchar *path)
       goto done; 
     }
 
-  map = g_mapped_file_new (cache_filename, FALSE, NULL);
+  /* The mapping is private and writable, so that surfaces can be
+   * made directly over the pixels stored in the cache; pages are
+   * shared with other processes until something draws on them
+   */
+  map = g_mapped_file_new_from_fd (fd, TRUE, NULL);
 
   if (!map)
     goto done;
@@ -158,6 +177,7 @@ _gtk_icon_cache_new_for_path (const gchar *path)
   cache->ref_count = 1;
   cache->map = map;
   cache->buffer = g_mapped_file_get_contents (map);
+  cache->size = g_mapped_file_get_length (map);
 
  done:
   g_free (cache_filename);  
@@ -176,6 +196,8 @@ _gtk_icon_cache_new (const gchar *data)
   cache->ref_count = 1;
   cache->map = NULL;
   cache->buffer = (gchar *)data;
+  /* Built-in caches are generated at build time */
+  cache->size = G_MAXSIZE;
   
   return cache;
 }
@@ -476,32 +498,115 @@ pixbuf_destroy_cb (guchar   *pixels,
   _gtk_icon_cache_unref (cache);
 }
 
+static guint32
+find_pixel_data_offset (GtkIconCache *cache,
+                        const gchar  *icon_name,
+                        gint          directory_index)
+{
+  guint32 offset, image_data_offset;
+
+  offset = find_image_offset (cache, icon_name, directory_index);
+
+  if (!offset)
+    return 0;
+
+  image_data_offset = GET_UINT32 (cache->buffer, offset + 4);
+
+  if (!image_data_offset)
+    return 0;
+
+  return GET_UINT32 (cache->buffer, image_data_offset);
+}
+
+static const cairo_user_data_key_t cache_key;
+
+static cairo_surface_t *
+surface_from_pixel_data (GtkIconCache *cache,
+                         guint32       pixel_data_offset)
+{
+  cairo_surface_t *surface;
+  guint32 width, height, stride;
+
+  /* Built-in caches live in read-only memory */
+  if (cache->map == NULL)
+    return NULL;
+
+  if ((guint64) pixel_data_offset + 20 > cache->size)
+    return NULL;
+
+  width = GET_UINT32 (cache->buffer, pixel_data_offset + 8);
+  height = GET_UINT32 (cache->buffer, pixel_data_offset + 12);
+  stride = GET_UINT32 (cache->buffer, pixel_data_offset + 16);
+
+  /* The cache may be truncated or corrupt */
+  if (width == 0 || height == 0 ||
+      width > G_MAXINT / 4 || height > G_MAXINT ||
+      stride < 4 * width ||
+      (guint64) stride * height > cache->size ||
+      (guint64) pixel_data_offset + 20 + (guint64) stride * height > cache->size)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("invalid surface data: %ux%u, stride %u\n", width, height, stride));
+      return NULL;
+    }
+
+  /* The pixels are used in place, in the copy-on-write mapping */
+  surface = cairo_image_surface_create_for_data ((guchar *)(cache->buffer + pixel_data_offset + 20),
+                                                 CAIRO_FORMAT_ARGB32,
+                                                 width, height, stride);
+  if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("invalid surface data: %s\n",
+                         cairo_status_to_string (cairo_surface_status (surface))));
+      cairo_surface_destroy (surface);
+
+      return NULL;
+    }
+
+  cairo_surface_set_user_data (surface, &cache_key,
+                               _gtk_icon_cache_ref (cache),
+                               (cairo_destroy_func_t) _gtk_icon_cache_unref);
+
+  return surface;
+}
+
 GdkPixbuf *
 _gtk_icon_cache_get_icon (GtkIconCache *cache,
 			  const gchar  *icon_name,
 			  gint          directory_index)
 {
-  guint32 offset, image_data_offset, pixel_data_offset;
+  guint32 pixel_data_offset;
   guint32 length, type;
   GdkPixbuf *pixbuf;
   GdkPixdata pixdata;
   GError *error = NULL;
 
-  offset = find_image_offset (cache, icon_name, directory_index);
-  
-  if (!offset)
-    return NULL;
+  pixel_data_offset = find_pixel_data_offset (cache, icon_name, directory_index);
 
-  image_data_offset = GET_UINT32 (cache->buffer, offset + 4);
-  
-  if (!image_data_offset)
+  if (!pixel_data_offset)
     return NULL;
 
-  pixel_data_offset = GET_UINT32 (cache->buffer, image_data_offset);
-
   type = GET_UINT32 (cache->buffer, pixel_data_offset);
 
-  if (type != 0)
+  if (type == PIXEL_DATA_SURFACE_NATIVE)
+    {
+      cairo_surface_t *surface;
+
+      /* Pixbufs are not premultiplied, so this needs a copy */
+      surface = surface_from_pixel_data (cache, pixel_data_offset);
+      if (surface == NULL)
+        return NULL;
+
+      pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0,
+                                            cairo_image_surface_get_width (surface),
+                                            cairo_image_surface_get_height (surface));
+      cairo_surface_destroy (surface);
+
+      return pixbuf;
+    }
+
+  if (type != PIXEL_DATA_PIXDATA)
     {
       GTK_NOTE (ICONTHEME,
 		g_print ("invalid pixel data type %u\n", type));
@@ -542,6 +647,26 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   return pixbuf;
 }
 
+/* Returns a surface that uses the pixels stored in the cache
+ * directly, or %NULL if the cache holds no valid surface data for
+ * the icon, or holds it in a different byte order.
+ */
+cairo_surface_t *
+_gtk_icon_cache_get_surface (GtkIconCache *cache,
+                             const gchar  *icon_name,
+                             gint          directory_index)
+{
+  guint32 pixel_data_offset;
+
+  pixel_data_offset = find_pixel_data_offset (cache, icon_name, directory_index);
+
+  if (!pixel_data_offset ||
+      GET_UINT32 (cache->buffer, pixel_data_offset) != PIXEL_DATA_SURFACE_NATIVE)
+    return NULL;
+
+  return surface_from_pixel_data (cache, pixel_data_offset);
+}
+
 GtkIconData  *
 _gtk_icon_cache_get_icon_data  (GtkIconCache *cache,
 				const gchar  *icon_name,
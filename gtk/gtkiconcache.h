@@ -56,6 +56,9 @@ gint          _gtk_icon_cache_get_icon_flags (GtkIconCache *cache,
 GdkPixbuf    *_gtk_icon_cache_get_icon       (GtkIconCache *cache,
 					      const gchar  *icon_name,
 					      gint          directory_index);
+cairo_surface_t *_gtk_icon_cache_get_surface (GtkIconCache *cache,
+                                              const gchar  *icon_name,
+                                              gint          directory_index);
 GtkIconData  *_gtk_icon_cache_get_icon_data  (GtkIconCache *cache,
  					      const gchar  *icon_name,
  					      gint          directory_index);
@@ -156,9 +156,24 @@ check_pixel_data (CacheInfo *info,
   check ("offset, pixel data type", get_uint32 (info, offset, &type));
   check ("offset, pixel data length", get_uint32 (info, offset + 4, &length));
 
-  check ("pixel data type", type == 0);
+  check ("pixel data type", type <= 2);
   check ("pixel data length", offset + 8 + length < info->cache_size);
 
+  if (type != 0)
+    {
+      guint32 width, height, stride;
+
+      /* Premultiplied ARGB32 surface data */
+      check ("surface data length", length >= 12);
+      check ("offset, surface width", get_uint32 (info, offset + 8, &width));
+      check ("offset, surface height", get_uint32 (info, offset + 12, &height));
+      check ("offset, surface stride", get_uint32 (info, offset + 16, &stride));
+      check ("surface stride", stride >= 4 * width && stride % 4 == 0);
+      check ("surface data", height == 0 || stride <= (length - 12) / height);
+
+      return TRUE;
+    }
+
   if (info->flags & CHECK_PIXBUFS) 
     {
       GdkPixdata data; 
@@ -24,6 +24,7 @@
 #include <math.h>
 
 #include "gtkiconhelperprivate.h"
+#include "gtkiconthemeprivate.h"
 #include "gtkstylecontextprivate.h"
 
 struct _GtkIconHelperPrivate {
@@ -31,6 +32,10 @@ struct _GtkIconHelperPrivate {
 
   GdkWindow *window;
 
+  /* Widget to queue a resize on when an icon finishes loading */
+  GtkWidget *owner;
+  GtkIconInfo *loading_info;
+
   GdkPixbuf *orig_pixbuf;
   int orig_pixbuf_scale;
   GdkPixbufAnimation *animation;
@@ -65,6 +70,7 @@ _gtk_icon_helper_clear (GtkIconHelper *self)
   g_clear_object (&self->priv->animation);
   g_clear_object (&self->priv->rendered_pixbuf);
   g_clear_object (&self->priv->window);
+  g_clear_object (&self->priv->loading_info);
   g_clear_pointer (&self->priv->orig_surface, cairo_surface_destroy);
   g_clear_pointer (&self->priv->rendered_surface, cairo_surface_destroy);
 
@@ -108,11 +114,32 @@ void
 
 }
 
+/* Sets the widget showing the icon. With an owner, icons that are
+ * still being loaded in a thread, e.g. by
+ * gtk_icon_theme_preload_icons_async(), are not waited for; the
+ * owner is resized once they are ready.
+ */
+void
+_gtk_icon_helper_set_owner (GtkIconHelper *self,
+                            GtkWidget     *owner)
+{
+  if (self->priv->owner)
+    g_object_remove_weak_pointer (G_OBJECT (self->priv->owner),
+                                  (gpointer *) &self->priv->owner);
+
+  self->priv->owner = owner;
+
+  if (owner)
+    g_object_add_weak_pointer (G_OBJECT (owner),
+                               (gpointer *) &self->priv->owner);
+}
+
 static void
 gtk_icon_helper_finalize (GObject *object)
 {
   GtkIconHelper *self = GTK_ICON_HELPER (object);
 
+  _gtk_icon_helper_set_owner (self, NULL);
   _gtk_icon_helper_clear (self);
   
   G_OBJECT_CLASS (_gtk_icon_helper_parent_class)->finalize (object);
@@ -703,6 +730,28 @@ ensure_stated_surface_from_info (GtkIconHelper *self,
   self->priv->rendered_surface = surface;
 }
 
+static void
+icon_loaded_cb (GObject      *source_object,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  GtkIconHelper *self = user_data;
+  GdkPixbuf *pixbuf;
+
+  pixbuf = gtk_icon_info_load_icon_finish (GTK_ICON_INFO (source_object), result, NULL);
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  if (self->priv->loading_info == (GtkIconInfo *) source_object)
+    {
+      _gtk_icon_helper_invalidate (self);
+      if (self->priv->owner)
+        gtk_widget_queue_resize (self->priv->owner);
+    }
+
+  g_object_unref (self);
+}
+
 static void
 ensure_surface_for_gicon (GtkIconHelper   *self,
                           GtkStyleContext *context)
@@ -734,8 +783,29 @@ ensure_surface_for_gicon (GtkIconHelper   *self,
       return;
     }
 
+  if (info != NULL && self->priv->owner != NULL &&
+      _gtk_icon_info_is_loading (info))
+    {
+      if (info != self->priv->loading_info)
+        {
+          g_clear_object (&self->priv->loading_info);
+          self->priv->loading_info = g_object_ref (info);
+          gtk_icon_info_load_icon_async (info, NULL,
+                                         icon_loaded_cb,
+                                         g_object_ref (self));
+        }
+
+      g_object_unref (info);
+      return;
+    }
+
   ensure_stated_surface_from_info (self, context, info, scale);
 
+  /* Holding on to the loading info kept it in the icon theme
+   * cache until we got to use it
+   */
+  g_clear_object (&self->priv->loading_info);
+
   if (info)
     g_object_unref (info);
 }
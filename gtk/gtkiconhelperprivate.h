@@ -72,6 +72,8 @@ void _gtk_icon_helper_clear (GtkIconHelper *self);
 void _gtk_icon_helper_invalidate (GtkIconHelper *self);
 void _gtk_icon_helper_set_window (GtkIconHelper *self,
 				  GdkWindow *window);
+void _gtk_icon_helper_set_owner (GtkIconHelper *self,
+                                 GtkWidget     *owner);
 
 gboolean _gtk_icon_helper_get_is_empty (GtkIconHelper *self);
 
@@ -38,6 +38,7 @@
 #endif /* G_OS_WIN32 */
 
 #include "gtkicontheme.h"
+#include "gtkiconthemeprivate.h"
 #include "gtkdebug.h"
 #include "deprecated/gtkiconfactory.h"
 #include "gtkiconcache.h"
@@ -155,7 +156,12 @@ typedef enum
   ICON_SUFFIX_SYMBOLIC_PNG = 1 << 4
 } IconSuffix;
 
-#define INFO_CACHE_LRU_SIZE 32
+/* Icon infos that are not in use any more are kept around while
+ * their decoded pixels fit in this budget
+ */
+#define INFO_CACHE_LRU_BUDGET (4 * 1024 * 1024)
+/* Number of lookup results that are kept around */
+#define LOOKUP_CACHE_SIZE 1024
 #if 0
 #define DEBUG_CACHE(args) g_print args
 #else
@@ -165,7 +171,16 @@ typedef enum
 struct _GtkIconThemePrivate
 {
   GHashTable *info_cache;
-  GList *info_cache_lru;
+  GQueue info_cache_lru;
+  gsize info_cache_lru_bytes;
+
+  /* The results of real_choose_icon(), so infos that fell out
+   * of the info cache can be recreated without a lookup
+   */
+  GHashTable *lookup_cache;
+  GQueue lookup_cache_lru;
+
+  GtkIconThemeCacheStats cache_stats;
 
   gchar *current_theme;
   gchar **search_path;
@@ -177,6 +192,7 @@ struct _GtkIconThemePrivate
   guint pixbuf_supports_svg : 1;
   guint themes_valid        : 1;
   guint loading_themes      : 1;
+  guint snapshot_stale      : 1;
 
   /* A list of all the themes needed to look up icons.
    * In search order, without duplicates
@@ -192,6 +208,7 @@ struct _GtkIconThemePrivate
   GList *dir_mtimes;
 
   gulong theme_changed_idle;
+  gulong check_snapshot_idle;
 };
 
 typedef struct {
@@ -213,6 +230,20 @@ struct _SymbolicPixbufCache {
   SymbolicPixbufCache *next;
 };
 
+/* Symbolic svgs are rendered once per file and size into a mask
+ * in the format of .symbolic.png files, with the amount of the
+ * success, warning and error colors in the red, green and blue
+ * channels. Recoloring the icon then doesn't need the svg anymore.
+ * The masks are shared between all icon infos.
+ */
+typedef struct {
+  gchar *uri;
+  gint width;
+  gint height;
+} SymbolicMaskKey;
+
+#define SYMBOLIC_MASK_CACHE_SIZE 128
+
 struct _GtkIconInfoClass
 {
   GObjectClass parent_class;
@@ -234,6 +265,9 @@ struct _GtkIconInfo
 
   /* Cache pixbuf (if there is any) */
   GdkPixbuf *cache_pixbuf;
+  /* Surface using the pixels in the icon cache; for symbolic
+   * svgs this is the mask to recolor */
+  cairo_surface_t *cache_surface;
 
   /* Information about the directory where
    * the source was found
@@ -265,8 +299,24 @@ struct _GtkIconInfo
   SymbolicPixbufCache *symbolic_pixbuf_cache;
 
   gint symbolic_size;
+
+  /* Tasks waiting for the load running in a thread */
+  GList *load_waiters;
+
+  /* Link in the LRU of the icon theme, data is set while in it */
+  GList lru_link;
+  gsize lru_bytes;
 };
 
+typedef struct
+{
+  IconInfoKey key;
+  /* An info without pixels to copy, or NULL if nothing was found */
+  GtkIconInfo *info;
+  guint builtin_icons_serial;
+  GList link;
+} LookupResult;
+
 typedef struct
 {
   gchar *name;
@@ -276,6 +326,9 @@ typedef struct
 
   /* In search order */
   GList *dirs;
+
+  /* The directories and subdirectories as stored in the snapshot */
+  GVariant *snapshot;
 } IconTheme;
 
 typedef struct
@@ -338,7 +391,16 @@ static void         theme_list_contexts       (IconTheme        *theme,
 static void         theme_subdir_load         (GtkIconTheme     *icon_theme,
                                                IconTheme        *theme,
                                                GKeyFile         *theme_file,
-                                               gchar            *subdir);
+                                               gchar            *subdir,
+                                               GVariantBuilder  *snapshot);
+static void         theme_subdir_add          (GtkIconTheme     *icon_theme,
+                                               IconTheme        *theme,
+                                               const IconThemeDir *params,
+                                               IconThemeDirMtime *dir_mtime,
+                                               gchar            *full_dir);
+static void         theme_subdir_add_resources (GtkIconTheme    *icon_theme,
+                                               IconTheme        *theme,
+                                               const IconThemeDir *params);
 static void         do_theme_change           (GtkIconTheme     *icon_theme);
 static void         blow_themes               (GtkIconTheme     *icon_themes);
 static gboolean     rescan_themes             (GtkIconTheme     *icon_themes);
@@ -356,11 +418,25 @@ static BuiltinIcon *find_builtin_icon         (const gchar      *icon_name,
                                                gint             *min_difference_p);
 static void         remove_from_lru_cache     (GtkIconTheme     *icon_theme,
                                                GtkIconInfo      *icon_info);
+static void         lookup_cache_clear        (GtkIconTheme     *icon_theme);
+static void         lookup_result_free        (LookupResult     *result);
+#ifdef G_ENABLE_DEBUG
+static void         print_cache_stats         (GtkIconTheme     *icon_theme);
+#endif
+static GtkIconInfo *icon_info_dup             (GtkIconInfo      *icon_info);
 static gboolean     icon_info_ensure_scale_and_pixbuf (GtkIconInfo* icon_info);
+static void         symbolic_masks_clear      (void);
 
 static guint signal_changed = 0;
 
 static GHashTable *icon_theme_builtin_icons;
+/* Bumped when builtin icons are added, to invalidate lookup results */
+static guint builtin_icons_serial;
+
+/* SymbolicMaskKey -> GdkPixbuf, the queue holds the keys oldest first */
+static GHashTable *symbolic_masks;
+static GQueue symbolic_mask_keys = G_QUEUE_INIT;
+G_LOCK_DEFINE_STATIC (symbolic_masks);
 
 static guint
 icon_info_key_hash (gconstpointer _key)
@@ -717,6 +793,8 @@ gtk_icon_theme_init (GtkIconTheme *icon_theme)
 
   priv->info_cache = g_hash_table_new_full (icon_info_key_hash, icon_info_key_equal, NULL,
                                             (GDestroyNotify)icon_info_uncached);
+  priv->lookup_cache = g_hash_table_new_full (icon_info_key_hash, icon_info_key_equal, NULL,
+                                              (GDestroyNotify)lookup_result_free);
 
   priv->custom_theme = FALSE;
 
@@ -795,6 +873,8 @@ do_theme_change (GtkIconTheme *icon_theme)
   GtkIconThemePrivate *priv = icon_theme->priv;
 
   g_hash_table_remove_all (priv->info_cache);
+  lookup_cache_clear (icon_theme);
+  symbolic_masks_clear ();
 
   if (!priv->themes_valid)
     return;
@@ -834,12 +914,18 @@ gtk_icon_theme_finalize (GObject *object)
   icon_theme = GTK_ICON_THEME (object);
   priv = icon_theme->priv;
 
+  GTK_NOTE (ICONTHEME, print_cache_stats (icon_theme));
+
   g_hash_table_destroy (priv->info_cache);
-  g_assert (priv->info_cache_lru == NULL);
+  g_assert (priv->info_cache_lru.length == 0);
+  g_hash_table_destroy (priv->lookup_cache);
 
   if (priv->theme_changed_idle)
     g_source_remove (priv->theme_changed_idle);
 
+  if (priv->check_snapshot_idle)
+    g_source_remove (priv->check_snapshot_idle);
+
   unset_screen (icon_theme);
 
   g_free (priv->current_theme);
@@ -1115,6 +1201,7 @@ insert_theme (GtkIconTheme *icon_theme,
   GError *error = NULL;
   IconThemeDirMtime *dir_mtime;
   GStatBuf stat_buf;
+  GVariantBuilder snapshot;
   
   priv = icon_theme->priv;
 
@@ -1209,20 +1296,40 @@ insert_theme (GtkIconTheme *icon_theme,
                            "Icon Theme", "Example",
                            NULL);
 
+  if (priv->is_screen_singleton)
+    g_variant_builder_init (&snapshot, G_VARIANT_TYPE ("a(susiiiii)"));
+
   theme->dirs = NULL;
   for (i = 0; dirs[i] != NULL; i++)
-    theme_subdir_load (icon_theme, theme, theme_file, dirs[i]);
+    theme_subdir_load (icon_theme, theme, theme_file, dirs[i],
+                       priv->is_screen_singleton ? &snapshot : NULL);
 
   if (scaled_dirs)
     {
       for (i = 0; scaled_dirs[i] != NULL; i++)
-        theme_subdir_load (icon_theme, theme, theme_file, scaled_dirs[i]);
+        theme_subdir_load (icon_theme, theme, theme_file, scaled_dirs[i],
+                           priv->is_screen_singleton ? &snapshot : NULL);
     }
   g_strfreev (dirs);
   g_strfreev (scaled_dirs);
 
   theme->dirs = g_list_reverse (theme->dirs);
 
+  if (priv->is_screen_singleton)
+    {
+      GVariantBuilder dir_names;
+
+      /* The directories the subdirectories were looked for in */
+      g_variant_builder_init (&dir_names, G_VARIANT_TYPE ("as"));
+      for (l = priv->dir_mtimes; l != NULL; l = l->next)
+        {
+          dir_mtime = l->data;
+          g_variant_builder_add (&dir_names, "s", dir_mtime->dir);
+        }
+
+      theme->snapshot = g_variant_ref_sink (g_variant_new ("(asa(susiiiii))", &dir_names, &snapshot));
+    }
+
   themes = g_key_file_get_string_list (theme_file,
                                        "Icon Theme",
                                        "Inherits",
@@ -1329,6 +1436,371 @@ add_unthemed_icon (GtkIconTheme *icon_theme,
     }
 }
 
+/* Snapshots
+ *
+ * Loading the themes stats every theme directory in every element of
+ * the search path, and every subdirectory of the themes in them, and
+ * parses the index.theme files of all inherited themes. The default
+ * icon theme of a screen writes the outcome to a per-user snapshot,
+ * which later processes with the same theme and search path map
+ * instead. Only the subdirectories of directories without an icon
+ * cache still need to be looked for then. The file name contains a
+ * hash of the theme, the search path and the scale, so processes with
+ * different configurations keep separate snapshots, and the snapshot
+ * is written in a thread.
+ *
+ * The directory mtimes recorded in the snapshot are only checked
+ * once the process goes idle. If they changed, the themes are loaded
+ * from scratch and the snapshot is written again.
+ *
+ * The snapshot is a serialized GVariant holding a format version, the
+ * theme name, the search path, the theme directories and the elements
+ * of the search path with their mtimes and whether they have an icon
+ * cache, and the themes with the directories and subdirectories they
+ * were loaded from. Snapshots that don't have the current version or
+ * don't fit the search path are ignored, and the themes are loaded
+ * from scratch.
+ */
+#define SNAPSHOT_TYPE "(usasa(sxb)a(xb)a(smsmsms(asa(susiiiii))))"
+#define SNAPSHOT_VERSION 1
+
+static gchar *
+get_snapshot_filename (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GChecksum *checksum;
+  gchar *basename, *filename;
+  gint scale, i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+
+  /* Include the terminating nul, so that the strings can't run
+   * into each other
+   */
+  if (priv->current_theme)
+    g_checksum_update (checksum, (const guchar *) priv->current_theme,
+                       strlen (priv->current_theme) + 1);
+  else
+    g_checksum_update (checksum, (const guchar *) "", 1);
+
+  for (i = 0; i < priv->search_path_len; i++)
+    g_checksum_update (checksum, (const guchar *) priv->search_path[i],
+                       strlen (priv->search_path[i]) + 1);
+
+  scale = priv->screen ? gdk_screen_get_monitor_scale_factor (priv->screen, 0) : 1;
+  g_checksum_update (checksum, (const guchar *) &scale, sizeof (scale));
+
+  basename = g_strconcat ("icon-theme-", g_checksum_get_string (checksum), ".snapshot", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (), "gtk-3.0", basename, NULL);
+
+  g_free (basename);
+  g_checksum_free (checksum);
+
+  return filename;
+}
+
+static GVariant *
+read_snapshot (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GMappedFile *map;
+  GBytes *bytes;
+  GVariant *snapshot;
+  const gchar *theme_name;
+  const gchar **search_path;
+  gsize search_path_len;
+  gchar *filename;
+  gboolean matches;
+  guint32 version;
+  GVariant *bases;
+  gsize n_bases;
+  gint i;
+
+  filename = get_snapshot_filename (icon_theme);
+  map = g_mapped_file_new (filename, FALSE, NULL);
+  g_free (filename);
+
+  if (map == NULL)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (map);
+  g_mapped_file_unref (map);
+
+  snapshot = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (SNAPSHOT_TYPE), bytes, FALSE));
+  g_bytes_unref (bytes);
+
+  if (G_BYTE_ORDER == G_BIG_ENDIAN)
+    {
+      GVariant *swapped;
+
+      swapped = g_variant_byteswap (snapshot);
+      g_variant_unref (snapshot);
+      snapshot = swapped;
+    }
+
+  /* Files written with another format read back as a wrong version */
+  g_variant_get_child (snapshot, 0, "u", &version);
+  if (version != SNAPSHOT_VERSION)
+    {
+      GTK_NOTE (ICONTHEME, g_print ("icon theme snapshot has version %u\n", version));
+      g_variant_unref (snapshot);
+      return NULL;
+    }
+
+  g_variant_get_child (snapshot, 1, "&s", &theme_name);
+  g_variant_get_child (snapshot, 2, "^a&s", &search_path);
+  search_path_len = g_strv_length ((gchar **) search_path);
+
+  bases = g_variant_get_child_value (snapshot, 4);
+  n_bases = g_variant_n_children (bases);
+  g_variant_unref (bases);
+
+  matches = strcmp (theme_name, priv->current_theme ? priv->current_theme : "") == 0 &&
+            search_path_len == priv->search_path_len &&
+            n_bases == priv->search_path_len;
+  for (i = 0; matches && i < priv->search_path_len; i++)
+    matches = strcmp (search_path[i], priv->search_path[i]) == 0;
+
+  g_free (search_path);
+
+  if (!matches)
+    {
+      GTK_NOTE (ICONTHEME, g_print ("icon theme snapshot doesn't match\n"));
+      g_variant_unref (snapshot);
+      return NULL;
+    }
+
+  return snapshot;
+}
+
+typedef struct {
+  gchar *filename;
+  GVariant *snapshot;
+} SnapshotWrite;
+
+static void
+snapshot_write_free (SnapshotWrite *write)
+{
+  g_free (write->filename);
+  g_variant_unref (write->snapshot);
+  g_slice_free (SnapshotWrite, write);
+}
+
+static void
+write_snapshot_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  SnapshotWrite *write = task_data;
+  gchar *dirname;
+  GError *error = NULL;
+
+  dirname = g_path_get_dirname (write->filename);
+
+  if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+      GTK_NOTE (ICONTHEME,
+                g_print ("failed to create %s\n", dirname));
+    }
+  else if (!g_file_set_contents (write->filename,
+                                 g_variant_get_data (write->snapshot),
+                                 g_variant_get_size (write->snapshot),
+                                 &error))
+    {
+      GTK_NOTE (ICONTHEME,
+                g_print ("failed to write icon theme snapshot: %s\n", error->message));
+      g_error_free (error);
+    }
+
+  g_free (dirname);
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+write_snapshot (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GVariantBuilder dirs, bases, themes;
+  GVariant *snapshot;
+  SnapshotWrite *write;
+  GTask *task;
+  gint n_theme_dirs, i;
+  GList *l;
+
+  /* The elements of the search path come after the theme directories */
+  n_theme_dirs = g_list_length (priv->dir_mtimes) - priv->search_path_len;
+
+  g_variant_builder_init (&dirs, G_VARIANT_TYPE ("a(sxb)"));
+  g_variant_builder_init (&bases, G_VARIANT_TYPE ("a(xb)"));
+  for (l = priv->dir_mtimes, i = 0; l; l = l->next, i++)
+    {
+      IconThemeDirMtime *dir_mtime = l->data;
+
+      if (i < n_theme_dirs)
+        g_variant_builder_add (&dirs, "(sxb)", dir_mtime->dir,
+                               (gint64) dir_mtime->mtime, dir_mtime->cache != NULL);
+      else
+        g_variant_builder_add (&bases, "(xb)",
+                               (gint64) dir_mtime->mtime, dir_mtime->cache != NULL);
+    }
+
+  g_variant_builder_init (&themes, G_VARIANT_TYPE ("a(smsmsms(asa(susiiiii)))"));
+  for (l = priv->themes; l; l = l->next)
+    {
+      IconTheme *theme = l->data;
+
+      g_variant_builder_add (&themes, "(smsmsms@(asa(susiiiii)))",
+                             theme->name, theme->display_name,
+                             theme->comment, theme->example,
+                             theme->snapshot);
+    }
+
+  snapshot = g_variant_ref_sink (g_variant_new (SNAPSHOT_TYPE,
+                                                SNAPSHOT_VERSION,
+                                                priv->current_theme ? priv->current_theme : "",
+                                                g_variant_new_strv ((const gchar * const *) priv->search_path,
+                                                                    priv->search_path_len),
+                                                &dirs, &bases, &themes));
+  if (G_BYTE_ORDER == G_BIG_ENDIAN)
+    {
+      GVariant *swapped;
+
+      swapped = g_variant_byteswap (snapshot);
+      g_variant_unref (snapshot);
+      snapshot = swapped;
+    }
+
+  /* The snapshot only holds serialized data, so the file can be
+   * written without blocking startup
+   */
+  write = g_slice_new (SnapshotWrite);
+  write->filename = get_snapshot_filename (icon_theme);
+  write->snapshot = snapshot;
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, write, (GDestroyNotify) snapshot_write_free);
+  g_task_run_in_thread (task, write_snapshot_thread);
+  g_object_unref (task);
+}
+
+static void
+load_themes_from_snapshot (GtkIconTheme *icon_theme,
+                           GVariant     *snapshot)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  GVariantIter *iter, *dir_names, *subdirs;
+  GHashTable *dirs;
+  GPtrArray *theme_dirs;
+  IconThemeDirMtime *dir_mtime;
+  IconTheme *theme;
+  IconThemeDir params;
+  const gchar *dir, *context;
+  gchar *name, *display_name, *comment, *example;
+  gchar *full_dir;
+  guint i;
+  gint64 mtime;
+  gboolean has_cache;
+  guint32 type;
+
+  GTK_NOTE (ICONTHEME, g_print ("loading icon themes from snapshot\n"));
+
+  dirs = g_hash_table_new (g_str_hash, g_str_equal);
+  theme_dirs = g_ptr_array_new ();
+
+  g_variant_get_child (snapshot, 3, "a(sxb)", &iter);
+  while (g_variant_iter_next (iter, "(&sxb)", &dir, &mtime, &has_cache))
+    {
+      dir_mtime = g_slice_new (IconThemeDirMtime);
+      dir_mtime->dir = g_strdup (dir);
+      dir_mtime->mtime = mtime;
+      dir_mtime->cache = has_cache ? _gtk_icon_cache_new_for_path (dir) : NULL;
+
+      priv->dir_mtimes = g_list_prepend (priv->dir_mtimes, dir_mtime);
+      g_hash_table_insert (dirs, dir_mtime->dir, dir_mtime);
+    }
+  g_variant_iter_free (iter);
+  priv->dir_mtimes = g_list_reverse (priv->dir_mtimes);
+
+  g_variant_get_child (snapshot, 5, "a(smsmsms(asa(susiiiii)))", &iter);
+  while (g_variant_iter_next (iter, "(smsmsms(asa(susiiiii)))",
+                              &name, &display_name, &comment, &example,
+                              &dir_names, &subdirs))
+    {
+      theme = g_new0 (IconTheme, 1);
+      theme->name = name;
+      theme->display_name = display_name;
+      theme->comment = comment;
+      theme->example = example;
+
+      g_ptr_array_set_size (theme_dirs, 0);
+      while (g_variant_iter_next (dir_names, "&s", &dir))
+        {
+          dir_mtime = g_hash_table_lookup (dirs, dir);
+          if (dir_mtime != NULL)
+            g_ptr_array_add (theme_dirs, dir_mtime);
+        }
+      g_variant_iter_free (dir_names);
+
+      memset (&params, 0, sizeof (params));
+      while (g_variant_iter_next (subdirs, "(&su&siiiii)",
+                                  &params.subdir, &type, &context,
+                                  &params.size, &params.min_size, &params.max_size,
+                                  &params.threshold, &params.scale))
+        {
+          params.type = type;
+          params.context = context[0] ? g_quark_from_string (context) : 0;
+
+          for (i = 0; i < theme_dirs->len; i++)
+            {
+              dir_mtime = g_ptr_array_index (theme_dirs, i);
+
+              if (dir_mtime->mtime == 0)
+                continue;
+
+              /* Directories with a cache know whether they have the
+               * subdirectory. New subdirectories in the others don't
+               * change the mtime of the theme directory, so they need
+               * to be looked for like before.
+               */
+              full_dir = g_build_filename (dir_mtime->dir, params.subdir, NULL);
+              if (dir_mtime->cache != NULL || g_file_test (full_dir, G_FILE_TEST_IS_DIR))
+                theme_subdir_add (icon_theme, theme, &params, dir_mtime, full_dir);
+              else
+                g_free (full_dir);
+            }
+
+          theme_subdir_add_resources (icon_theme, theme, &params);
+        }
+      g_variant_iter_free (subdirs);
+
+      theme->dirs = g_list_reverse (theme->dirs);
+      priv->themes = g_list_prepend (priv->themes, theme);
+    }
+  g_variant_iter_free (iter);
+  priv->themes = g_list_reverse (priv->themes);
+
+  g_ptr_array_unref (theme_dirs);
+  g_hash_table_destroy (dirs);
+}
+
+static gboolean
+check_snapshot_idle (gpointer user_data)
+{
+  GtkIconTheme *icon_theme = user_data;
+  GtkIconThemePrivate *priv = icon_theme->priv;
+
+  priv->check_snapshot_idle = 0;
+
+  if (priv->themes_valid && rescan_themes (icon_theme))
+    {
+      GTK_NOTE (ICONTHEME, g_print ("icon theme snapshot is outdated\n"));
+      do_theme_change (icon_theme);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 load_themes (GtkIconTheme *icon_theme)
 {
@@ -1341,21 +1813,34 @@ load_themes (GtkIconTheme *icon_theme)
   IconThemeDirMtime *dir_mtime;
   GStatBuf stat_buf;
   GList *d;
+  GVariant *snapshot = NULL;
+  GVariant *bases = NULL;
   
   priv = icon_theme->priv;
 
-  if (priv->current_theme)
-    insert_theme (icon_theme, priv->current_theme);
+  if (priv->is_screen_singleton && !priv->snapshot_stale)
+    snapshot = read_snapshot (icon_theme);
 
-  /* Always look in the Adwaita, gnome and hicolor icon themes.
-   * Looking in hicolor is mandated by the spec, looking in Adwaita
-   * and gnome is a pragmatic solution to prevent missing icons in
-   * GTK+ applications when run under, e.g. KDE.
-   */
-  insert_theme (icon_theme, DEFAULT_ICON_THEME);
-  insert_theme (icon_theme, "gnome");
-  insert_theme (icon_theme, FALLBACK_ICON_THEME);
-  priv->themes = g_list_reverse (priv->themes);
+  if (snapshot)
+    {
+      load_themes_from_snapshot (icon_theme, snapshot);
+      bases = g_variant_get_child_value (snapshot, 4);
+    }
+  else
+    {
+      if (priv->current_theme)
+        insert_theme (icon_theme, priv->current_theme);
+
+      /* Always look in the Adwaita, gnome and hicolor icon themes.
+       * Looking in hicolor is mandated by the spec, looking in Adwaita
+       * and gnome is a pragmatic solution to prevent missing icons in
+       * GTK+ applications when run under, e.g. KDE.
+       */
+      insert_theme (icon_theme, DEFAULT_ICON_THEME);
+      insert_theme (icon_theme, "gnome");
+      insert_theme (icon_theme, FALLBACK_ICON_THEME);
+      priv->themes = g_list_reverse (priv->themes);
+    }
 
 
   priv->unthemed_icons = g_hash_table_new_full (g_str_hash, g_str_equal,
@@ -1372,11 +1857,32 @@ load_themes (GtkIconTheme *icon_theme)
       dir_mtime->mtime = 0;
       dir_mtime->cache = NULL;
 
-      if (g_stat (dir, &stat_buf) != 0 || !S_ISDIR (stat_buf.st_mode))
-        continue;
-      dir_mtime->mtime = stat_buf.st_mtime;
+      if (snapshot)
+        {
+          gint64 mtime;
+          gboolean has_cache;
+
+          /* read_snapshot() checked that there is an entry
+           * for each element of the search path
+           */
+          g_variant_get_child (bases, base, "(xb)", &mtime, &has_cache);
+
+          dir_mtime->mtime = mtime;
+          if (mtime == 0)
+            continue;
+
+          if (has_cache)
+            dir_mtime->cache = _gtk_icon_cache_new_for_path (dir);
+        }
+      else
+        {
+          if (g_stat (dir, &stat_buf) != 0 || !S_ISDIR (stat_buf.st_mode))
+            continue;
+          dir_mtime->mtime = stat_buf.st_mtime;
+
+          dir_mtime->cache = _gtk_icon_cache_new_for_path (dir);
+        }
 
-      dir_mtime->cache = _gtk_icon_cache_new_for_path (dir);
       if (dir_mtime->cache != NULL)
         continue;
 
@@ -1411,6 +1917,26 @@ load_themes (GtkIconTheme *icon_theme)
   g_get_current_time (&tv);
   priv->last_stat_time = tv.tv_sec;
 
+  if (snapshot)
+    {
+      /* Check that the snapshot is still valid once we're idle */
+      if (!priv->check_snapshot_idle)
+        {
+          priv->check_snapshot_idle =
+            gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                       check_snapshot_idle, icon_theme, NULL);
+          g_source_set_name_by_id (priv->check_snapshot_idle, "[gtk+] check_snapshot_idle");
+        }
+
+      g_variant_unref (bases);
+      g_variant_unref (snapshot);
+    }
+  else if (priv->is_screen_singleton)
+    {
+      write_snapshot (icon_theme);
+      priv->snapshot_stale = FALSE;
+    }
+
   GTK_NOTE (ICONTHEME, {
     GList *l;
     g_print ("Current icon themes ");
@@ -1442,6 +1968,7 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
           rescan_themes (icon_theme))
         {
           g_hash_table_remove_all (priv->info_cache);
+          lookup_cache_clear (icon_theme);
           blow_themes (icon_theme);
         }
     }
@@ -1457,7 +1984,7 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
   priv->loading_themes = FALSE;
 }
 
-/* The LRU cache is a short list of IconInfos that are kept
+/* The LRU cache is a list of IconInfos that are kept
  * alive even though their IconInfo would otherwise have
  * been freed, so that we can avoid reloading these
  * constantly.
@@ -1465,28 +1992,94 @@ ensure_valid_themes (GtkIconTheme *icon_theme)
  * references the info. So, when we get a cache hit
  * we remove it from the list, and when the proxy
  * pixmap is released we put it on the list.
+ * The list is limited by the memory taken by the decoded
+ * pixels of the infos; the infos link themselves into it,
+ * so that all operations on it are O(1).
  */
+static gsize
+icon_info_get_pixel_bytes (GtkIconInfo *icon_info)
+{
+  SymbolicPixbufCache *symbolic_cache;
+  gsize bytes = sizeof (GtkIconInfo);
+
+  /* Pixels from the icon cache are mapped, not decoded */
+  if (icon_info->pixbuf && icon_info->pixbuf != icon_info->cache_pixbuf)
+    bytes += gdk_pixbuf_get_byte_length (icon_info->pixbuf);
+
+  for (symbolic_cache = icon_info->symbolic_pixbuf_cache;
+       symbolic_cache != NULL;
+       symbolic_cache = symbolic_cache->next)
+    bytes += gdk_pixbuf_get_byte_length (symbolic_cache->pixbuf);
+
+  return bytes;
+}
+
+#ifdef G_ENABLE_DEBUG
+static void
+print_cache_stats (GtkIconTheme *icon_theme)
+{
+  GtkIconThemeCacheStats stats;
+
+  _gtk_icon_theme_get_cache_stats (icon_theme, &stats);
+
+  g_print ("icon theme %p: %u hits, %u lookup hits, %u misses, "
+           "%u infos (%" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes) unused, "
+           "%u lookup results, %u evictions, %u lookup evictions\n",
+           icon_theme,
+           stats.hits, stats.lookup_hits, stats.misses,
+           stats.n_unused, stats.unused_bytes, stats.unused_budget,
+           stats.n_lookups, stats.evictions, stats.lookup_evictions);
+}
+#endif
+
+/*
+ * _gtk_icon_theme_get_cache_stats:
+ * @icon_theme: a #GtkIconTheme
+ * @stats: (out): return location for the statistics
+ *
+ * Gets the counters of the icon info and lookup caches of
+ * @icon_theme, for debugging purposes.
+ */
+void
+_gtk_icon_theme_get_cache_stats (GtkIconTheme           *icon_theme,
+                                 GtkIconThemeCacheStats *stats)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+
+  *stats = priv->cache_stats;
+  stats->n_unused = priv->info_cache_lru.length;
+  stats->unused_bytes = priv->info_cache_lru_bytes;
+  stats->unused_budget = INFO_CACHE_LRU_BUDGET;
+  stats->n_lookups = priv->lookup_cache_lru.length;
+}
+
 static void
 ensure_lru_cache_space (GtkIconTheme *icon_theme)
 {
   GtkIconThemePrivate *priv = icon_theme->priv;
-  GList *l;
 
-  /* Remove last item if LRU full */
-  l = g_list_nth (priv->info_cache_lru, INFO_CACHE_LRU_SIZE - 1);
-  if (l)
+  /* Remove the least recently used items until we fit,
+   * but keep the one that was just added
+   */
+  if (priv->info_cache_lru_bytes <= INFO_CACHE_LRU_BUDGET)
+    return;
+
+  while (priv->info_cache_lru_bytes > INFO_CACHE_LRU_BUDGET &&
+         priv->info_cache_lru.length > 1)
     {
-      GtkIconInfo *icon_info = l->data;
+      GtkIconInfo *icon_info = g_queue_peek_tail (&priv->info_cache_lru);
 
       DEBUG_CACHE (("removing (due to out of space) %p (%s %d 0x%x) from LRU cache (cache size %d)\n",
                     icon_info,
                     g_strjoinv (",", icon_info->key.icon_names),
                     icon_info->key.size, icon_info->key.flags,
-                    g_list_length (priv->info_cache_lru)));
+                    priv->info_cache_lru.length));
 
-      priv->info_cache_lru = g_list_delete_link (priv->info_cache_lru, l);
-      g_object_unref (icon_info);
+      priv->cache_stats.evictions++;
+      remove_from_lru_cache (icon_theme, icon_info);
     }
+
+  GTK_NOTE (ICONTHEME, print_cache_stats (icon_theme));
 }
 
 static void
@@ -1499,14 +2092,17 @@ add_to_lru_cache (GtkIconTheme *icon_theme,
                 icon_info,
                 g_strjoinv (",", icon_info->key.icon_names),
                 icon_info->key.size, icon_info->key.flags,
-                g_list_length (priv->info_cache_lru)));
+                priv->info_cache_lru.length));
 
-  g_assert (g_list_find (priv->info_cache_lru, icon_info) == NULL);
+  g_assert (icon_info->lru_link.data == NULL);
 
-  ensure_lru_cache_space (icon_theme);
   /* prepend new info to LRU */
-  priv->info_cache_lru = g_list_prepend (priv->info_cache_lru,
-                                         g_object_ref (icon_info));
+  icon_info->lru_link.data = g_object_ref (icon_info);
+  icon_info->lru_bytes = icon_info_get_pixel_bytes (icon_info);
+  g_queue_push_head_link (&priv->info_cache_lru, &icon_info->lru_link);
+  priv->info_cache_lru_bytes += icon_info->lru_bytes;
+
+  ensure_lru_cache_space (icon_theme);
 }
 
 static void
@@ -1514,14 +2110,12 @@ ensure_in_lru_cache (GtkIconTheme *icon_theme,
                      GtkIconInfo  *icon_info)
 {
   GtkIconThemePrivate *priv = icon_theme->priv;
-  GList *l;
 
-  l = g_list_find (priv->info_cache_lru, icon_info);
-  if (l)
+  if (icon_info->lru_link.data != NULL)
     {
       /* Move to front of LRU if already in it */
-      priv->info_cache_lru = g_list_remove_link (priv->info_cache_lru, l);
-      priv->info_cache_lru = g_list_concat (l, priv->info_cache_lru);
+      g_queue_unlink (&priv->info_cache_lru, &icon_info->lru_link);
+      g_queue_push_head_link (&priv->info_cache_lru, &icon_info->lru_link);
     }
   else
     add_to_lru_cache (icon_theme, icon_info);
@@ -1532,19 +2126,95 @@ remove_from_lru_cache (GtkIconTheme *icon_theme,
                        GtkIconInfo  *icon_info)
 {
   GtkIconThemePrivate *priv = icon_theme->priv;
-  if (g_list_find (priv->info_cache_lru, icon_info))
+
+  if (icon_info->lru_link.data != NULL)
     {
       DEBUG_CACHE (("removing %p (%s %d 0x%x) from LRU cache (cache size %d)\n",
                     icon_info,
                     g_strjoinv (",", icon_info->key.icon_names),
                     icon_info->key.size, icon_info->key.flags,
-                    g_list_length (priv->info_cache_lru)));
+                    priv->info_cache_lru.length));
 
-      priv->info_cache_lru = g_list_remove (priv->info_cache_lru, icon_info);
+      g_queue_unlink (&priv->info_cache_lru, &icon_info->lru_link);
+      priv->info_cache_lru_bytes -= icon_info->lru_bytes;
+      icon_info->lru_link.data = NULL;
+      icon_info->lru_bytes = 0;
       g_object_unref (icon_info);
     }
 }
 
+static void
+lookup_result_free (LookupResult *result)
+{
+  g_strfreev (result->key.icon_names);
+  if (result->info)
+    g_object_unref (result->info);
+  g_slice_free (LookupResult, result);
+}
+
+static void
+lookup_cache_clear (GtkIconTheme *icon_theme)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+
+  g_hash_table_remove_all (priv->lookup_cache);
+  g_queue_init (&priv->lookup_cache_lru);
+}
+
+static LookupResult *
+lookup_cache_get (GtkIconTheme *icon_theme,
+                  IconInfoKey  *key)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  LookupResult *result;
+
+  result = g_hash_table_lookup (priv->lookup_cache, key);
+  if (result == NULL)
+    return NULL;
+
+  g_queue_unlink (&priv->lookup_cache_lru, &result->link);
+
+  if (result->builtin_icons_serial != builtin_icons_serial)
+    {
+      g_hash_table_remove (priv->lookup_cache, key);
+      return NULL;
+    }
+
+  g_queue_push_head_link (&priv->lookup_cache_lru, &result->link);
+
+  return result;
+}
+
+static void
+lookup_cache_add (GtkIconTheme *icon_theme,
+                  IconInfoKey  *key,
+                  GtkIconInfo  *icon_info)
+{
+  GtkIconThemePrivate *priv = icon_theme->priv;
+  LookupResult *result;
+
+  if (priv->lookup_cache_lru.length >= LOOKUP_CACHE_SIZE)
+    {
+      result = g_queue_peek_tail (&priv->lookup_cache_lru);
+      g_queue_unlink (&priv->lookup_cache_lru, &result->link);
+      g_hash_table_remove (priv->lookup_cache, &result->key);
+      priv->cache_stats.lookup_evictions++;
+    }
+
+  result = g_slice_new0 (LookupResult);
+  result->key.icon_names = g_strdupv (key->icon_names);
+  result->key.size = key->size;
+  result->key.scale = key->scale;
+  result->key.flags = key->flags;
+  if (icon_info)
+    result->info = icon_info_dup (icon_info);
+  result->builtin_icons_serial = builtin_icons_serial;
+  result->link.data = result;
+
+  g_queue_push_head_link (&priv->lookup_cache_lru, &result->link);
+  g_hash_table_insert (priv->lookup_cache, &result->key, result);
+}
+
 static SymbolicPixbufCache *
 symbolic_pixbuf_cache_new (GdkPixbuf           *pixbuf,
                            const GdkRGBA       *fg,
@@ -1624,6 +2294,107 @@ symbolic_pixbuf_cache_free (SymbolicPixbufCache *cache)
     }
 }
 
+static guint
+symbolic_mask_key_hash (gconstpointer data)
+{
+  const SymbolicMaskKey *key = data;
+
+  return g_str_hash (key->uri) ^ (key->width * 0x10001) ^ (key->height * 0x1000010);
+}
+
+static gboolean
+symbolic_mask_key_equal (gconstpointer a,
+                         gconstpointer b)
+{
+  const SymbolicMaskKey *key_a = a;
+  const SymbolicMaskKey *key_b = b;
+
+  return key_a->width == key_b->width &&
+         key_a->height == key_b->height &&
+         strcmp (key_a->uri, key_b->uri) == 0;
+}
+
+static void
+symbolic_mask_key_free (SymbolicMaskKey *key)
+{
+  g_free (key->uri);
+  g_slice_free (SymbolicMaskKey, key);
+}
+
+static GdkPixbuf *
+symbolic_mask_lookup (const gchar *uri,
+                      gint         width,
+                      gint         height)
+{
+  SymbolicMaskKey key;
+  GdkPixbuf *mask = NULL;
+
+  key.uri = (gchar *) uri;
+  key.width = width;
+  key.height = height;
+
+  G_LOCK (symbolic_masks);
+
+  if (symbolic_masks)
+    mask = g_hash_table_lookup (symbolic_masks, &key);
+  if (mask)
+    g_object_ref (mask);
+
+  G_UNLOCK (symbolic_masks);
+
+  return mask;
+}
+
+static void
+symbolic_mask_insert (const gchar *uri,
+                      gint         width,
+                      gint         height,
+                      GdkPixbuf   *mask)
+{
+  SymbolicMaskKey *key;
+
+  key = g_slice_new (SymbolicMaskKey);
+  key->uri = g_strdup (uri);
+  key->width = width;
+  key->height = height;
+
+  G_LOCK (symbolic_masks);
+
+  if (symbolic_masks == NULL)
+    symbolic_masks = g_hash_table_new_full (symbolic_mask_key_hash,
+                                            symbolic_mask_key_equal,
+                                            (GDestroyNotify) symbolic_mask_key_free,
+                                            g_object_unref);
+
+  /* Another thread may have rendered the same mask meanwhile */
+  if (g_hash_table_contains (symbolic_masks, key))
+    {
+      symbolic_mask_key_free (key);
+    }
+  else
+    {
+      if (g_queue_get_length (&symbolic_mask_keys) >= SYMBOLIC_MASK_CACHE_SIZE)
+        g_hash_table_remove (symbolic_masks, g_queue_pop_head (&symbolic_mask_keys));
+
+      g_hash_table_insert (symbolic_masks, key, g_object_ref (mask));
+      g_queue_push_tail (&symbolic_mask_keys, key);
+    }
+
+  G_UNLOCK (symbolic_masks);
+}
+
+static void
+symbolic_masks_clear (void)
+{
+  G_LOCK (symbolic_masks);
+
+  g_queue_clear (&symbolic_mask_keys);
+  if (symbolic_masks)
+    g_hash_table_remove_all (symbolic_masks);
+
+  G_UNLOCK (symbolic_masks);
+}
+
 static gboolean
 icon_name_is_symbolic (const gchar *icon_name)
 {
@@ -1659,6 +2430,7 @@ real_choose_icon (GtkIconTheme       *icon_theme,
   IconTheme *theme = NULL;
   gint i;
   IconInfoKey key;
+  LookupResult *result;
 
   priv = icon_theme->priv;
 
@@ -1678,12 +2450,35 @@ real_choose_icon (GtkIconTheme       *icon_theme,
                     icon_info->key.size, icon_info->key.flags,
                     g_hash_table_size (priv->info_cache)));
 
+      priv->cache_stats.hits++;
+
       icon_info = g_object_ref (icon_info);
       remove_from_lru_cache (icon_theme, icon_info);
 
       return icon_info;
     }
 
+  result = lookup_cache_get (icon_theme, &key);
+  if (result != NULL)
+    {
+      priv->cache_stats.lookup_hits++;
+
+      if (result->info == NULL)
+        return NULL;
+
+      icon_info = icon_info_dup (result->info);
+      icon_info->key.icon_names = g_strdupv ((char **)icon_names);
+      icon_info->key.size = size;
+      icon_info->key.scale = scale;
+      icon_info->key.flags = flags;
+      icon_info->in_cache = icon_theme;
+      g_hash_table_insert (priv->info_cache, &icon_info->key, icon_info);
+
+      return icon_info;
+    }
+
+  priv->cache_stats.misses++;
+
   if (flags & GTK_ICON_LOOKUP_NO_SVG)
     allow_svg = FALSE;
   else if (flags & GTK_ICON_LOOKUP_FORCE_SVG)
@@ -1826,7 +2621,10 @@ real_choose_icon (GtkIconTheme       *icon_theme,
                     g_hash_table_size (priv->info_cache)));
      g_hash_table_insert (priv->info_cache, &icon_info->key, icon_info);
     }
-  else
+
+  lookup_cache_add (icon_theme, &key, icon_info);
+
+  if (icon_info == NULL)
     {
       static gboolean check_for_default_theme = TRUE;
       gchar *default_theme_path;
@@ -2379,6 +3177,153 @@ gtk_icon_theme_load_surface (GtkIconTheme        *icon_theme,
   return surface;
 }
 
+typedef struct {
+  GPtrArray *infos;
+  gint n_pending;
+} PreloadData;
+
+static void
+preload_data_free (PreloadData *data)
+{
+  g_ptr_array_unref (data->infos);
+  g_slice_free (PreloadData, data);
+}
+
+static void
+preload_icon_loaded (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  GTask *task = user_data;
+  PreloadData *data = g_task_get_task_data (task);
+  GdkPixbuf *pixbuf;
+
+  /* Icons that fail to load are not an error for the batch,
+   * the failure is cached in the icon info like for any load.
+   */
+  pixbuf = gtk_icon_info_load_icon_finish (GTK_ICON_INFO (source_object), result, NULL);
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  data->n_pending--;
+  if (data->n_pending == 0)
+    {
+      if (!g_task_return_error_if_cancelled (task))
+        g_task_return_boolean (task, TRUE);
+    }
+
+  g_object_unref (task);
+}
+
+/**
+ * gtk_icon_theme_preload_icons_async:
+ * @icon_theme: a #GtkIconTheme
+ * @icon_names: (array zero-terminated=1): %NULL-terminated array of
+ *     icon names to preload
+ * @size: desired icon size
+ * @scale: desired scale
+ * @flags: flags modifying the behavior of the icon lookup
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when all
+ *     the icons are loaded
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Looks up a batch of icons and loads them in parallel in worker
+ * threads, so that a window about to be shown can have all its icons
+ * decoded without blocking the main loop.
+ *
+ * The lookups happen before this function returns; the loading of
+ * the icon data is spread over the threads of the #GTask pool.
+ * Widgets such as #GtkImage that look up one of these icons while it
+ * is still loading show it as soon as it is ready instead of loading
+ * it again; for that, @size, @scale and @flags need to match the ones
+ * the widget uses for its lookup.
+ *
+ * Loaded icons stay in the icon theme cache while they are in use and
+ * for a while afterwards, so @callback is a good place to create the
+ * widgets that display them.
+ *
+ * Since: 3.16
+ */
+void
+gtk_icon_theme_preload_icons_async (GtkIconTheme        *icon_theme,
+                                    const gchar * const *icon_names,
+                                    gint                 size,
+                                    gint                 scale,
+                                    GtkIconLookupFlags   flags,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  GTask *task;
+  PreloadData *data;
+  guint i;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
+  g_return_if_fail (icon_names != NULL);
+  g_return_if_fail (scale >= 1);
+
+  task = g_task_new (icon_theme, cancellable, callback, user_data);
+
+  data = g_slice_new (PreloadData);
+  data->infos = g_ptr_array_new_with_free_func (g_object_unref);
+  data->n_pending = 0;
+  g_task_set_task_data (task, data, (GDestroyNotify) preload_data_free);
+
+  for (i = 0; icon_names[i] != NULL; i++)
+    {
+      GtkIconInfo *info;
+
+      info = gtk_icon_theme_lookup_icon_for_scale (icon_theme, icon_names[i],
+                                                   size, scale, flags);
+      if (info == NULL)
+        continue;
+
+      /* Keep the infos alive, and thus in the cache, until all
+       * of them are loaded
+       */
+      g_ptr_array_add (data->infos, info);
+      data->n_pending++;
+    }
+
+  if (data->n_pending == 0)
+    g_task_return_boolean (task, TRUE);
+
+  for (i = 0; i < data->infos->len; i++)
+    gtk_icon_info_load_icon_async (g_ptr_array_index (data->infos, i),
+                                   cancellable,
+                                   preload_icon_loaded,
+                                   g_object_ref (task));
+
+  g_object_unref (task);
+}
+
+/**
+ * gtk_icon_theme_preload_icons_finish:
+ * @icon_theme: a #GtkIconTheme
+ * @result: a #GAsyncResult
+ * @error: (allow-none): location to store error information on failure,
+ *     or %NULL
+ *
+ * Finishes a preload started with gtk_icon_theme_preload_icons_async().
+ *
+ * Icons that could not be found or loaded do not make the preload
+ * fail; an error is only returned if the operation was cancelled.
+ *
+ * Returns: %TRUE if the icons were preloaded
+ *
+ * Since: 3.16
+ */
+gboolean
+gtk_icon_theme_preload_icons_finish (GtkIconTheme  *icon_theme,
+                                     GAsyncResult  *result,
+                                     GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, icon_theme), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * gtk_icon_theme_has_icon:
  * @icon_theme: a #GtkIconTheme
@@ -2718,6 +3663,9 @@ rescan_themes (GtkIconTheme *icon_theme)
           (stat_res != 0 || !S_ISDIR (stat_buf.st_mode)))
         continue;
 
+      /* don't reload the outdated themes from the snapshot */
+      priv->snapshot_stale = TRUE;
+
       return TRUE;
     }
 
@@ -2763,6 +3711,9 @@ theme_destroy (IconTheme *theme)
   g_free (theme->example);
 
   g_list_free_full (theme->dirs, (GDestroyNotify) theme_dir_destroy);
+
+  if (theme->snapshot)
+    g_variant_unref (theme->snapshot);
   
   g_free (theme);
 }
@@ -3077,8 +4028,14 @@ theme_lookup_icon (IconTheme   *theme,
 
       if (min_dir->cache)
         {
-          icon_info->cache_pixbuf = _gtk_icon_cache_get_icon (min_dir->cache, icon_name,
-                                                              min_dir->subdir_index);
+          icon_info->cache_surface = _gtk_icon_cache_get_surface (min_dir->cache, icon_name,
+                                                                  min_dir->subdir_index);
+          /* Svgs are rendered at the needed size, so the only
+           * prerendered data we can use for them is the surface
+           */
+          if (icon_info->cache_surface == NULL && !icon_info->is_svg)
+            icon_info->cache_pixbuf = _gtk_icon_cache_get_icon (min_dir->cache, icon_name,
+                                                                min_dir->subdir_index);
         }
 
       return icon_info;
@@ -3232,29 +4189,103 @@ scan_resources (GtkIconThemePrivate  *icon_theme,
   return g_hash_table_size (dir->icons) > 0;
 }
 
+static IconThemeDir *
+theme_dir_new (const IconThemeDir *params,
+               gchar              *full_dir,
+               gboolean            is_resource)
+{
+  IconThemeDir *dir;
+
+  dir = g_new0 (IconThemeDir, 1);
+  dir->type = params->type;
+  dir->is_resource = is_resource;
+  dir->context = params->context;
+  dir->size = params->size;
+  dir->min_size = params->min_size;
+  dir->max_size = params->max_size;
+  dir->threshold = params->threshold;
+  dir->dir = full_dir;
+  dir->subdir = g_strdup (params->subdir);
+  dir->scale = params->scale;
+  dir->cache = NULL;
+  dir->subdir_index = -1;
+
+  return dir;
+}
+
+/* Adds the subdirectory described by @params of the directory
+ * in @dir_mtime to @theme, if it has any icons.
+ */
+static void
+theme_subdir_add (GtkIconTheme       *icon_theme,
+                  IconTheme          *theme,
+                  const IconThemeDir *params,
+                  IconThemeDirMtime  *dir_mtime,
+                  gchar              *full_dir)
+{
+  IconThemeDir *dir;
+  gboolean has_icons;
+
+  dir = theme_dir_new (params, full_dir, FALSE);
+
+  if (dir_mtime->cache != NULL)
+    {
+      dir->cache = _gtk_icon_cache_ref (dir_mtime->cache);
+      dir->subdir_index = _gtk_icon_cache_get_directory_index (dir->cache, dir->subdir);
+      has_icons = _gtk_icon_cache_has_icons (dir->cache, dir->subdir);
+    }
+  else
+    has_icons = scan_directory (icon_theme->priv, dir, full_dir);
+
+  if (has_icons)
+    theme->dirs = g_list_prepend (theme->dirs, dir);
+  else
+    theme_dir_destroy (dir);
+}
+
+static void
+theme_subdir_add_resources (GtkIconTheme       *icon_theme,
+                            IconTheme          *theme,
+                            const IconThemeDir *params)
+{
+  IconThemeDir *dir;
+  gchar *full_dir;
+  GList *d;
+
+  if (strcmp (theme->name, FALLBACK_ICON_THEME) != 0)
+    return;
+
+  for (d = icon_theme->priv->resource_paths; d; d = d->next)
+    {
+      full_dir = g_build_filename ((const gchar *)d->data, params->subdir, NULL);
+      dir = theme_dir_new (params, full_dir, TRUE);
+
+      if (scan_resources (icon_theme->priv, dir, full_dir))
+        theme->dirs = g_list_prepend (theme->dirs, dir);
+      else
+        theme_dir_destroy (dir);
+    }
+}
+
 static void
-theme_subdir_load (GtkIconTheme *icon_theme,
-                   IconTheme    *theme,
-                   GKeyFile     *theme_file,
-                   gchar        *subdir)
+theme_subdir_load (GtkIconTheme    *icon_theme,
+                   IconTheme       *theme,
+                   GKeyFile        *theme_file,
+                   gchar           *subdir,
+                   GVariantBuilder *snapshot)
 {
   GList *d;
   gchar *type_string;
-  IconThemeDir *dir;
-  IconThemeDirType type;
+  IconThemeDir params;
   gchar *context_string;
-  GQuark context;
-  gint size;
-  gint min_size;
-  gint max_size;
-  gint threshold;
   gchar *full_dir;
   GError *error = NULL;
   IconThemeDirMtime *dir_mtime;
-  gint scale;
-  gboolean has_icons;
 
-  size = g_key_file_get_integer (theme_file, subdir, "Size", &error);
+  memset (&params, 0, sizeof (params));
+  params.subdir = subdir;
+
+  params.size = g_key_file_get_integer (theme_file, subdir, "Size", &error);
   if (error)
     {
       g_error_free (error);
@@ -3263,47 +4294,44 @@ theme_subdir_load (GtkIconTheme *icon_theme,
       return;
     }
   
-  type = ICON_THEME_DIR_THRESHOLD;
+  params.type = ICON_THEME_DIR_THRESHOLD;
   type_string = g_key_file_get_string (theme_file, subdir, "Type", NULL);
   if (type_string)
     {
       if (strcmp (type_string, "Fixed") == 0)
-        type = ICON_THEME_DIR_FIXED;
+        params.type = ICON_THEME_DIR_FIXED;
       else if (strcmp (type_string, "Scalable") == 0)
-        type = ICON_THEME_DIR_SCALABLE;
+        params.type = ICON_THEME_DIR_SCALABLE;
       else if (strcmp (type_string, "Threshold") == 0)
-        type = ICON_THEME_DIR_THRESHOLD;
+        params.type = ICON_THEME_DIR_THRESHOLD;
 
       g_free (type_string);
     }
   
-  context = 0;
+  params.context = 0;
   context_string = g_key_file_get_string (theme_file, subdir, "Context", NULL);
   if (context_string)
-    {
-      context = g_quark_from_string (context_string);
-      g_free (context_string);
-    }
+    params.context = g_quark_from_string (context_string);
 
   if (g_key_file_has_key (theme_file, subdir, "MaxSize", NULL))
-    max_size = g_key_file_get_integer (theme_file, subdir, "MaxSize", NULL);
+    params.max_size = g_key_file_get_integer (theme_file, subdir, "MaxSize", NULL);
   else
-    max_size = size;
+    params.max_size = params.size;
 
   if (g_key_file_has_key (theme_file, subdir, "MinSize", NULL))
-    min_size = g_key_file_get_integer (theme_file, subdir, "MinSize", NULL);
+    params.min_size = g_key_file_get_integer (theme_file, subdir, "MinSize", NULL);
   else
-    min_size = size;
+    params.min_size = params.size;
 
   if (g_key_file_has_key (theme_file, subdir, "Threshold", NULL))
-    threshold = g_key_file_get_integer (theme_file, subdir, "Threshold", NULL);
+    params.threshold = g_key_file_get_integer (theme_file, subdir, "Threshold", NULL);
   else
-    threshold = 2;
+    params.threshold = 2;
 
   if (g_key_file_has_key (theme_file, subdir, "Scale", NULL))
-    scale = g_key_file_get_integer (theme_file, subdir, "Scale", NULL);
+    params.scale = g_key_file_get_integer (theme_file, subdir, "Scale", NULL);
   else
-    scale = 1;
+    params.scale = 1;
 
   for (d = icon_theme->priv->dir_mtimes; d; d = d->next)
     {
@@ -3320,68 +4348,25 @@ theme_subdir_load (GtkIconTheme *icon_theme,
           if (dir_mtime->cache == NULL)
             {
               /* This will return NULL if the cache doesn't exist or is outdated */
-              dir_mtime->cache = _gtk_icon_cache_new_for_path (dir_mtime->dir);
-            }
-
-          dir = g_new0 (IconThemeDir, 1);
-          dir->type = type;
-          dir->is_resource = FALSE;
-          dir->context = context;
-          dir->size = size;
-          dir->min_size = min_size;
-          dir->max_size = max_size;
-          dir->threshold = threshold;
-          dir->dir = full_dir;
-          dir->subdir = g_strdup (subdir);
-          dir->scale = scale;
-
-          if (dir_mtime->cache != NULL)
-            {
-              dir->cache = _gtk_icon_cache_ref (dir_mtime->cache);
-              dir->subdir_index = _gtk_icon_cache_get_directory_index (dir->cache, dir->subdir);
-              has_icons = _gtk_icon_cache_has_icons (dir->cache, dir->subdir);
-            }
-          else
-            {
-              dir->cache = NULL;
-              dir->subdir_index = -1;
-              has_icons = scan_directory (icon_theme->priv, dir, full_dir);
+              dir_mtime->cache = _gtk_icon_cache_new_for_path (dir_mtime->dir);
             }
 
-          if (has_icons)
-            theme->dirs = g_list_prepend (theme->dirs, dir);
-          else
-            theme_dir_destroy (dir);
+          theme_subdir_add (icon_theme, theme, &params, dir_mtime, full_dir);
         }
       else
         g_free (full_dir);
     }
 
-  if (strcmp (theme->name, FALLBACK_ICON_THEME) == 0)
-    { 
-      for (d = icon_theme->priv->resource_paths; d; d = d->next)
-        {
-          full_dir = g_build_filename ((const gchar *)d->data, subdir, NULL);
-          dir = g_new0 (IconThemeDir, 1);
-          dir->type = type;
-          dir->is_resource = TRUE;
-          dir->context = context;
-          dir->size = size;
-          dir->min_size = min_size;
-          dir->max_size = max_size;
-          dir->threshold = threshold;
-          dir->dir = full_dir;
-          dir->subdir = g_strdup (subdir);
-          dir->scale = scale;
-          dir->cache = NULL;
-          dir->subdir_index = -1;
-
-          if (scan_resources (icon_theme->priv, dir, full_dir))
-            theme->dirs = g_list_prepend (theme->dirs, dir);
-          else
-            theme_dir_destroy (dir);
-        }
-    }
+  theme_subdir_add_resources (icon_theme, theme, &params);
+
+  if (snapshot)
+    g_variant_builder_add (snapshot, "(susiiiii)",
+                           subdir, (guint32) params.type,
+                           context_string ? context_string : "",
+                           params.size, params.min_size, params.max_size,
+                           params.threshold, params.scale);
+
+  g_free (context_string);
 }
 
 /*
@@ -3448,6 +4433,8 @@ icon_info_dup (GtkIconInfo *icon_info)
 
   if (icon_info->cache_pixbuf)
     dup->cache_pixbuf = g_object_ref (icon_info->cache_pixbuf);
+  if (icon_info->cache_surface)
+    dup->cache_surface = cairo_surface_reference (icon_info->cache_surface);
 
   dup->scale = icon_info->scale;
   dup->unscaled_scale = icon_info->unscaled_scale;
@@ -3527,6 +4514,7 @@ gtk_icon_info_finalize (GObject *object)
   g_clear_object (&icon_info->pixbuf);
   g_clear_object (&icon_info->proxy_pixbuf);
   g_clear_object (&icon_info->cache_pixbuf);
+  g_clear_pointer (&icon_info->cache_surface, cairo_surface_destroy);
   g_clear_error (&icon_info->load_error);
 
   symbolic_pixbuf_cache_free (icon_info->symbolic_pixbuf_cache);
@@ -3785,29 +4773,17 @@ icon_info_get_pixbuf_ready (GtkIconInfo *icon_info)
   return FALSE;
 }
 
-/* This function contains the complicated logic for deciding
- * on the size at which to load the icon and loading it at
- * that size.
+/* Returns the scale at which the icon is loaded when it can be
+ * determined without access to the icon file, or -1. For svgs,
+ * @svg_size is set to the size at which they get rendered.
  */
-static gboolean
-icon_info_ensure_scale_and_pixbuf (GtkIconInfo *icon_info)
+static gdouble
+icon_info_compute_scale (GtkIconInfo *icon_info,
+                         gint        *svg_size)
 {
-  gint image_width, image_height, image_size;
   gint scaled_desired_size;
-  GdkPixbuf *source_pixbuf;
   gdouble dir_scale;
-
-  if (icon_info->pixbuf)
-    {
-      apply_emblems (icon_info);
-      return TRUE;
-    }
-
-  if (icon_info->load_error)
-    return FALSE;
-
-  if (icon_info->icon_file && !icon_info->loadable)
-    icon_info->loadable = G_LOADABLE_ICON (g_file_icon_new (icon_info->icon_file));
+  gdouble scale;
 
   scaled_desired_size = icon_info->desired_size * icon_info->desired_scale;
 
@@ -3820,10 +4796,10 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo *icon_info)
    */
   if (icon_info->forced_size ||
       icon_info->dir_type == ICON_THEME_DIR_UNTHEMED)
-    icon_info->scale = -1;
+    scale = -1;
   else if (icon_info->dir_type == ICON_THEME_DIR_FIXED ||
            icon_info->dir_type == ICON_THEME_DIR_THRESHOLD)
-    icon_info->scale = icon_info->unscaled_scale;
+    scale = icon_info->unscaled_scale;
   else if (icon_info->dir_type == ICON_THEME_DIR_SCALABLE)
     {
       /* For svg icons, treat scalable directories as if they had
@@ -3835,31 +4811,95 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo *icon_info)
         dir_scale = icon_info->desired_scale;
 
       if (scaled_desired_size < icon_info->min_size * dir_scale)
-        icon_info->scale = (gdouble) icon_info->min_size / (gdouble) icon_info->dir_size;
+        scale = (gdouble) icon_info->min_size / (gdouble) icon_info->dir_size;
       else if (scaled_desired_size > icon_info->max_size * dir_scale)
-        icon_info->scale = (gdouble) icon_info->max_size / (gdouble) icon_info->dir_size;
+        scale = (gdouble) icon_info->max_size / (gdouble) icon_info->dir_size;
       else
-        icon_info->scale = (gdouble) scaled_desired_size / (icon_info->dir_size * dir_scale);
+        scale = (gdouble) scaled_desired_size / (icon_info->dir_size * dir_scale);
+    }
+  else
+    scale = icon_info->scale;
+
+  if (icon_info->forced_size)
+    *svg_size = scaled_desired_size;
+  else
+    *svg_size = icon_info->dir_size * dir_scale * scale;
+
+  return scale;
+}
+
+/* Returns whether the surface from the icon cache can be used as
+ * the icon as is, that is if it has the size the icon gets loaded
+ * at and nothing needs to be drawn on top of it.
+ */
+static gboolean
+icon_info_cache_surface_usable (GtkIconInfo *icon_info)
+{
+  gint image_size, svg_size;
+  gdouble scale;
+
+  if (icon_info->cache_surface == NULL ||
+      icon_info->emblem_infos != NULL)
+    return FALSE;
+
+  image_size = MAX (cairo_image_surface_get_width (icon_info->cache_surface),
+                    cairo_image_surface_get_height (icon_info->cache_surface));
+
+  scale = icon_info_compute_scale (icon_info, &svg_size);
+
+  if (icon_info->is_svg)
+    return image_size == svg_size;
+  else if (scale < 0.0)
+    return icon_info->forced_size &&
+           image_size == icon_info->desired_size * icon_info->desired_scale;
+  else
+    return scale == 1.0;
+}
+
+/* This function contains the complicated logic for deciding
+ * on the size at which to load the icon and loading it at
+ * that size.
+ */
+static gboolean
+icon_info_ensure_scale_and_pixbuf (GtkIconInfo *icon_info)
+{
+  gint image_width, image_height, image_size;
+  gint scaled_desired_size;
+  GdkPixbuf *source_pixbuf;
+  gint svg_size;
+
+  if (icon_info->pixbuf)
+    {
+      apply_emblems (icon_info);
+      return TRUE;
     }
 
+  if (icon_info->load_error)
+    return FALSE;
+
+  if (icon_info->icon_file && !icon_info->loadable)
+    icon_info->loadable = G_LOADABLE_ICON (g_file_icon_new (icon_info->icon_file));
+
+  scaled_desired_size = icon_info->desired_size * icon_info->desired_scale;
+
+  icon_info->scale = icon_info_compute_scale (icon_info, &svg_size);
+
   /* At this point, we need to actually get the icon; either from the
    * builtin image or by loading the file
    */
   source_pixbuf = NULL;
   if (icon_info->cache_pixbuf)
     source_pixbuf = g_object_ref (icon_info->cache_pixbuf);
+  else if (icon_info->cache_surface && !icon_info->is_svg)
+    source_pixbuf = gdk_pixbuf_get_from_surface (icon_info->cache_surface, 0, 0,
+                                                 cairo_image_surface_get_width (icon_info->cache_surface),
+                                                 cairo_image_surface_get_height (icon_info->cache_surface));
   else if (icon_info->is_resource)
     {
       if (icon_info->is_svg)
         {
-          gint size;
-
-          if (icon_info->forced_size)
-            size = scaled_desired_size;
-          else
-            size = icon_info->dir_size * dir_scale * icon_info->scale;
           source_pixbuf = gdk_pixbuf_new_from_resource_at_scale (icon_info->filename,
-                                                                 size, size, TRUE,
+                                                                 svg_size, svg_size, TRUE,
                                                                  &icon_info->load_error);
         }
       else
@@ -3882,14 +4922,8 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo *icon_info)
            */
           if (icon_info->is_svg)
             {
-              gint size;
-
-              if (icon_info->forced_size)
-                size = scaled_desired_size;
-              else
-                size = icon_info->dir_size * dir_scale * icon_info->scale;
               source_pixbuf = gdk_pixbuf_new_from_stream_at_scale (stream,
-                                                                   size, size,
+                                                                   svg_size, svg_size,
                                                                    TRUE, NULL,
                                                                    &icon_info->load_error);
             }
@@ -4067,6 +5101,26 @@ gtk_icon_info_load_surface (GtkIconInfo  *icon_info,
   g_return_val_if_fail (icon_info != NULL, NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+  /* Use the pixels from the icon cache without decoding or copying
+   * them when they are what we would load anyway
+   */
+  if (icon_info->pixbuf == NULL &&
+      !(icon_info->is_svg && icon_uri_is_symbolic (icon_info->filename)) &&
+      icon_info_cache_surface_usable (icon_info))
+    {
+      if (icon_info->is_svg)
+        icon_info->scale = MAX (cairo_image_surface_get_width (icon_info->cache_surface),
+                                cairo_image_surface_get_height (icon_info->cache_surface)) / 1000.;
+      else
+        icon_info->scale = 1.0;
+
+      cairo_surface_set_device_scale (icon_info->cache_surface,
+                                      icon_info->desired_scale,
+                                      icon_info->desired_scale);
+
+      return cairo_surface_reference (icon_info->cache_surface);
+    }
+
   pixbuf = gtk_icon_info_load_icon (icon_info, error);
 
   if (pixbuf == NULL)
@@ -4090,6 +5144,66 @@ load_icon_thread  (GTask        *task,
   g_task_return_pointer (task, NULL, NULL);
 }
 
+static void
+load_icon_thread_done (GObject      *source_object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+  GtkIconInfo *icon_info = GTK_ICON_INFO (source_object);
+  GtkIconInfo *dup = g_task_get_task_data (G_TASK (result));
+  GList *waiters, *l;
+
+  /* Check if someone else updated the icon_info in between */
+  if (!icon_info_get_pixbuf_ready (icon_info))
+    {
+      /* If not, copy results from dup back to icon_info */
+      icon_info->emblems_applied = dup->emblems_applied;
+      icon_info->scale = dup->scale;
+      g_clear_object (&icon_info->pixbuf);
+      if (dup->pixbuf)
+        icon_info->pixbuf = g_object_ref (dup->pixbuf);
+      g_clear_error (&icon_info->load_error);
+      if (dup->load_error)
+        icon_info->load_error = g_error_copy (dup->load_error);
+    }
+
+  g_assert (icon_info_get_pixbuf_ready (icon_info));
+
+  waiters = icon_info->load_waiters;
+  icon_info->load_waiters = NULL;
+
+  for (l = waiters; l != NULL; l = l->next)
+    {
+      GTask *task = l->data;
+      GdkPixbuf *pixbuf;
+      GError *error = NULL;
+
+      /* This is now guaranteed to not block */
+      pixbuf = gtk_icon_info_load_icon (icon_info, &error);
+      if (pixbuf == NULL)
+        g_task_return_error (task, error);
+      else
+        g_task_return_pointer (task, pixbuf, g_object_unref);
+    }
+
+  g_list_free_full (waiters, g_object_unref);
+}
+
+/*
+ * _gtk_icon_info_is_loading:
+ * @icon_info: a #GtkIconInfo
+ *
+ * Returns whether an asynchronous load of @icon_info is currently
+ * running in a thread. Widgets can use this to wait for the result
+ * with gtk_icon_info_load_icon_async() instead of loading the icon
+ * a second time in the main thread.
+ */
+gboolean
+_gtk_icon_info_is_loading (GtkIconInfo *icon_info)
+{
+  return icon_info->load_waiters != NULL;
+}
+
 /**
  * gtk_icon_info_load_icon_async:
  * @icon_info: a #GtkIconInfo from gtk_icon_theme_lookup_icon()
@@ -4101,6 +5215,9 @@ load_icon_thread  (GTask        *task,
  * Asynchronously load, render and scale an icon previously looked up
  * from the icon theme using gtk_icon_theme_lookup_icon().
  *
+ * If the icon is already being loaded asynchronously, no new load is
+ * started and @callback is called when the running one finishes.
+ *
  * For more details, see gtk_icon_info_load_icon() which is the synchronous
  * version of this call.
  *
@@ -4114,7 +5231,6 @@ gtk_icon_info_load_icon_async (GtkIconInfo         *icon_info,
 {
   GTask *task;
   GdkPixbuf *pixbuf;
-  GtkIconInfo *dup;
   GError *error = NULL;
 
   task = g_task_new (icon_info, cancellable, callback, user_data);
@@ -4130,10 +5246,20 @@ gtk_icon_info_load_icon_async (GtkIconInfo         *icon_info,
     }
   else
     {
-      dup = icon_info_dup (icon_info);
-      g_task_set_task_data (task, dup, g_object_unref);
-      g_task_run_in_thread (task, load_icon_thread);
-      g_object_unref (task);
+      /* The thread is shared by all the callers and keeps running;
+       * a cancelled task reports the cancellation once it is done.
+       */
+      if (icon_info->load_waiters == NULL)
+        {
+          GTask *thread_task;
+
+          thread_task = g_task_new (icon_info, NULL, load_icon_thread_done, NULL);
+          g_task_set_task_data (thread_task, icon_info_dup (icon_info), g_object_unref);
+          g_task_run_in_thread (thread_task, load_icon_thread);
+          g_object_unref (thread_task);
+        }
+
+      icon_info->load_waiters = g_list_append (icon_info->load_waiters, task);
     }
 }
 
@@ -4158,35 +5284,9 @@ gtk_icon_info_load_icon_finish (GtkIconInfo   *icon_info,
                                 GAsyncResult  *result,
                                 GError       **error)
 {
-  GTask *task = G_TASK (result);
-  GtkIconInfo *dup;
-
   g_return_val_if_fail (g_task_is_valid (result, icon_info), NULL);
 
-  dup = g_task_get_task_data (task);
-  if (dup == NULL || g_task_had_error (task))
-    return g_task_propagate_pointer (task, error);
-
-  /* We ran the thread and it was not cancelled */
-
-  /* Check if someone else updated the icon_info in between */
-  if (!icon_info_get_pixbuf_ready (icon_info))
-    {
-      /* If not, copy results from dup back to icon_info */
-      icon_info->emblems_applied = dup->emblems_applied;
-      icon_info->scale = dup->scale;
-      g_clear_object (&icon_info->pixbuf);
-      if (dup->pixbuf)
-        icon_info->pixbuf = g_object_ref (dup->pixbuf);
-      g_clear_error (&icon_info->load_error);
-      if (dup->load_error)
-        icon_info->load_error = g_error_copy (dup->load_error);
-    }
-
-  g_assert (icon_info_get_pixbuf_ready (icon_info));
-
-  /* This is now guaranteed to not block */
-  return gtk_icon_info_load_icon (icon_info, error);
+  return g_task_propagate_pointer (G_TASK (result), error);
 }
 
 static void
@@ -4239,24 +5339,13 @@ symbolic_cache_get_proxy (SymbolicPixbufCache *symbolic_cache,
   return symbolic_cache->proxy_pixbuf;
 }
 
-static gchar *
-rgba_to_string_noalpha (const GdkRGBA *rgba)
-{
-  GdkRGBA color;
-
-  color = *rgba;
-  color.alpha = 1.0;
-
-  return gdk_rgba_to_string (&color);
-}
-
 static void
 rgba_to_pixel(const GdkRGBA  *rgba,
 	      guint8 pixel[4])
 {
-  pixel[0] = rgba->red * 255;
-  pixel[1] = rgba->green * 255;
-  pixel[2] = rgba->blue * 255;
+  pixel[0] = CLAMP (rgba->red, 0, 1) * 255 + 0.5;
+  pixel[1] = CLAMP (rgba->green, 0, 1) * 255 + 0.5;
+  pixel[2] = CLAMP (rgba->blue, 0, 1) * 255 + 0.5;
   pixel[3] = 255;
 }
 
@@ -4274,7 +5363,7 @@ color_symbolic_pixbuf (GdkPixbuf *symbolic,
   GdkPixbuf *colored;
   guint8 fg_pixel[4], success_pixel[4], warning_pixel[4], error_pixel[4];
 
-  alpha = fg_color->alpha * 255;
+  alpha = CLAMP (fg_color->alpha, 0, 1) * 255 + 0.5;
 
   rgba_to_pixel (fg_color, fg_pixel);
   rgba_to_pixel (success_color, success_pixel);
@@ -4324,15 +5413,17 @@ color_symbolic_pixbuf (GdkPixbuf *symbolic,
                 }
               else
                 {
-                  c1 = 255 - c2 - c3 - c4;
+                  /* Rounding in the mask can make the channels
+                   * add up to slightly more than 255 */
+                  c1 = MAX (255 - c2 - c3 - c4, 0);
 
                   r = fg_pixel[0] * c1 + success_pixel[0] * c2 +  warning_pixel[0] * c3 +  error_pixel[0] * c4;
                   g = fg_pixel[1] * c1 + success_pixel[1] * c2 +  warning_pixel[1] * c3 +  error_pixel[1] * c4;
                   b = fg_pixel[2] * c1 + success_pixel[2] * c2 +  warning_pixel[2] * c3 +  error_pixel[2] * c4;
 
-                  dst_row[0] = r / 255;
-                  dst_row[1] = g / 255;
-                  dst_row[2] = b / 255;
+                  dst_row[0] = MIN (r / 255, 255);
+                  dst_row[1] = MIN (g / 255, 255);
+                  dst_row[2] = MIN (b / 255, 255);
                 }
             }
 
@@ -4382,53 +5473,77 @@ gtk_icon_info_load_symbolic_png (GtkIconInfo    *icon_info,
                                 error_color ? error_color : &error_default);
 }
 
-static GdkPixbuf *
-gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
-                                 const GdkRGBA  *fg,
-                                 const GdkRGBA  *success_color,
-                                 const GdkRGBA  *warning_color,
-                                 const GdkRGBA  *error_color,
-                                 GError        **error)
+static gchar *
+rgba_to_string_noalpha (const GdkRGBA *rgba)
 {
-  GInputStream *stream;
-  GdkPixbuf *pixbuf;
-  gchar *css_fg;
-  gchar *css_success;
-  gchar *css_warning;
-  gchar *css_error;
-  gchar *data;
-  gchar *size;
-  gchar *file_data, *escaped_file_data;
-  gsize file_len;
-  double alpha;
-  gchar alphastr[G_ASCII_DTOSTR_BUF_SIZE];
+  GdkRGBA color;
 
-  alpha = fg->alpha;
+  color = *rgba;
+  color.alpha = 1.0;
 
-  css_fg = rgba_to_string_noalpha (fg);
+  return gdk_rgba_to_string (&color);
+}
 
-  css_success = css_warning = css_error = NULL;
+/* The mask holds the amount of the foreground and of the success,
+ * warning and error colors in each pixel, which only works when all
+ * of the icon is drawn with fills that the style sheet overrides.
+ * Strokes and images keep colors of their own, so svgs using them
+ * are rendered with the final colors instead.
+ */
+static gboolean
+symbolic_svg_can_use_mask (const gchar *data,
+                           gsize        len)
+{
+  const gchar *p, *end;
 
-  if (warning_color)
-    css_warning = rgba_to_string_noalpha (warning_color);
-  else
-    css_warning = g_strdup ("rgb(245,121,62)");
+  end = data + len;
+  for (p = data; p < end; p++)
+    {
+      if (end - p >= 6 && strncmp (p, "<image", 6) == 0)
+        return FALSE;
 
-  if (error_color)
-    css_error = rgba_to_string_noalpha (error_color);
-  else
-    css_error = g_strdup ("rgb(204,0,0)");
+      if (end - p >= 6 && strncmp (p, "stroke", 6) == 0)
+        {
+          const gchar *value = p + 6;
 
-  if (success_color)
-    css_success = rgba_to_string_noalpha (success_color);
-  else
-    css_success = g_strdup ("rgb(78,154,6)");
+          /* Either a stroke attribute or a stroke property,
+           * stroke-width and friends don't paint anything
+           */
+          while (value < end && g_ascii_isspace (*value))
+            value++;
+          if (value == end || (*value != '=' && *value != ':'))
+            continue;
 
-  if (!g_file_load_contents (icon_info->icon_file, NULL, &file_data, &file_len, NULL, error))
-    return NULL;
+          value++;
+          while (value < end && (g_ascii_isspace (*value) || *value == '"' || *value == '\''))
+            value++;
+          if (end - value < 4 || strncmp (value, "none", 4) != 0)
+            return FALSE;
+        }
+    }
 
-  if (!icon_info_ensure_scale_and_pixbuf (icon_info))
-    return NULL;
+  return TRUE;
+}
+
+static GdkPixbuf *
+render_symbolic_svg (GtkIconInfo  *icon_info,
+                     const gchar  *file_data,
+                     gsize         file_len,
+                     const gchar  *css_fg,
+                     const gchar  *css_success,
+                     const gchar  *css_warning,
+                     const gchar  *css_error,
+                     gdouble       alpha,
+                     gint          width,
+                     gint          height,
+                     GError      **error)
+{
+  GInputStream *stream;
+  GdkPixbuf *pixbuf;
+  gchar *data;
+  gchar *size;
+  gchar *escaped_file_data;
+  gchar alphastr[G_ASCII_DTOSTR_BUF_SIZE];
 
   if (icon_info->symbolic_size == 0)
     {
@@ -4456,7 +5571,6 @@ gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
   size = g_strdup_printf ("%d", icon_info->symbolic_size);
 
   escaped_file_data = g_markup_escape_text (file_data, file_len);
-  g_free (file_data);
 
   g_ascii_dtostr (alphastr, G_ASCII_DTOSTR_BUF_SIZE, CLAMP (alpha, 0, 1));
 
@@ -4467,14 +5581,14 @@ gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
                       "     width=\"", size, "\"\n"
                       "     height=\"", size, "\">\n"
                       "  <style type=\"text/css\">\n"
-                      "    rect,path {\n"
-                      "      fill: ", css_fg," !important;\n"
+                      "    rect,circle,ellipse,line,polyline,polygon,path,text,tspan,textPath {\n"
+                      "      fill: ", css_fg, " !important;\n"
                       "    }\n"
                       "    .warning {\n"
                       "      fill: ", css_warning, " !important;\n"
                       "    }\n"
                       "    .error {\n"
-                      "      fill: ", css_error ," !important;\n"
+                      "      fill: ", css_error, " !important;\n"
                       "    }\n"
                       "    .success {\n"
                       "      fill: ", css_success, " !important;\n"
@@ -4484,16 +5598,12 @@ gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
                       "</svg>",
                       NULL);
   g_free (escaped_file_data);
-  g_free (css_fg);
-  g_free (css_warning);
-  g_free (css_error);
-  g_free (css_success);
   g_free (size);
 
   stream = g_memory_input_stream_new_from_data (data, -1, g_free);
   pixbuf = gdk_pixbuf_new_from_stream_at_scale (stream,
-                                                gdk_pixbuf_get_width (icon_info->pixbuf),
-                                                gdk_pixbuf_get_height (icon_info->pixbuf),
+                                                width,
+                                                height,
                                                 TRUE,
                                                 NULL,
                                                 error);
@@ -4502,7 +5612,110 @@ gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
   return pixbuf;
 }
 
+static GdkPixbuf *
+gtk_icon_info_load_symbolic_svg (GtkIconInfo    *icon_info,
+                                 const GdkRGBA  *fg,
+                                 const GdkRGBA  *success_color,
+                                 const GdkRGBA  *warning_color,
+                                 const GdkRGBA  *error_color,
+                                 GError        **error)
+{
+  GdkRGBA success_default = { 78 / 255., 154 / 255., 6 / 255., 1.0 };
+  GdkRGBA warning_default = { 245 / 255., 121 / 255., 62 / 255., 1.0 };
+  GdkRGBA error_default = { 204 / 255., 0, 0, 1.0 };
+  GdkPixbuf *mask;
+  GdkPixbuf *pixbuf;
+  gchar *uri;
+  gchar *file_data;
+  gsize file_len;
+  gint width, height;
+  gboolean use_cache_surface;
+
+  /* A mask from the icon cache spares us rendering the svg even
+   * once to find out its size
+   */
+  use_cache_surface = icon_info->pixbuf == NULL &&
+                      icon_info_cache_surface_usable (icon_info);
+  if (use_cache_surface)
+    {
+      width = cairo_image_surface_get_width (icon_info->cache_surface);
+      height = cairo_image_surface_get_height (icon_info->cache_surface);
+    }
+  else
+    {
+      if (!icon_info_ensure_scale_and_pixbuf (icon_info))
+        return NULL;
+
+      width = gdk_pixbuf_get_width (icon_info->pixbuf);
+      height = gdk_pixbuf_get_height (icon_info->pixbuf);
+    }
+
+  uri = g_file_get_uri (icon_info->icon_file);
+  mask = symbolic_mask_lookup (uri, width, height);
+  if (mask == NULL && use_cache_surface)
+    {
+      mask = gdk_pixbuf_get_from_surface (icon_info->cache_surface, 0, 0, width, height);
+      if (mask != NULL)
+        symbolic_mask_insert (uri, width, height, mask);
+    }
+  else if (mask == NULL)
+    {
+      if (!g_file_load_contents (icon_info->icon_file, NULL, &file_data, &file_len, NULL, error))
+        {
+          g_free (uri);
+          return NULL;
+        }
+
+      if (!symbolic_svg_can_use_mask (file_data, file_len))
+        {
+          gchar *css_fg, *css_success, *css_warning, *css_error;
+
+          css_fg = rgba_to_string_noalpha (fg);
+          css_success = rgba_to_string_noalpha (success_color ? success_color : &success_default);
+          css_warning = rgba_to_string_noalpha (warning_color ? warning_color : &warning_default);
+          css_error = rgba_to_string_noalpha (error_color ? error_color : &error_default);
+
+          pixbuf = render_symbolic_svg (icon_info, file_data, file_len,
+                                        css_fg, css_success, css_warning, css_error,
+                                        fg->alpha, width, height, error);
+
+          g_free (css_fg);
+          g_free (css_success);
+          g_free (css_warning);
+          g_free (css_error);
+          g_free (file_data);
+          g_free (uri);
+
+          return pixbuf;
+        }
+
+      /* The foreground is black and the other colors each get a
+       * channel of their own, so that after blending the channels
+       * hold the amount of each color, just like in .symbolic.png
+       * files.
+       */
+      mask = render_symbolic_svg (icon_info, file_data, file_len,
+                                  "rgb(0,0,0)", "rgb(255,0,0)", "rgb(0,255,0)", "rgb(0,0,255)",
+                                  1.0, width, height, error);
+      g_free (file_data);
+
+      if (mask != NULL)
+        symbolic_mask_insert (uri, width, height, mask);
+    }
+  g_free (uri);
+
+  if (mask == NULL)
+    return NULL;
+
+  pixbuf = color_symbolic_pixbuf (mask,
+                                  fg,
+                                  success_color ? success_color : &success_default,
+                                  warning_color ? warning_color : &warning_default,
+                                  error_color ? error_color : &error_default);
+  g_object_unref (mask);
 
+  return pixbuf;
+}
 
 static GdkPixbuf *
 gtk_icon_info_load_symbolic_internal (GtkIconInfo    *icon_info,
@@ -5266,6 +6479,8 @@ gtk_icon_theme_add_builtin_icon (const gchar *icon_name,
   /* Replaces value, leaves key untouched
    */
   g_hash_table_insert (icon_theme_builtin_icons, key, icons);
+
+  builtin_icons_serial++;
 }
 
 /* Look up a builtin icon; the min_difference_p and
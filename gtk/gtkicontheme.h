@@ -258,6 +258,20 @@ GtkIconInfo * gtk_icon_theme_lookup_by_gicon_for_scale (GtkIconTheme
                                                         gint                      scale,
                                                         GtkIconLookupFlags        flags);
 
+GDK_AVAILABLE_IN_3_16
+void          gtk_icon_theme_preload_icons_async   (GtkIconTheme                *icon_theme,
+                                                    const gchar * const         *icon_names,
+                                                    gint                         size,
+                                                    gint                         scale,
+                                                    GtkIconLookupFlags           flags,
+                                                    GCancellable                *cancellable,
+                                                    GAsyncReadyCallback          callback,
+                                                    gpointer                     user_data);
+GDK_AVAILABLE_IN_3_16
+gboolean      gtk_icon_theme_preload_icons_finish  (GtkIconTheme                *icon_theme,
+                                                    GAsyncResult                *result,
+                                                    GError                     **error);
+
 
 GDK_AVAILABLE_IN_ALL
 GList *       gtk_icon_theme_list_icons            (GtkIconTheme                *icon_theme,
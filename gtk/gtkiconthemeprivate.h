@@ -0,0 +1,46 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_ICON_THEME_PRIVATE_H__
+#define __GTK_ICON_THEME_PRIVATE_H__
+
+#include <gtk/gtkicontheme.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  guint hits;             /* lookups answered from the info cache */
+  guint lookup_hits;      /* lookups answered from earlier results */
+  guint misses;           /* lookups that searched the themes */
+  guint evictions;        /* unused infos dropped to stay in budget */
+  guint lookup_evictions; /* lookup results dropped */
+
+  guint n_unused;         /* unused infos kept around */
+  gsize unused_bytes;     /* memory taken by their pixels */
+  gsize unused_budget;
+  guint n_lookups;        /* lookup results kept around */
+} GtkIconThemeCacheStats;
+
+gboolean _gtk_icon_info_is_loading       (GtkIconInfo            *icon_info);
+
+void     _gtk_icon_theme_get_cache_stats (GtkIconTheme           *icon_theme,
+                                          GtkIconThemeCacheStats *stats);
+
+G_END_DECLS
+
+#endif /* __GTK_ICON_THEME_PRIVATE_H__ */
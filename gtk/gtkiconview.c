@@ -221,6 +221,10 @@ static gboolean             gtk_icon_view_unselect_all_internal          (GtkIco
 static void                 gtk_icon_view_update_rubberband              (gpointer                data);
 static void                 gtk_icon_view_item_invalidate_size           (GtkIconViewItem        *item);
 static void                 gtk_icon_view_invalidate_sizes               (GtkIconView            *icon_view);
+static void                 gtk_icon_view_clear_item_sizes               (GtkIconView            *icon_view);
+static gint                 gtk_icon_view_find_row                       (GtkIconView            *icon_view,
+									  gint                    y,
+									  gint                    extra);
 static void                 gtk_icon_view_add_move_binding               (GtkBindingSet          *binding_set,
 									  guint                   keyval,
 									  guint                   modmask,
@@ -987,6 +991,7 @@ gtk_icon_view_init (GtkIconView *icon_view)
 
   icon_view->priv->row_contexts = 
     g_ptr_array_new_with_free_func ((GDestroyNotify)g_object_unref);
+  icon_view->priv->rows = g_array_new (FALSE, TRUE, sizeof (GtkIconViewRow));
 
   gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (icon_view)),
                                GTK_STYLE_CLASS_VIEW);
@@ -1015,6 +1020,9 @@ gtk_icon_view_dispose (GObject *object)
 
   if (priv->cell_area_context)
     {
+      g_signal_handler_disconnect (priv->cell_area_context, priv->context_changed_id);
+      priv->context_changed_id = 0;
+
       g_object_unref (priv->cell_area_context);
       priv->cell_area_context = NULL;
     }
@@ -1025,6 +1033,15 @@ gtk_icon_view_dispose (GObject *object)
       priv->row_contexts = NULL;
     }
 
+  if (priv->rows)
+    {
+      g_array_free (priv->rows, TRUE);
+      priv->rows = NULL;
+      priv->rows_valid = FALSE;
+    }
+
+  gtk_icon_view_clear_item_sizes (icon_view);
+
   if (priv->cell_area)
     {
       gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
@@ -1371,7 +1388,7 @@ gtk_icon_view_style_updated (GtkWidget *widget)
   GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->style_updated (widget);
 
   _gtk_icon_view_update_background (GTK_ICON_VIEW (widget));
-  gtk_widget_queue_resize (widget);
+  gtk_icon_view_invalidate_sizes (GTK_ICON_VIEW (widget));
 }
 
 static gint
@@ -1505,21 +1522,71 @@ gtk_icon_view_is_empty (GtkIconView *icon_view)
 }
 
 static void
-gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
-                                       GtkOrientation  orientation,
-                                       gint            for_size,
-                                       gint           *minimum,
-                                       gint           *natural)
+gtk_icon_view_clear_item_sizes (GtkIconView *icon_view)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  guint i;
+
+  for (i = 0; i < GTK_ICON_VIEW_N_ITEM_SIZES; i++)
+    g_clear_object (&priv->item_sizes[i].context);
+}
+
+/* Adds a single item to the cached measurements. Like the layout,
+ * this only ever grows them, an item that got smaller is only
+ * accounted for when all sizes are invalidated.
+ */
+static void
+gtk_icon_view_add_item_sizes (GtkIconView     *icon_view,
+                              GtkIconViewItem *item)
 {
   GtkIconViewPrivate *priv = icon_view->priv;
+  gboolean cell_data_set = FALSE;
+  guint i;
+
+  for (i = 0; i < GTK_ICON_VIEW_N_ITEM_SIZES; i++)
+    {
+      GtkIconViewItemSize *size = &priv->item_sizes[i];
+
+      if (size->context == NULL)
+        continue;
+
+      if (!cell_data_set)
+        {
+          _gtk_icon_view_set_cell_data (icon_view, item);
+          cell_data_set = TRUE;
+        }
+
+      if (size->for_size > 0)
+        cell_area_get_preferred_size (icon_view, size->context, 1 - size->orientation, -1, NULL, NULL);
+      cell_area_get_preferred_size (icon_view, size->context, size->orientation, size->for_size, NULL, NULL);
+    }
+}
+
+static GtkCellAreaContext *
+gtk_icon_view_get_item_size_context (GtkIconView    *icon_view,
+                                     GtkOrientation  orientation,
+                                     gint            for_size)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkIconViewItemSize *size;
   GtkCellAreaContext *context;
   GList *items;
+  guint i;
 
-  g_assert (!gtk_icon_view_is_empty (icon_view));
+  if (for_size <= 0)
+    for_size = -1;
 
-  context = gtk_cell_area_create_context (priv->cell_area);
+  for (i = 0; i < GTK_ICON_VIEW_N_ITEM_SIZES; i++)
+    {
+      size = &priv->item_sizes[i];
 
-  for_size -= 2 * priv->item_padding;
+      if (size->context &&
+          size->orientation == orientation &&
+          size->for_size == for_size)
+        return size->context;
+    }
+
+  context = gtk_cell_area_create_context (priv->cell_area);
 
   if (for_size > 0)
     {
@@ -1543,6 +1610,35 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
       cell_area_get_preferred_size (icon_view, context, orientation, for_size, NULL, NULL);
     }
 
+  /* Replace the oldest entry */
+  size = &priv->item_sizes[priv->next_item_size];
+  priv->next_item_size = (priv->next_item_size + 1) % GTK_ICON_VIEW_N_ITEM_SIZES;
+
+  if (size->context)
+    g_object_unref (size->context);
+  size->context = context;
+  size->orientation = orientation;
+  size->for_size = for_size;
+
+  return context;
+}
+
+static void
+gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
+                                       GtkOrientation  orientation,
+                                       gint            for_size,
+                                       gint           *minimum,
+                                       gint           *natural)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  GtkCellAreaContext *context;
+
+  g_assert (!gtk_icon_view_is_empty (icon_view));
+
+  for_size -= 2 * priv->item_padding;
+
+  context = gtk_icon_view_get_item_size_context (icon_view, orientation, for_size);
+
   if (orientation == GTK_ORIENTATION_HORIZONTAL)
     {
       if (for_size > 0)
@@ -1576,8 +1672,6 @@ gtk_icon_view_get_preferred_item_size (GtkIconView    *icon_view,
     *minimum = MAX (1, *minimum + 2 * priv->item_padding);
   if (natural)
     *natural = MAX (1, *natural + 2 * priv->item_padding);
-
-  g_object_unref (context);
 }
 
 static void
@@ -1866,6 +1960,8 @@ gtk_icon_view_draw (GtkWidget *widget,
   GtkIconViewDropPosition dest_pos;
   GtkIconViewItem *dest_item = NULL;
   GtkStyleContext *context;
+  GdkRectangle clip;
+  gint n_items;
 
   icon_view = GTK_ICON_VIEW (widget);
 
@@ -1894,11 +1990,34 @@ gtk_icon_view_draw (GtkWidget *widget,
   else
     dest_index = -1;
 
-  for (icons = icon_view->priv->items; icons; icons = icons->next)
+  /* Skip the rows above the area to be drawn */
+  if (icon_view->priv->rows_valid && gdk_cairo_get_clip_rectangle (cr, &clip))
+    {
+      guint row;
+
+      row = gtk_icon_view_find_row (icon_view, clip.y, icon_view->priv->item_padding);
+      if (row < icon_view->priv->rows->len)
+        icons = g_array_index (icon_view->priv->rows, GtkIconViewRow, row).first;
+      else
+        icons = NULL;
+    }
+  else
+    {
+      icons = icon_view->priv->items;
+      clip.y = G_MININT;
+      clip.height = 0;
+    }
+
+  for (n_items = 0; icons; icons = icons->next, n_items++)
     {
       GtkIconViewItem *item = icons->data;
       GdkRectangle paint_area;
 
+      /* and stop at the first row below it */
+      if (clip.height > 0 && n_items % icon_view->priv->layout_columns == 0 &&
+          item->cell_area.y - icon_view->priv->item_padding >= clip.y + clip.height)
+        break;
+
       paint_area.x      = item->cell_area.x      - icon_view->priv->item_padding;
       paint_area.y      = item->cell_area.y      - icon_view->priv->item_padding;
       paint_area.width  = item->cell_area.width  + icon_view->priv->item_padding * 2;
@@ -2957,10 +3076,12 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   GtkWidget *widget = GTK_WIDGET (icon_view);
   GList *items;
   gint item_width; /* this doesn't include item_padding */
-  gint n_columns, n_rows, n_items;
+  gint n_columns, n_rows, n_items, n_measured_rows;
   gint col, row;
   GtkRequestedSize *sizes;
-  gboolean rtl;
+  gboolean rtl, measure_all;
+
+  priv->rows_valid = FALSE;
 
   if (gtk_icon_view_is_empty (icon_view))
     return;
@@ -2979,22 +3100,69 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   priv->width += 2 * priv->margin;
   priv->width = MAX (priv->width, gtk_widget_get_allocated_width (widget));
 
-  /* Clear the per row contexts */
-  g_ptr_array_set_size (icon_view->priv->row_contexts, 0);
+  /* The widths of all items go into one context, which the per row
+   * contexts are copied from. It is only rebuilt from scratch when
+   * the sizes got invalidated, otherwise only the items that changed
+   * since the last layout are added to it, and the rows only need to
+   * be measured again if the aligned widths changed.
+   */
+  measure_all = !priv->context_valid ||
+                n_columns != priv->layout_columns ||
+                item_width != priv->layout_item_width;
+
+  if (!priv->context_valid)
+    {
+      g_signal_handler_block (priv->cell_area_context, priv->context_changed_id);
+      gtk_cell_area_context_reset (priv->cell_area_context);
+      g_signal_handler_unblock (priv->cell_area_context, priv->context_changed_id);
 
-  gtk_cell_area_context_reset (priv->cell_area_context);
-  /* because layouting is complicated. We designed an API
-   * that is O(N²) and nonsensical.
-   * And we're proud of it. */
-  for (items = priv->items; items; items = items->next)
+      /* because layouting is complicated. We designed an API
+       * that is O(N²) and nonsensical.
+       * And we're proud of it. */
+      for (items = priv->items; items; items = items->next)
+        {
+          _gtk_icon_view_set_cell_data (icon_view, items->data);
+          gtk_cell_area_get_preferred_width (priv->cell_area,
+                                             priv->cell_area_context,
+                                             widget,
+                                             NULL, NULL);
+        }
+
+      priv->context_valid = TRUE;
+    }
+  else
     {
-      _gtk_icon_view_set_cell_data (icon_view, items->data);
-      gtk_cell_area_get_preferred_width (priv->cell_area,
-                                         priv->cell_area_context,
-                                         widget,
-                                         NULL, NULL);
+      gint old_min, old_nat, min, nat;
+
+      gtk_cell_area_context_get_preferred_width (priv->cell_area_context, &old_min, &old_nat);
+
+      for (items = priv->items; items; items = items->next)
+        {
+          GtkIconViewItem *item = items->data;
+
+          if (item->cell_area.width >= 0)
+            continue;
+
+          _gtk_icon_view_set_cell_data (icon_view, item);
+          gtk_cell_area_get_preferred_width (priv->cell_area,
+                                             priv->cell_area_context,
+                                             widget,
+                                             NULL, NULL);
+        }
+
+      gtk_cell_area_context_get_preferred_width (priv->cell_area_context, &min, &nat);
+      if (min != old_min || nat != old_nat)
+        measure_all = TRUE;
     }
 
+  if (measure_all)
+    g_ptr_array_set_size (priv->row_contexts, 0);
+  else if (priv->row_contexts->len > n_rows)
+    g_ptr_array_set_size (priv->row_contexts, n_rows);
+  n_measured_rows = priv->row_contexts->len;
+
+  g_array_set_size (priv->rows, n_rows);
+
   sizes = g_newa (GtkRequestedSize, n_rows);
   items = priv->items;
   priv->height = priv->margin;
@@ -3002,29 +3170,68 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   /* Collect the heights for all rows */
   for (row = 0; row < n_rows; row++)
     {
-      GtkCellAreaContext *context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
-      g_ptr_array_add (priv->row_contexts, context);
+      GtkIconViewRow *icon_row = &g_array_index (priv->rows, GtkIconViewRow, row);
+      GList *first = items;
+      gboolean dirty = row >= n_measured_rows;
 
+      /* A row needs to be measured again if any of its items
+       * changed or moved in from elsewhere */
       for (col = 0; col < n_columns && items; col++, items = items->next)
         {
           GtkIconViewItem *item = items->data;
 
-          _gtk_icon_view_set_cell_data (icon_view, item);
-          gtk_cell_area_get_preferred_height_for_width (priv->cell_area,
-                                                        context,
-                                                        widget,
-                                                        item_width, 
-                                                        NULL, NULL);
+          if (item->cell_area.width < 0 ||
+              item->row != row ||
+              item->col != (rtl ? n_columns - 1 - col : col))
+            dirty = TRUE;
         }
-      
+
+      if (col != icon_row->n_items)
+        dirty = TRUE;
+
+      icon_row->first = first;
+      icon_row->n_items = col;
+
+      if (dirty)
+        {
+          GtkCellAreaContext *context = gtk_cell_area_copy_context (priv->cell_area, priv->cell_area_context);
+          GList *l;
+
+          if (row < n_measured_rows)
+            {
+              g_object_unref (g_ptr_array_index (priv->row_contexts, row));
+              g_ptr_array_index (priv->row_contexts, row) = context;
+            }
+          else
+            g_ptr_array_add (priv->row_contexts, context);
+
+          for (l = first; l != items; l = l->next)
+            {
+              GtkIconViewItem *item = l->data;
+
+              _gtk_icon_view_set_cell_data (icon_view, item);
+              gtk_cell_area_get_preferred_height_for_width (priv->cell_area,
+                                                            context,
+                                                            widget,
+                                                            item_width, 
+                                                            NULL, NULL);
+            }
+
+          gtk_cell_area_context_get_preferred_height_for_width (context,
+                                                                item_width,
+                                                                &icon_row->minimum_height,
+                                                                &icon_row->natural_height);
+        }
+
       sizes[row].data = GINT_TO_POINTER (row);
-      gtk_cell_area_context_get_preferred_height_for_width (context,
-                                                            item_width,
-                                                            &sizes[row].minimum_size,
-                                                            &sizes[row].natural_size);
+      sizes[row].minimum_size = icon_row->minimum_height;
+      sizes[row].natural_size = icon_row->natural_height;
       priv->height += sizes[row].minimum_size + 2 * priv->item_padding + priv->row_spacing;
     }
 
+  priv->layout_columns = n_columns;
+  priv->layout_item_width = item_width;
+
   priv->height -= priv->row_spacing;
   priv->height += priv->margin;
   priv->height = MIN (priv->height, gtk_widget_get_allocated_height (widget));
@@ -3041,11 +3248,19 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 
   for (row = 0; row < n_rows; row++)
     {
+      GtkIconViewRow *icon_row = &g_array_index (priv->rows, GtkIconViewRow, row);
       GtkCellAreaContext *context = g_ptr_array_index (priv->row_contexts, row);
-      gtk_cell_area_context_allocate (context, item_width, sizes[row].minimum_size);
+      gint allocated_width, allocated_height;
+
+      gtk_cell_area_context_get_allocation (context, &allocated_width, &allocated_height);
+      if (allocated_width != item_width || allocated_height != sizes[row].minimum_size)
+        gtk_cell_area_context_allocate (context, item_width, sizes[row].minimum_size);
 
       priv->height += priv->item_padding;
 
+      icon_row->y = priv->height;
+      icon_row->height = sizes[row].minimum_size;
+
       for (col = 0; col < n_columns && items; col++, items = items->next)
         {
           GtkIconViewItem *item = items->data;
@@ -3069,11 +3284,44 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   priv->height -= priv->row_spacing;
   priv->height += priv->margin;
   priv->height = MAX (priv->height, gtk_widget_get_allocated_height (widget));
+
+  priv->rows_valid = TRUE;
+}
+
+/* Returns the first row whose area, extended by @extra on both
+ * sides, does not end before @y.
+ */
+static gint
+gtk_icon_view_find_row (GtkIconView *icon_view,
+                        gint         y,
+                        gint         extra)
+{
+  GtkIconViewPrivate *priv = icon_view->priv;
+  guint lo, hi;
+
+  lo = 0;
+  hi = priv->rows->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      GtkIconViewRow *row = &g_array_index (priv->rows, GtkIconViewRow, mid);
+
+      if (row->y + row->height + extra < y)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
 }
 
 static void
 gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
 {
+  gtk_icon_view_clear_item_sizes (icon_view);
+  icon_view->priv->context_valid = FALSE;
+
   /* Clear all item sizes */
   g_list_foreach (icon_view->priv->items,
 		  (GFunc)gtk_icon_view_item_invalidate_size, NULL);
@@ -3082,6 +3330,40 @@ gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
   gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 }
 
+/* Invalidates the size of a single item, after it changed or
+ * got inserted. Everything else is kept and only grows.
+ */
+static void
+gtk_icon_view_invalidate_item_size (GtkIconView     *icon_view,
+                                    GtkIconViewItem *item)
+{
+  /* The wrap width of the text is guessed from the first item */
+  if (item->index == 0)
+    {
+      gtk_icon_view_invalidate_sizes (icon_view);
+      return;
+    }
+
+  gtk_icon_view_add_item_sizes (icon_view, item);
+  gtk_icon_view_item_invalidate_size (item);
+
+  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+}
+
+static void
+gtk_icon_view_context_changed (GtkCellAreaContext *context,
+                               GParamSpec         *pspec,
+                               GtkIconView        *icon_view)
+{
+  gint minimum;
+
+  /* The cell area resets all of its contexts when the layout
+   * of its cells changes, so all cached sizes are gone */
+  gtk_cell_area_context_get_preferred_width (context, &minimum, NULL);
+  if (minimum == 0)
+    gtk_icon_view_invalidate_sizes (icon_view);
+}
+
 static void
 gtk_icon_view_item_invalidate_size (GtkIconViewItem *item)
 {
@@ -3307,6 +3589,57 @@ gtk_icon_view_item_free (GtkIconViewItem *item)
   g_slice_free (GtkIconViewItem, item);
 }
 
+static gboolean
+gtk_icon_view_item_contains (GtkIconView     *icon_view,
+                             GtkIconViewItem *item,
+                             gint             x,
+                             gint             y)
+{
+  GdkRectangle *item_area = &item->cell_area;
+
+  return x >= item_area->x - icon_view->priv->column_spacing/2 && 
+         x <= item_area->x + item_area->width + icon_view->priv->column_spacing/2 &&
+         y >= item_area->y - icon_view->priv->row_spacing/2 && 
+         y <= item_area->y + item_area->height + icon_view->priv->row_spacing/2;
+}
+
+static GtkIconViewItem *
+gtk_icon_view_item_at_coords (GtkIconView      *icon_view,
+                              GtkIconViewItem  *item,
+                              gint              x,
+                              gint              y,
+                              gboolean          only_in_cell,
+                              GtkCellRenderer **cell_at_pos)
+{
+  GdkRectangle *item_area = &item->cell_area;
+
+  if (only_in_cell || cell_at_pos)
+    {
+      GtkCellRenderer *cell = NULL;
+      GtkCellAreaContext *context;
+
+      context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
+      _gtk_icon_view_set_cell_data (icon_view, item);
+
+      if (x >= item_area->x && x <= item_area->x + item_area->width &&
+          y >= item_area->y && y <= item_area->y + item_area->height)
+        cell = gtk_cell_area_get_cell_at_position (icon_view->priv->cell_area, context,
+                                                   GTK_WIDGET (icon_view),
+                                                   item_area,
+                                                   x, y, NULL);
+
+      if (cell_at_pos)
+        *cell_at_pos = cell;
+
+      if (only_in_cell)
+        return cell != NULL ? item : NULL;
+      else
+        return item;
+    }
+
+  return item;
+}
+
 GtkIconViewItem *
 _gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
                                    gint                  x,
@@ -3314,47 +3647,45 @@ _gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
                                    gboolean              only_in_cell,
                                    GtkCellRenderer     **cell_at_pos)
 {
+  GtkIconViewPrivate *priv = icon_view->priv;
   GList *items;
 
   if (cell_at_pos)
     *cell_at_pos = NULL;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  if (priv->rows_valid)
     {
-      GtkIconViewItem *item = items->data;
-      GdkRectangle    *item_area = &item->cell_area;
+      guint row;
 
-      if (x >= item_area->x - icon_view->priv->column_spacing/2 && 
-	  x <= item_area->x + item_area->width + icon_view->priv->column_spacing/2 &&
-	  y >= item_area->y - icon_view->priv->row_spacing/2 && 
-	  y <= item_area->y + item_area->height + icon_view->priv->row_spacing/2)
-	{
-	  if (only_in_cell || cell_at_pos)
-	    {
-	      GtkCellRenderer *cell = NULL;
-	      GtkCellAreaContext *context;
+      /* Only look at the rows that can contain @y */
+      for (row = gtk_icon_view_find_row (icon_view, y, priv->row_spacing/2);
+           row < priv->rows->len;
+           row++)
+        {
+          GtkIconViewRow *icon_row = &g_array_index (priv->rows, GtkIconViewRow, row);
+          gint i;
 
-	      context = g_ptr_array_index (icon_view->priv->row_contexts, item->row);
-	      _gtk_icon_view_set_cell_data (icon_view, item);
+          if (icon_row->y - priv->row_spacing/2 > y)
+            break;
 
-	      if (x >= item_area->x && x <= item_area->x + item_area->width &&
-		  y >= item_area->y && y <= item_area->y + item_area->height)
-		cell = gtk_cell_area_get_cell_at_position (icon_view->priv->cell_area, context,
-							   GTK_WIDGET (icon_view),
-							   item_area,
-							   x, y, NULL);
+          for (i = 0, items = icon_row->first; i < icon_row->n_items; i++, items = items->next)
+            {
+              if (gtk_icon_view_item_contains (icon_view, items->data, x, y))
+                return gtk_icon_view_item_at_coords (icon_view, items->data, x, y,
+                                                     only_in_cell, cell_at_pos);
+            }
+        }
 
-	      if (cell_at_pos)
-		*cell_at_pos = cell;
+      return NULL;
+    }
 
-	      if (only_in_cell)
-		return cell != NULL ? item : NULL;
-	      else
-		return item;
-	    }
-	  return item;
-	}
+  for (items = priv->items; items; items = items->next)
+    {
+      if (gtk_icon_view_item_contains (icon_view, items->data, x, y))
+        return gtk_icon_view_item_at_coords (icon_view, items->data, x, y,
+                                             only_in_cell, cell_at_pos);
     }
+
   return NULL;
 }
 
@@ -3429,6 +3760,8 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
                            gpointer      data)
 {
   GtkIconView *icon_view = GTK_ICON_VIEW (data);
+  GtkIconViewItem *item;
+  gint index;
 
   /* ignore changes in branches */
   if (gtk_tree_path_get_depth (path) > 1)
@@ -3441,15 +3774,14 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
   if (icon_view->priv->cell_area)
     gtk_cell_area_stop_editing (icon_view->priv->cell_area, TRUE);
 
-  /* Here we can use a "grow-only" strategy for optimization
-   * and only invalidate a single item and queue a relayout
-   * instead of invalidating the whole thing.
-   *
-   * For now GtkIconView still cant deal with huge models
-   * so just invalidate the whole thing when the model
-   * changes.
+  /* Use a "grow-only" strategy and only invalidate the changed
+   * item, the relayout will then only measure the item and its
+   * row again instead of the whole thing.
    */
-  gtk_icon_view_invalidate_sizes (icon_view);
+  index = gtk_tree_path_get_indices (path)[0];
+  item = g_list_nth_data (icon_view->priv->items, index);
+  if (item)
+    gtk_icon_view_invalidate_item_size (icon_view, item);
 
   verify_items (icon_view);
 }
@@ -3492,7 +3824,8 @@ gtk_icon_view_row_inserted (GtkTreeModel *model,
     
   verify_items (icon_view);
 
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+  icon_view->priv->rows_valid = FALSE;
+  gtk_icon_view_invalidate_item_size (icon_view, g_list_nth_data (icon_view->priv->items, index));
 }
 
 static void
@@ -3543,7 +3876,9 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
 
   verify_items (icon_view);  
   
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+  /* The remaining items may be smaller */
+  icon_view->priv->rows_valid = FALSE;
+  gtk_icon_view_invalidate_sizes (icon_view);
 
   if (emit)
     g_signal_emit (icon_view, icon_view_signals[SELECTION_CHANGED], 0);
@@ -3591,7 +3926,14 @@ gtk_icon_view_rows_reordered (GtkTreeModel *model,
   g_list_free (icon_view->priv->items);
   icon_view->priv->items = items;
 
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+  /* The item sizes stay the same, the relayout picks up the moved
+   * items. The text wrap width is guessed from the first item though.
+   */
+  icon_view->priv->rows_valid = FALSE;
+  if (length > 0 && new_order[0] != 0)
+    gtk_icon_view_invalidate_sizes (icon_view);
+  else
+    gtk_widget_queue_resize (GTK_WIDGET (icon_view));
 
   verify_items (icon_view);  
 }
@@ -4309,6 +4651,9 @@ gtk_icon_view_ensure_cell_area (GtkIconView *icon_view,
     gtk_orientable_set_orientation (GTK_ORIENTABLE (priv->cell_area), priv->item_orientation);
 
   priv->cell_area_context = gtk_cell_area_create_context (priv->cell_area);
+  priv->context_changed_id =
+    g_signal_connect (priv->cell_area_context, "notify::minimum-width",
+                      G_CALLBACK (gtk_icon_view_context_changed), icon_view);
 
   priv->add_editable_id =
     g_signal_connect (priv->cell_area, "add-editable",
@@ -5043,6 +5388,7 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
       
       g_list_free_full (icon_view->priv->items, (GDestroyNotify) gtk_icon_view_item_free);
       icon_view->priv->items = NULL;
+      icon_view->priv->rows_valid = FALSE;
       icon_view->priv->anchor_item = NULL;
       icon_view->priv->cursor_item = NULL;
       icon_view->priv->last_single_clicked = NULL;
@@ -5081,7 +5427,7 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
   if (dirty)
     g_signal_emit (icon_view, icon_view_signals[SELECTION_CHANGED], 0);
 
-  gtk_widget_queue_resize (GTK_WIDGET (icon_view));
+  gtk_icon_view_invalidate_sizes (icon_view);
 }
 
 /**
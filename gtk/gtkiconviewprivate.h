@@ -34,6 +34,39 @@ struct _GtkIconViewItem
 
 };
 
+/* One row of items, as placed by the last layout. The rows double
+ * as a spatial index: they are sorted by y, so hit testing and
+ * drawing can binary search them instead of walking all items.
+ */
+typedef struct _GtkIconViewRow GtkIconViewRow;
+struct _GtkIconViewRow
+{
+  GList *first;
+  gint n_items;
+
+  /* the height request of the row, kept so that rows whose items
+   * did not change do not need to be measured again */
+  gint minimum_height;
+  gint natural_height;
+
+  /* the allocated cell area of the row */
+  gint y;
+  gint height;
+};
+
+/* The measurements of all items for one orientation and size,
+ * as used by the size request code.
+ */
+typedef struct _GtkIconViewItemSize GtkIconViewItemSize;
+struct _GtkIconViewItemSize
+{
+  GtkCellAreaContext *context;
+  GtkOrientation orientation;
+  gint for_size;
+};
+
+#define GTK_ICON_VIEW_N_ITEM_SIZES 4
+
 struct _GtkIconViewPrivate
 {
   GtkCellArea        *cell_area;
@@ -44,6 +77,13 @@ struct _GtkIconViewPrivate
   gulong              context_changed_id;
 
   GPtrArray          *row_contexts;
+  GArray             *rows;
+
+  GtkIconViewItemSize item_sizes[GTK_ICON_VIEW_N_ITEM_SIZES];
+  guint               next_item_size;
+
+  gint layout_columns;
+  gint layout_item_width;
 
   gint width, height;
 
@@ -128,6 +168,10 @@ struct _GtkIconViewPrivate
 
   guint doing_rubberband : 1;
 
+  /* cell_area_context holds the widths of all items */
+  guint context_valid : 1;
+  /* the rows point to the current items */
+  guint rows_valid : 1;
 };
 
 void                 _gtk_icon_view_set_cell_data                  (GtkIconView            *icon_view,
@@ -99,6 +99,24 @@ typedef struct
 
   int n_visible_rows;
   gboolean in_widget;
+
+  /* virtual rows */
+  GtkListBoxCreateRowFunc create_row_func;
+  GtkListBoxBindRowFunc bind_row_func;
+  gpointer virtual_rows_target;
+  GDestroyNotify virtual_rows_target_destroy_notify;
+  guint n_virtual_rows;
+  guint virtual_first;
+  GArray *virtual_heights;
+  gint *virtual_height_sums;
+  gint *virtual_count_sums;
+  gboolean virtual_sums_dirty;
+  gint64 virtual_measured_height;
+  guint virtual_n_measured;
+  gint virtual_width;
+  GPtrArray *virtual_pool;
+  guint virtual_tick_id;
+  gboolean virtual_resize_needed;
 } GtkListBoxPrivate;
 
 typedef struct
@@ -259,6 +277,13 @@ static void gtk_list_box_update_row_styles (GtkListBox    *box);
 static void gtk_list_box_update_row_style  (GtkListBox    *box,
                                             GtkListBoxRow *row);
 
+static gint gtk_list_box_get_virtual_row_offset   (GtkListBox    *box,
+                                                   guint          index);
+static void gtk_list_box_allocate_virtual_rows    (GtkListBox    *box,
+                                                   GtkAllocation *allocation);
+static void gtk_list_box_queue_virtual_update     (GtkListBox    *box);
+static void gtk_list_box_clear_virtual_rows       (GtkListBox    *box);
+
 static GParamSpec *properties[LAST_PROPERTY] = { NULL, };
 static guint signals[LAST_SIGNAL] = { 0 };
 static GParamSpec *row_properties[LAST_ROW_PROPERTY] = { NULL, };
@@ -366,6 +391,10 @@ gtk_list_box_finalize (GObject *obj)
   if (priv->update_header_func_target_destroy_notify != NULL)
     priv->update_header_func_target_destroy_notify (priv->update_header_func_target);
 
+  gtk_list_box_clear_virtual_rows (GTK_LIST_BOX (obj));
+
+  if (priv->adjustment)
+    g_signal_handlers_disconnect_by_data (priv->adjustment, obj);
   g_clear_object (&priv->adjustment);
   g_clear_object (&priv->drag_highlighted_row);
 
@@ -635,11 +664,22 @@ GtkListBoxRow *
 gtk_list_box_get_row_at_index (GtkListBox *box,
                                gint        index_)
 {
+  GtkListBoxPrivate *priv;
   GSequenceIter *iter;
 
   g_return_val_if_fail (GTK_IS_LIST_BOX (box), NULL);
 
-  iter = g_sequence_get_iter_at_pos (BOX_PRIV (box)->children, index_);
+  priv = BOX_PRIV (box);
+
+  /* Only the bound rows exist */
+  if (priv->create_row_func != NULL)
+    {
+      if (index_ < (gint) priv->virtual_first)
+        return NULL;
+      index_ -= priv->virtual_first;
+    }
+
+  iter = g_sequence_get_iter_at_pos (priv->children, index_);
   if (!g_sequence_iter_is_end (iter))
     return g_sequence_get (iter);
 
@@ -903,6 +943,12 @@ gtk_list_box_set_placeholder (GtkListBox *box,
 }
 
 
+static void
+gtk_list_box_adjustment_changed (GtkListBox *box)
+{
+  gtk_list_box_queue_virtual_update (box);
+}
+
 /**
  * gtk_list_box_set_adjustment:
  * @box: a #GtkListBox
@@ -929,8 +975,21 @@ gtk_list_box_set_adjustment (GtkListBox    *box,
 
   g_object_ref_sink (adjustment);
   if (priv->adjustment)
-    g_object_unref (priv->adjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->adjustment,
+                                            gtk_list_box_adjustment_changed,
+                                            box);
+      g_object_unref (priv->adjustment);
+    }
   priv->adjustment = adjustment;
+
+  if (priv->adjustment)
+    {
+      g_signal_connect_swapped (priv->adjustment, "value-changed",
+                                G_CALLBACK (gtk_list_box_adjustment_changed), box);
+      g_signal_connect_swapped (priv->adjustment, "changed",
+                                G_CALLBACK (gtk_list_box_adjustment_changed), box);
+    }
 }
 
 /**
@@ -2393,6 +2452,18 @@ gtk_list_box_get_preferred_height_for_width (GtkWidget *widget,
     gtk_widget_get_preferred_height_for_width (priv->placeholder, width,
                                                &minimum_height, NULL);
 
+  /* Unbound rows are accounted for with their last known or
+   * estimated height
+   */
+  if (priv->create_row_func != NULL)
+    {
+      minimum_height += gtk_list_box_get_virtual_row_offset (GTK_LIST_BOX (widget),
+                                                             priv->n_virtual_rows);
+      *minimum_height_out = minimum_height;
+      *natural_height_out = minimum_height;
+      return;
+    }
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -2523,6 +2594,12 @@ gtk_list_box_size_allocate (GtkWidget     *widget,
       child_allocation.y += child_min;
     }
 
+  if (priv->create_row_func != NULL)
+    {
+      gtk_list_box_allocate_virtual_rows (GTK_LIST_BOX (widget), allocation);
+      return;
+    }
+
   for (iter = g_sequence_get_begin_iter (priv->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -2642,6 +2719,591 @@ gtk_list_box_insert (GtkListBox *box,
     }
 }
 
+/* Virtual rows
+ *
+ * In virtual mode, only the rows that are in the visible part of the
+ * list, plus a margin above and below it, exist as children. They are
+ * a contiguous range of indexes, starting at virtual_first, and are
+ * kept in priv->children like other rows. Rows that move out of that
+ * range are unbound and kept in a pool, to be bound to other indexes
+ * later on.
+ *
+ * The heights of rows are remembered once they have been allocated;
+ * rows that haven't been are assumed to have the average height of
+ * the known ones. Offsets are computed with a pair of Fenwick trees
+ * over the known heights and over the number of known heights, so
+ * that finding the row at a given y position stays cheap for long
+ * lists.
+ */
+
+#define VIRTUAL_ROW_DEFAULT_HEIGHT 32
+#define VIRTUAL_ROWS_MIN_MARGIN 256
+#define VIRTUAL_ROWS_MAX_POOL 64
+
+static void
+gtk_list_box_rebuild_virtual_sums (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  gint n = priv->n_virtual_rows;
+  gint i, j;
+
+  g_free (priv->virtual_height_sums);
+  g_free (priv->virtual_count_sums);
+  priv->virtual_height_sums = g_new0 (gint, n + 1);
+  priv->virtual_count_sums = g_new0 (gint, n + 1);
+
+  for (i = 1; i <= n; i++)
+    {
+      gint height = g_array_index (priv->virtual_heights, gint, i - 1);
+
+      if (height >= 0)
+        {
+          priv->virtual_height_sums[i] += height;
+          priv->virtual_count_sums[i] += 1;
+        }
+
+      j = i + (i & -i);
+      if (j <= n)
+        {
+          priv->virtual_height_sums[j] += priv->virtual_height_sums[i];
+          priv->virtual_count_sums[j] += priv->virtual_count_sums[i];
+        }
+    }
+
+  priv->virtual_sums_dirty = FALSE;
+}
+
+static gint
+gtk_list_box_get_virtual_row_estimate (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->virtual_n_measured == 0)
+    return VIRTUAL_ROW_DEFAULT_HEIGHT;
+
+  return priv->virtual_measured_height / priv->virtual_n_measured;
+}
+
+/* Returns the y position of the row at @index */
+static gint
+gtk_list_box_get_virtual_row_offset (GtkListBox *box,
+                                     guint       index)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  gint height = 0;
+  gint count = 0;
+  gint i;
+
+  if (priv->virtual_sums_dirty)
+    gtk_list_box_rebuild_virtual_sums (box);
+
+  for (i = MIN (index, priv->n_virtual_rows); i > 0; i -= i & -i)
+    {
+      height += priv->virtual_height_sums[i];
+      count += priv->virtual_count_sums[i];
+    }
+
+  return height + ((gint) index - count) * gtk_list_box_get_virtual_row_estimate (box);
+}
+
+/* Returns the index of the row at position @y */
+static guint
+gtk_list_box_get_virtual_row_at_y (GtkListBox *box,
+                                   gint        y)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint lo, hi, mid;
+
+  if (priv->n_virtual_rows == 0)
+    return 0;
+
+  lo = 0;
+  hi = priv->n_virtual_rows - 1;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo + 1) / 2;
+      if (gtk_list_box_get_virtual_row_offset (box, mid) <= y)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  return lo;
+}
+
+/* Records the allocated height of the row at @index, returns
+ * %TRUE if it was different from what was known before.
+ */
+static gboolean
+gtk_list_box_set_virtual_row_height (GtkListBox *box,
+                                     guint       index,
+                                     gint        height)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  gint old_height;
+  gint height_delta;
+  gint count_delta;
+  gint i;
+
+  old_height = g_array_index (priv->virtual_heights, gint, index);
+  if (old_height == height)
+    return FALSE;
+
+  if (old_height < 0)
+    {
+      height_delta = height;
+      count_delta = 1;
+      priv->virtual_n_measured++;
+    }
+  else
+    {
+      height_delta = height - old_height;
+      count_delta = 0;
+    }
+
+  priv->virtual_measured_height += height_delta;
+  g_array_index (priv->virtual_heights, gint, index) = height;
+
+  if (!priv->virtual_sums_dirty)
+    {
+      for (i = index + 1; i <= (gint) priv->n_virtual_rows; i += i & -i)
+        {
+          priv->virtual_height_sums[i] += height_delta;
+          priv->virtual_count_sums[i] += count_delta;
+        }
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_list_box_forget_virtual_row_heights (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint i;
+
+  for (i = 0; i < priv->n_virtual_rows; i++)
+    g_array_index (priv->virtual_heights, gint, i) = -1;
+
+  priv->virtual_measured_height = 0;
+  priv->virtual_n_measured = 0;
+  priv->virtual_sums_dirty = TRUE;
+}
+
+/* Computes the range of rows that should be bound */
+static void
+gtk_list_box_get_virtual_range (GtkListBox *box,
+                                guint      *first,
+                                guint      *end)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  gint top, bottom, margin;
+
+  if (priv->n_virtual_rows == 0)
+    {
+      *first = *end = 0;
+      return;
+    }
+
+  if (priv->adjustment)
+    {
+      top = gtk_adjustment_get_value (priv->adjustment);
+      bottom = top + gtk_adjustment_get_page_size (priv->adjustment);
+    }
+  else
+    {
+      top = 0;
+      bottom = gtk_widget_get_allocated_height (GTK_WIDGET (box));
+    }
+
+  margin = MAX (bottom - top, VIRTUAL_ROWS_MIN_MARGIN);
+  top -= margin;
+  bottom += margin;
+
+  *first = gtk_list_box_get_virtual_row_at_y (box, MAX (top, 0));
+  *end = MIN (gtk_list_box_get_virtual_row_at_y (box, bottom) + 1, priv->n_virtual_rows);
+}
+
+static void
+gtk_list_box_unbind_virtual_row (GtkListBox    *box,
+                                 GtkListBoxRow *row)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  g_object_ref (row);
+  gtk_container_remove (GTK_CONTAINER (box), GTK_WIDGET (row));
+  ROW_PRIV (row)->iter = NULL;
+  gtk_list_box_row_set_selected (row, FALSE);
+
+  if (priv->virtual_pool->len < VIRTUAL_ROWS_MAX_POOL)
+    g_ptr_array_add (priv->virtual_pool, row);
+  else
+    {
+      gtk_widget_destroy (GTK_WIDGET (row));
+      g_object_unref (row);
+    }
+}
+
+static void
+gtk_list_box_bind_virtual_row (GtkListBox *box,
+                               guint       index,
+                               gint        position)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkListBoxRow *row;
+
+  if (priv->virtual_pool->len > 0)
+    {
+      row = g_ptr_array_index (priv->virtual_pool, priv->virtual_pool->len - 1);
+      g_ptr_array_remove_index_fast (priv->virtual_pool, priv->virtual_pool->len - 1);
+    }
+  else
+    {
+      GtkWidget *child;
+
+      child = priv->create_row_func (priv->virtual_rows_target);
+      if (GTK_IS_LIST_BOX_ROW (child))
+        row = GTK_LIST_BOX_ROW (child);
+      else
+        {
+          row = GTK_LIST_BOX_ROW (gtk_list_box_row_new ());
+          gtk_widget_show (GTK_WIDGET (row));
+          gtk_container_add (GTK_CONTAINER (row), child);
+        }
+      g_object_ref_sink (row);
+    }
+
+  priv->bind_row_func (row, index, priv->virtual_rows_target);
+  gtk_list_box_insert (box, GTK_WIDGET (row), position);
+  g_object_unref (row);
+}
+
+static void
+gtk_list_box_unbind_virtual_rows_from (GtkListBox *box,
+                                       guint       index)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint end;
+
+  end = priv->virtual_first + g_sequence_get_length (priv->children);
+  while (end > MAX (index, priv->virtual_first))
+    {
+      GSequenceIter *iter;
+
+      iter = g_sequence_iter_prev (g_sequence_get_end_iter (priv->children));
+      gtk_list_box_unbind_virtual_row (box, g_sequence_get (iter));
+      end--;
+    }
+}
+
+/* Binds the rows in the current virtual range, and unbinds the others */
+static void
+gtk_list_box_update_virtual_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint first, end;
+  guint old_first, old_end;
+  guint i;
+
+  gtk_list_box_get_virtual_range (box, &first, &end);
+
+  old_first = priv->virtual_first;
+  old_end = old_first + g_sequence_get_length (priv->children);
+
+  if (first >= old_end || end <= old_first)
+    {
+      gtk_list_box_unbind_virtual_rows_from (box, 0);
+      old_first = old_end = first;
+    }
+  else
+    {
+      for (; old_first < first; old_first++)
+        gtk_list_box_unbind_virtual_row (box, g_sequence_get (g_sequence_get_begin_iter (priv->children)));
+      priv->virtual_first = old_first;
+      gtk_list_box_unbind_virtual_rows_from (box, end);
+      old_end = MIN (old_end, end);
+    }
+
+  for (i = old_first; i > first; i--)
+    gtk_list_box_bind_virtual_row (box, i - 1, 0);
+  for (i = old_end; i < end; i++)
+    gtk_list_box_bind_virtual_row (box, i, -1);
+
+  priv->virtual_first = first;
+}
+
+static gboolean
+gtk_list_box_virtual_tick (GtkWidget     *widget,
+                           GdkFrameClock *frame_clock,
+                           gpointer       user_data)
+{
+  GtkListBox *box = GTK_LIST_BOX (widget);
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  priv->virtual_tick_id = 0;
+
+  gtk_list_box_update_virtual_rows (box);
+
+  if (priv->virtual_resize_needed)
+    {
+      priv->virtual_resize_needed = FALSE;
+      gtk_widget_queue_resize (widget);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Updates the bound rows at the start of the next frame, so that
+ * rows get bound before the frame is laid out and drawn.
+ */
+static void
+gtk_list_box_queue_virtual_update (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+
+  if (priv->create_row_func == NULL || priv->virtual_tick_id != 0)
+    return;
+
+  priv->virtual_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (box),
+                                                        gtk_list_box_virtual_tick,
+                                                        NULL, NULL);
+}
+
+static void
+gtk_list_box_allocate_virtual_rows (GtkListBox    *box,
+                                    GtkAllocation *allocation)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  GtkAllocation child_allocation;
+  GSequenceIter *iter;
+  gboolean heights_changed = FALSE;
+  guint index, first, end;
+  gint child_min;
+
+  /* Heights depend on the width */
+  if (allocation->width != priv->virtual_width)
+    {
+      gtk_list_box_forget_virtual_row_heights (box);
+      priv->virtual_width = allocation->width;
+      heights_changed = TRUE;
+    }
+
+  index = priv->virtual_first;
+
+  child_allocation.x = 0;
+  child_allocation.y = gtk_list_box_get_virtual_row_offset (box, index);
+  child_allocation.width = allocation->width;
+
+  for (iter = g_sequence_get_begin_iter (priv->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter), index++)
+    {
+      GtkListBoxRow *row = g_sequence_get (iter);
+
+      if (!row_is_visible (row))
+        {
+          ROW_PRIV (row)->y = child_allocation.y;
+          ROW_PRIV (row)->height = 0;
+          heights_changed |= gtk_list_box_set_virtual_row_height (box, index, 0);
+          continue;
+        }
+
+      gtk_widget_get_preferred_height_for_width (GTK_WIDGET (row),
+                                                 child_allocation.width, &child_min, NULL);
+      heights_changed |= gtk_list_box_set_virtual_row_height (box, index, child_min);
+
+      child_allocation.height = child_min;
+      ROW_PRIV (row)->y = child_allocation.y;
+      ROW_PRIV (row)->height = child_min;
+      gtk_widget_size_allocate (GTK_WIDGET (row), &child_allocation);
+      child_allocation.y += child_min;
+    }
+
+  /* Bound rows and the size can't be changed from here, leave it
+   * to the next frame
+   */
+  gtk_list_box_get_virtual_range (box, &first, &end);
+  if (heights_changed)
+    priv->virtual_resize_needed = TRUE;
+  if (heights_changed ||
+      first != priv->virtual_first ||
+      end != priv->virtual_first + g_sequence_get_length (priv->children))
+    gtk_list_box_queue_virtual_update (box);
+}
+
+static void
+gtk_list_box_clear_virtual_rows (GtkListBox *box)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint i;
+
+  if (priv->create_row_func == NULL)
+    return;
+
+  if (priv->virtual_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (box), priv->virtual_tick_id);
+      priv->virtual_tick_id = 0;
+    }
+
+  gtk_list_box_unbind_virtual_rows_from (box, 0);
+
+  for (i = 0; i < priv->virtual_pool->len; i++)
+    {
+      GtkWidget *row = g_ptr_array_index (priv->virtual_pool, i);
+
+      gtk_widget_destroy (row);
+      g_object_unref (row);
+    }
+  g_clear_pointer (&priv->virtual_pool, g_ptr_array_unref);
+
+  if (priv->virtual_rows_target_destroy_notify != NULL)
+    priv->virtual_rows_target_destroy_notify (priv->virtual_rows_target);
+
+  priv->create_row_func = NULL;
+  priv->bind_row_func = NULL;
+  priv->virtual_rows_target = NULL;
+  priv->virtual_rows_target_destroy_notify = NULL;
+
+  g_clear_pointer (&priv->virtual_heights, g_array_unref);
+  g_clear_pointer (&priv->virtual_height_sums, g_free);
+  g_clear_pointer (&priv->virtual_count_sums, g_free);
+  priv->n_virtual_rows = 0;
+  priv->virtual_first = 0;
+}
+
+/**
+ * gtk_list_box_set_virtual_rows:
+ * @box: a #GtkListBox
+ * @n_rows: the number of rows
+ * @create_func: (allow-none): function that creates new rows
+ * @bind_func: (allow-none): function that updates a row to show
+ *     the item at a given index
+ * @user_data: user data passed to @create_func and @bind_func
+ * @destroy: destroy notifier for @user_data
+ *
+ * Makes @box show @n_rows rows, without creating a widget for each
+ * of them. Only the rows that are visible, or close to being visible,
+ * in the #GtkScrolledWindow containing @box get a widget. These are
+ * created with @create_func, and reused for other rows when they are
+ * scrolled out of view; @bind_func is called every time a widget is
+ * made to show the row at a given index.
+ *
+ * The height of rows that haven't been shown yet is estimated from the
+ * rows that have been, so the scrollable area may change slightly while
+ * scrolling through the list.
+ *
+ * Rows must not be added to @box with gtk_container_add() or
+ * gtk_list_box_insert() while it is showing virtual rows, and sorting,
+ * filtering and headers are not supported. Selected rows are unselected
+ * when they are reused; use @bind_func to restore the selection state if
+ * needed. gtk_list_box_get_row_at_index() and gtk_list_box_row_get_index()
+ * work with the row indexes, but only find rows that are currently shown.
+ *
+ * Call gtk_list_box_virtual_rows_changed() when rows are added or removed,
+ * or when their content changes. Passing %NULL for @create_func removes
+ * all virtual rows.
+ *
+ * Since: 3.16
+ */
+void
+gtk_list_box_set_virtual_rows (GtkListBox              *box,
+                               guint                    n_rows,
+                               GtkListBoxCreateRowFunc  create_func,
+                               GtkListBoxBindRowFunc    bind_func,
+                               gpointer                 user_data,
+                               GDestroyNotify           destroy)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint i;
+
+  g_return_if_fail (GTK_IS_LIST_BOX (box));
+  g_return_if_fail ((create_func == NULL) == (bind_func == NULL));
+
+  gtk_list_box_clear_virtual_rows (box);
+
+  if (create_func != NULL)
+    {
+      priv->create_row_func = create_func;
+      priv->bind_row_func = bind_func;
+      priv->virtual_rows_target = user_data;
+      priv->virtual_rows_target_destroy_notify = destroy;
+
+      priv->n_virtual_rows = n_rows;
+      priv->virtual_heights = g_array_sized_new (FALSE, FALSE, sizeof (gint), n_rows);
+      g_array_set_size (priv->virtual_heights, n_rows);
+      for (i = 0; i < n_rows; i++)
+        g_array_index (priv->virtual_heights, gint, i) = -1;
+      priv->virtual_measured_height = 0;
+      priv->virtual_n_measured = 0;
+      priv->virtual_sums_dirty = TRUE;
+      priv->virtual_width = -1;
+      priv->virtual_first = 0;
+      priv->virtual_pool = g_ptr_array_new ();
+
+      gtk_list_box_update_virtual_rows (box);
+    }
+
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
+/**
+ * gtk_list_box_virtual_rows_changed:
+ * @box: a #GtkListBox
+ * @position: the index of the first changed row
+ * @removed: the number of rows that were removed at @position
+ * @added: the number of rows that were added at @position
+ *
+ * Tells @box that the rows set with gtk_list_box_set_virtual_rows()
+ * have changed. All the rows from @position on are bound again.
+ * Passing 0 for both @removed and @added can be used to refresh rows
+ * whose content changed.
+ *
+ * Since: 3.16
+ */
+void
+gtk_list_box_virtual_rows_changed (GtkListBox *box,
+                                   guint       position,
+                                   guint       removed,
+                                   guint       added)
+{
+  GtkListBoxPrivate *priv = BOX_PRIV (box);
+  guint i;
+
+  g_return_if_fail (GTK_IS_LIST_BOX (box));
+  g_return_if_fail (priv->create_row_func != NULL);
+  g_return_if_fail (position + removed <= priv->n_virtual_rows);
+
+  gtk_list_box_unbind_virtual_rows_from (box, position);
+
+  for (i = position; i < position + removed; i++)
+    {
+      gint height = g_array_index (priv->virtual_heights, gint, i);
+
+      if (height >= 0)
+        {
+          priv->virtual_measured_height -= height;
+          priv->virtual_n_measured--;
+        }
+    }
+
+  g_array_remove_range (priv->virtual_heights, position, removed);
+  g_array_set_size (priv->virtual_heights, priv->n_virtual_rows - removed + added);
+  if (position < priv->n_virtual_rows - removed)
+    memmove (&g_array_index (priv->virtual_heights, gint, position + added),
+             &g_array_index (priv->virtual_heights, gint, position),
+             (priv->n_virtual_rows - removed - position) * sizeof (gint));
+  for (i = position; i < position + added; i++)
+    g_array_index (priv->virtual_heights, gint, i) = -1;
+
+  priv->n_virtual_rows = priv->n_virtual_rows - removed + added;
+  priv->virtual_sums_dirty = TRUE;
+  priv->virtual_first = MIN (priv->virtual_first, priv->n_virtual_rows);
+
+  gtk_list_box_update_virtual_rows (box);
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
 /**
  * gtk_list_box_drag_unhighlight_row:
  * @box: a #GtkListBox
@@ -3253,7 +3915,14 @@ gtk_list_box_row_get_index (GtkListBoxRow *row)
   priv = ROW_PRIV (row);
 
   if (priv->iter != NULL)
-    return g_sequence_iter_get_position (priv->iter);
+    {
+      GtkListBox *box = gtk_list_box_row_get_box (row);
+
+      if (box != NULL && BOX_PRIV (box)->create_row_func != NULL)
+        return BOX_PRIV (box)->virtual_first + g_sequence_iter_get_position (priv->iter);
+
+      return g_sequence_iter_get_position (priv->iter);
+    }
 
   return -1;
 }
@@ -169,6 +169,36 @@ typedef void (*GtkListBoxUpdateHeaderFunc) (GtkListBoxRow *row,
                                             GtkListBoxRow *before,
                                             gpointer       user_data);
 
+/**
+ * GtkListBoxCreateRowFunc:
+ * @user_data: (closure): user data
+ *
+ * Called to create a new row for gtk_list_box_set_virtual_rows().
+ * If the returned widget is not a #GtkListBoxRow, it is wrapped in one.
+ * The widget should be made visible before returning it.
+ *
+ * Returns: (transfer full): a new widget
+ *
+ * Since: 3.16
+ */
+typedef GtkWidget * (*GtkListBoxCreateRowFunc) (gpointer user_data);
+
+/**
+ * GtkListBoxBindRowFunc:
+ * @row: the row to update
+ * @index: the index of the item that @row should show
+ * @user_data: (closure): user data
+ *
+ * Called to make @row, which was created by the #GtkListBoxCreateRowFunc
+ * given to gtk_list_box_set_virtual_rows(), show the item at @index.
+ * The row may have been showing another item before.
+ *
+ * Since: 3.16
+ */
+typedef void (*GtkListBoxBindRowFunc) (GtkListBoxRow *row,
+                                       guint          index,
+                                       gpointer       user_data);
+
 GDK_AVAILABLE_IN_3_10
 GType      gtk_list_box_row_get_type      (void) G_GNUC_CONST;
 GDK_AVAILABLE_IN_3_10
@@ -284,6 +314,18 @@ void           gtk_list_box_drag_highlight_row           (GtkListBox
                                                           GtkListBoxRow                 *row);
 GDK_AVAILABLE_IN_3_10
 GtkWidget*     gtk_list_box_new                          (void);
+GDK_AVAILABLE_IN_3_16
+void           gtk_list_box_set_virtual_rows             (GtkListBox                    *box,
+                                                          guint                          n_rows,
+                                                          GtkListBoxCreateRowFunc        create_func,
+                                                          GtkListBoxBindRowFunc          bind_func,
+                                                          gpointer                       user_data,
+                                                          GDestroyNotify                 destroy);
+GDK_AVAILABLE_IN_3_16
+void           gtk_list_box_virtual_rows_changed         (GtkListBox                    *box,
+                                                          guint                          position,
+                                                          guint                          removed,
+                                                          guint                          added);
 
 
 
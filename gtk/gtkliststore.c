@@ -24,6 +24,7 @@
 #include "gtkliststore.h"
 #include "gtktreedatalist.h"
 #include "gtktreednd.h"
+#include "gtktreeprivate.h"
 #include "gtkintl.h"
 #include "gtkbuildable.h"
 #include "gtkbuilderprivate.h"
@@ -556,14 +557,24 @@ gtk_list_store_set_column_type (GtkListStore *list_store,
   priv->column_headers[column] = type;
 }
 
+static void
+gtk_list_store_free_row (gpointer data,
+                         gpointer user_data)
+{
+  GtkListStore *list_store = user_data;
+
+  _gtk_tree_data_list_row_free (data,
+                                list_store->priv->column_headers,
+                                list_store->priv->n_columns);
+}
+
 static void
 gtk_list_store_finalize (GObject *object)
 {
   GtkListStore *list_store = GTK_LIST_STORE (object);
   GtkListStorePrivate *priv = list_store->priv;
 
-  g_sequence_foreach (priv->seq,
-		      (GFunc) _gtk_tree_data_list_free, priv->column_headers);
+  g_sequence_foreach (priv->seq, gtk_list_store_free_row, list_store);
 
   g_sequence_free (priv->seq);
 
@@ -669,21 +680,17 @@ gtk_list_store_get_value (GtkTreeModel *tree_model,
 {
   GtkListStore *list_store = GTK_LIST_STORE (tree_model);
   GtkListStorePrivate *priv = list_store->priv;
-  GtkTreeDataList *list;
-  gint tmp_column = column;
+  GtkTreeDataList *row;
 
   g_return_if_fail (column < priv->n_columns);
   g_return_if_fail (iter_is_valid (iter, list_store));
-		    
-  list = g_sequence_get (iter->user_data);
 
-  while (tmp_column-- > 0 && list)
-    list = list->next;
+  row = g_sequence_get (iter->user_data);
 
-  if (list == NULL)
+  if (row == NULL)
     g_value_init (value, priv->column_headers[column]);
   else
-    _gtk_tree_data_list_node_to_value (list,
+    _gtk_tree_data_list_node_to_value (&row[column],
 				       priv->column_headers[column],
 				       value);
 }
@@ -819,9 +826,7 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
 			       gboolean      sort)
 {
   GtkListStorePrivate *priv = list_store->priv;
-  GtkTreeDataList *list;
-  GtkTreeDataList *prev;
-  gint old_column = column;
+  GtkTreeDataList *row;
   GValue real_value = G_VALUE_INIT;
   gboolean converted = FALSE;
   gboolean retval = FALSE;
@@ -850,60 +855,27 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
       converted = TRUE;
     }
 
-  prev = list = g_sequence_get (iter->user_data);
-
-  while (list != NULL)
-    {
-      if (column == 0)
-	{
-	  if (converted)
-	    _gtk_tree_data_list_value_to_node (list, &real_value);
-	  else
-	    _gtk_tree_data_list_value_to_node (list, value);
-	  retval = TRUE;
-	  if (converted)
-	    g_value_unset (&real_value);
-         if (sort && GTK_LIST_STORE_IS_SORTED (list_store))
-            gtk_list_store_sort_iter_changed (list_store, iter, old_column);
-	  return retval;
-	}
-
-      column--;
-      prev = list;
-      list = list->next;
-    }
-
-  if (g_sequence_get (iter->user_data) == NULL)
-    {
-      list = _gtk_tree_data_list_alloc();
-      g_sequence_set (iter->user_data, list);
-      list->next = NULL;
-    }
-  else
-    {
-      list = prev->next = _gtk_tree_data_list_alloc ();
-      list->next = NULL;
-    }
-
-  while (column != 0)
+  /* All cells of a row live in one block, which is allocated
+   * when the first value of the row is set.
+   */
+  row = g_sequence_get (iter->user_data);
+  if (row == NULL)
     {
-      list->next = _gtk_tree_data_list_alloc ();
-      list = list->next;
-      list->next = NULL;
-      column --;
+      row = _gtk_tree_data_list_row_new (priv->n_columns);
+      g_sequence_set (iter->user_data, row);
     }
 
   if (converted)
-    _gtk_tree_data_list_value_to_node (list, &real_value);
+    _gtk_tree_data_list_value_to_node (&row[column], &real_value);
   else
-    _gtk_tree_data_list_value_to_node (list, value);
+    _gtk_tree_data_list_value_to_node (&row[column], value);
 
   retval = TRUE;
   if (converted)
     g_value_unset (&real_value);
 
   if (sort && GTK_LIST_STORE_IS_SORTED (list_store))
-    gtk_list_store_sort_iter_changed (list_store, iter, old_column);
+    gtk_list_store_sort_iter_changed (list_store, iter, column);
 
   return retval;
 }
@@ -1209,7 +1181,8 @@ gtk_list_store_remove (GtkListStore *list_store,
   ptr = iter->user_data;
   next = g_sequence_iter_next (ptr);
   
-  _gtk_tree_data_list_free (g_sequence_get (ptr), priv->column_headers);
+  _gtk_tree_data_list_row_free (g_sequence_get (ptr),
+                                priv->column_headers, priv->n_columns);
   g_sequence_remove (iter->user_data);
 
   priv->length--;
@@ -1564,33 +1537,14 @@ gtk_list_store_drag_data_received (GtkTreeDragDest   *drag_dest,
        */
       if (retval)
         {
-          GtkTreeDataList *dl = g_sequence_get (src_iter.user_data);
-          GtkTreeDataList *copy_head = NULL;
-          GtkTreeDataList *copy_prev = NULL;
-          GtkTreeDataList *copy_iter = NULL;
+          GtkTreeDataList *row = g_sequence_get (src_iter.user_data);
 	  GtkTreePath *path;
-          gint col;
-
-          col = 0;
-          while (dl)
-            {
-              copy_iter = _gtk_tree_data_list_node_copy (dl,
-                                                         priv->column_headers[col]);
-
-              if (copy_head == NULL)
-                copy_head = copy_iter;
-
-              if (copy_prev)
-                copy_prev->next = copy_iter;
-
-              copy_prev = copy_iter;
-
-              dl = dl->next;
-              ++col;
-            }
 
 	  dest_iter.stamp = priv->stamp;
-          g_sequence_set (dest_iter.user_data, copy_head);
+          g_sequence_set (dest_iter.user_data,
+                          _gtk_tree_data_list_row_copy (row,
+                                                        priv->column_headers,
+                                                        priv->n_columns));
 
 	  path = gtk_list_store_get_path (tree_model, &dest_iter);
 	  gtk_tree_model_row_changed (tree_model, path, &dest_iter);
@@ -1954,6 +1908,61 @@ gtk_list_store_compare_func (GSequenceIter *a,
   return retval;
 }
 
+/* Sorts the list store with _gtk_tree_data_list_sort_by_key() when
+ * the sort column uses the default sort function, returning the new
+ * order, or %NULL if the sort function is a custom one.
+ */
+static gint *
+gtk_list_store_sort_by_key (GtkListStore *list_store)
+{
+  GtkListStorePrivate *priv = list_store->priv;
+  GtkTreeDataSortHeader *header;
+  GSequenceIter **ptrs;
+  GSequenceIter *ptr;
+  GSequenceIter *end;
+  GtkTreeIter *iters;
+  gint *new_order;
+  gint length, i;
+
+  if (priv->sort_column_id < 0)
+    return NULL;
+
+  header = _gtk_tree_data_list_get_header (priv->sort_list,
+                                           priv->sort_column_id);
+  if (header == NULL ||
+      !_gtk_tree_data_list_can_sort_by_key (header->func,
+                                            priv->column_headers[GPOINTER_TO_INT (header->data)]))
+    return NULL;
+
+  length = g_sequence_get_length (priv->seq);
+  ptrs = g_new (GSequenceIter *, length);
+  iters = g_new (GtkTreeIter, length);
+
+  ptr = g_sequence_get_begin_iter (priv->seq);
+  for (i = 0; i < length; i++)
+    {
+      ptrs[i] = ptr;
+      iters[i].stamp = priv->stamp;
+      iters[i].user_data = ptr;
+      ptr = g_sequence_iter_next (ptr);
+    }
+
+  new_order = _gtk_tree_data_list_sort_by_key (GTK_TREE_MODEL (list_store),
+                                               GPOINTER_TO_INT (header->data),
+                                               priv->order,
+                                               iters, length);
+
+  /* Moving the rows keeps the iters valid */
+  end = g_sequence_get_end_iter (priv->seq);
+  for (i = 0; i < length; i++)
+    g_sequence_move (ptrs[new_order[i]], end);
+
+  g_free (iters);
+  g_free (ptrs);
+
+  return new_order;
+}
+
 static void
 gtk_list_store_sort (GtkListStore *list_store)
 {
@@ -1966,12 +1975,16 @@ gtk_list_store_sort (GtkListStore *list_store)
       g_sequence_get_length (priv->seq) <= 1)
     return;
 
-  old_positions = save_positions (priv->seq);
+  new_order = gtk_list_store_sort_by_key (list_store);
+  if (new_order == NULL)
+    {
+      old_positions = save_positions (priv->seq);
 
-  g_sequence_sort_iter (priv->seq, gtk_list_store_compare_func, list_store);
+      g_sequence_sort_iter (priv->seq, gtk_list_store_compare_func, list_store);
 
-  /* Let the world know about our new order */
-  new_order = generate_order (priv->seq, old_positions);
+      /* Let the world know about our new order */
+      new_order = generate_order (priv->seq, old_positions);
+    }
 
   path = gtk_tree_path_new ();
   gtk_tree_model_rows_reordered (GTK_TREE_MODEL (list_store),
@@ -2314,6 +2327,101 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_rows_with_valuesv:
+ * @list_store: A #GtkListStore
+ * @position: position to insert the first new row, or -1 to append
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows * @n_values GValues, holding the
+ *     values for the first row, followed by those for the second row, etc.
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows new rows starting at @position, filling each of
+ * them with its slice of @values as gtk_list_store_insert_with_valuesv()
+ * would.
+ *
+ * If the list store is not sorted, the rows are consecutive and this
+ * emits #GtkTreeModel::rows-inserted once for the whole range, which
+ * lets views such as #GtkTreeView place each row without looking it
+ * up and update their size only once. #GtkTreeModelFilter and unsorted
+ * #GtkTreeModelSort models pass the range on. Use this function when
+ * adding large numbers of rows to a list store that is already shown.
+ *
+ * Since: 3.16
+ */
+void
+gtk_list_store_insert_rows_with_valuesv (GtkListStore *list_store,
+                                         gint          position,
+                                         gint          n_rows,
+                                         gint         *columns,
+                                         GValue       *values,
+                                         gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GtkTreePath *path;
+  GSequenceIter *ptr;
+  GtkTreeIter iter;
+  GtkTreeIter first;
+  gint length;
+  gint i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  if (n_rows == 0)
+    return;
+
+  /* Sorted rows don't end up next to each other */
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      for (i = 0; i < n_rows; i++)
+        gtk_list_store_insert_with_valuesv (list_store, NULL, position,
+                                            columns, values + i * n_values,
+                                            n_values);
+      return;
+    }
+
+  priv = list_store->priv;
+
+  priv->columns_dirty = TRUE;
+
+  length = g_sequence_get_length (priv->seq);
+  if (position > length || position < 0)
+    position = length;
+
+  ptr = g_sequence_get_iter_at_pos (priv->seq, position);
+  path = gtk_tree_path_new_from_indices (position, -1);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gboolean changed = FALSE;
+      gboolean maybe_need_sort = FALSE;
+
+      iter.stamp = priv->stamp;
+      iter.user_data = g_sequence_insert_before (ptr, NULL);
+
+      priv->length++;
+
+      gtk_list_store_set_vector_internal (list_store, &iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values + i * n_values,
+                                          n_values);
+      if (i == 0)
+        first = iter;
+
+      _gtk_tree_model_row_inserted_batched (GTK_TREE_MODEL (list_store), path, &iter);
+      gtk_tree_path_next (path);
+    }
+
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  gtk_tree_model_rows_inserted (GTK_TREE_MODEL (list_store), path, &first, n_rows);
+  gtk_tree_path_free (path);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
@@ -33,6 +33,8 @@ static void        _gtk_rbtree_remove_node_fixup  (GtkRBTree  *tree,
                                                    GtkRBNode  *parent);
 static inline void _fixup_validation              (GtkRBTree  *tree,
 						   GtkRBNode  *node);
+static inline void _fixup_selection               (GtkRBTree  *tree,
+						   GtkRBNode  *node);
 static inline void _fixup_total_count             (GtkRBTree  *tree,
 						   GtkRBNode  *node);
 #ifdef G_ENABLE_DEBUG  
@@ -130,6 +132,8 @@ _gtk_rbnode_rotate_left (GtkRBTree *tree,
 
   _fixup_validation (tree, node);
   _fixup_validation (tree, right);
+  _fixup_selection (tree, node);
+  _fixup_selection (tree, right);
   _fixup_total_count (tree, node);
   _fixup_total_count (tree, right);
 }
@@ -180,6 +184,8 @@ _gtk_rbnode_rotate_right (GtkRBTree *tree,
 
   _fixup_validation (tree, node);
   _fixup_validation (tree, left);
+  _fixup_selection (tree, node);
+  _fixup_selection (tree, left);
   _fixup_total_count (tree, node);
   _fixup_total_count (tree, left);
 }
@@ -374,6 +380,7 @@ gtk_rbnode_adjust (GtkRBTree *tree,
   while (tree && node && !_gtk_rbtree_is_nil (node))
     {
       _fixup_validation (tree, node);
+      _fixup_selection (tree, node);
       node->offset += offset_diff;
       node->count += count_diff;
       node->total_count += total_count_diff;
@@ -401,6 +408,7 @@ _gtk_rbtree_remove (GtkRBTree *tree)
   /* ugly hack to make _fixup_validation work in the first iteration of the
    * loop below */
   GTK_RBNODE_UNSET_FLAG (tree->root, GTK_RBNODE_DESCENDANTS_INVALID);
+  GTK_RBNODE_UNSET_FLAG (tree->root, GTK_RBNODE_DESCENDANTS_SELECTED);
   
   gtk_rbnode_adjust (tree->parent_tree, 
                      tree->parent_node,
@@ -693,6 +701,104 @@ _gtk_rbtree_node_mark_valid (GtkRBTree *tree,
   while (node);
 }
 #endif
+/* GTK_RBNODE_DESCENDANTS_SELECTED is set on a node if it or any node
+ * below it, including the nodes of its child tree, is selected. That
+ * lets walks over the selection skip subtrees without selected rows.
+ */
+void
+_gtk_rbtree_node_set_selected (GtkRBTree *tree,
+			       GtkRBNode *node,
+			       gboolean   selected)
+{
+  gboolean was_set;
+
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED) == !!selected)
+    return;
+
+  if (selected)
+    GTK_RBNODE_SET_FLAG (node, GTK_RBNODE_IS_SELECTED);
+  else
+    GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_IS_SELECTED);
+
+  do
+    {
+      was_set = GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_SELECTED);
+      _fixup_selection (tree, node);
+      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_SELECTED) == was_set)
+	return;
+
+      node = node->parent;
+      if (_gtk_rbtree_is_nil (node))
+	{
+	  node = tree->parent_node;
+	  tree = tree->parent_tree;
+	}
+    }
+  while (node);
+}
+
+static void
+gtk_rbnode_set_all_selected (GtkRBTree             *tree,
+			     GtkRBNode             *node,
+			     gboolean               selected,
+			     GtkRBTreeTraverseFunc  func,
+			     gpointer               data)
+{
+  if (_gtk_rbtree_is_nil (node))
+    return;
+
+  /* Nothing to unselect in here */
+  if (!selected && !GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_SELECTED))
+    return;
+
+  gtk_rbnode_set_all_selected (tree, node->left, selected, func, data);
+  gtk_rbnode_set_all_selected (tree, node->right, selected, func, data);
+  if (node->children)
+    gtk_rbnode_set_all_selected (node->children, node->children->root, selected, func, data);
+
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED) != selected)
+    {
+      node->flags ^= GTK_RBNODE_IS_SELECTED;
+      if (func)
+	func (tree, node, data);
+    }
+
+  if (selected)
+    GTK_RBNODE_SET_FLAG (node, GTK_RBNODE_DESCENDANTS_SELECTED);
+  else
+    GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_DESCENDANTS_SELECTED);
+}
+
+/* Selects or unselects every node of @tree and of its child trees,
+ * calling @func for each node that changed. Unselecting only visits
+ * the parts of the tree that contain selected nodes.
+ */
+void
+_gtk_rbtree_set_all_selected (GtkRBTree             *tree,
+			      gboolean               selected,
+			      GtkRBTreeTraverseFunc  func,
+			      gpointer               data)
+{
+  GtkRBNode *node;
+
+  if (tree == NULL)
+    return;
+
+  gtk_rbnode_set_all_selected (tree, tree->root, !!selected, func, data);
+
+  for (node = tree->parent_node, tree = tree->parent_tree; node != NULL; )
+    {
+      _fixup_selection (tree, node);
+
+      node = node->parent;
+      if (_gtk_rbtree_is_nil (node))
+	{
+	  node = tree->parent_node;
+	  tree = tree->parent_tree;
+	}
+    }
+}
+
 /* Assume tree is the root node as it doesn't set DESCENDANTS_INVALID above.
  */
 void
@@ -772,6 +878,7 @@ reorder_prepare (GtkRBTree *tree,
 {
   node->offset -= node->left->offset + node->right->offset;
   GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_DESCENDANTS_INVALID);
+  GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_DESCENDANTS_SELECTED);
 }
 
 static void
@@ -782,6 +889,7 @@ reorder_fixup (GtkRBTree *tree,
   node->offset += node->left->offset + node->right->offset;
   node->count = 1 + node->left->count + node->right->count;
   _fixup_validation (tree, node);
+  _fixup_selection (tree, node);
   _fixup_total_count (tree, node);
 }
 
@@ -1465,6 +1573,23 @@ void _fixup_validation (GtkRBTree *tree,
     }
 }
 
+static inline
+void _fixup_selection (GtkRBTree *tree,
+		       GtkRBNode *node)
+{
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED) ||
+      GTK_RBNODE_FLAG_SET (node->left, GTK_RBNODE_DESCENDANTS_SELECTED) ||
+      GTK_RBNODE_FLAG_SET (node->right, GTK_RBNODE_DESCENDANTS_SELECTED) ||
+      (node->children != NULL && GTK_RBNODE_FLAG_SET (node->children->root, GTK_RBNODE_DESCENDANTS_SELECTED)))
+    {
+      GTK_RBNODE_SET_FLAG (node, GTK_RBNODE_DESCENDANTS_SELECTED);
+    }
+  else
+    {
+      GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_DESCENDANTS_SELECTED);
+    }
+}
+
 static inline
 void _fixup_total_count (GtkRBTree *tree,
 		    GtkRBNode *node)
@@ -1596,6 +1721,26 @@ _gtk_rbtree_test_dirty (GtkRBTree *tree,
     _gtk_rbtree_test_dirty (node->children, node->children->root, GTK_RBNODE_FLAG_SET (node->children->root, GTK_RBNODE_DESCENDANTS_INVALID));
 }
 
+static gboolean
+_gtk_rbtree_test_selected (GtkRBTree *tree,
+                           GtkRBNode *node)
+{
+  gboolean selected;
+
+  if (_gtk_rbtree_is_nil (node))
+    return FALSE;
+
+  selected = GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED);
+  selected |= _gtk_rbtree_test_selected (tree, node->left);
+  selected |= _gtk_rbtree_test_selected (tree, node->right);
+  if (node->children)
+    selected |= _gtk_rbtree_test_selected (node->children, node->children->root);
+
+  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_SELECTED) == selected);
+
+  return selected;
+}
+
 static void _gtk_rbtree_test_structure (GtkRBTree *tree);
 
 static void
@@ -1664,6 +1809,7 @@ _gtk_rbtree_test (const gchar *where,
   _gtk_rbtree_test_height (tmp_tree, tmp_tree->root);
   _gtk_rbtree_test_dirty (tmp_tree, tmp_tree->root, GTK_RBNODE_FLAG_SET (tmp_tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
   g_assert (count_total (tmp_tree, tmp_tree->root) == tmp_tree->root->total_count);
+  _gtk_rbtree_test_selected (tmp_tree, tmp_tree->root);
 }
 
 static void
@@ -36,12 +36,14 @@ typedef enum
   GTK_RBNODE_INVALID = 1 << 7,
   GTK_RBNODE_COLUMN_INVALID = 1 << 8,
   GTK_RBNODE_DESCENDANTS_INVALID = 1 << 9,
+  GTK_RBNODE_DESCENDANTS_SELECTED = 1 << 10,
   GTK_RBNODE_NON_COLORS = GTK_RBNODE_IS_PARENT |
   			  GTK_RBNODE_IS_SELECTED |
   			  GTK_RBNODE_IS_PRELIT |
                           GTK_RBNODE_INVALID |
                           GTK_RBNODE_COLUMN_INVALID |
-                          GTK_RBNODE_DESCENDANTS_INVALID
+                          GTK_RBNODE_DESCENDANTS_INVALID |
+                          GTK_RBNODE_DESCENDANTS_SELECTED
 } GtkRBNodeColor;
 
 typedef struct _GtkRBTree GtkRBTree;
@@ -127,6 +129,13 @@ void       _gtk_rbtree_node_mark_invalid(GtkRBTree              *tree,
 					 GtkRBNode              *node);
 void       _gtk_rbtree_node_mark_valid  (GtkRBTree              *tree,
 					 GtkRBNode              *node);
+void       _gtk_rbtree_node_set_selected(GtkRBTree              *tree,
+					 GtkRBNode              *node,
+					 gboolean                selected);
+void       _gtk_rbtree_set_all_selected (GtkRBTree              *tree,
+					 gboolean                selected,
+					 GtkRBTreeTraverseFunc   func,
+					 gpointer                data);
 void       _gtk_rbtree_column_invalid   (GtkRBTree              *tree);
 void       _gtk_rbtree_mark_invalid     (GtkRBTree              *tree);
 void       _gtk_rbtree_set_fixed_height (GtkRBTree              *tree,
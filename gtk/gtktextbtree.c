@@ -214,6 +214,15 @@ struct _GtkTextBTree {
   guint end_iter_segment_stamp;
   
   GHashTable *child_anchor_table;
+
+  /* While tag changes are batched, the char range they cover
+   * is redisplayed once when the batch ends
+   */
+  gint tag_batch_depth;
+  gint tag_batch_start;
+  gint tag_batch_end;
+  guint tag_batch_invalidate : 1;
+  guint tag_batch_redisplay : 1;
 };
 
 
@@ -1255,6 +1264,279 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   }
 }
 
+/*
+ * Loaders collect complete lines, with their own segments, outside of
+ * any tree. Nothing in here touches a tree, so text can be split in
+ * lines in a thread, and only spliced into the tree, in a single
+ * insertion, from the main thread.
+ */
+struct _GtkTextBTreeLoader
+{
+  GtkTextLine *first_line;
+  GtkTextLine *last_line;
+  gint n_lines;
+  gint n_chars;
+
+  /* Text of the line being loaded. A trailing '\r' is kept
+   * here until we know whether a '\n' follows.
+   */
+  GString *pending;
+};
+
+GtkTextBTreeLoader *
+_gtk_text_btree_loader_new (void)
+{
+  GtkTextBTreeLoader *loader;
+
+  loader = g_slice_new0 (GtkTextBTreeLoader);
+  loader->pending = g_string_new (NULL);
+
+  return loader;
+}
+
+void
+_gtk_text_btree_loader_free (GtkTextBTreeLoader *loader)
+{
+  GtkTextLine *line, *next;
+  GtkTextLineSegment *seg;
+
+  for (line = loader->first_line; line != NULL; line = next)
+    {
+      next = line->next;
+
+      while (line->segments != NULL)
+        {
+          seg = line->segments;
+          line->segments = seg->next;
+          (*seg->type->deleteFunc) (seg, line, TRUE);
+        }
+
+      g_slice_free (GtkTextLine, line);
+    }
+
+  g_string_free (loader->pending, TRUE);
+  g_slice_free (GtkTextBTreeLoader, loader);
+}
+
+static void
+loader_add_line (GtkTextBTreeLoader *loader,
+                 const gchar        *text,
+                 gsize               len)
+{
+  GtkTextLine *line;
+
+  line = gtk_text_line_new ();
+  line->segments = _gtk_char_segment_new (text, len);
+  loader->n_chars += line->segments->char_count;
+
+  if (loader->last_line)
+    loader->last_line->next = line;
+  else
+    loader->first_line = line;
+  loader->last_line = line;
+  loader->n_lines++;
+}
+
+/* Finds the next paragraph delimiter, the same that
+ * pango_find_paragraph_boundary() does, but looking at
+ * bytes rather than decoding characters
+ */
+static const gchar *
+find_paragraph_delimiter (const gchar *p,
+                          const gchar *end)
+{
+  for (; p < end; p++)
+    {
+      guchar c = *p;
+
+      if (c == '\n' || c == '\r')
+        return p;
+
+      /* U+2029 PARAGRAPH SEPARATOR */
+      if (c == 0xe2 && end - p >= 3 &&
+          (guchar) p[1] == 0x80 && (guchar) p[2] == 0xa9)
+        return p;
+    }
+
+  return end;
+}
+
+/* Adds @text, which must be valid UTF-8 and not end in the
+ * middle of a character, to the lines of @loader
+ */
+void
+_gtk_text_btree_loader_append (GtkTextBTreeLoader *loader,
+                               const gchar        *text,
+                               gsize               len)
+{
+  GString *pending = loader->pending;
+  const gchar *p = text;
+  const gchar *end = text + len;
+  const gchar *delim, *eol;
+
+  if (pending->len > 0 && pending->str[pending->len - 1] == '\r' && p < end)
+    {
+      if (*p == '\n')
+        {
+          g_string_append_c (pending, '\n');
+          p++;
+        }
+      loader_add_line (loader, pending->str, pending->len);
+      g_string_truncate (pending, 0);
+    }
+
+  while (p < end)
+    {
+      delim = find_paragraph_delimiter (p, end);
+
+      if (delim == end ||
+          (*delim == '\r' && delim + 1 == end))
+        {
+          g_string_append_len (pending, p, end - p);
+          break;
+        }
+
+      if (*delim == '\r')
+        eol = delim[1] == '\n' ? delim + 2 : delim + 1;
+      else if (*delim == '\n')
+        eol = delim + 1;
+      else
+        eol = delim + 3;
+
+      if (pending->len > 0)
+        {
+          g_string_append_len (pending, p, eol - p);
+          loader_add_line (loader, pending->str, pending->len);
+          g_string_truncate (pending, 0);
+        }
+      else
+        loader_add_line (loader, p, eol - p);
+
+      p = eol;
+    }
+}
+
+/* Inserts the text of @loader at @iter, like _gtk_text_btree_insert(),
+ * and empties @loader. The new lines are linked in at once, and the
+ * tree is only rebalanced once.
+ */
+void
+_gtk_text_btree_insert_loaded (GtkTextIter        *iter,
+                               GtkTextBTreeLoader *loader)
+{
+  GtkTextBTree *tree;
+  GtkTextLine *line, *start_line, *end_line, *first, *next;
+  GtkTextLineSegment *prev_seg, *tail, *pending_seg;
+  gint start_byte_index, end_byte_index;
+  gint line_count_delta, char_count_delta;
+  GString *pending = loader->pending;
+
+  g_return_if_fail (iter != NULL);
+
+  /* The text ended with a lone '\r' */
+  if (pending->len > 0 && pending->str[pending->len - 1] == '\r')
+    {
+      loader_add_line (loader, pending->str, pending->len);
+      g_string_truncate (pending, 0);
+    }
+
+  tree = _gtk_text_iter_get_btree (iter);
+  line = _gtk_text_iter_get_text_line (iter);
+
+  start_line = line;
+  start_byte_index = gtk_text_iter_get_line_index (iter);
+
+  g_assert (!_gtk_text_line_is_last (line, tree));
+  prev_seg = gtk_text_line_segment_split (iter);
+
+  /* Invalidate all iterators */
+  chars_changed (tree);
+  segments_changed (tree);
+
+  tail = prev_seg ? prev_seg->next : line->segments;
+
+  pending_seg = NULL;
+  if (pending->len > 0)
+    pending_seg = _gtk_char_segment_new (pending->str, pending->len);
+
+  line_count_delta = loader->n_lines;
+  char_count_delta = loader->n_chars + (pending_seg ? pending_seg->char_count : 0);
+
+  if (loader->first_line == NULL)
+    {
+      /* No complete line, the text goes in the middle of @line */
+      if (pending_seg)
+        {
+          pending_seg->next = tail;
+          if (prev_seg)
+            prev_seg->next = pending_seg;
+          else
+            line->segments = pending_seg;
+        }
+
+      end_line = line;
+      end_byte_index = start_byte_index + pending->len;
+    }
+  else
+    {
+      first = loader->first_line;
+
+      /* The first loaded line finishes @line */
+      if (prev_seg)
+        prev_seg->next = first->segments;
+      else
+        line->segments = first->segments;
+
+      /* The rest of @line goes after the last loaded line */
+      end_line = gtk_text_line_new ();
+      if (pending_seg)
+        {
+          pending_seg->next = tail;
+          end_line->segments = pending_seg;
+        }
+      else
+        end_line->segments = tail;
+
+      loader->last_line->next = end_line;
+      end_line->next = line->next;
+      line->next = first->next;
+
+      for (next = line->next; next != end_line->next; next = next->next)
+        gtk_text_line_set_parent (next, line->parent);
+
+      g_slice_free (GtkTextLine, first);
+
+      end_byte_index = pending->len;
+    }
+
+  loader->first_line = NULL;
+  loader->last_line = NULL;
+  loader->n_lines = 0;
+  loader->n_chars = 0;
+  g_string_truncate (pending, 0);
+
+  cleanup_line (start_line);
+  if (end_line != start_line)
+    cleanup_line (end_line);
+
+  post_insert_fixup (tree, end_line, line_count_delta, char_count_delta);
+
+  {
+    GtkTextIter start;
+    GtkTextIter end;
+
+    _gtk_text_btree_get_iter_at_line (tree, &start, start_line, start_byte_index);
+    _gtk_text_btree_get_iter_at_line (tree, &end, end_line, end_byte_index);
+
+    DV (g_print ("invalidating due to inserting loaded text (%s)\n", G_STRLOC));
+    _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
+
+    *iter = end;
+
+    gtk_text_btree_resolve_bidi (&start, &end);
+  }
+}
+
 static void
 insert_pixbuf_or_widget_segment (GtkTextIter        *iter,
                                  GtkTextLineSegment *seg)
@@ -1744,6 +2026,20 @@ queue_tag_redisplay (GtkTextBTree      *tree,
                      const GtkTextIter *start,
                      const GtkTextIter *end)
 {
+  if (tree->tag_batch_depth > 0)
+    {
+      if (_gtk_text_tag_affects_size (tag))
+        tree->tag_batch_invalidate = TRUE;
+      else if (_gtk_text_tag_affects_nonsize_appearance (tag))
+        tree->tag_batch_redisplay = TRUE;
+      else
+        return;
+
+      tree->tag_batch_start = MIN (tree->tag_batch_start, gtk_text_iter_get_offset (start));
+      tree->tag_batch_end = MAX (tree->tag_batch_end, gtk_text_iter_get_offset (end));
+      return;
+    }
+
   if (_gtk_text_tag_affects_size (tag))
     {
       DV (g_print ("invalidating due to size-affecting tag (%s)\n", G_STRLOC));
@@ -1758,6 +2054,46 @@ queue_tag_redisplay (GtkTextBTree      *tree,
   /* We don't need to do anything if the tag doesn't affect display */
 }
 
+/* Tag changes made between these calls invalidate the views
+ * once, for the range covering all of them, at the end
+ */
+void
+_gtk_text_btree_begin_tag_batch (GtkTextBTree *tree)
+{
+  if (tree->tag_batch_depth++ > 0)
+    return;
+
+  tree->tag_batch_start = G_MAXINT;
+  tree->tag_batch_end = 0;
+  tree->tag_batch_invalidate = FALSE;
+  tree->tag_batch_redisplay = FALSE;
+}
+
+void
+_gtk_text_btree_end_tag_batch (GtkTextBTree *tree)
+{
+  GtkTextIter start, end;
+
+  g_return_if_fail (tree->tag_batch_depth > 0);
+
+  if (--tree->tag_batch_depth > 0)
+    return;
+
+  if (!tree->tag_batch_invalidate && !tree->tag_batch_redisplay)
+    return;
+
+  _gtk_text_btree_get_iter_at_char (tree, &start, tree->tag_batch_start);
+  _gtk_text_btree_get_iter_at_char (tree, &end, tree->tag_batch_end);
+
+  if (tree->tag_batch_invalidate)
+    {
+      DV (g_print ("invalidating due to size-affecting tags (%s)\n", G_STRLOC));
+      _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
+    }
+  else
+    redisplay_region (tree, &start, &end, FALSE);
+}
+
 void
 _gtk_text_btree_tag (const GtkTextIter *start_orig,
                      const GtkTextIter *end_orig,
@@ -3948,7 +4284,7 @@ _gtk_text_line_byte_to_char (GtkTextLine *line,
   else
     {
       if (seg->type == &gtk_text_char_type)
-        return char_offset + g_utf8_strlen (seg->body.chars, byte_offset);
+        return char_offset + _gtk_char_segment_byte_to_char (seg, byte_offset);
       else
         {
           g_assert (seg->char_count == 1);
@@ -4155,7 +4491,7 @@ _gtk_text_line_byte_to_char_offsets (GtkTextLine *line,
 
   if (seg->type == &gtk_text_char_type)
     {
-      *seg_char_offset = g_utf8_strlen (seg->body.chars, offset);
+      *seg_char_offset = _gtk_char_segment_byte_to_char (seg, offset);
 
       g_assert (*seg_char_offset < seg->char_count);
 
@@ -4200,16 +4536,7 @@ _gtk_text_line_char_to_byte_offsets (GtkTextLine *line,
 
   if (seg->type == &gtk_text_char_type)
     {
-      const char *p;
-
-      /* if in the last fourth of the segment walk backwards */
-      if (seg->char_count - offset < seg->char_count / 4)
-        p = g_utf8_offset_to_pointer (seg->body.chars + seg->byte_count, 
-                                      offset - seg->char_count);
-      else
-        p = g_utf8_offset_to_pointer (seg->body.chars, offset);
-
-      *seg_byte_offset = p - seg->body.chars;
+      *seg_byte_offset = _gtk_char_segment_char_to_byte (seg, offset);
 
       g_assert (*seg_byte_offset < seg->byte_count);
 
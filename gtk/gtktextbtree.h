@@ -71,6 +71,19 @@ void _gtk_text_btree_insert        (GtkTextIter *iter,
 void _gtk_text_btree_insert_pixbuf (GtkTextIter *iter,
                                     GdkPixbuf   *pixbuf);
 
+/* Building lines away from the tree, possibly in another thread,
+ * and inserting them at once
+ */
+typedef struct _GtkTextBTreeLoader GtkTextBTreeLoader;
+
+GtkTextBTreeLoader *_gtk_text_btree_loader_new    (void);
+void                _gtk_text_btree_loader_free   (GtkTextBTreeLoader *loader);
+void                _gtk_text_btree_loader_append (GtkTextBTreeLoader *loader,
+                                                   const gchar        *text,
+                                                   gsize               len);
+void                _gtk_text_btree_insert_loaded (GtkTextIter        *iter,
+                                                   GtkTextBTreeLoader *loader);
+
 void _gtk_text_btree_insert_child_anchor (GtkTextIter        *iter,
                                           GtkTextChildAnchor *anchor);
 
@@ -114,6 +127,8 @@ void _gtk_text_btree_tag (const GtkTextIter *start,
                           const GtkTextIter *end,
                           GtkTextTag        *tag,
                           gboolean           apply);
+void _gtk_text_btree_begin_tag_batch (GtkTextBTree      *tree);
+void _gtk_text_btree_end_tag_batch   (GtkTextBTree      *tree);
 
 /* "Getters" */
 
@@ -74,6 +74,12 @@ struct _GtkTextBufferPrivate
 
   guint user_action_count;
 
+  /* Lines built by gtk_text_buffer_load_stream_async(), inserted
+   * by the default handler when it is passed loaded_text
+   */
+  GtkTextBTreeLoader *loaded_lines;
+  const gchar *loaded_text;
+
   /* Whether the buffer has been modified since last save */
   guint modified : 1;
   guint has_selection : 1;
@@ -877,6 +883,226 @@ gtk_text_buffer_set_text (GtkTextBuffer *buffer,
     }
 }
 
+/* Size of the reads when loading a stream */
+#define LOAD_CHUNK_SIZE (1024 * 1024)
+
+typedef struct
+{
+  GInputStream *stream;
+  GString *text;
+  GtkTextBTreeLoader *lines;
+} TextLoad;
+
+static void
+text_load_free (TextLoad *load)
+{
+  g_object_unref (load->stream);
+  g_string_free (load->text, TRUE);
+  _gtk_text_btree_loader_free (load->lines);
+
+  g_slice_free (TextLoad, load);
+}
+
+/* Like g_utf8_validate(), but skips over ASCII text a word at a time */
+static gboolean
+utf8_validate_fast (const gchar  *text,
+                    gsize         len,
+                    const gchar **end)
+{
+  const gsize ones = (gsize) -1 / 0xff;
+  const gsize highs = ones * 0x80;
+  const gchar *p = text;
+  const gchar *stop = text + len;
+  gsize word;
+
+  while ((gsize) (stop - p) >= sizeof (gsize))
+    {
+      memcpy (&word, p, sizeof (gsize));
+
+      /* Non-ASCII or nul bytes */
+      if ((word & highs) != 0 || ((word - ones) & ~word & highs) != 0)
+        break;
+
+      p += sizeof (gsize);
+    }
+
+  return g_utf8_validate (p, stop - p, end);
+}
+
+static void
+load_stream_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  TextLoad *load = task_data;
+  GString *text = load->text;
+  gsize n_valid = 0;
+  gssize n_read;
+  const gchar *valid_end;
+  GError *error = NULL;
+
+  do
+    {
+      gsize old_len = text->len;
+
+      g_string_set_size (text, old_len + LOAD_CHUNK_SIZE);
+      n_read = g_input_stream_read (load->stream,
+                                    text->str + old_len, LOAD_CHUNK_SIZE,
+                                    cancellable, &error);
+      if (n_read < 0)
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+      g_string_set_size (text, old_len + n_read);
+
+      if (text->len > G_MAXINT)
+        {
+          g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                   _("The text is too large"));
+          return;
+        }
+
+      /* A character can be split between reads, wait for its end */
+      if (!utf8_validate_fast (text->str + n_valid, text->len - n_valid, &valid_end) &&
+          (n_read == 0 ||
+           g_utf8_get_char_validated (valid_end, text->str + text->len - valid_end) != (gunichar) -2))
+        {
+          g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                                   _("The text is not valid UTF-8"));
+          return;
+        }
+
+      _gtk_text_btree_loader_append (load->lines,
+                                     text->str + n_valid,
+                                     valid_end - (text->str + n_valid));
+      n_valid = valid_end - text->str;
+    }
+  while (n_read > 0);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+load_stream_done (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GtkTextBuffer *buffer = GTK_TEXT_BUFFER (source);
+  GtkTextBufferPrivate *priv = buffer->priv;
+  GTask *task = user_data;
+  TextLoad *load = g_task_get_task_data (G_TASK (result));
+  GtkTextIter start, end;
+  GError *error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+
+  if (load->text->len > 0)
+    {
+      gtk_text_buffer_get_start_iter (buffer, &start);
+
+      priv->loaded_lines = load->lines;
+      priv->loaded_text = load->text->str;
+
+      g_signal_emit (buffer, signals[INSERT_TEXT], 0,
+                     &start, load->text->str, (gint) load->text->len);
+
+      priv->loaded_lines = NULL;
+      priv->loaded_text = NULL;
+    }
+
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+/**
+ * gtk_text_buffer_load_stream_async:
+ * @buffer: a #GtkTextBuffer
+ * @stream: a #GInputStream with UTF-8 text
+ * @io_priority: the I/O priority of the request
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: (scope async): callback to call when the text is loaded
+ * @user_data: user data for @callback
+ *
+ * Reads all of @stream and replaces the contents of @buffer with it,
+ * like gtk_text_buffer_set_text() would.
+ *
+ * The stream is read, validated and split in lines in a thread, so
+ * the user interface stays responsive while large files load. When
+ * the whole stream has been read, the current contents of @buffer are
+ * deleted, and the text is inserted at once, with a single emission of
+ * the #GtkTextBuffer::insert-text signal; views only update once.
+ * Changes made to @buffer while the stream is read are replaced too.
+ *
+ * If the stream does not contain valid UTF-8, the load fails with
+ * %G_IO_ERROR_INVALID_DATA and @buffer is left unchanged.
+ *
+ * Since: 3.16
+ */
+void
+gtk_text_buffer_load_stream_async (GtkTextBuffer       *buffer,
+                                   GInputStream        *stream,
+                                   gint                 io_priority,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+  GTask *task, *load_task;
+  TextLoad *load;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+  task = g_task_new (buffer, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_text_buffer_load_stream_async);
+
+  load = g_slice_new0 (TextLoad);
+  load->stream = g_object_ref (stream);
+  load->text = g_string_new (NULL);
+  load->lines = _gtk_text_btree_loader_new ();
+
+  /* The text is inserted from the main thread, before
+   * the callback of the outer task runs
+   */
+  load_task = g_task_new (buffer, cancellable, load_stream_done, task);
+  g_task_set_priority (load_task, io_priority);
+  g_task_set_task_data (load_task, load, (GDestroyNotify) text_load_free);
+  g_task_run_in_thread (load_task, load_stream_thread);
+  g_object_unref (load_task);
+}
+
+/**
+ * gtk_text_buffer_load_stream_finish:
+ * @buffer: a #GtkTextBuffer
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for an error, or %NULL
+ *
+ * Finishes a load started with gtk_text_buffer_load_stream_async().
+ *
+ * Returns: %TRUE if the contents of @buffer were replaced
+ *
+ * Since: 3.16
+ */
+gboolean
+gtk_text_buffer_load_stream_finish (GtkTextBuffer  *buffer,
+                                    GAsyncResult   *result,
+                                    GError        **error)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, buffer), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
  
 
 /*
@@ -891,8 +1117,15 @@ gtk_text_buffer_real_insert_text (GtkTextBuffer *buffer,
 {
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (iter != NULL);
-  
-  _gtk_text_btree_insert (iter, text, len);
+
+  if (buffer->priv->loaded_lines != NULL &&
+      text == buffer->priv->loaded_text)
+    {
+      _gtk_text_btree_insert_loaded (iter, buffer->priv->loaded_lines);
+      buffer->priv->loaded_lines = NULL;
+    }
+  else
+    _gtk_text_btree_insert (iter, text, len);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
   g_object_notify (G_OBJECT (buffer), "cursor-position");
@@ -2729,6 +2962,155 @@ gtk_text_buffer_remove_tag_by_name (GtkTextBuffer     *buffer,
   gtk_text_buffer_emit_tag (buffer, tag, FALSE, start, end);
 }
 
+typedef struct
+{
+  gint start;
+  gint end;
+} TagRange;
+
+static gint
+tag_range_compare (gconstpointer a,
+                   gconstpointer b)
+{
+  const TagRange *range_a = a;
+  const TagRange *range_b = b;
+
+  if (range_a->start < range_b->start)
+    return -1;
+  else if (range_a->start > range_b->start)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+gtk_text_buffer_emit_tag_ranges (GtkTextBuffer     *buffer,
+                                 GtkTextTag        *tag,
+                                 gboolean           apply,
+                                 const GtkTextIter *ranges,
+                                 guint              n_iters)
+{
+  TagRange *offsets;
+  GtkTextIter start, end;
+  guint i, n_ranges, n_offsets;
+
+  n_ranges = n_iters / 2;
+
+  if (n_ranges == 0)
+    return;
+
+  /* Ranges are only resolved to iters as they are applied,
+   * the earlier ones invalidate the iters passed in
+   */
+  offsets = g_new (TagRange, n_ranges);
+  for (i = 0; i < n_ranges; i++)
+    {
+      offsets[i].start = gtk_text_iter_get_offset (&ranges[2 * i]);
+      offsets[i].end = gtk_text_iter_get_offset (&ranges[2 * i + 1]);
+      if (offsets[i].start > offsets[i].end)
+        {
+          gint tmp = offsets[i].start;
+          offsets[i].start = offsets[i].end;
+          offsets[i].end = tmp;
+        }
+    }
+
+  g_qsort_with_data (offsets, n_ranges, sizeof (TagRange),
+                     (GCompareDataFunc) tag_range_compare, NULL);
+
+  /* Merge the overlapping and touching ranges */
+  n_offsets = 0;
+  for (i = 0; i < n_ranges; i++)
+    {
+      if (offsets[i].start == offsets[i].end)
+        continue;
+
+      if (n_offsets > 0 && offsets[i].start <= offsets[n_offsets - 1].end)
+        offsets[n_offsets - 1].end = MAX (offsets[n_offsets - 1].end, offsets[i].end);
+      else
+        offsets[n_offsets++] = offsets[i];
+    }
+
+  _gtk_text_btree_begin_tag_batch (get_btree (buffer));
+
+  for (i = 0; i < n_offsets; i++)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, offsets[i].start);
+      gtk_text_buffer_get_iter_at_offset (buffer, &end, offsets[i].end);
+
+      gtk_text_buffer_emit_tag (buffer, tag, apply, &start, &end);
+    }
+
+  _gtk_text_btree_end_tag_batch (get_btree (buffer));
+
+  g_free (offsets);
+}
+
+/**
+ * gtk_text_buffer_apply_tag_ranges:
+ * @buffer: a #GtkTextBuffer
+ * @tag: a #GtkTextTag
+ * @ranges: (array length=n_iters): pairs of bounds of the ranges to
+ *     be tagged
+ * @n_iters: the number of iters in @ranges, twice the number of ranges
+ *
+ * Applies @tag to many ranges at once, like calling
+ * gtk_text_buffer_apply_tag() for each of them, but the views of
+ * @buffer are only updated once, for all the ranges. This is meant
+ * for syntax highlighting and search results, and the matches that
+ * gtk_text_buffer_find_all() reports can be passed as they are, with
+ * twice the number of matches as @n_iters.
+ *
+ * The ranges don’t have to be sorted, and the bounds of a range
+ * don’t have to be in order. Overlapping and touching ranges are
+ * merged, and the “apply-tag” signal is emitted once per merged
+ * range, in buffer order.
+ *
+ * Since: 3.16
+ */
+void
+gtk_text_buffer_apply_tag_ranges (GtkTextBuffer     *buffer,
+                                  GtkTextTag        *tag,
+                                  const GtkTextIter *ranges,
+                                  guint              n_iters)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (GTK_IS_TEXT_TAG (tag));
+  g_return_if_fail (ranges != NULL || n_iters == 0);
+  g_return_if_fail (n_iters % 2 == 0);
+  g_return_if_fail (tag->priv->table == buffer->priv->tag_table);
+
+  gtk_text_buffer_emit_tag_ranges (buffer, tag, TRUE, ranges, n_iters);
+}
+
+/**
+ * gtk_text_buffer_remove_tag_ranges:
+ * @buffer: a #GtkTextBuffer
+ * @tag: a #GtkTextTag
+ * @ranges: (array length=n_iters): pairs of bounds of the ranges to
+ *     be untagged
+ * @n_iters: the number of iters in @ranges, twice the number of ranges
+ *
+ * Removes @tag from many ranges at once, with a single update of the
+ * views of @buffer. See gtk_text_buffer_apply_tag_ranges().
+ *
+ * Since: 3.16
+ */
+void
+gtk_text_buffer_remove_tag_ranges (GtkTextBuffer     *buffer,
+                                   GtkTextTag        *tag,
+                                   const GtkTextIter *ranges,
+                                   guint              n_iters)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (GTK_IS_TEXT_TAG (tag));
+  g_return_if_fail (ranges != NULL || n_iters == 0);
+  g_return_if_fail (n_iters % 2 == 0);
+  g_return_if_fail (tag->priv->table == buffer->priv->tag_table);
+
+  gtk_text_buffer_emit_tag_ranges (buffer, tag, FALSE, ranges, n_iters);
+}
+
 static gint
 pointer_cmp (gconstpointer a,
              gconstpointer b)
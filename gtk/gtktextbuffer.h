@@ -185,6 +185,18 @@ void gtk_text_buffer_set_text          (GtkTextBuffer *buffer,
                                         const gchar   *text,
                                         gint           len);
 
+GDK_AVAILABLE_IN_3_16
+void     gtk_text_buffer_load_stream_async  (GtkTextBuffer        *buffer,
+                                             GInputStream         *stream,
+                                             gint                  io_priority,
+                                             GCancellable         *cancellable,
+                                             GAsyncReadyCallback   callback,
+                                             gpointer              user_data);
+GDK_AVAILABLE_IN_3_16
+gboolean gtk_text_buffer_load_stream_finish (GtkTextBuffer        *buffer,
+                                             GAsyncResult         *result,
+                                             GError              **error);
+
 /* Insert into the buffer */
 GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_insert            (GtkTextBuffer *buffer,
@@ -352,6 +364,16 @@ GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_remove_all_tags       (GtkTextBuffer     *buffer,
                                             const GtkTextIter *start,
                                             const GtkTextIter *end);
+GDK_AVAILABLE_IN_3_16
+void gtk_text_buffer_apply_tag_ranges      (GtkTextBuffer     *buffer,
+                                            GtkTextTag        *tag,
+                                            const GtkTextIter *ranges,
+                                            guint              n_iters);
+GDK_AVAILABLE_IN_3_16
+void gtk_text_buffer_remove_tag_ranges     (GtkTextBuffer     *buffer,
+                                            GtkTextTag        *tag,
+                                            const GtkTextIter *ranges,
+                                            guint              n_iters);
 
 
 /* You can either ignore the return value, or use it to
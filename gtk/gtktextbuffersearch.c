@@ -0,0 +1,797 @@
+/* GTK - The GIMP Toolkit
+ * gtktextbuffersearch.c: Searching for all matches in a GtkTextBuffer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Finding all matches of a string with gtk_text_iter_forward_search()
+ * copies, casefolds and normalizes every line of the buffer once per
+ * match. The functions here walk the segments of the B-tree instead,
+ * and only build the text of a line when it is split in several
+ * segments, into a buffer that is reused from line to line:
+ *
+ * - exact searches look for the first byte of the string with
+ *   memchr(), which the C library vectorizes, and compare the rest
+ * - case insensitive searches for strings that are ASCII once
+ *   casefolded compare ASCII lines through a folding table; lines
+ *   with other characters can casefold or decompose into ASCII, so
+ *   they are left to gtk_text_iter_forward_search()
+ * - regular expressions are matched against each line with GRegex
+ *
+ * Everything else, that is searches for visible text only or for
+ * strings spanning several lines, goes through
+ * gtk_text_iter_forward_search() one line at a time, which still
+ * allows reporting matches in batches and searching in the
+ * background.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gtktextbuffersearch.h"
+#include "gtktextbtree.h"
+#include "gtktextiterprivate.h"
+
+/* Number of matches handed to the matches function at once */
+#define SEARCH_BATCH_SIZE 256
+
+/* Time spent searching per main loop iteration in the background,
+ * in microseconds
+ */
+#define SEARCH_TIME_SLICE 4000
+
+typedef enum
+{
+  SEARCH_EXACT,
+  SEARCH_ASCII_CASELESS,
+  SEARCH_REGEX,
+  SEARCH_ITER
+} SearchMode;
+
+typedef struct
+{
+  GtkTextBuffer *buffer;
+  GtkTextSearchFlags flags;
+  SearchMode mode;
+
+  /* The string as given, for gtk_text_iter_forward_search() */
+  gchar *str;
+  gint n_newlines;
+
+  /* The string the fast paths look for, casefolded if needed */
+  gchar *needle;
+  gsize needle_len;
+
+  GRegex *regex;
+
+  /* Text of the current line, if it is made of several segments */
+  GString *line_text;
+
+  /* Pairs of iterators */
+  GArray *matches;
+  gint n_matches;
+
+  GtkTextBufferMatchesFunc func;
+  gpointer func_data;
+  GDestroyNotify func_data_destroy;
+
+  /* Background searches */
+  GtkTextMark *pos_mark;
+  GtkTextMark *end_mark;
+  gint first_line;
+  gint last_line;
+} TextSearch;
+
+static guchar fold_table[256];
+
+static void
+init_fold_table (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      gint i;
+
+      for (i = 0; i < 256; i++)
+        fold_table[i] = g_ascii_tolower (i);
+
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+static gboolean
+is_ascii (const gchar *text,
+          gsize        len)
+{
+  gsize i;
+
+  for (i = 0; i < len; i++)
+    {
+      if (text[i] & 0x80)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+text_search_free (TextSearch *search)
+{
+  if (search->pos_mark)
+    {
+      if (!gtk_text_mark_get_deleted (search->pos_mark))
+        gtk_text_buffer_delete_mark (search->buffer, search->pos_mark);
+      g_object_unref (search->pos_mark);
+    }
+
+  if (search->end_mark)
+    {
+      if (!gtk_text_mark_get_deleted (search->end_mark))
+        gtk_text_buffer_delete_mark (search->buffer, search->end_mark);
+      g_object_unref (search->end_mark);
+    }
+
+  if (search->func_data_destroy)
+    search->func_data_destroy (search->func_data);
+
+  g_object_unref (search->buffer);
+  g_free (search->str);
+  g_free (search->needle);
+  if (search->regex)
+    g_regex_unref (search->regex);
+  g_string_free (search->line_text, TRUE);
+  g_array_unref (search->matches);
+
+  g_slice_free (TextSearch, search);
+}
+
+static TextSearch *
+text_search_new (GtkTextBuffer       *buffer,
+                 const gchar         *str,
+                 GtkTextSearchFlags   flags,
+                 GError             **error)
+{
+  TextSearch *search;
+  const gchar *p;
+
+  search = g_slice_new0 (TextSearch);
+  search->buffer = g_object_ref (buffer);
+  search->flags = flags;
+  search->str = g_strdup (str);
+  search->line_text = g_string_new (NULL);
+  search->matches = g_array_new (FALSE, FALSE, sizeof (GtkTextIter));
+
+  for (p = str; *p; p++)
+    {
+      if (*p == '\n')
+        search->n_newlines++;
+    }
+
+  if (flags & GTK_TEXT_SEARCH_REGEX)
+    {
+      GRegexCompileFlags compile_flags = G_REGEX_OPTIMIZE;
+
+      if (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE)
+        compile_flags |= G_REGEX_CASELESS;
+
+      search->regex = g_regex_new (str, compile_flags, 0, error);
+      if (search->regex == NULL)
+        {
+          text_search_free (search);
+          return NULL;
+        }
+
+      search->mode = SEARCH_REGEX;
+    }
+  else if ((flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0 ||
+           search->n_newlines > 0)
+    {
+      search->mode = SEARCH_ITER;
+    }
+  else if (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE)
+    {
+      gchar *casefold;
+
+      /* Same as what gtk_text_iter_forward_search() compares */
+      casefold = g_utf8_casefold (str, -1);
+      search->needle = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+      search->needle_len = strlen (search->needle);
+      g_free (casefold);
+
+      if (is_ascii (search->needle, search->needle_len))
+        {
+          init_fold_table ();
+          search->mode = SEARCH_ASCII_CASELESS;
+        }
+      else
+        search->mode = SEARCH_ITER;
+    }
+  else
+    {
+      search->needle = g_strdup (str);
+      search->needle_len = strlen (str);
+      search->mode = SEARCH_EXACT;
+    }
+
+  return search;
+}
+
+/* Returns the text of @line, with the unknown character standing in
+ * for embedded pixbufs and widgets, so that byte offsets in the text
+ * are line byte indexes. If the line is a single segment of text, it
+ * is not copied.
+ */
+static const gchar *
+text_search_get_line_text (TextSearch  *search,
+                           GtkTextLine *line,
+                           gsize       *length,
+                           gboolean    *has_objects)
+{
+  GtkTextLineSegment *seg;
+  GtkTextLineSegment *text_seg = NULL;
+  gint n_text_segs = 0;
+
+  *has_objects = FALSE;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        {
+          text_seg = seg;
+          n_text_segs++;
+        }
+      else if (seg->byte_count > 0)
+        *has_objects = TRUE;
+    }
+
+  if (n_text_segs == 1 && !*has_objects)
+    {
+      *length = text_seg->byte_count;
+      return text_seg->body.chars;
+    }
+
+  g_string_truncate (search->line_text, 0);
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        g_string_append_len (search->line_text, seg->body.chars, seg->byte_count);
+      else if (seg->byte_count > 0)
+        g_string_append_len (search->line_text,
+                             _gtk_text_unknown_char_utf8,
+                             GTK_TEXT_UNKNOWN_CHAR_UTF8_LEN);
+    }
+
+  *length = search->line_text->len;
+
+  return search->line_text->str;
+}
+
+static const gchar *
+find_exact (const gchar *text,
+            const gchar *text_end,
+            const gchar *needle,
+            gsize        needle_len)
+{
+  const gchar *p = text;
+
+  while ((gsize) (text_end - p) >= needle_len)
+    {
+      p = memchr (p, needle[0], text_end - p - needle_len + 1);
+      if (p == NULL)
+        return NULL;
+
+      if (memcmp (p + 1, needle + 1, needle_len - 1) == 0)
+        return p;
+
+      p++;
+    }
+
+  return NULL;
+}
+
+static const gchar *
+find_ascii_caseless (const gchar *text,
+                     const gchar *text_end,
+                     const gchar *needle,
+                     gsize        needle_len)
+{
+  const guchar *p = (const guchar *) text;
+  const guchar *n = (const guchar *) needle;
+  gsize i;
+
+  for (; (gsize) ((const guchar *) text_end - p) >= needle_len; p++)
+    {
+      if (fold_table[*p] != n[0])
+        continue;
+
+      for (i = 1; i < needle_len; i++)
+        {
+          if (fold_table[p[i]] != n[i])
+            break;
+        }
+
+      if (i == needle_len)
+        return (const gchar *) p;
+    }
+
+  return NULL;
+}
+
+static void
+text_search_add_match (TextSearch        *search,
+                       const GtkTextIter *match_start,
+                       const GtkTextIter *match_end)
+{
+  g_array_append_vals (search->matches, match_start, 1);
+  g_array_append_vals (search->matches, match_end, 1);
+  search->n_matches++;
+}
+
+/* Adds the match between the byte indexes @start and @end of @line,
+ * where @end may be the length of the line
+ */
+static void
+text_search_add_line_match (TextSearch  *search,
+                            GtkTextLine *line,
+                            gsize        length,
+                            gint         start,
+                            gint         end)
+{
+  GtkTextBTree *tree = _gtk_text_buffer_get_btree (search->buffer);
+  GtkTextIter match_start, match_end;
+
+  _gtk_text_btree_get_iter_at_line (tree, &match_start, line, start);
+
+  if (end < length)
+    _gtk_text_btree_get_iter_at_line (tree, &match_end, line, end);
+  else
+    {
+      _gtk_text_btree_get_iter_at_line (tree, &match_end, line, 0);
+      gtk_text_iter_forward_line (&match_end);
+    }
+
+  text_search_add_match (search, &match_start, &match_end);
+}
+
+/* Finds the matches starting on the line of @iter, from @iter on, with
+ * gtk_text_iter_forward_search(), and moves @iter to where the search
+ * continues.
+ */
+static void
+text_search_line_with_iters (TextSearch        *search,
+                             GtkTextIter       *iter,
+                             const GtkTextIter *end)
+{
+  GtkTextIter limit, match_start, match_end;
+  gint line;
+
+  line = gtk_text_iter_get_line (iter);
+
+  /* A match starting on this line can't end further down than this */
+  limit = *iter;
+  gtk_text_iter_forward_lines (&limit, search->n_newlines + 1);
+  if (gtk_text_iter_compare (&limit, end) > 0)
+    limit = *end;
+
+  while (gtk_text_iter_forward_search (iter, search->str,
+                                       search->flags & ~GTK_TEXT_SEARCH_REGEX,
+                                       &match_start, &match_end, &limit) &&
+         gtk_text_iter_get_line (&match_start) == line)
+    {
+      text_search_add_match (search, &match_start, &match_end);
+
+      *iter = match_end;
+      if (gtk_text_iter_get_line (iter) != line)
+        return;
+    }
+
+  gtk_text_iter_set_line (iter, line);
+  if (!gtk_text_iter_forward_line (iter))
+    gtk_text_iter_forward_to_end (iter);
+}
+
+/* Finds the matches on the line of @iter, from @iter on, and moves
+ * @iter to where the search continues.
+ */
+static void
+text_search_line (TextSearch        *search,
+                  GtkTextIter       *iter,
+                  const GtkTextIter *end)
+{
+  GtkTextLine *line;
+  const gchar *text, *found;
+  gsize length;
+  gboolean has_objects;
+  gint from, to;
+
+  if (search->mode == SEARCH_ITER)
+    {
+      text_search_line_with_iters (search, iter, end);
+      return;
+    }
+
+  line = _gtk_text_iter_get_text_line (iter);
+  text = text_search_get_line_text (search, line, &length, &has_objects);
+
+  /* Searching for text only skips the embedded objects */
+  if (has_objects &&
+      (search->flags & GTK_TEXT_SEARCH_TEXT_ONLY) != 0 &&
+      search->mode != SEARCH_REGEX)
+    {
+      text_search_line_with_iters (search, iter, end);
+      return;
+    }
+
+  if (search->mode == SEARCH_ASCII_CASELESS &&
+      !is_ascii (text, length))
+    {
+      text_search_line_with_iters (search, iter, end);
+      return;
+    }
+
+  from = gtk_text_iter_get_line_index (iter);
+  to = length;
+  if (line == _gtk_text_iter_get_text_line (end))
+    to = MIN (to, gtk_text_iter_get_line_index (end));
+
+  switch (search->mode)
+    {
+    case SEARCH_EXACT:
+      while ((found = find_exact (text + from, text + to,
+                                  search->needle, search->needle_len)))
+        {
+          from = found - text;
+          text_search_add_line_match (search, line, length,
+                                      from, from + search->needle_len);
+          from += search->needle_len;
+        }
+      break;
+
+    case SEARCH_ASCII_CASELESS:
+      while ((found = find_ascii_caseless (text + from, text + to,
+                                           search->needle, search->needle_len)))
+        {
+          from = found - text;
+          text_search_add_line_match (search, line, length,
+                                      from, from + search->needle_len);
+          from += search->needle_len;
+        }
+      break;
+
+    case SEARCH_REGEX:
+      {
+        GMatchInfo *info;
+        gint start, stop;
+
+        g_regex_match_full (search->regex, text, length, from, 0, &info, NULL);
+        while (g_match_info_matches (info))
+          {
+            g_match_info_fetch_pos (info, 0, &start, &stop);
+            if (stop > to)
+              break;
+
+            /* Empty matches can't be highlighted */
+            if (start < stop)
+              text_search_add_line_match (search, line, length, start, stop);
+
+            g_match_info_next (info, NULL);
+          }
+        g_match_info_free (info);
+      }
+      break;
+
+    case SEARCH_ITER:
+    default:
+      g_assert_not_reached ();
+    }
+
+  if (!gtk_text_iter_forward_line (iter))
+    gtk_text_iter_forward_to_end (iter);
+}
+
+static gdouble
+text_search_get_fraction (TextSearch        *search,
+                          const GtkTextIter *iter)
+{
+  gint n_lines = search->last_line - search->first_line + 1;
+  gint line = gtk_text_iter_get_line (iter) - search->first_line;
+
+  return CLAMP ((gdouble) line / n_lines, 0.0, 1.0);
+}
+
+static void
+text_search_flush (TextSearch *search,
+                   gdouble     fraction)
+{
+  if (search->func)
+    search->func (search->buffer,
+                  (const GtkTextIter *) search->matches->data,
+                  search->matches->len / 2,
+                  fraction,
+                  search->func_data);
+
+  g_array_set_size (search->matches, 0);
+}
+
+/* Searches from @iter to @end, moving @iter along. Returns %TRUE once
+ * @end is reached, or %FALSE if @deadline passed before. Without a
+ * deadline, full batches of matches are handed out as they fill up.
+ */
+static gboolean
+text_search_run (TextSearch        *search,
+                 GtkTextIter       *iter,
+                 const GtkTextIter *end,
+                 gint64             deadline)
+{
+  guint n_lines = 0;
+
+  while (gtk_text_iter_compare (iter, end) < 0)
+    {
+      text_search_line (search, iter, end);
+
+      if (deadline == 0)
+        {
+          if (search->matches->len >= 2 * SEARCH_BATCH_SIZE)
+            text_search_flush (search, text_search_get_fraction (search, iter));
+        }
+      else if (++n_lines % 16 == 0 &&
+               g_get_monotonic_time () >= deadline)
+        return gtk_text_iter_compare (iter, end) >= 0;
+    }
+
+  return TRUE;
+}
+
+static void
+get_search_range (GtkTextBuffer     *buffer,
+                  const GtkTextIter *start,
+                  const GtkTextIter *end,
+                  GtkTextIter       *range_start,
+                  GtkTextIter       *range_end)
+{
+  if (start)
+    *range_start = *start;
+  else
+    gtk_text_buffer_get_start_iter (buffer, range_start);
+
+  if (end)
+    *range_end = *end;
+  else
+    gtk_text_buffer_get_end_iter (buffer, range_end);
+
+  gtk_text_iter_order (range_start, range_end);
+}
+
+/**
+ * gtk_text_buffer_find_all:
+ * @buffer: a #GtkTextBuffer
+ * @str: the string to search for
+ * @flags: flags affecting how the search is done
+ * @start: (allow-none): where to start searching, or %NULL for the
+ *     start of @buffer
+ * @end: (allow-none): where to stop searching, or %NULL for the end
+ *     of @buffer
+ * @func: (scope call) (allow-none): function to call with the matches
+ * @user_data: user data for @func
+ * @error: return location for an error, or %NULL
+ *
+ * Finds all the non-overlapping matches of @str between @start and
+ * @end, the same that repeatedly calling gtk_text_iter_forward_search()
+ * from the end of the previous match would find, only much faster for
+ * the common kinds of searches.
+ *
+ * If @flags contains %GTK_TEXT_SEARCH_REGEX, @str is a regular
+ * expression, which is matched against the text of each line,
+ * including the embedded objects as the 0xFFFC character.
+ * %GTK_TEXT_SEARCH_VISIBLE_ONLY and %GTK_TEXT_SEARCH_TEXT_ONLY have
+ * no effect then. Empty matches are skipped.
+ *
+ * The matches are passed to @func in batches, while the search is
+ * going on, with a last call when it is done. @func must not modify
+ * @buffer.
+ *
+ * Returns: the number of matches, or -1 if @str is not a valid
+ *     regular expression
+ *
+ * Since: 3.16
+ */
+gint
+gtk_text_buffer_find_all (GtkTextBuffer             *buffer,
+                          const gchar               *str,
+                          GtkTextSearchFlags         flags,
+                          const GtkTextIter         *start,
+                          const GtkTextIter         *end,
+                          GtkTextBufferMatchesFunc   func,
+                          gpointer                   user_data,
+                          GError                   **error)
+{
+  TextSearch *search;
+  GtkTextIter iter, stop;
+  gint n_matches;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), -1);
+  g_return_val_if_fail (str != NULL, -1);
+  g_return_val_if_fail (start == NULL || gtk_text_iter_get_buffer (start) == buffer, -1);
+  g_return_val_if_fail (end == NULL || gtk_text_iter_get_buffer (end) == buffer, -1);
+  g_return_val_if_fail (error == NULL || *error == NULL, -1);
+
+  search = text_search_new (buffer, str, flags, error);
+  if (search == NULL)
+    return -1;
+
+  search->func = func;
+  search->func_data = user_data;
+
+  get_search_range (buffer, start, end, &iter, &stop);
+  search->first_line = gtk_text_iter_get_line (&iter);
+  search->last_line = gtk_text_iter_get_line (&stop);
+
+  if (*str != '\0')
+    text_search_run (search, &iter, &stop, 0);
+
+  text_search_flush (search, 1.0);
+
+  n_matches = search->n_matches;
+  text_search_free (search);
+
+  return n_matches;
+}
+
+static gboolean
+text_search_idle (gpointer data)
+{
+  GTask *task = data;
+  TextSearch *search = g_task_get_task_data (task);
+  GtkTextIter iter, end;
+  gboolean done;
+
+  if (g_task_return_error_if_cancelled (task))
+    return G_SOURCE_REMOVE;
+
+  gtk_text_buffer_get_iter_at_mark (search->buffer, &iter, search->pos_mark);
+  gtk_text_buffer_get_iter_at_mark (search->buffer, &end, search->end_mark);
+
+  done = text_search_run (search, &iter, &end,
+                          g_get_monotonic_time () + SEARCH_TIME_SLICE);
+
+  /* The matches function may change the buffer */
+  gtk_text_buffer_move_mark (search->buffer, search->pos_mark, &iter);
+  text_search_flush (search, done ? 1.0 : text_search_get_fraction (search, &iter));
+
+  if (!done)
+    return G_SOURCE_CONTINUE;
+
+  g_task_return_int (task, search->n_matches);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gtk_text_buffer_find_all_async:
+ * @buffer: a #GtkTextBuffer
+ * @str: the string to search for
+ * @flags: flags affecting how the search is done
+ * @start: (allow-none): where to start searching, or %NULL for the
+ *     start of @buffer
+ * @end: (allow-none): where to stop searching, or %NULL for the end
+ *     of @buffer
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @func: (scope notified) (allow-none): function to call with the matches
+ * @func_data: user data for @func
+ * @func_data_destroy: (allow-none): destroy notifier for @func_data
+ * @callback: (scope async): callback to call when the search is done
+ * @user_data: user data for @callback
+ *
+ * Like gtk_text_buffer_find_all(), but searches from the main loop in
+ * short time slices, so that the user interface stays responsive while
+ * a large buffer is searched. @func is called after each slice, with
+ * the matches found in it, which can be none, and the progress of the
+ * search.
+ *
+ * The range to search is tracked with marks, so @buffer can be
+ * changed while the search is running, including from @func. Text
+ * that is changed before the current position is not searched again.
+ *
+ * When the search is done, @callback is called, and can get the
+ * number of matches with gtk_text_buffer_find_all_finish().
+ *
+ * Since: 3.16
+ */
+void
+gtk_text_buffer_find_all_async (GtkTextBuffer             *buffer,
+                                const gchar               *str,
+                                GtkTextSearchFlags         flags,
+                                const GtkTextIter         *start,
+                                const GtkTextIter         *end,
+                                GCancellable              *cancellable,
+                                GtkTextBufferMatchesFunc   func,
+                                gpointer                   func_data,
+                                GDestroyNotify             func_data_destroy,
+                                GAsyncReadyCallback        callback,
+                                gpointer                   user_data)
+{
+  TextSearch *search;
+  GtkTextIter iter, stop;
+  GError *error = NULL;
+  GTask *task;
+  guint id;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (str != NULL);
+  g_return_if_fail (start == NULL || gtk_text_iter_get_buffer (start) == buffer);
+  g_return_if_fail (end == NULL || gtk_text_iter_get_buffer (end) == buffer);
+
+  task = g_task_new (buffer, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_text_buffer_find_all_async);
+
+  search = text_search_new (buffer, str, flags, &error);
+  if (search == NULL)
+    {
+      if (func_data_destroy)
+        func_data_destroy (func_data);
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  search->func = func;
+  search->func_data = func_data;
+  search->func_data_destroy = func_data_destroy;
+
+  get_search_range (buffer, start, end, &iter, &stop);
+  search->first_line = gtk_text_iter_get_line (&iter);
+  search->last_line = gtk_text_iter_get_line (&stop);
+
+  /* An empty string has no matches */
+  if (*str == '\0')
+    iter = stop;
+
+  search->pos_mark = g_object_ref (gtk_text_buffer_create_mark (buffer, NULL, &iter, TRUE));
+  search->end_mark = g_object_ref (gtk_text_buffer_create_mark (buffer, NULL, &stop, FALSE));
+
+  g_task_set_task_data (task, search, (GDestroyNotify) text_search_free);
+
+  id = gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                                  text_search_idle,
+                                  task, g_object_unref);
+  g_source_set_name_by_id (id, "[gtk+] text_search_idle");
+}
+
+/**
+ * gtk_text_buffer_find_all_finish:
+ * @buffer: a #GtkTextBuffer
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for an error, or %NULL
+ *
+ * Finishes a search started with gtk_text_buffer_find_all_async().
+ *
+ * Returns: the number of matches, or -1 if the search failed or was
+ *     cancelled
+ *
+ * Since: 3.16
+ */
+gint
+gtk_text_buffer_find_all_finish (GtkTextBuffer  *buffer,
+                                 GAsyncResult   *result,
+                                 GError        **error)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), -1);
+  g_return_val_if_fail (g_task_is_valid (result, buffer), -1);
+
+  return g_task_propagate_int (G_TASK (result), error);
+}
@@ -0,0 +1,80 @@
+/* GTK - The GIMP Toolkit
+ * gtktextbuffersearch.h: Searching for all matches in a GtkTextBuffer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_TEXT_BUFFER_SEARCH_H__
+#define __GTK_TEXT_BUFFER_SEARCH_H__
+
+#if !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#include <gio/gio.h>
+#include <gtk/gtktextbuffer.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GtkTextBufferMatchesFunc:
+ * @buffer: the #GtkTextBuffer that is searched
+ * @matches: the start and end iterators of the matches, one after
+ *     the other, so that there are 2 * @n_matches of them
+ * @n_matches: the number of matches in @matches
+ * @fraction: the fraction of the searched range that has been
+ *     searched so far, between 0.0 and 1.0
+ * @user_data: user data passed to the search function
+ *
+ * A function that is called with batches of matches found by
+ * gtk_text_buffer_find_all() and gtk_text_buffer_find_all_async().
+ * The iterators are only valid for the duration of the call.
+ *
+ * Since: 3.16
+ */
+typedef void (* GtkTextBufferMatchesFunc) (GtkTextBuffer     *buffer,
+                                           const GtkTextIter *matches,
+                                           guint              n_matches,
+                                           gdouble            fraction,
+                                           gpointer           user_data);
+
+GDK_AVAILABLE_IN_3_16
+gint     gtk_text_buffer_find_all        (GtkTextBuffer             *buffer,
+                                          const gchar               *str,
+                                          GtkTextSearchFlags         flags,
+                                          const GtkTextIter         *start,
+                                          const GtkTextIter         *end,
+                                          GtkTextBufferMatchesFunc   func,
+                                          gpointer                   user_data,
+                                          GError                   **error);
+GDK_AVAILABLE_IN_3_16
+void     gtk_text_buffer_find_all_async  (GtkTextBuffer             *buffer,
+                                          const gchar               *str,
+                                          GtkTextSearchFlags         flags,
+                                          const GtkTextIter         *start,
+                                          const GtkTextIter         *end,
+                                          GCancellable              *cancellable,
+                                          GtkTextBufferMatchesFunc   func,
+                                          gpointer                   func_data,
+                                          GDestroyNotify             func_data_destroy,
+                                          GAsyncReadyCallback        callback,
+                                          gpointer                   user_data);
+GDK_AVAILABLE_IN_3_16
+gint     gtk_text_buffer_find_all_finish (GtkTextBuffer             *buffer,
+                                          GAsyncResult              *result,
+                                          GError                   **error);
+
+G_END_DECLS
+
+#endif /* __GTK_TEXT_BUFFER_SEARCH_H__ */
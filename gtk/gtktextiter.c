@@ -2390,18 +2390,15 @@ gtk_text_iter_backward_chars (GtkTextIter *iter, gint count)
 
       if (real->line_byte_offset >= 0)
         {
-          const char *p;
           gint new_byte_offset;
 
-          /* if in the last fourth of the segment walk backwards */
-          if (count < real->segment_char_offset / 4)
-            p = g_utf8_offset_to_pointer (real->segment->body.chars + real->segment_byte_offset, 
-                                          -count);
+          /* Walking back a few chars is cheaper than any lookup */
+          if (count < MAX_LINEAR_SCAN)
+            new_byte_offset = g_utf8_offset_to_pointer (real->segment->body.chars + real->segment_byte_offset,
+                                                        -count) - real->segment->body.chars;
           else
-            p = g_utf8_offset_to_pointer (real->segment->body.chars,
-                                          real->segment_char_offset - count);
-
-          new_byte_offset = p - real->segment->body.chars;
+            new_byte_offset = _gtk_char_segment_char_to_byte (real->segment,
+                                                              real->segment_char_offset - count);
           real->line_byte_offset -= (real->segment_byte_offset - new_byte_offset);
           real->segment_byte_offset = new_byte_offset;
         }
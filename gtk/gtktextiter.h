@@ -43,6 +43,9 @@ G_BEGIN_DECLS
  * child widgets mixed inside the matched range.
  * @GTK_TEXT_SEARCH_CASE_INSENSITIVE: The text will be matched regardless of
  * what case it is in.
+ * @GTK_TEXT_SEARCH_REGEX: The string is a #GRegex pattern. This is only
+ * supported by gtk_text_buffer_find_all() and
+ * gtk_text_buffer_find_all_async(). Since 3.16
  *
  * Flags affecting how a search is done.
  *
@@ -53,8 +56,8 @@ G_BEGIN_DECLS
 typedef enum {
   GTK_TEXT_SEARCH_VISIBLE_ONLY     = 1 << 0,
   GTK_TEXT_SEARCH_TEXT_ONLY        = 1 << 1,
-  GTK_TEXT_SEARCH_CASE_INSENSITIVE = 1 << 2
-  /* Possible future plans: SEARCH_REGEXP */
+  GTK_TEXT_SEARCH_CASE_INSENSITIVE = 1 << 2,
+  GTK_TEXT_SEARCH_REGEX            = 1 << 3
 } GtkTextSearchFlags;
 
 /*
@@ -187,6 +187,39 @@ char_segment_self_check (GtkTextLineSegment *seg)
     }
 }
 
+/* Counts the characters in @len bytes of valid UTF-8 a word at a
+ * time, as the number of bytes that are not continuation bytes
+ */
+static gsize
+utf8_count_chars (const gchar *text,
+                  gsize        len)
+{
+  const gsize ones = (gsize) -1 / 0xff;
+  const guchar *p = (const guchar *) text;
+  const guchar *end = p + len;
+  gsize n_continuation = 0;
+  gsize word;
+
+  while ((gsize) (end - p) >= sizeof (gsize))
+    {
+      memcpy (&word, p, sizeof (gsize));
+
+      /* Bit 0 of each byte is set for bytes starting with 10 */
+      word = (word >> 7) & ~(word >> 6) & ones;
+      n_continuation += (word * ones) >> ((sizeof (gsize) - 1) * 8);
+
+      p += sizeof (gsize);
+    }
+
+  for (; p < end; p++)
+    {
+      if ((*p & 0xc0) == 0x80)
+        n_continuation++;
+    }
+
+  return len - n_continuation;
+}
+
 GtkTextLineSegment*
 _gtk_char_segment_new (const gchar *text, guint len)
 {
@@ -201,7 +234,7 @@ _gtk_char_segment_new (const gchar *text, guint len)
   memcpy (seg->body.chars, text, len);
   seg->body.chars[len] = '\0';
 
-  seg->char_count = g_utf8_strlen (seg->body.chars, seg->byte_count);
+  seg->char_count = utf8_count_chars (seg->body.chars, seg->byte_count);
 
   if (gtk_get_debug_flags () & GTK_DEBUG_TEXT)
     char_segment_self_check (seg);
@@ -238,6 +271,175 @@ _gtk_char_segment_new_from_two_strings (const gchar *text1,
   return seg;
 }
 
+/*
+ * Converting between char and byte offsets in a segment means
+ * counting characters from its start. Long segments with multibyte
+ * characters, as found in minified files, get an index with the byte
+ * offset of every CHAR_INDEX_STRIDE-th character the first time they
+ * are looked up, so that only a few characters have to be counted.
+ * Char segments never change once created, so the indexes of the
+ * last few segments are kept until the segments are freed.
+ */
+#define CHAR_INDEX_MIN_BYTES 4096
+#define CHAR_INDEX_STRIDE 256
+#define CHAR_INDEX_CACHE_SIZE 8
+
+typedef struct
+{
+  const GtkTextLineSegment *seg;
+  gint *byte_offsets;
+  guint age;
+} CharIndex;
+
+static CharIndex char_indexes[CHAR_INDEX_CACHE_SIZE];
+static guint char_index_age;
+
+/* Lines can be built and freed in other threads, see GtkTextBTreeLoader */
+G_LOCK_DEFINE_STATIC (char_indexes);
+
+static const gint *
+char_segment_get_index (const GtkTextLineSegment *seg)
+{
+  CharIndex *index = NULL;
+  const gchar *p;
+  gint n_chars, i;
+
+  G_LOCK (char_indexes);
+
+  for (i = 0; i < CHAR_INDEX_CACHE_SIZE; i++)
+    {
+      if (char_indexes[i].seg == seg)
+        {
+          index = &char_indexes[i];
+          index->age = ++char_index_age;
+          G_UNLOCK (char_indexes);
+
+          return index->byte_offsets;
+        }
+
+      if (index == NULL || char_indexes[i].age < index->age)
+        index = &char_indexes[i];
+    }
+
+  g_free (index->byte_offsets);
+  index->seg = seg;
+  index->byte_offsets = g_new (gint, seg->char_count / CHAR_INDEX_STRIDE + 1);
+  index->age = ++char_index_age;
+
+  n_chars = 0;
+  for (p = seg->body.chars; p < seg->body.chars + seg->byte_count; p++)
+    {
+      if (((guchar) *p & 0xc0) == 0x80)
+        continue;
+
+      if (n_chars % CHAR_INDEX_STRIDE == 0)
+        index->byte_offsets[n_chars / CHAR_INDEX_STRIDE] = p - seg->body.chars;
+      n_chars++;
+    }
+
+  G_UNLOCK (char_indexes);
+
+  return index->byte_offsets;
+}
+
+static void
+char_segment_drop_index (const GtkTextLineSegment *seg)
+{
+  gint i;
+
+  G_LOCK (char_indexes);
+
+  for (i = 0; i < CHAR_INDEX_CACHE_SIZE; i++)
+    {
+      if (char_indexes[i].seg == seg)
+        {
+          g_free (char_indexes[i].byte_offsets);
+          char_indexes[i].seg = NULL;
+          char_indexes[i].byte_offsets = NULL;
+          char_indexes[i].age = 0;
+          break;
+        }
+    }
+
+  G_UNLOCK (char_indexes);
+}
+
+/* Returns the byte offset of the character at @char_offset in @seg */
+gint
+_gtk_char_segment_char_to_byte (const GtkTextLineSegment *seg,
+                                gint                      char_offset)
+{
+  const gint *byte_offsets;
+  const gchar *p;
+
+  g_assert (seg->type == &gtk_text_char_type);
+  g_assert (char_offset >= 0 && char_offset <= seg->char_count);
+
+  /* No chars use more than one byte */
+  if (seg->byte_count == seg->char_count)
+    return char_offset;
+
+  if (seg->byte_count < CHAR_INDEX_MIN_BYTES)
+    {
+      /* if in the last fourth of the segment walk backwards */
+      if (seg->char_count - char_offset < seg->char_count / 4)
+        p = g_utf8_offset_to_pointer (seg->body.chars + seg->byte_count,
+                                      char_offset - seg->char_count);
+      else
+        p = g_utf8_offset_to_pointer (seg->body.chars, char_offset);
+
+      return p - seg->body.chars;
+    }
+
+  if (char_offset == seg->char_count)
+    return seg->byte_count;
+
+  byte_offsets = char_segment_get_index (seg);
+  p = g_utf8_offset_to_pointer (seg->body.chars + byte_offsets[char_offset / CHAR_INDEX_STRIDE],
+                                char_offset % CHAR_INDEX_STRIDE);
+
+  return p - seg->body.chars;
+}
+
+/* Returns the char offset of the character at @byte_offset in @seg */
+gint
+_gtk_char_segment_byte_to_char (const GtkTextLineSegment *seg,
+                                gint                      byte_offset)
+{
+  const gint *byte_offsets;
+  gint low, high, mid;
+
+  g_assert (seg->type == &gtk_text_char_type);
+  g_assert (byte_offset >= 0 && byte_offset <= seg->byte_count);
+
+  /* No chars use more than one byte */
+  if (seg->byte_count == seg->char_count)
+    return byte_offset;
+
+  if (seg->byte_count < CHAR_INDEX_MIN_BYTES)
+    return utf8_count_chars (seg->body.chars, byte_offset);
+
+  if (byte_offset == seg->byte_count)
+    return seg->char_count;
+
+  /* Find the last indexed character at or before @byte_offset */
+  byte_offsets = char_segment_get_index (seg);
+  low = 0;
+  high = (seg->char_count - 1) / CHAR_INDEX_STRIDE;
+  while (low < high)
+    {
+      mid = (low + high + 1) / 2;
+      if (byte_offsets[mid] <= byte_offset)
+        low = mid;
+      else
+        high = mid - 1;
+    }
+
+  return low * CHAR_INDEX_STRIDE +
+         utf8_count_chars (seg->body.chars + byte_offsets[low],
+                           byte_offset - byte_offsets[low]);
+}
+
 static void
 _gtk_char_segment_free (GtkTextLineSegment *seg)
 {
@@ -246,6 +448,10 @@ _gtk_char_segment_free (GtkTextLineSegment *seg)
 
   g_assert (seg->type == &gtk_text_char_type);
 
+  if (seg->byte_count >= CHAR_INDEX_MIN_BYTES &&
+      seg->byte_count != seg->char_count)
+    char_segment_drop_index (seg);
+
   g_slice_free1 (CSEG_SIZE (seg->byte_count), seg);
 }
 
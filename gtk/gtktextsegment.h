@@ -161,6 +161,10 @@ GtkTextLineSegment *_gtk_char_segment_new_from_two_strings (const gchar    *text
                                                             const gchar    *text2,
                                                             guint           len2,
 							    guint           chars2);
+gint                _gtk_char_segment_char_to_byte         (const GtkTextLineSegment *seg,
+                                                            gint                      char_offset);
+gint                _gtk_char_segment_byte_to_char         (const GtkTextLineSegment *seg,
+                                                            gint                      byte_offset);
 GtkTextLineSegment *_gtk_toggle_segment_new                (GtkTextTagInfo *info,
                                                             gboolean        on);
 
@@ -34,6 +34,20 @@ _gtk_tree_data_list_alloc (void)
   return list;
 }
 
+static void
+gtk_tree_data_list_free_data (GtkTreeDataList *node,
+                              GType            type)
+{
+  if (g_type_is_a (type, G_TYPE_STRING))
+    g_free ((gchar *) node->data.v_pointer);
+  else if (g_type_is_a (type, G_TYPE_OBJECT) && node->data.v_pointer != NULL)
+    g_object_unref (node->data.v_pointer);
+  else if (g_type_is_a (type, G_TYPE_BOXED) && node->data.v_pointer != NULL)
+    g_boxed_free (type, (gpointer) node->data.v_pointer);
+  else if (g_type_is_a (type, G_TYPE_VARIANT) && node->data.v_pointer != NULL)
+    g_variant_unref ((gpointer) node->data.v_pointer);
+}
+
 void
 _gtk_tree_data_list_free (GtkTreeDataList *list,
 			  GType           *column_headers)
@@ -46,21 +60,75 @@ _gtk_tree_data_list_free (GtkTreeDataList *list,
   while (tmp)
     {
       next = tmp->next;
-      if (g_type_is_a (column_headers [i], G_TYPE_STRING))
-	g_free ((gchar *) tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_OBJECT) && tmp->data.v_pointer != NULL)
-	g_object_unref (tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_BOXED) && tmp->data.v_pointer != NULL)
-	g_boxed_free (column_headers [i], (gpointer) tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_VARIANT) && tmp->data.v_pointer != NULL)
-	g_variant_unref ((gpointer) tmp->data.v_pointer);
-
+      gtk_tree_data_list_free_data (tmp, column_headers[i]);
       g_slice_free (GtkTreeDataList, tmp);
       i++;
       tmp = next;
     }
 }
 
+/* row allocation
+ *
+ * A row is a single block holding one zero-initialized cell per
+ * column, which is what an unset cell looks like. The cells are
+ * chained through ->next, so a row can be passed to the functions
+ * that walk a list; but it must only be freed with
+ * _gtk_tree_data_list_row_free().
+ */
+GtkTreeDataList *
+_gtk_tree_data_list_row_new (gint n_columns)
+{
+  GtkTreeDataList *row;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  row = g_new0 (GtkTreeDataList, n_columns);
+  for (i = 0; i < n_columns - 1; i++)
+    row[i].next = &row[i + 1];
+
+  return row;
+}
+
+void
+_gtk_tree_data_list_row_free (GtkTreeDataList *row,
+                              GType           *column_headers,
+                              gint             n_columns)
+{
+  gint i;
+
+  if (row == NULL)
+    return;
+
+  for (i = 0; i < n_columns; i++)
+    gtk_tree_data_list_free_data (&row[i], column_headers[i]);
+
+  g_free (row);
+}
+
+GtkTreeDataList *
+_gtk_tree_data_list_row_copy (GtkTreeDataList *row,
+                              GType           *column_headers,
+                              gint             n_columns)
+{
+  GtkTreeDataList *copy;
+  GtkTreeDataList *node;
+  gint i;
+
+  if (row == NULL)
+    return NULL;
+
+  copy = _gtk_tree_data_list_row_new (n_columns);
+  for (i = 0; i < n_columns; i++)
+    {
+      node = _gtk_tree_data_list_node_copy (&row[i], column_headers[i]);
+      copy[i].data = node->data;
+      g_slice_free (GtkTreeDataList, node);
+    }
+
+  return copy;
+}
+
 gboolean
 _gtk_tree_data_list_check_type (GType type)
 {
@@ -464,6 +532,376 @@ _gtk_tree_data_list_compare_func (GtkTreeModel *model,
 }
 
 
+/* Sorting by key
+ *
+ * Sorting with _gtk_tree_data_list_compare_func() fetches two GValues
+ * per comparison, and collates strings from scratch every time. For the
+ * types it knows about, the same order can be obtained by extracting one
+ * key per row up front and sorting the keys instead. Strings are turned
+ * into g_utf8_collate_key() keys, which compare with strcmp() the same
+ * way g_utf8_collate() compares the strings.
+ *
+ * Computing collation keys and sorting are split in chunks that are
+ * handled by separate threads on large inputs, and the sorted chunks are
+ * merged afterwards. Fetching the values stays on the calling thread,
+ * since tree models aren't thread-safe.
+ */
+
+#define SORT_KEY_MIN_CHUNK 4096
+
+typedef enum {
+  SORT_KEY_NONE,
+  SORT_KEY_INT,
+  SORT_KEY_UINT,
+  SORT_KEY_DOUBLE,
+  SORT_KEY_STRING
+} SortKeyType;
+
+typedef struct {
+  union {
+    gint64 i;
+    guint64 u;
+    gdouble d;
+    gchar *s;
+  } key;
+  gint index;
+} SortKey;
+
+typedef struct {
+  SortKeyType type;
+  gboolean descending;
+  SortKey *keys;
+  SortKey *dest;
+  gint start;
+  gint middle;
+  gint end;
+} SortKeyJob;
+
+static SortKeyType
+get_sort_key_type (GType type)
+{
+  switch (get_fundamental_type (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+    case G_TYPE_ENUM:
+      return SORT_KEY_INT;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+    case G_TYPE_FLAGS:
+      return SORT_KEY_UINT;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      return SORT_KEY_DOUBLE;
+    case G_TYPE_STRING:
+      return SORT_KEY_STRING;
+    default:
+      return SORT_KEY_NONE;
+    }
+}
+
+static void
+sort_key_from_value (SortKey      *key,
+                     SortKeyType   key_type,
+                     const GValue *value)
+{
+  switch (get_fundamental_type (G_VALUE_TYPE (value)))
+    {
+    case G_TYPE_BOOLEAN:
+      key->key.i = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      key->key.i = g_value_get_schar (value);
+      break;
+    case G_TYPE_INT:
+      key->key.i = g_value_get_int (value);
+      break;
+    case G_TYPE_LONG:
+      key->key.i = g_value_get_long (value);
+      break;
+    case G_TYPE_INT64:
+      key->key.i = g_value_get_int64 (value);
+      break;
+    case G_TYPE_ENUM:
+      key->key.i = g_value_get_enum (value);
+      break;
+    case G_TYPE_UCHAR:
+      key->key.u = g_value_get_uchar (value);
+      break;
+    case G_TYPE_UINT:
+      key->key.u = g_value_get_uint (value);
+      break;
+    case G_TYPE_ULONG:
+      key->key.u = g_value_get_ulong (value);
+      break;
+    case G_TYPE_UINT64:
+      key->key.u = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_FLAGS:
+      key->key.u = g_value_get_flags (value);
+      break;
+    case G_TYPE_FLOAT:
+      key->key.d = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      key->key.d = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      /* replaced by the collation key later on */
+      key->key.s = g_value_dup_string (value);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+/* Must return the same as _gtk_tree_data_list_compare_func() would
+ * for the values the keys were made from.
+ */
+static gint
+compare_sort_keys (const SortKey *a,
+                   const SortKey *b,
+                   SortKeyType    key_type,
+                   gboolean       descending)
+{
+  gint retval;
+
+  switch (key_type)
+    {
+    case SORT_KEY_INT:
+      retval = a->key.i < b->key.i ? -1 : (a->key.i == b->key.i ? 0 : 1);
+      break;
+    case SORT_KEY_UINT:
+      retval = a->key.u < b->key.u ? -1 : (a->key.u == b->key.u ? 0 : 1);
+      break;
+    case SORT_KEY_DOUBLE:
+      retval = a->key.d < b->key.d ? -1 : (a->key.d == b->key.d ? 0 : 1);
+      break;
+    case SORT_KEY_STRING:
+      retval = strcmp (a->key.s, b->key.s);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  if (descending)
+    {
+      if (retval > 0)
+        retval = -1;
+      else if (retval < 0)
+        retval = 1;
+    }
+
+  return retval;
+}
+
+static gint
+sort_key_compare_func (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  SortKeyJob *job = user_data;
+
+  return compare_sort_keys (a, b, job->type, job->descending);
+}
+
+static gpointer
+sort_key_chunk_thread (gpointer data)
+{
+  SortKeyJob *job = data;
+  gint i;
+
+  if (job->type == SORT_KEY_STRING)
+    {
+      for (i = job->start; i < job->end; i++)
+        {
+          gchar *str = job->keys[i].key.s;
+
+          job->keys[i].key.s = g_utf8_collate_key (str ? str : "", -1);
+          g_free (str);
+        }
+    }
+
+  /* g_qsort_with_data() is stable, as g_sequence_sort() is */
+  g_qsort_with_data (job->keys + job->start, job->end - job->start,
+                     sizeof (SortKey), sort_key_compare_func, job);
+
+  return NULL;
+}
+
+static gpointer
+sort_key_merge_thread (gpointer data)
+{
+  SortKeyJob *job = data;
+  gint i, j, k;
+
+  i = job->start;
+  j = job->middle;
+  k = job->start;
+
+  /* Taking from the left run on ties keeps the merge stable */
+  while (i < job->middle && j < job->end)
+    {
+      if (compare_sort_keys (&job->keys[j], &job->keys[i], job->type, job->descending) < 0)
+        job->dest[k++] = job->keys[j++];
+      else
+        job->dest[k++] = job->keys[i++];
+    }
+
+  memcpy (job->dest + k, job->keys + i, (job->middle - i) * sizeof (SortKey));
+  k += job->middle - i;
+  memcpy (job->dest + k, job->keys + j, (job->end - j) * sizeof (SortKey));
+
+  return NULL;
+}
+
+/* Runs @func on every job, in parallel when there is more than one */
+static void
+run_sort_key_jobs (GThreadFunc  func,
+                   SortKeyJob  *jobs,
+                   gint         n_jobs)
+{
+  GThread **threads;
+  gint i;
+
+  if (n_jobs == 1)
+    {
+      func (&jobs[0]);
+      return;
+    }
+
+  threads = g_new (GThread *, n_jobs);
+
+  /* The calling thread takes the first job itself */
+  for (i = 1; i < n_jobs; i++)
+    threads[i] = g_thread_new ("gtk-sort", func, &jobs[i]);
+
+  func (&jobs[0]);
+
+  for (i = 1; i < n_jobs; i++)
+    g_thread_join (threads[i]);
+
+  g_free (threads);
+}
+
+/**
+ * _gtk_tree_data_list_can_sort_by_key:
+ * @func: the sort function
+ * @type: the type of the sort column
+ *
+ * Returns whether _gtk_tree_data_list_sort_by_key() can be used
+ * instead of sorting with @func on a column of type @type.
+ */
+gboolean
+_gtk_tree_data_list_can_sort_by_key (GtkTreeIterCompareFunc func,
+                                     GType                  type)
+{
+  return func == _gtk_tree_data_list_compare_func &&
+         get_sort_key_type (type) != SORT_KEY_NONE;
+}
+
+/**
+ * _gtk_tree_data_list_sort_by_key:
+ * @model: the model holding the rows
+ * @column: the column to sort on
+ * @order: the sort order
+ * @iters: the rows to sort
+ * @n_iters: the number of rows in @iters
+ *
+ * Sorts @iters the way sorting them with _gtk_tree_data_list_compare_func()
+ * would, see _gtk_tree_data_list_can_sort_by_key().
+ *
+ * Returns: a newly allocated array of @n_iters indexes into @iters,
+ *   in sorted order
+ */
+gint *
+_gtk_tree_data_list_sort_by_key (GtkTreeModel *model,
+                                 gint          column,
+                                 GtkSortType   order,
+                                 GtkTreeIter  *iters,
+                                 gint          n_iters)
+{
+  GValue value = G_VALUE_INIT;
+  SortKeyType key_type;
+  SortKey *keys, *tmp;
+  SortKeyJob *jobs;
+  gint *result;
+  gint n_chunks, chunk_size, width;
+  gint i;
+
+  key_type = get_sort_key_type (gtk_tree_model_get_column_type (model, column));
+  g_return_val_if_fail (key_type != SORT_KEY_NONE, NULL);
+
+  keys = g_new (SortKey, n_iters);
+
+  for (i = 0; i < n_iters; i++)
+    {
+      gtk_tree_model_get_value (model, &iters[i], column, &value);
+      sort_key_from_value (&keys[i], key_type, &value);
+      keys[i].index = i;
+      g_value_unset (&value);
+    }
+
+  n_chunks = CLAMP (n_iters / SORT_KEY_MIN_CHUNK, 1, (gint) g_get_num_processors ());
+  chunk_size = (n_iters + n_chunks - 1) / n_chunks;
+
+  jobs = g_new (SortKeyJob, n_chunks);
+  for (i = 0; i < n_chunks; i++)
+    {
+      jobs[i].type = key_type;
+      jobs[i].descending = order == GTK_SORT_DESCENDING;
+      jobs[i].keys = keys;
+      jobs[i].dest = NULL;
+      jobs[i].start = MIN (i * chunk_size, n_iters);
+      jobs[i].end = MIN ((i + 1) * chunk_size, n_iters);
+    }
+
+  run_sort_key_jobs (sort_key_chunk_thread, jobs, n_chunks);
+
+  /* Merge the sorted chunks pairwise until one run is left */
+  tmp = n_chunks > 1 ? g_new (SortKey, n_iters) : NULL;
+  for (width = chunk_size; width < n_iters; width *= 2)
+    {
+      SortKey *swap;
+      gint n_jobs = 0;
+
+      for (i = 0; i < n_iters; i += 2 * width)
+        {
+          jobs[n_jobs].keys = keys;
+          jobs[n_jobs].dest = tmp;
+          jobs[n_jobs].start = i;
+          jobs[n_jobs].middle = MIN (i + width, n_iters);
+          jobs[n_jobs].end = MIN (i + 2 * width, n_iters);
+          n_jobs++;
+        }
+
+      run_sort_key_jobs (sort_key_merge_thread, jobs, n_jobs);
+
+      swap = keys;
+      keys = tmp;
+      tmp = swap;
+    }
+
+  result = g_new (gint, n_iters);
+  for (i = 0; i < n_iters; i++)
+    {
+      result[i] = keys[i].index;
+      if (key_type == SORT_KEY_STRING)
+        g_free (keys[i].key.s);
+    }
+
+  g_free (tmp);
+  g_free (keys);
+  g_free (jobs);
+
+  return result;
+}
+
 GList *
 _gtk_tree_data_list_header_new (gint   n_columns,
 				GType *types)
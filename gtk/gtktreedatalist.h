@@ -62,11 +62,26 @@ void             _gtk_tree_data_list_value_to_node  (GtkTreeDataList *list,
 GtkTreeDataList *_gtk_tree_data_list_node_copy      (GtkTreeDataList *list,
                                                      GType            type);
 
+GtkTreeDataList *_gtk_tree_data_list_row_new        (gint             n_columns);
+void             _gtk_tree_data_list_row_free       (GtkTreeDataList *row,
+                                                     GType           *column_headers,
+                                                     gint             n_columns);
+GtkTreeDataList *_gtk_tree_data_list_row_copy       (GtkTreeDataList *row,
+                                                     GType           *column_headers,
+                                                     gint             n_columns);
+
 /* Header code */
 gint                   _gtk_tree_data_list_compare_func (GtkTreeModel *model,
 							 GtkTreeIter  *a,
 							 GtkTreeIter  *b,
 							 gpointer      user_data);
+gboolean               _gtk_tree_data_list_can_sort_by_key (GtkTreeIterCompareFunc func,
+                                                            GType                  type);
+gint *                 _gtk_tree_data_list_sort_by_key (GtkTreeModel *model,
+                                                        gint          column,
+                                                        GtkSortType   order,
+                                                        GtkTreeIter  *iters,
+                                                        gint          n_iters);
 GList *                _gtk_tree_data_list_header_new  (gint          n_columns,
 							GType        *types);
 void                   _gtk_tree_data_list_header_free (GList        *header_list);
@@ -247,10 +247,12 @@ enum {
   ROW_HAS_CHILD_TOGGLED,
   ROW_DELETED,
   ROWS_REORDERED,
+  ROWS_INSERTED,
   LAST_SIGNAL
 };
 
 static guint tree_model_signals[LAST_SIGNAL] = { 0 };
+static GQuark batched_quark = 0;
 
 struct _GtkTreePath
 {
@@ -338,6 +340,8 @@ gtk_tree_model_base_init (gpointer g_class)
       GType row_deleted_params[1];
       GType rows_reordered_params[3];
 
+      batched_quark = g_quark_from_static_string ("batched");
+
       row_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
       row_inserted_params[1] = GTK_TYPE_TREE_ITER;
 
@@ -391,13 +395,19 @@ gtk_tree_model_base_init (gpointer g_class)
        * Note that the row may still be empty at this point, since
        * it is a common pattern to first insert an empty row, and
        * then fill it with the desired values.
+       *
+       * When the row is part of a range that is going to be announced
+       * with #GtkTreeModel::rows-inserted, the signal is emitted with
+       * the "batched" detail. Handlers that also connect to
+       * #GtkTreeModel::rows-inserted can use g_signal_get_invocation_hint()
+       * to recognize and skip these emissions.
        */
       closure = g_closure_new_simple (sizeof (GClosure), NULL);
       g_closure_set_marshal (closure, row_inserted_marshal);
       tree_model_signals[ROW_INSERTED] =
         g_signal_newv (I_("row-inserted"),
                        GTK_TYPE_TREE_MODEL,
-                       G_SIGNAL_RUN_FIRST,
+                       G_SIGNAL_RUN_FIRST | G_SIGNAL_DETAILED,
                        closure,
                        NULL, NULL,
                        _gtk_marshal_VOID__BOXED_BOXED,
@@ -479,6 +489,37 @@ gtk_tree_model_base_init (gpointer g_class)
                        _gtk_marshal_VOID__BOXED_BOXED_POINTER,
                        G_TYPE_NONE, 3,
                        rows_reordered_params);
+
+      /**
+       * GtkTreeModel::rows-inserted:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath-struct identifying the first new row
+       * @iter: a valid #GtkTreeIter-struct pointing to the first new row
+       * @n_rows: the number of consecutive sibling rows that were inserted
+       *
+       * This signal is emitted after @n_rows consecutive sibling rows,
+       * starting at @path, have been inserted in the model.
+       *
+       * Models emitting this signal still emit #GtkTreeModel::row-inserted
+       * for each row as it is inserted, with the "batched" detail, so
+       * that handlers which only know about single rows keep working.
+       * A handler that wants to process the whole range at once should
+       * ignore the "batched" emissions of #GtkTreeModel::row-inserted.
+       *
+       * Since: 3.16
+       */
+      tree_model_signals[ROWS_INSERTED] =
+        g_signal_new (I_("rows-inserted"),
+                      GTK_TYPE_TREE_MODEL,
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL, NULL,
+                      _gtk_marshal_VOID__BOXED_BOXED_INT,
+                      G_TYPE_NONE, 3,
+                      GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE,
+                      GTK_TYPE_TREE_ITER,
+                      G_TYPE_INT);
+
       initialized = TRUE;
     }
 }
@@ -1852,6 +1893,65 @@ gtk_tree_model_row_inserted (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], 0, path, iter);
 }
 
+/* Emits ::row-inserted with the "batched" detail, for rows that
+ * are going to be announced with gtk_tree_model_rows_inserted().
+ */
+void
+_gtk_tree_model_row_inserted_batched (GtkTreeModel *tree_model,
+                                      GtkTreePath  *path,
+                                      GtkTreeIter  *iter)
+{
+  g_signal_emit (tree_model, tree_model_signals[ROW_INSERTED], batched_quark, path, iter);
+}
+
+/* Returns whether the ::row-inserted emission currently running on
+ * @tree_model is one of the per-row emissions of a batch.
+ */
+gboolean
+_gtk_tree_model_is_batched_emission (GtkTreeModel *tree_model)
+{
+  GSignalInvocationHint *hint;
+
+  hint = g_signal_get_invocation_hint (tree_model);
+
+  return hint != NULL && hint->detail == batched_quark;
+}
+
+/**
+ * gtk_tree_model_rows_inserted:
+ * @tree_model: a #GtkTreeModel
+ * @path: a #GtkTreePath-struct pointing to the first inserted row
+ * @iter: a valid #GtkTreeIter-struct pointing to the first inserted row
+ * @n_rows: the number of consecutive sibling rows that were inserted
+ *
+ * Emits the #GtkTreeModel::rows-inserted signal on @tree_model.
+ *
+ * This should be called after the rows have been inserted, and after
+ * #GtkTreeModel::row-inserted has been emitted with the "batched"
+ * detail for each of them, e.g. with
+ * |[<!-- language="C" -->
+ *   g_signal_emit_by_name (model, "row-inserted::batched", path, iter);
+ * ]|
+ *
+ * Since: 3.16
+ */
+void
+gtk_tree_model_rows_inserted (GtkTreeModel *tree_model,
+                              GtkTreePath  *path,
+                              GtkTreeIter  *iter,
+                              gint          n_rows)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (n_rows >= 0);
+
+  if (n_rows == 0)
+    return;
+
+  g_signal_emit (tree_model, tree_model_signals[ROWS_INSERTED], 0, path, iter, n_rows);
+}
+
 /**
  * gtk_tree_model_row_has_child_toggled:
  * @tree_model: a #GtkTreeModel
@@ -20,6 +20,7 @@
 #include "gtktreemodelfilter.h"
 #include "gtkintl.h"
 #include "gtktreednd.h"
+#include "gtktreeprivate.h"
 #include "gtkprivate.h"
 #include <string.h>
 
@@ -287,10 +288,20 @@ struct _GtkTreeModelFilterPrivate
 
   guint in_row_deleted       : 1;
   guint virtual_root_deleted : 1;
+  guint refilter_narrow      : 1;
+
+  /* asynchronous refilter */
+  guint refilter_id;
+  GtkTreeRowReference *refilter_row;
+
+  /* rows of a batch in the child model, announced as a range */
+  GtkTreePath *batch_path;
+  gint batch_n_rows;
 
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
   gulong reordered_id;
@@ -347,6 +358,11 @@ static void         gtk_tree_model_filter_row_inserted                    (GtkTr
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_rows_inserted                   (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gint                    n_rows,
+                                                                           gpointer                data);
 static void         gtk_tree_model_filter_row_has_child_toggled           (GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
                                                                            GtkTreeIter            *c_iter,
@@ -453,6 +469,7 @@ static void         gtk_tree_model_filter_real_unref_node                 (GtkTr
                                                                            gboolean                external,
                                                                            gboolean                propagate_unref);
 
+static void         gtk_tree_model_filter_cancel_refilter                 (GtkTreeModelFilter     *filter);
 static void         gtk_tree_model_filter_set_model                       (GtkTreeModelFilter     *filter,
                                                                            GtkTreeModel           *child_model);
 static void         gtk_tree_model_filter_ref_path                        (GtkTreeModelFilter     *filter,
@@ -489,7 +506,8 @@ static void         gtk_tree_model_filter_update_children                 (GtkTr
 static void         gtk_tree_model_filter_emit_row_inserted_for_path      (GtkTreeModelFilter     *filter,
                                                                            GtkTreeModel           *c_model,
                                                                            GtkTreePath            *c_path,
-                                                                           GtkTreeIter            *c_iter);
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gboolean                batched);
 
 
 G_DEFINE_TYPE_WITH_CODE (GtkTreeModelFilter, gtk_tree_model_filter, G_TYPE_OBJECT,
@@ -1413,7 +1431,8 @@ gtk_tree_model_filter_check_ancestors (GtkTreeModelFilter *filter,
           gtk_tree_model_filter_emit_row_inserted_for_path (filter,
                                                             filter->priv->child_model,
                                                             c_path,
-                                                            &c_iter);
+                                                            &c_iter,
+                                                            FALSE);
 
           gtk_tree_path_free (c_path);
 
@@ -1484,7 +1503,8 @@ gtk_tree_model_filter_check_ancestors (GtkTreeModelFilter *filter,
                   gtk_tree_model_filter_emit_row_inserted_for_path (filter,
                                                                     filter->priv->child_model,
                                                                     c_path,
-                                                                    &c_iter);
+                                                                    &c_iter,
+                                                                    FALSE);
 
                   gtk_tree_path_free (c_path);
                 }
@@ -1889,11 +1909,17 @@ find_elt_with_offset (GtkTreeModelFilter *filter,
 }
 
 /* TreeModel signals */
+
+/* Rows of a batch in the child model are passed on as part of a batch.
+ * Their visible rows are consecutive in the filter too, since the rows
+ * between them in the batch are not visible.
+ */
 static void
 gtk_tree_model_filter_emit_row_inserted_for_path (GtkTreeModelFilter *filter,
                                                   GtkTreeModel       *c_model,
                                                   GtkTreePath        *c_path,
-                                                  GtkTreeIter        *c_iter)
+                                                  GtkTreeIter        *c_iter,
+                                                  gboolean            batched)
 {
   FilterLevel *level;
   FilterElt *elt;
@@ -1956,7 +1982,18 @@ gtk_tree_model_filter_emit_row_inserted_for_path (GtkTreeModelFilter *filter,
 
       if (!signals_emitted &&
           (!level->parent_level || level->ext_ref_count > 0))
-        gtk_tree_model_row_inserted (GTK_TREE_MODEL (filter), path, &iter);
+        {
+          if (batched)
+            {
+              if (filter->priv->batch_path == NULL)
+                filter->priv->batch_path = gtk_tree_path_copy (path);
+              filter->priv->batch_n_rows++;
+
+              _gtk_tree_model_row_inserted_batched (GTK_TREE_MODEL (filter), path, &iter);
+            }
+          else
+            gtk_tree_model_row_inserted (GTK_TREE_MODEL (filter), path, &iter);
+        }
 
       if (level->parent_level && level->parent_elt->ext_ref_count > 0 &&
           g_sequence_get_length (level->visible_seq) == 1)
@@ -2097,7 +2134,7 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
     gtk_tree_model_filter_check_ancestors (filter, real_path);
 
   gtk_tree_model_filter_emit_row_inserted_for_path (filter, c_model,
-                                                    c_path, c_iter);
+                                                    c_path, c_iter, FALSE);
 
 done:
   if (path)
@@ -2286,7 +2323,8 @@ done:
 
   if (emit_row_inserted)
     gtk_tree_model_filter_emit_row_inserted_for_path (filter, c_model,
-                                                      c_path, c_iter);
+                                                      c_path, c_iter,
+                                                      _gtk_tree_model_is_batched_emission (c_model));
 
   if (real_path)
     gtk_tree_path_free (real_path);
@@ -2295,6 +2333,33 @@ done:
     gtk_tree_path_free (c_path);
 }
 
+static void
+gtk_tree_model_filter_rows_inserted (GtkTreeModel *c_model,
+                                     GtkTreePath  *c_path,
+                                     GtkTreeIter  *c_iter,
+                                     gint          n_rows,
+                                     gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint n;
+
+  /* None of the rows were visible */
+  if (filter->priv->batch_path == NULL)
+    return;
+
+  path = filter->priv->batch_path;
+  n = filter->priv->batch_n_rows;
+  filter->priv->batch_path = NULL;
+  filter->priv->batch_n_rows = 0;
+
+  if (gtk_tree_model_get_iter (GTK_TREE_MODEL (filter), &iter, path))
+    gtk_tree_model_rows_inserted (GTK_TREE_MODEL (filter), path, &iter, n);
+
+  gtk_tree_path_free (path);
+}
+
 static void
 gtk_tree_model_filter_row_has_child_toggled (GtkTreeModel *c_model,
                                              GtkTreePath  *c_path,
@@ -3639,12 +3704,16 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  gtk_tree_model_filter_cancel_refilter (filter);
+
   if (filter->priv->child_model)
     {
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->changed_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->inserted_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->rows_inserted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->has_child_toggled_id);
       g_signal_handler_disconnect (filter->priv->child_model,
@@ -3658,6 +3727,8 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
                                           TRUE, TRUE, FALSE);
 
       filter->priv->root = NULL;
+      g_clear_pointer (&filter->priv->batch_path, gtk_tree_path_free);
+      filter->priv->batch_n_rows = 0;
       g_object_unref (filter->priv->child_model);
       filter->priv->visible_column = -1;
 
@@ -3677,6 +3748,10 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_filter_row_inserted),
                           filter);
+      filter->priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_filter_rows_inserted),
+                          filter);
       filter->priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_filter_row_has_child_toggled),
@@ -4266,12 +4341,242 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  gtk_tree_model_filter_cancel_refilter (filter);
+
   /* S L O W */
   gtk_tree_model_foreach (filter->priv->child_model,
                           gtk_tree_model_filter_refilter_helper,
                           filter);
 }
 
+/* Time spent re-testing rows per main loop iteration during an
+ * asynchronous refilter, in microseconds. This leaves room for the
+ * frame clock to keep drawing at a reasonable rate.
+ */
+#define REFILTER_TIME_SLICE 4000
+
+static void
+gtk_tree_model_filter_cancel_refilter (GtkTreeModelFilter *filter)
+{
+  if (filter->priv->refilter_id != 0)
+    {
+      g_source_remove (filter->priv->refilter_id);
+      filter->priv->refilter_id = 0;
+    }
+
+  g_clear_pointer (&filter->priv->refilter_row, gtk_tree_row_reference_free);
+}
+
+/* Returns whether the child row at @c_path currently has a visible
+ * row in the filter, without building any level.
+ */
+static gboolean
+gtk_tree_model_filter_child_row_is_shown (GtkTreeModelFilter *filter,
+                                          GtkTreePath        *c_path)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
+                                                                c_path,
+                                                                FALSE,
+                                                                FALSE);
+  if (!path)
+    return FALSE;
+
+  gtk_tree_model_filter_get_iter_full (GTK_TREE_MODEL (filter), &iter, path);
+  gtk_tree_path_free (path);
+
+  return FILTER_ELT (iter.user_data2)->visible_siter != NULL;
+}
+
+/* Finds the first child row below the virtual root, in the order
+ * gtk_tree_model_foreach() uses.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_first (GtkTreeModelFilter  *filter,
+                                      GtkTreeIter         *c_iter,
+                                      GtkTreePath        **c_path)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter root;
+
+  if (filter->priv->virtual_root)
+    {
+      if (filter->priv->virtual_root_deleted ||
+          !gtk_tree_model_get_iter (c_model, &root, filter->priv->virtual_root) ||
+          !gtk_tree_model_iter_children (c_model, c_iter, &root))
+        return FALSE;
+
+      *c_path = gtk_tree_path_copy (filter->priv->virtual_root);
+      gtk_tree_path_down (*c_path);
+    }
+  else
+    {
+      if (!gtk_tree_model_get_iter_first (c_model, c_iter))
+        return FALSE;
+
+      *c_path = gtk_tree_path_new_first ();
+    }
+
+  return TRUE;
+}
+
+/* Moves @c_iter and @c_path to the next child row, skipping the
+ * children of the current row unless @descend is set.
+ */
+static gboolean
+gtk_tree_model_filter_refilter_next (GtkTreeModelFilter *filter,
+                                     GtkTreeIter        *c_iter,
+                                     GtkTreePath        *c_path,
+                                     gboolean            descend)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter tmp;
+  gint min_depth;
+
+  if (descend && gtk_tree_model_iter_children (c_model, &tmp, c_iter))
+    {
+      *c_iter = tmp;
+      gtk_tree_path_down (c_path);
+      return TRUE;
+    }
+
+  if (filter->priv->virtual_root)
+    min_depth = gtk_tree_path_get_depth (filter->priv->virtual_root) + 1;
+  else
+    min_depth = 1;
+
+  while (TRUE)
+    {
+      tmp = *c_iter;
+      if (gtk_tree_model_iter_next (c_model, &tmp))
+        {
+          *c_iter = tmp;
+          gtk_tree_path_next (c_path);
+          return TRUE;
+        }
+
+      if (gtk_tree_path_get_depth (c_path) <= min_depth ||
+          !gtk_tree_model_iter_parent (c_model, &tmp, c_iter))
+        return FALSE;
+
+      *c_iter = tmp;
+      gtk_tree_path_up (c_path);
+    }
+}
+
+static gboolean
+gtk_tree_model_filter_refilter_idle (gpointer data)
+{
+  GtkTreeModelFilter *filter = data;
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreePath *c_path = NULL;
+  GtkTreeIter c_iter;
+  gboolean valid;
+  gint64 deadline;
+  guint id;
+
+  id = filter->priv->refilter_id;
+  deadline = g_get_monotonic_time () + REFILTER_TIME_SLICE;
+
+  /* The reference points to the next row to test. If that row went
+   * away in the meantime, start over, re-testing rows is harmless.
+   */
+  if (filter->priv->refilter_row &&
+      gtk_tree_row_reference_valid (filter->priv->refilter_row))
+    {
+      c_path = gtk_tree_row_reference_get_path (filter->priv->refilter_row);
+      valid = gtk_tree_model_get_iter (c_model, &c_iter, c_path);
+    }
+  else
+    valid = gtk_tree_model_filter_refilter_first (filter, &c_iter, &c_path);
+
+  g_clear_pointer (&filter->priv->refilter_row, gtk_tree_row_reference_free);
+
+  while (valid)
+    {
+      gboolean descend = TRUE;
+
+      if (!filter->priv->refilter_narrow ||
+          gtk_tree_model_filter_child_row_is_shown (filter, c_path))
+        gtk_tree_model_filter_row_changed (c_model, c_path, &c_iter, filter);
+
+      /* A signal handler restarted or cancelled the refilter */
+      if (filter->priv->refilter_id != id)
+        {
+          gtk_tree_path_free (c_path);
+          return G_SOURCE_REMOVE;
+        }
+
+      /* When narrowing, hidden rows stay hidden, and so does
+       * everything below them.
+       */
+      if (filter->priv->refilter_narrow)
+        descend = gtk_tree_model_filter_child_row_is_shown (filter, c_path);
+
+      valid = gtk_tree_model_filter_refilter_next (filter, &c_iter, c_path, descend);
+
+      if (valid && g_get_monotonic_time () >= deadline)
+        {
+          filter->priv->refilter_row = gtk_tree_row_reference_new (c_model, c_path);
+          gtk_tree_path_free (c_path);
+
+          return G_SOURCE_CONTINUE;
+        }
+    }
+
+  if (c_path)
+    gtk_tree_path_free (c_path);
+
+  filter->priv->refilter_id = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gtk_tree_model_filter_refilter_async:
+ * @filter: A #GtkTreeModelFilter
+ * @narrow: %TRUE if the visibility criteria only became stricter
+ *
+ * Like gtk_tree_model_filter_refilter(), but re-evaluates the rows
+ * from the main loop in small time slices, so that the user interface
+ * stays responsive while a large model is being refiltered. Rows are
+ * added to and removed from @filter as they get re-evaluated.
+ *
+ * If @narrow is %TRUE, the caller guarantees that no row that is
+ * currently hidden can become visible, e.g. because a search string
+ * was extended. Only the visible rows are re-evaluated then.
+ *
+ * Calling this function, or gtk_tree_model_filter_refilter(), while
+ * an asynchronous refilter is still running cancels it; if a narrowing
+ * refilter replaces one that was not narrowing, the non-narrowing mode
+ * is kept, since hidden rows may still need to be shown.
+ *
+ * Since: 3.16
+ */
+void
+gtk_tree_model_filter_refilter_async (GtkTreeModelFilter *filter,
+                                      gboolean            narrow)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  if (filter->priv->refilter_id != 0 && !filter->priv->refilter_narrow)
+    narrow = FALSE;
+
+  gtk_tree_model_filter_cancel_refilter (filter);
+
+  if (!filter->priv->child_model)
+    return;
+
+  filter->priv->refilter_narrow = narrow != FALSE;
+  filter->priv->refilter_id =
+    gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                               gtk_tree_model_filter_refilter_idle,
+                               filter, NULL);
+  g_source_set_name_by_id (filter->priv->refilter_id, "[gtk+] gtk_tree_model_filter_refilter_idle");
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
@@ -23,6 +23,7 @@
 #include "gtktreesortable.h"
 #include "gtktreestore.h"
 #include "gtktreedatalist.h"
+#include "gtktreeprivate.h"
 #include "gtkintl.h"
 #include "gtkprivate.h"
 #include "gtktreednd.h"
@@ -273,9 +274,14 @@ struct _GtkTreeModelSortPrivate
   gpointer default_sort_data;
   GDestroyNotify default_sort_destroy;
 
+  /* rows of a batch in the child model, announced as a range */
+  GtkTreePath *batch_path;
+  gint batch_n_rows;
+
   /* signal ids */
   gulong changed_id;
   gulong inserted_id;
+  gulong rows_inserted_id;
   gulong has_child_toggled_id;
   gulong deleted_id;
   gulong reordered_id;
@@ -327,6 +333,11 @@ static void gtk_tree_model_sort_row_inserted          (GtkTreeModel          *mo
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
 						       gpointer               data);
+static void gtk_tree_model_sort_rows_inserted         (GtkTreeModel          *model,
+						       GtkTreePath           *path,
+						       GtkTreeIter           *iter,
+						       gint                   n_rows,
+						       gpointer               data);
 static void gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel          *model,
 						       GtkTreePath           *path,
 						       GtkTreeIter           *iter,
@@ -420,7 +431,7 @@ static void         gtk_tree_model_sort_sort_level        (GtkTreeModelSort *tre
 							   gboolean          recurse,
 							   gboolean          emit_reordered);
 static void         gtk_tree_model_sort_sort              (GtkTreeModelSort *tree_model_sort);
-static gboolean     gtk_tree_model_sort_insert_value      (GtkTreeModelSort *tree_model_sort,
+static SortElt     *gtk_tree_model_sort_insert_value      (GtkTreeModelSort *tree_model_sort,
 							   SortLevel        *level,
 							   GtkTreePath      *s_path,
 							   GtkTreeIter      *s_iter);
@@ -898,11 +909,14 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
   SortElt *elt;
   SortLevel *level;
   SortLevel *parent_level = NULL;
+  gboolean batched;
 
   parent_level = level = SORT_LEVEL (priv->root);
 
   g_return_if_fail (s_path != NULL || s_iter != NULL);
 
+  batched = _gtk_tree_model_is_batched_emission (s_model);
+
   if (!s_path)
     {
       s_path = gtk_tree_model_get_path (s_model, s_iter);
@@ -968,12 +982,24 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
       goto done;
     }
 
-  if (!gtk_tree_model_sort_insert_value (tree_model_sort,
-					 parent_level,
-					 s_path,
-					 &real_s_iter))
+  elt = gtk_tree_model_sort_insert_value (tree_model_sort,
+                                          parent_level,
+                                          s_path,
+                                          &real_s_iter);
+  if (!elt)
     goto done;
 
+  gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+  /* The new element gives the path directly, converting the child
+   * path would search each level for the element with its offset
+   */
+  iter.stamp = priv->stamp;
+  iter.user_data = parent_level;
+  iter.user_data2 = elt;
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (data), &iter);
+  goto emit;
+
  done_and_submit:
   path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort,
 							      s_path,
@@ -985,7 +1011,24 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
   gtk_tree_model_sort_increment_stamp (tree_model_sort);
 
   gtk_tree_model_get_iter (GTK_TREE_MODEL (data), &iter, path);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (data), path, &iter);
+
+ emit:
+  /* Consecutive rows of the child model stay consecutive
+   * only while the model is unsorted
+   */
+  if (batched &&
+      priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
+      priv->default_sort_func == NO_SORT_FUNC)
+    {
+      if (priv->batch_path == NULL)
+        priv->batch_path = gtk_tree_path_copy (path);
+      priv->batch_n_rows++;
+
+      _gtk_tree_model_row_inserted_batched (GTK_TREE_MODEL (data), path, &iter);
+    }
+  else
+    gtk_tree_model_row_inserted (GTK_TREE_MODEL (data), path, &iter);
+
   gtk_tree_path_free (path);
 
  done:
@@ -995,6 +1038,34 @@ gtk_tree_model_sort_row_inserted (GtkTreeModel          *s_model,
   return;
 }
 
+static void
+gtk_tree_model_sort_rows_inserted (GtkTreeModel *s_model,
+                                   GtkTreePath  *s_path,
+                                   GtkTreeIter  *s_iter,
+                                   gint          n_rows,
+                                   gpointer      data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gint n;
+
+  /* None of the rows were passed on as part of a batch */
+  if (priv->batch_path == NULL)
+    return;
+
+  path = priv->batch_path;
+  n = priv->batch_n_rows;
+  priv->batch_path = NULL;
+  priv->batch_n_rows = 0;
+
+  if (gtk_tree_model_get_iter (GTK_TREE_MODEL (data), &iter, path))
+    gtk_tree_model_rows_inserted (GTK_TREE_MODEL (data), path, &iter, n);
+
+  gtk_tree_path_free (path);
+}
+
 static void
 gtk_tree_model_sort_row_has_child_toggled (GtkTreeModel *s_model,
 					   GtkTreePath  *s_path,
@@ -1891,6 +1962,68 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+/* Sorts @level with _gtk_tree_data_list_sort_by_key(), if the
+ * sort function allows it. Returns %FALSE if it doesn't.
+ */
+static gboolean
+gtk_tree_model_sort_sort_level_by_key (GtkTreeModelSort *tree_model_sort,
+                                       SortLevel        *level,
+                                       SortData         *data)
+{
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GSequenceIter **siters;
+  GSequenceIter *siter, *end_siter;
+  GtkTreeIter *iters;
+  gint *order;
+  gint column;
+  gint length, i;
+
+  if (data->sort_func != _gtk_tree_data_list_compare_func)
+    return FALSE;
+
+  column = GPOINTER_TO_INT (data->sort_data);
+  if (!_gtk_tree_data_list_can_sort_by_key (data->sort_func,
+                                            gtk_tree_model_get_column_type (priv->child_model, column)))
+    return FALSE;
+
+  length = g_sequence_get_length (level->seq);
+  siters = g_new (GSequenceIter *, length);
+  iters = g_new (GtkTreeIter, length);
+
+  i = 0;
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      SortElt *elt = g_sequence_get (siter);
+
+      siters[i] = siter;
+
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        iters[i] = elt->iter;
+      else
+        {
+          data->parent_path_indices [data->parent_path_depth-1] = elt->offset;
+          gtk_tree_model_get_iter (priv->child_model, &iters[i], data->parent_path);
+        }
+
+      i++;
+    }
+
+  order = _gtk_tree_data_list_sort_by_key (priv->child_model, column,
+                                           priv->order, iters, length);
+
+  for (i = 0; i < length; i++)
+    g_sequence_move (siters[order[i]], end_siter);
+
+  g_free (order);
+  g_free (iters);
+  g_free (siters);
+
+  return TRUE;
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1939,7 +2072,7 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
   if (data.sort_func == NO_SORT_FUNC)
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
-  else
+  else if (!gtk_tree_model_sort_sort_level_by_key (tree_model_sort, level, &data))
     g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
 
   free_sort_data (&data);
@@ -2042,7 +2175,7 @@ gtk_tree_model_sort_sort (GtkTreeModelSort *tree_model_sort)
 }
 
 /* signal helpers */
-static gboolean
+static SortElt *
 gtk_tree_model_sort_insert_value (GtkTreeModelSort *tree_model_sort,
 				  SortLevel        *level,
 				  GtkTreePath      *s_path,
@@ -2064,8 +2197,9 @@ gtk_tree_model_sort_insert_value (GtkTreeModelSort *tree_model_sort,
   elt->ref_count = 0;
   elt->children = NULL;
 
-  /* update all larger offsets */
-  g_sequence_foreach (level->seq, increase_offset_iter, GINT_TO_POINTER (offset));
+  /* update all larger offsets, there are none when appending */
+  if (offset < g_sequence_get_length (level->seq))
+    g_sequence_foreach (level->seq, increase_offset_iter, GINT_TO_POINTER (offset));
 
   fill_sort_data (&data, tree_model_sort, level);
 
@@ -2085,7 +2219,7 @@ gtk_tree_model_sort_insert_value (GtkTreeModelSort *tree_model_sort,
 
   free_sort_data (&data);
 
-  return TRUE;
+  return elt;
 }
 
 /* sort elt stuff */
@@ -2141,6 +2275,8 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
                                    priv->changed_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->inserted_id);
+      g_signal_handler_disconnect (priv->child_model,
+                                   priv->rows_inserted_id);
       g_signal_handler_disconnect (priv->child_model,
                                    priv->has_child_toggled_id);
       g_signal_handler_disconnect (priv->child_model,
@@ -2152,6 +2288,8 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
       if (priv->root)
 	gtk_tree_model_sort_free_level (tree_model_sort, priv->root, TRUE);
       priv->root = NULL;
+      g_clear_pointer (&priv->batch_path, gtk_tree_path_free);
+      priv->batch_n_rows = 0;
       _gtk_tree_data_list_header_free (priv->sort_list);
       priv->sort_list = NULL;
       g_object_unref (priv->child_model);
@@ -2172,6 +2310,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
         g_signal_connect (child_model, "row-inserted",
                           G_CALLBACK (gtk_tree_model_sort_row_inserted),
                           tree_model_sort);
+      priv->rows_inserted_id =
+        g_signal_connect (child_model, "rows-inserted",
+                          G_CALLBACK (gtk_tree_model_sort_rows_inserted),
+                          tree_model_sort);
       priv->has_child_toggled_id =
         g_signal_connect (child_model, "row-has-child-toggled",
                           G_CALLBACK (gtk_tree_model_sort_row_has_child_toggled),
@@ -35,6 +35,10 @@ typedef enum
 GtkTreeSelectMode;
 
 /* functions that shouldn't be exported */
+void         _gtk_tree_model_row_inserted_batched     (GtkTreeModel      *tree_model,
+                                                       GtkTreePath       *path,
+                                                       GtkTreeIter       *iter);
+gboolean     _gtk_tree_model_is_batched_emission      (GtkTreeModel      *tree_model);
 void         _gtk_tree_selection_internal_select_node (GtkTreeSelection  *selection,
 						       GtkRBNode         *node,
 						       GtkRBTree         *tree,
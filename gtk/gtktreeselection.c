@@ -531,6 +531,87 @@ gtk_tree_selection_get_selected (GtkTreeSelection  *selection,
   return retval;
 }
 
+/* Selected rows are found by only descending into the parts of the
+ * rbtree that have GTK_RBNODE_DESCENDANTS_SELECTED set, so walking a
+ * small selection doesn't touch the rest of the tree. @indices holds
+ * the path of the current node; @func returns %TRUE to stop the walk.
+ */
+typedef gboolean (* SelectedNodeFunc) (GtkRBTree *tree,
+                                       GtkRBNode *node,
+                                       GArray    *indices,
+                                       gpointer   data);
+
+static gboolean
+gtk_tree_selection_walk_selected (GtkRBTree        *tree,
+                                  GtkRBNode        *node,
+                                  GArray           *indices,
+                                  gint              base,
+                                  SelectedNodeFunc  func,
+                                  gpointer          data)
+{
+  gint index;
+  gboolean stop;
+
+  if (_gtk_rbtree_is_nil (node) ||
+      !GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_SELECTED))
+    return FALSE;
+
+  if (gtk_tree_selection_walk_selected (tree, node->left, indices, base, func, data))
+    return TRUE;
+
+  index = base + node->left->count;
+  g_array_index (indices, gint, indices->len - 1) = index;
+
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED) &&
+      func (tree, node, indices, data))
+    return TRUE;
+
+  if (node->children)
+    {
+      gint first = 0;
+
+      g_array_append_val (indices, first);
+      stop = gtk_tree_selection_walk_selected (node->children, node->children->root,
+                                               indices, 0, func, data);
+      g_array_set_size (indices, indices->len - 1);
+
+      if (stop)
+        return TRUE;
+    }
+
+  return gtk_tree_selection_walk_selected (tree, node->right, indices, index + 1, func, data);
+}
+
+static void
+gtk_tree_selection_foreach_selected_node (GtkRBTree        *tree,
+                                          SelectedNodeFunc  func,
+                                          gpointer          data)
+{
+  GArray *indices;
+  gint first = 0;
+
+  indices = g_array_sized_new (FALSE, FALSE, sizeof (gint), 8);
+  g_array_append_val (indices, first);
+
+  gtk_tree_selection_walk_selected (tree, tree->root, indices, 0, func, data);
+
+  g_array_free (indices, TRUE);
+}
+
+static gboolean
+get_selected_rows_helper (GtkRBTree *tree,
+                          GtkRBNode *node,
+                          GArray    *indices,
+                          gpointer   data)
+{
+  GList **list = data;
+
+  *list = g_list_prepend (*list, gtk_tree_path_new_from_indicesv ((gint *) indices->data,
+                                                                  indices->len));
+
+  return FALSE;
+}
+
 /**
  * gtk_tree_selection_get_selected_rows:
  * @selection: A #GtkTreeSelection.
@@ -557,8 +638,6 @@ gtk_tree_selection_get_selected_rows (GtkTreeSelection   *selection,
   GtkTreeSelectionPrivate *priv;
   GList *list = NULL;
   GtkRBTree *tree = NULL;
-  GtkRBNode *node = NULL;
-  GtkTreePath *path;
 
   g_return_val_if_fail (GTK_IS_TREE_SELECTION (selection), NULL);
 
@@ -593,73 +672,22 @@ gtk_tree_selection_get_selected_rows (GtkTreeSelection   *selection,
       return NULL;
     }
 
-  node = _gtk_rbtree_first (tree);
-  path = gtk_tree_path_new_first ();
-
-  do
-    {
-      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
-	list = g_list_prepend (list, gtk_tree_path_copy (path));
-
-      if (node->children)
-        {
-	  tree = node->children;
-          node = _gtk_rbtree_first (tree);
-
-	  gtk_tree_path_append_index (path, 0);
-	}
-      else
-        {
-	  gboolean done = FALSE;
-
-	  do
-	    {
-	      node = _gtk_rbtree_next (tree, node);
-	      if (node != NULL)
-	        {
-		  done = TRUE;
-		  gtk_tree_path_next (path);
-		}
-	      else
-	        {
-		  node = tree->parent_node;
-		  tree = tree->parent_tree;
-
-		  if (!tree)
-		    {
-		      gtk_tree_path_free (path);
-
-		      goto done; 
-		    }
-
-		  gtk_tree_path_up (path);
-		}
-	    }
-	  while (!done);
-	}
-    }
-  while (TRUE);
-
-  gtk_tree_path_free (path);
+  gtk_tree_selection_foreach_selected_node (tree, get_selected_rows_helper, &list);
 
- done:
   return g_list_reverse (list);
 }
 
-static void
+static gboolean
 gtk_tree_selection_count_selected_rows_helper (GtkRBTree *tree,
 					       GtkRBNode *node,
+					       GArray    *indices,
 					       gpointer   data)
 {
   gint *count = (gint *)data;
 
-  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
-    (*count)++;
+  (*count)++;
 
-  if (node->children)
-    _gtk_rbtree_traverse (node->children, node->children->root,
-			  G_PRE_ORDER,
-			  gtk_tree_selection_count_selected_rows_helper, data);
+  return FALSE;
 }
 
 /**
@@ -699,10 +727,9 @@ gtk_tree_selection_count_selected_rows (GtkTreeSelection *selection)
 	return 0;
     }
 
-  _gtk_rbtree_traverse (tree, tree->root,
-			G_PRE_ORDER,
-			gtk_tree_selection_count_selected_rows_helper,
-			&count);
+  gtk_tree_selection_foreach_selected_node (tree,
+                                            gtk_tree_selection_count_selected_rows_helper,
+                                            &count);
 
   return count;
 }
@@ -716,6 +743,32 @@ model_changed (gpointer data)
   *stop = TRUE;
 }
 
+typedef struct
+{
+  GtkTreeModel *model;
+  GtkTreeSelectionForeachFunc func;
+  gpointer data;
+  gboolean stop;
+} ForeachData;
+
+static gboolean
+selected_foreach_helper (GtkRBTree *tree,
+                         GtkRBNode *node,
+                         GArray    *indices,
+                         gpointer   data)
+{
+  ForeachData *foreach = data;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  path = gtk_tree_path_new_from_indicesv ((gint *) indices->data, indices->len);
+  gtk_tree_model_get_iter (foreach->model, &iter, path);
+  (* foreach->func) (foreach->model, path, &iter, foreach->data);
+  gtk_tree_path_free (path);
+
+  return foreach->stop;
+}
+
 /**
  * gtk_tree_selection_selected_foreach:
  * @selection: A #GtkTreeSelection.
@@ -734,12 +787,11 @@ gtk_tree_selection_selected_foreach (GtkTreeSelection            *selection,
   GtkTreeSelectionPrivate *priv;
   GtkTreePath *path;
   GtkRBTree *tree;
-  GtkRBNode *node;
   GtkTreeIter iter;
   GtkTreeModel *model;
 
   gulong inserted_id, deleted_id, reordered_id, changed_id;
-  gboolean stop = FALSE;
+  ForeachData foreach;
 
   g_return_if_fail (GTK_IS_TREE_SELECTION (selection));
 
@@ -768,81 +820,28 @@ gtk_tree_selection_selected_foreach (GtkTreeSelection            *selection,
       return;
     }
 
-  node = _gtk_rbtree_first (tree);
-
   g_object_ref (model);
 
+  foreach.model = model;
+  foreach.func = func;
+  foreach.data = data;
+  foreach.stop = FALSE;
+
   /* connect to signals to monitor changes in treemodel */
   inserted_id = g_signal_connect_swapped (model, "row-inserted",
 					  G_CALLBACK (model_changed),
-				          &stop);
+				          &foreach.stop);
   deleted_id = g_signal_connect_swapped (model, "row-deleted",
 					 G_CALLBACK (model_changed),
-				         &stop);
+				         &foreach.stop);
   reordered_id = g_signal_connect_swapped (model, "rows-reordered",
 					   G_CALLBACK (model_changed),
-				           &stop);
+				           &foreach.stop);
   changed_id = g_signal_connect_swapped (priv->tree_view, "notify::model",
 					 G_CALLBACK (model_changed), 
-					 &stop);
-
-  /* find the node internally */
-  path = gtk_tree_path_new_first ();
-
-  do
-    {
-      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
-        {
-          gtk_tree_model_get_iter (model, &iter, path);
-	  (* func) (model, path, &iter, data);
-        }
-
-      if (stop)
-	goto out;
-
-      if (node->children)
-	{
-	  tree = node->children;
-          node = _gtk_rbtree_first (tree);
-
-	  gtk_tree_path_append_index (path, 0);
-	}
-      else
-	{
-	  gboolean done = FALSE;
-
-	  do
-	    {
-	      node = _gtk_rbtree_next (tree, node);
-	      if (node != NULL)
-		{
-		  done = TRUE;
-		  gtk_tree_path_next (path);
-		}
-	      else
-		{
-		  node = tree->parent_node;
-		  tree = tree->parent_tree;
-
-		  if (tree == NULL)
-		    {
-		      /* we've run out of tree */
-		      /* We're done with this function */
-
-		      goto out;
-		    }
-
-		  gtk_tree_path_up (path);
-		}
-	    }
-	  while (!done);
-	}
-    }
-  while (TRUE);
+					 &foreach.stop);
 
-out:
-  if (path)
-    gtk_tree_path_free (path);
+  gtk_tree_selection_foreach_selected_node (tree, selected_foreach_helper, &foreach);
 
   g_signal_handler_disconnect (model, inserted_id);
   g_signal_handler_disconnect (model, deleted_id);
@@ -851,7 +850,7 @@ out:
   g_object_unref (model);
 
   /* check if we have to spew a scary message */
-  if (stop)
+  if (foreach.stop)
     g_warning ("The model has been modified from within gtk_tree_selection_selected_foreach.\n"
 	       "This function is for observing the selections of the tree only.  If\n"
 	       "you are trying to get all selected items from the tree, try using\n"
@@ -1117,6 +1116,59 @@ select_all_helper (GtkRBTree  *tree,
 }
 
 
+static void
+select_all_fast_helper (GtkRBTree *tree,
+                        GtkRBNode *node,
+                        gpointer   data)
+{
+  struct _TempTuple *tuple = data;
+
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
+    _gtk_tree_view_accessible_add_state (tuple->selection->priv->tree_view, tree, node, GTK_CELL_RENDERER_SELECTED);
+  else
+    _gtk_tree_view_accessible_remove_state (tuple->selection->priv->tree_view, tree, node, GTK_CELL_RENDERER_SELECTED);
+
+  tuple->dirty = TRUE;
+}
+
+/* Without a select function or row separators every row can be
+ * selected and unselected, so the flags can be flipped directly
+ * instead of going through gtk_tree_selection_real_select_node(),
+ * which builds a path, looks up an iter and queues a redraw for
+ * each row.
+ */
+static gboolean
+gtk_tree_selection_set_all_fast (GtkTreeSelection *selection,
+                                 GtkRBTree        *tree,
+                                 gboolean          select,
+                                 gboolean         *dirty)
+{
+  GtkTreeSelectionPrivate *priv = selection->priv;
+  GtkTreeViewRowSeparatorFunc separator_func;
+  gpointer separator_data;
+  struct _TempTuple tuple;
+
+  if (priv->user_func)
+    return FALSE;
+
+  _gtk_tree_view_get_row_separator_func (priv->tree_view,
+                                         &separator_func, &separator_data);
+  if (separator_func)
+    return FALSE;
+
+  tuple.selection = selection;
+  tuple.dirty = FALSE;
+
+  _gtk_rbtree_set_all_selected (tree, select, select_all_fast_helper, &tuple);
+
+  if (tuple.dirty)
+    gtk_widget_queue_draw (GTK_WIDGET (priv->tree_view));
+
+  *dirty = tuple.dirty;
+
+  return TRUE;
+}
+
 /* We have a real_{un,}select_all function that doesn't emit the signal, so we
  * can use it in other places without fear of the signal being emitted.
  */
@@ -1126,12 +1178,16 @@ gtk_tree_selection_real_select_all (GtkTreeSelection *selection)
   GtkTreeSelectionPrivate *priv = selection->priv;
   struct _TempTuple *tuple;
   GtkRBTree *tree;
+  gboolean dirty;
 
   tree = _gtk_tree_view_get_rbtree (priv->tree_view);
 
   if (tree == NULL)
     return FALSE;
 
+  if (gtk_tree_selection_set_all_fast (selection, tree, TRUE, &dirty))
+    return dirty;
+
   /* Mark all nodes selected */
   tuple = g_new (struct _TempTuple, 1);
   tuple->selection = selection;
@@ -1178,23 +1234,17 @@ gtk_tree_selection_select_all (GtkTreeSelection *selection)
     g_signal_emit (selection, tree_selection_signals[CHANGED], 0);
 }
 
-static void
+static gboolean
 unselect_all_helper (GtkRBTree  *tree,
 		     GtkRBNode  *node,
+		     GArray     *indices,
 		     gpointer    data)
 {
   struct _TempTuple *tuple = data;
 
-  if (node->children)
-    _gtk_rbtree_traverse (node->children,
-			  node->children->root,
-			  G_PRE_ORDER,
-			  unselect_all_helper,
-			  data);
-  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
-    {
-      tuple->dirty = gtk_tree_selection_real_select_node (tuple->selection, tree, node, FALSE) || tuple->dirty;
-    }
+  tuple->dirty = gtk_tree_selection_real_select_node (tuple->selection, tree, node, FALSE) || tuple->dirty;
+
+  return FALSE;
 }
 
 static gboolean
@@ -1238,16 +1288,21 @@ gtk_tree_selection_real_unselect_all (GtkTreeSelection *selection)
   else
     {
       GtkRBTree *tree;
+      gboolean dirty;
+
+      tree = _gtk_tree_view_get_rbtree (priv->tree_view);
+
+      if (tree == NULL)
+        return FALSE;
+
+      if (gtk_tree_selection_set_all_fast (selection, tree, FALSE, &dirty))
+        return dirty;
 
       tuple = g_new (struct _TempTuple, 1);
       tuple->selection = selection;
       tuple->dirty = FALSE;
 
-      tree = _gtk_tree_view_get_rbtree (priv->tree_view);
-      _gtk_rbtree_traverse (tree, tree->root,
-                            G_PRE_ORDER,
-                            unselect_all_helper,
-                            tuple);
+      gtk_tree_selection_foreach_selected_node (tree, unselect_all_helper, tuple);
 
       if (tuple->dirty)
         {
@@ -1627,12 +1682,12 @@ gtk_tree_selection_real_select_node (GtkTreeSelection *selection,
     {
       if (!GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
         {
-          GTK_RBNODE_SET_FLAG (node, GTK_RBNODE_IS_SELECTED);
+          _gtk_rbtree_node_set_selected (tree, node, TRUE);
           _gtk_tree_view_accessible_add_state (priv->tree_view, tree, node, GTK_CELL_RENDERER_SELECTED);
         }
       else
         {
-          GTK_RBNODE_UNSET_FLAG (node, GTK_RBNODE_IS_SELECTED);
+          _gtk_rbtree_node_set_selected (tree, node, FALSE);
           _gtk_tree_view_accessible_remove_state (priv->tree_view, tree, node, GTK_CELL_RENDERER_SELECTED);
         }
 
@@ -73,9 +73,26 @@ struct _GtkTreeStorePrivate
   GtkTreeIterCompareFunc default_sort_func;
   gpointer default_sort_data;
   GDestroyNotify default_sort_destroy;
+
+  /* GNode * -> GPtrArray of its children, for parents with many
+   * children. Dropped whenever the children change. */
+  GHashTable *child_arrays;
+
+  /* GNode * of rows whose children are loaded on demand */
+  GHashTable *lazy_nodes;
+  GNode *loading_node;
+  GtkTreeStoreLoadFunc load_func;
+  gpointer load_data;
+  GDestroyNotify load_destroy;
+
   guint columns_dirty : 1;
 };
 
+/* Parents get an array of their children once a child at this
+ * position or further is looked up, walking the siblings is
+ * cheaper before that. */
+#define CHILD_ARRAY_THRESHOLD 32
+
 
 #define G_NODE(node) ((GNode *)node)
 #define GTK_TREE_STORE_IS_SORTED(tree) (((GtkTreeStore*)(tree))->priv->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
@@ -202,6 +219,67 @@ validate_tree (GtkTreeStore *tree_store)
     }
 }
 
+/* Must be called after the children of @parent changed */
+static inline void
+gtk_tree_store_children_changed (GtkTreeStore *tree_store,
+                                 GNode        *parent)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+
+  if (priv->child_arrays)
+    g_hash_table_remove (priv->child_arrays, parent);
+
+  /* Children that got added without the load function
+   * make the row a regular one */
+  if (priv->lazy_nodes && parent->children)
+    g_hash_table_remove (priv->lazy_nodes, parent);
+}
+
+/* Rows added by the load function are not announced with signals,
+ * as far as anyone is concerned they have been there all along.
+ */
+static inline gboolean
+gtk_tree_store_is_loading (GtkTreeStore *tree_store,
+                           GNode        *node)
+{
+  GNode *loading_node = tree_store->priv->loading_node;
+
+  return loading_node != NULL &&
+         (node == loading_node || g_node_is_ancestor (loading_node, node));
+}
+
+/* Emits the signals for a row that just got inserted at @iter */
+static void
+gtk_tree_store_row_inserted (GtkTreeStore *tree_store,
+                             GtkTreeIter  *iter)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GNode *node = iter->user_data;
+  GtkTreePath *path;
+
+  gtk_tree_store_children_changed (tree_store, node->parent);
+
+  if (gtk_tree_store_is_loading (tree_store, node))
+    return;
+
+  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
+
+  if (node->parent != priv->root &&
+      node->prev == NULL && node->next == NULL)
+    {
+      GtkTreeIter parent_iter;
+
+      parent_iter.stamp = priv->stamp;
+      parent_iter.user_data = node->parent;
+
+      gtk_tree_path_up (path);
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, &parent_iter);
+    }
+
+  gtk_tree_path_free (path);
+}
+
 G_DEFINE_TYPE_WITH_CODE (GtkTreeStore, gtk_tree_store, G_TYPE_OBJECT,
                          G_ADD_PRIVATE (GtkTreeStore)
 			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
@@ -468,6 +546,19 @@ node_free (GNode *node, gpointer data)
   return FALSE;
 }
 
+static gboolean
+node_forget (GNode *node, gpointer data)
+{
+  GtkTreeStorePrivate *priv = data;
+
+  if (priv->child_arrays)
+    g_hash_table_remove (priv->child_arrays, node);
+  if (priv->lazy_nodes)
+    g_hash_table_remove (priv->lazy_nodes, node);
+
+  return FALSE;
+}
+
 static void
 gtk_tree_store_finalize (GObject *object)
 {
@@ -480,6 +571,20 @@ gtk_tree_store_finalize (GObject *object)
   _gtk_tree_data_list_header_free (priv->sort_list);
   g_free (priv->column_headers);
 
+  if (priv->child_arrays)
+    g_hash_table_destroy (priv->child_arrays);
+  if (priv->lazy_nodes)
+    g_hash_table_destroy (priv->lazy_nodes);
+
+  if (priv->load_destroy)
+    {
+      GDestroyNotify d = priv->load_destroy;
+
+      priv->load_destroy = NULL;
+      d (priv->load_data);
+      priv->load_data = NULL;
+    }
+
   if (priv->default_sort_destroy)
     {
       GDestroyNotify d = priv->default_sort_destroy;
@@ -531,6 +636,81 @@ gtk_tree_store_get_column_type (GtkTreeModel *tree_model,
   return priv->column_headers[index];
 }
 
+static GNode *
+gtk_tree_store_nth_child_node (GtkTreeStore *tree_store,
+                               GNode        *parent,
+                               gint          n)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GPtrArray *children;
+  GNode *node;
+
+  if (n < CHILD_ARRAY_THRESHOLD)
+    return g_node_nth_child (parent, n);
+
+  if (priv->child_arrays == NULL)
+    priv->child_arrays = g_hash_table_new_full (NULL, NULL, NULL,
+                                                (GDestroyNotify) g_ptr_array_unref);
+
+  children = g_hash_table_lookup (priv->child_arrays, parent);
+  if (children == NULL)
+    {
+      children = g_ptr_array_new ();
+      for (node = parent->children; node; node = node->next)
+        g_ptr_array_add (children, node);
+
+      g_hash_table_insert (priv->child_arrays, parent, children);
+    }
+
+  if (n >= children->len)
+    return NULL;
+
+  return g_ptr_array_index (children, n);
+}
+
+/* Calls the load function for a lazy row the first time
+ * its children are asked for. */
+static void
+gtk_tree_store_ensure_loaded (GtkTreeStore *tree_store,
+                              GNode        *node)
+{
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GtkTreeIter iter;
+  GNode *loading_node;
+
+  if (priv->lazy_nodes == NULL ||
+      !g_hash_table_remove (priv->lazy_nodes, node))
+    return;
+
+  iter.stamp = priv->stamp;
+  iter.user_data = node;
+
+  if (priv->load_func)
+    {
+      loading_node = priv->loading_node;
+      if (loading_node == NULL)
+        priv->loading_node = node;
+
+      priv->load_func (tree_store, &iter, priv->load_data);
+
+      priv->loading_node = loading_node;
+    }
+
+  /* The row claimed to have children until now, so views need to
+   * be told if it turned out to have none
+   */
+  if (node->children == NULL &&
+      !g_hash_table_contains (priv->lazy_nodes, node) &&
+      !gtk_tree_store_is_loading (tree_store, node))
+    {
+      GtkTreePath *path;
+
+      path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), &iter);
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, &iter);
+      gtk_tree_path_free (path);
+    }
+}
+
 static gboolean
 gtk_tree_store_get_iter (GtkTreeModel *tree_model,
 			 GtkTreeIter  *iter,
@@ -717,7 +897,10 @@ gtk_tree_store_iter_children (GtkTreeModel *tree_model,
     g_return_val_if_fail (VALID_ITER (parent, tree_store), FALSE);
 
   if (parent)
-    children = G_NODE (parent->user_data)->children;
+    {
+      gtk_tree_store_ensure_loaded (tree_store, parent->user_data);
+      children = G_NODE (parent->user_data)->children;
+    }
   else
     children = G_NODE (priv->root)->children;
 
@@ -738,25 +921,45 @@ static gboolean
 gtk_tree_store_iter_has_child (GtkTreeModel *tree_model,
 			       GtkTreeIter  *iter)
 {
+  GtkTreeStorePrivate *priv = GTK_TREE_STORE (tree_model)->priv;
+
   g_return_val_if_fail (iter->user_data != NULL, FALSE);
   g_return_val_if_fail (VALID_ITER (iter, tree_model), FALSE);
 
-  return G_NODE (iter->user_data)->children != NULL;
+  if (G_NODE (iter->user_data)->children != NULL)
+    return TRUE;
+
+  /* Lazy rows have children, they just haven't been loaded yet */
+  return priv->lazy_nodes != NULL &&
+         g_hash_table_contains (priv->lazy_nodes, iter->user_data);
 }
 
 static gint
 gtk_tree_store_iter_n_children (GtkTreeModel *tree_model,
 				GtkTreeIter  *iter)
 {
+  GtkTreeStore *tree_store = (GtkTreeStore *) tree_model;
+  GtkTreeStorePrivate *priv = tree_store->priv;
+  GNode *parent_node;
   GNode *node;
+  GPtrArray *children;
   gint i = 0;
 
   g_return_val_if_fail (iter == NULL || iter->user_data != NULL, 0);
 
   if (iter == NULL)
-    node = G_NODE (GTK_TREE_STORE (tree_model)->priv->root)->children;
+    parent_node = priv->root;
   else
-    node = G_NODE (iter->user_data)->children;
+    {
+      parent_node = iter->user_data;
+      gtk_tree_store_ensure_loaded (tree_store, parent_node);
+    }
+
+  if (priv->child_arrays &&
+      (children = g_hash_table_lookup (priv->child_arrays, parent_node)))
+    return children->len;
+
+  node = parent_node->children;
 
   while (node)
     {
@@ -783,9 +986,12 @@ gtk_tree_store_iter_nth_child (GtkTreeModel *tree_model,
   if (parent == NULL)
     parent_node = priv->root;
   else
-    parent_node = parent->user_data;
+    {
+      parent_node = parent->user_data;
+      gtk_tree_store_ensure_loaded (tree_store, parent_node);
+    }
 
-  child = g_node_nth_child (parent_node, n);
+  child = gtk_tree_store_nth_child_node (tree_store, parent_node, n);
 
   if (child)
     {
@@ -950,7 +1156,8 @@ gtk_tree_store_set_value (GtkTreeStore *tree_store,
   g_return_if_fail (column >= 0 && column < tree_store->priv->n_columns);
   g_return_if_fail (G_IS_VALUE (value));
 
-  if (gtk_tree_store_real_set_value (tree_store, iter, column, value, TRUE))
+  if (gtk_tree_store_real_set_value (tree_store, iter, column, value, TRUE) &&
+      !gtk_tree_store_is_loading (tree_store, iter->user_data))
     {
       GtkTreePath *path;
 
@@ -1109,7 +1316,7 @@ gtk_tree_store_set_valuesv (GtkTreeStore *tree_store,
   if (maybe_need_sort && GTK_TREE_STORE_IS_SORTED (tree_store))
     gtk_tree_store_sort_iter_changed (tree_store, iter, priv->sort_column_id, TRUE);
 
-  if (emit_signal)
+  if (emit_signal && !gtk_tree_store_is_loading (tree_store, iter->user_data))
     {
       GtkTreePath *path;
 
@@ -1149,7 +1356,7 @@ gtk_tree_store_set_valist (GtkTreeStore *tree_store,
   if (maybe_need_sort && GTK_TREE_STORE_IS_SORTED (tree_store))
     gtk_tree_store_sort_iter_changed (tree_store, iter, priv->sort_column_id, TRUE);
 
-  if (emit_signal)
+  if (emit_signal && !gtk_tree_store_is_loading (tree_store, iter->user_data))
     {
       GtkTreePath *path;
 
@@ -1220,24 +1427,37 @@ gtk_tree_store_remove (GtkTreeStore *tree_store,
     g_node_traverse (G_NODE (iter->user_data), G_POST_ORDER, G_TRAVERSE_ALL,
 		     -1, node_free, priv->column_headers);
 
-  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-  g_node_destroy (G_NODE (iter->user_data));
+  if ((priv->child_arrays && g_hash_table_size (priv->child_arrays) > 0) ||
+      (priv->lazy_nodes && g_hash_table_size (priv->lazy_nodes) > 0))
+    g_node_traverse (G_NODE (iter->user_data), G_POST_ORDER, G_TRAVERSE_ALL,
+		     -1, node_forget, priv);
 
-  gtk_tree_model_row_deleted (GTK_TREE_MODEL (tree_store), path);
+  if (gtk_tree_store_is_loading (tree_store, parent))
+    path = NULL;
+  else
+    path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
 
-  if (parent != G_NODE (priv->root))
+  g_node_destroy (G_NODE (iter->user_data));
+  gtk_tree_store_children_changed (tree_store, parent);
+
+  if (path)
     {
-      /* child_toggled */
-      if (parent->children == NULL)
-	{
-	  gtk_tree_path_up (path);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (tree_store), path);
 
-	  new_iter.stamp = priv->stamp;
-	  new_iter.user_data = parent;
-	  gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, &new_iter);
-	}
+      if (parent != G_NODE (priv->root))
+        {
+          /* child_toggled */
+          if (parent->children == NULL)
+            {
+              gtk_tree_path_up (path);
+
+              new_iter.stamp = priv->stamp;
+              new_iter.user_data = parent;
+              gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, &new_iter);
+            }
+        }
+      gtk_tree_path_free (path);
     }
-  gtk_tree_path_free (path);
 
   /* revalidate iter */
   if (next_node != NULL)
@@ -1278,7 +1498,6 @@ gtk_tree_store_insert (GtkTreeStore *tree_store,
 		       gint          position)
 {
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreePath *path;
   GNode *parent_node;
   GNode *new_node;
 
@@ -1300,19 +1519,7 @@ gtk_tree_store_insert (GtkTreeStore *tree_store,
   iter->user_data = new_node;
   g_node_insert (parent_node, position, new_node);
 
-  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-  if (parent_node != priv->root)
-    {
-      if (new_node->prev == NULL && new_node->next == NULL)
-        {
-          gtk_tree_path_up (path);
-          gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
-        }
-    }
-
-  gtk_tree_path_free (path);
+  gtk_tree_store_row_inserted (tree_store, iter);
 
   validate_tree ((GtkTreeStore*)tree_store);
 }
@@ -1342,7 +1549,6 @@ gtk_tree_store_insert_before (GtkTreeStore *tree_store,
 			      GtkTreeIter  *sibling)
 {
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreePath *path;
   GNode *parent_node = NULL;
   GNode *new_node;
 
@@ -1376,24 +1582,7 @@ gtk_tree_store_insert_before (GtkTreeStore *tree_store,
   iter->stamp = priv->stamp;
   iter->user_data = new_node;
 
-  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-  if (parent_node != priv->root)
-    {
-      if (new_node->prev == NULL && new_node->next == NULL)
-        {
-          GtkTreeIter parent_iter;
-
-          parent_iter.stamp = priv->stamp;
-          parent_iter.user_data = parent_node;
-
-          gtk_tree_path_up (path);
-          gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, &parent_iter);
-        }
-    }
-
-  gtk_tree_path_free (path);
+  gtk_tree_store_row_inserted (tree_store, iter);
 
   validate_tree (tree_store);
 }
@@ -1423,7 +1612,6 @@ gtk_tree_store_insert_after (GtkTreeStore *tree_store,
 			     GtkTreeIter  *sibling)
 {
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreePath *path;
   GNode *parent_node;
   GNode *new_node;
 
@@ -1458,24 +1646,7 @@ gtk_tree_store_insert_after (GtkTreeStore *tree_store,
   iter->stamp = priv->stamp;
   iter->user_data = new_node;
 
-  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-  if (parent_node != priv->root)
-    {
-      if (new_node->prev == NULL && new_node->next == NULL)
-        {
-          GtkTreeIter parent_iter;
-
-          parent_iter.stamp = priv->stamp;
-          parent_iter.user_data = parent_node;
-
-          gtk_tree_path_up (path);
-          gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, &parent_iter);
-        }
-    }
-
-  gtk_tree_path_free (path);
+  gtk_tree_store_row_inserted (tree_store, iter);
 
   validate_tree (tree_store);
 }
@@ -1517,7 +1688,6 @@ gtk_tree_store_insert_with_values (GtkTreeStore *tree_store,
 				   ...)
 {
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreePath *path;
   GNode *parent_node;
   GNode *new_node;
   GtkTreeIter tmp_iter;
@@ -1555,19 +1725,7 @@ gtk_tree_store_insert_with_values (GtkTreeStore *tree_store,
   if (maybe_need_sort && GTK_TREE_STORE_IS_SORTED (tree_store))
     gtk_tree_store_sort_iter_changed (tree_store, iter, priv->sort_column_id, FALSE);
 
-  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-  if (parent_node != priv->root)
-    {
-      if (new_node->prev == NULL && new_node->next == NULL)
-        {
-	  gtk_tree_path_up (path);
-	  gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
-	}
-    }
-
-  gtk_tree_path_free (path);
+  gtk_tree_store_row_inserted (tree_store, iter);
 
   validate_tree ((GtkTreeStore *)tree_store);
 }
@@ -1598,7 +1756,6 @@ gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
 				    gint          n_values)
 {
   GtkTreeStorePrivate *priv = tree_store->priv;
-  GtkTreePath *path;
   GNode *parent_node;
   GNode *new_node;
   GtkTreeIter tmp_iter;
@@ -1633,19 +1790,7 @@ gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
   if (maybe_need_sort && GTK_TREE_STORE_IS_SORTED (tree_store))
     gtk_tree_store_sort_iter_changed (tree_store, iter, priv->sort_column_id, FALSE);
 
-  path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-  gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-  if (parent_node != priv->root)
-    {
-      if (new_node->prev == NULL && new_node->next == NULL)
-        {
-	  gtk_tree_path_up (path);
-	  gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
-	}
-    }
-
-  gtk_tree_path_free (path);
+  gtk_tree_store_row_inserted (tree_store, iter);
 
   validate_tree ((GtkTreeStore *)tree_store);
 }
@@ -1684,22 +1829,12 @@ gtk_tree_store_prepend (GtkTreeStore *tree_store,
 
   if (parent_node->children == NULL)
     {
-      GtkTreePath *path;
-      
       iter->stamp = priv->stamp;
       iter->user_data = g_node_new (NULL);
 
       g_node_prepend (parent_node, G_NODE (iter->user_data));
 
-      path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-      gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-      if (parent_node != priv->root)
-	{
-	  gtk_tree_path_up (path);
-	  gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
-	}
-      gtk_tree_path_free (path);
+      gtk_tree_store_row_inserted (tree_store, iter);
     }
   else
     {
@@ -1743,22 +1878,12 @@ gtk_tree_store_append (GtkTreeStore *tree_store,
 
   if (parent_node->children == NULL)
     {
-      GtkTreePath *path;
-
       iter->stamp = priv->stamp;
       iter->user_data = g_node_new (NULL);
 
       g_node_append (parent_node, G_NODE (iter->user_data));
 
-      path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
-      gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
-
-      if (parent_node != priv->root)
-	{
-	  gtk_tree_path_up (path);
-	  gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
-	}
-      gtk_tree_path_free (path);
+      gtk_tree_store_row_inserted (tree_store, iter);
     }
   else
     {
@@ -2326,6 +2451,8 @@ gtk_tree_store_reorder (GtkTreeStore *tree_store,
   else
     G_NODE (tree_store->priv->root)->children = sort_array[0].node;
 
+  gtk_tree_store_children_changed (tree_store, sort_array[0].node->parent);
+
   /* emit signal */
   if (parent)
     path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), parent);
@@ -2463,6 +2590,8 @@ gtk_tree_store_swap (GtkTreeStore *tree_store,
   node_b->prev = a_prev;
   node_b->next = a_next;
 
+  gtk_tree_store_children_changed (tree_store, parent_node);
+
   /* emit signal */
   order = g_new (gint, length);
   for (i = 0; i < length; i++)
@@ -2724,6 +2853,8 @@ gtk_tree_store_move (GtkTreeStore *tree_store,
         node->next = NULL;
     }
 
+  gtk_tree_store_children_changed (tree_store, parent);
+
   /* emit signal */
   if (position)
     new_pos = gtk_tree_path_get_indices (pos_path)[gtk_tree_path_get_depth (pos_path)-1];
@@ -2843,6 +2974,106 @@ gtk_tree_store_move_after (GtkTreeStore *tree_store,
   gtk_tree_store_move (tree_store, iter, position, FALSE);
 }
 
+/**
+ * gtk_tree_store_set_load_func:
+ * @tree_store: A #GtkTreeStore
+ * @func: (allow-none): The function that adds the children of lazy rows,
+ *     or %NULL
+ * @data: (closure): User data to pass to @func, or %NULL
+ * @destroy: (allow-none): Destroy notifier of @data, or %NULL
+ *
+ * Sets the function that adds the children of rows marked with
+ * gtk_tree_store_set_lazy(). It is called the first time the children
+ * of such a row are asked for, e.g. when the row gets expanded in a
+ * #GtkTreeView, and should add them with the usual functions like
+ * gtk_tree_store_insert_with_values().
+ *
+ * The rows added by @func are not announced with the
+ * #GtkTreeModel::row-inserted signal, as far as the users of the
+ * model are concerned they were always there. If @func adds no rows,
+ * the row stops claiming to have children and
+ * #GtkTreeModel::row-has-child-toggled is emitted for it. If the
+ * children are only available asynchronously, @func can add a
+ * placeholder row and replace it once the real children arrive.
+ *
+ * Since: 3.16
+ */
+void
+gtk_tree_store_set_load_func (GtkTreeStore         *tree_store,
+                              GtkTreeStoreLoadFunc  func,
+                              gpointer              data,
+                              GDestroyNotify        destroy)
+{
+  GtkTreeStorePrivate *priv;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+
+  priv = tree_store->priv;
+
+  if (priv->load_destroy)
+    {
+      GDestroyNotify d = priv->load_destroy;
+
+      priv->load_destroy = NULL;
+      d (priv->load_data);
+    }
+
+  priv->load_func = func;
+  priv->load_data = data;
+  priv->load_destroy = destroy;
+}
+
+/**
+ * gtk_tree_store_set_lazy:
+ * @tree_store: A #GtkTreeStore
+ * @iter: A valid #GtkTreeIter for a row without children
+ * @lazy: %TRUE if the children of the row should be loaded on demand
+ *
+ * Marks the row at @iter as having children that are only added by the
+ * function set with gtk_tree_store_set_load_func() once they are asked
+ * for. Until then the row is reported to have children, so that views
+ * can offer to expand it, without any of them existing.
+ *
+ * Adding children to the row in any other way, or calling this function
+ * with @lazy set to %FALSE, makes it a regular row again.
+ *
+ * Since: 3.16
+ */
+void
+gtk_tree_store_set_lazy (GtkTreeStore *tree_store,
+                         GtkTreeIter  *iter,
+                         gboolean      lazy)
+{
+  GtkTreeStorePrivate *priv;
+  GNode *node;
+  gboolean was_lazy;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+  g_return_if_fail (VALID_ITER (iter, tree_store));
+
+  priv = tree_store->priv;
+  node = iter->user_data;
+
+  g_return_if_fail (node->children == NULL);
+
+  if (lazy && priv->lazy_nodes == NULL)
+    priv->lazy_nodes = g_hash_table_new (NULL, NULL);
+
+  if (lazy)
+    was_lazy = !g_hash_table_add (priv->lazy_nodes, node);
+  else
+    was_lazy = priv->lazy_nodes && g_hash_table_remove (priv->lazy_nodes, node);
+
+  if (was_lazy != lazy && !gtk_tree_store_is_loading (tree_store, node))
+    {
+      GtkTreePath *path;
+
+      path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
+      gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, iter);
+      gtk_tree_path_free (path);
+    }
+}
+
 /* Sorting */
 static gint
 gtk_tree_store_compare_func (gconstpointer a,
@@ -2953,6 +3184,8 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
   g_array_index (sort_array, SortTuple, 0).node->prev = NULL;
   parent->children = g_array_index (sort_array, SortTuple, 0).node;
 
+  gtk_tree_store_children_changed (tree_store, parent);
+
   /* Let the world know about our new order */
   new_order = g_new (gint, list_length);
   for (i = 0; i < list_length; i++)
@@ -3156,7 +3389,9 @@ gtk_tree_store_sort_iter_changed (GtkTreeStore *tree_store,
       G_NODE (iter->user_data)->parent->children = G_NODE (iter->user_data);
     }
 
-  if (!emit_signal)
+  gtk_tree_store_children_changed (tree_store, node->parent);
+
+  if (!emit_signal || gtk_tree_store_is_loading (tree_store, node->parent))
     return;
 
   /* Emit the reordered signal. */
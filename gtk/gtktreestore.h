@@ -49,6 +49,21 @@ struct _GtkTreeStore
   GtkTreeStorePrivate *priv;
 };
 
+/**
+ * GtkTreeStoreLoadFunc:
+ * @tree_store: the #GtkTreeStore
+ * @iter: a #GtkTreeIter pointing to a row marked with gtk_tree_store_set_lazy()
+ * @data: (closure): user data given to gtk_tree_store_set_load_func()
+ *
+ * A function which adds the children of the row indicated by @iter,
+ * the first time they are asked for.
+ *
+ * Since: 3.16
+ */
+typedef void (* GtkTreeStoreLoadFunc) (GtkTreeStore *tree_store,
+                                       GtkTreeIter  *iter,
+                                       gpointer      data);
+
 struct _GtkTreeStoreClass
 {
   GObjectClass parent_class;
@@ -164,6 +179,16 @@ void          gtk_tree_store_move_after       (GtkTreeStore *tree_store,
                                                GtkTreeIter  *iter,
                                                GtkTreeIter  *position);
 
+GDK_AVAILABLE_IN_3_16
+void          gtk_tree_store_set_load_func    (GtkTreeStore         *tree_store,
+                                               GtkTreeStoreLoadFunc  func,
+                                               gpointer              data,
+                                               GDestroyNotify        destroy);
+GDK_AVAILABLE_IN_3_16
+void          gtk_tree_store_set_lazy         (GtkTreeStore *tree_store,
+                                               GtkTreeIter  *iter,
+                                               gboolean      lazy);
+
 
 G_END_DECLS
 
@@ -269,6 +269,15 @@ struct _TreeViewDragInfo
 };
 
 
+/* Case folded, normalized search keys for a list model, built the
+ * first time an interactive search uses the default equal function.
+ */
+typedef struct
+{
+  GPtrArray *keys;      /* the key of each row, in model order */
+  guint     *sorted;    /* row numbers ordered by key, NULL if out of date */
+} GtkTreeViewSearchIndex;
+
 struct _GtkTreeViewPrivate
 {
   GtkTreeModel *model;
@@ -316,6 +325,11 @@ struct _GtkTreeViewPrivate
   GtkRBNode *cursor_node;
   GtkRBTree *cursor_tree;
 
+  /* Where the next row of a batch of inserted rows goes */
+  GtkTreePath *batch_path;
+  GtkRBTree *batch_tree;
+  GtkRBNode *batch_node;
+
   GtkTreeViewColumn *focus_column;
 
   /* Current pressed node, previously pressed, prelight */
@@ -416,6 +430,7 @@ struct _GtkTreeViewPrivate
   GtkWidget *search_entry;
   gulong search_entry_changed_id;
   guint typeselect_flush_timeout;
+  GtkTreeViewSearchIndex *search_index;
 
   /* Grid and tree lines */
   GtkTreeViewGridLines grid_lines;
@@ -665,6 +680,11 @@ static void gtk_tree_view_row_inserted                    (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkTreeModel    *model,
+							   GtkTreePath     *path,
+							   GtkTreeIter     *iter,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -833,6 +853,27 @@ static gboolean gtk_tree_view_search_iter               (GtkTreeModel     *model
 							 gint              n);
 static void     gtk_tree_view_search_init               (GtkWidget        *entry,
 							 GtkTreeView      *tree_view);
+static gboolean gtk_tree_view_search_nth                (GtkTreeView      *tree_view,
+							 GtkTreeSelection *selection,
+							 GtkTreeIter      *iter,
+							 const gchar      *text,
+							 gint              n);
+static void     gtk_tree_view_search_index_free         (GtkTreeView      *tree_view);
+static void     gtk_tree_view_end_insert_batch          (GtkTreeView      *tree_view);
+static void     gtk_tree_view_search_index_row_changed  (GtkTreeView      *tree_view,
+							 GtkTreeModel     *model,
+							 GtkTreePath      *path,
+							 GtkTreeIter      *iter);
+static void     gtk_tree_view_search_index_rows_inserted (GtkTreeView     *tree_view,
+							 GtkTreeModel     *model,
+							 GtkTreePath      *path,
+							 GtkTreeIter      *iter,
+							 gint              n_rows);
+static void     gtk_tree_view_search_index_row_deleted  (GtkTreeView      *tree_view,
+							 GtkTreePath      *path);
+static void     gtk_tree_view_search_index_rows_reordered (GtkTreeView    *tree_view,
+							 GtkTreePath      *parent,
+							 gint             *new_order);
 static void     gtk_tree_view_put                       (GtkTreeView      *tree_view,
 							 GtkWidget        *child_widget,
                                                          GtkTreePath      *path,
@@ -2106,6 +2147,8 @@ gtk_tree_view_free_rbtree (GtkTreeView *tree_view)
 {
   _gtk_rbtree_free (tree_view->priv->tree);
 
+  gtk_tree_view_end_insert_batch (tree_view);
+
   tree_view->priv->tree = NULL;
   tree_view->priv->button_pressed_node = NULL;
   tree_view->priv->button_pressed_tree = NULL;
@@ -2183,6 +2226,8 @@ gtk_tree_view_destroy (GtkWidget *widget)
   gtk_tree_row_reference_free (tree_view->priv->anchor);
   tree_view->priv->anchor = NULL;
 
+  gtk_tree_view_search_index_free (tree_view);
+
   /* destroy interactive search dialog */
   if (tree_view->priv->search_window)
     {
@@ -4361,33 +4406,29 @@ gtk_tree_view_update_rubber_band_selection_range (GtkTreeView *tree_view,
       if (select)
         {
 	  if (tree_view->priv->rubber_band_extend)
-            GTK_RBNODE_SET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
+            _gtk_rbtree_node_set_selected (start_tree, start_node, TRUE);
 	  else if (tree_view->priv->rubber_band_modify)
 	    {
 	      /* Toggle the selection state */
-	      if (GTK_RBNODE_FLAG_SET (start_node, GTK_RBNODE_IS_SELECTED))
-		GTK_RBNODE_UNSET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
-	      else
-		GTK_RBNODE_SET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
+	      _gtk_rbtree_node_set_selected (start_tree, start_node,
+	                                     !GTK_RBNODE_FLAG_SET (start_node, GTK_RBNODE_IS_SELECTED));
 	    }
 	  else
-	    GTK_RBNODE_SET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
+	    _gtk_rbtree_node_set_selected (start_tree, start_node, TRUE);
 	}
       else
         {
 	  /* Mirror the above */
 	  if (tree_view->priv->rubber_band_extend)
-	    GTK_RBNODE_UNSET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
+	    _gtk_rbtree_node_set_selected (start_tree, start_node, FALSE);
 	  else if (tree_view->priv->rubber_band_modify)
 	    {
 	      /* Toggle the selection state */
-	      if (GTK_RBNODE_FLAG_SET (start_node, GTK_RBNODE_IS_SELECTED))
-		GTK_RBNODE_UNSET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
-	      else
-		GTK_RBNODE_SET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
+	      _gtk_rbtree_node_set_selected (start_tree, start_node,
+	                                     !GTK_RBNODE_FLAG_SET (start_node, GTK_RBNODE_IS_SELECTED));
 	    }
 	  else
-	    GTK_RBNODE_UNSET_FLAG (start_node, GTK_RBNODE_IS_SELECTED);
+	    _gtk_rbtree_node_set_selected (start_tree, start_node, FALSE);
 	}
 
       _gtk_tree_view_queue_draw_node (tree_view, start_tree, start_node, NULL);
@@ -8949,6 +8990,8 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
   else if (iter == NULL)
     gtk_tree_model_get_iter (model, iter, path);
 
+  gtk_tree_view_search_index_row_changed (tree_view, model, path, iter);
+
   if (_gtk_tree_view_find_node (tree_view,
 				path,
 				&tree,
@@ -8994,37 +9037,45 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+/* Forgets where the next row of a batch of inserted rows goes */
 static void
-gtk_tree_view_row_inserted (GtkTreeModel *model,
-			    GtkTreePath  *path,
-			    GtkTreeIter  *iter,
-			    gpointer      data)
+gtk_tree_view_end_insert_batch (GtkTreeView *tree_view)
+{
+  g_clear_pointer (&tree_view->priv->batch_path, gtk_tree_path_free);
+  tree_view->priv->batch_tree = NULL;
+  tree_view->priv->batch_node = NULL;
+}
+
+/* Inserts the row at @path and @iter into the rbtree.
+ *
+ * Rows of a batch are inserted as they are announced, so the rbtree
+ * always matches the model, but a row that follows the previous row
+ * of the batch goes right after it, without looking up its parent and
+ * position. The size of the view is updated once the batch is complete,
+ * in gtk_tree_view_rows_inserted().
+ */
+static void
+gtk_tree_view_insert_row (GtkTreeView  *tree_view,
+                          GtkTreeModel *model,
+                          GtkTreePath  *path,
+                          GtkTreeIter  *iter,
+                          gboolean      batched)
 {
-  GtkTreeView *tree_view = (GtkTreeView *) data;
   gint *indices;
   GtkRBTree *tree;
   GtkRBNode *tmpnode = NULL;
   gint depth;
   gint i = 0;
   gint height;
-  gboolean free_path = FALSE;
   gboolean node_visible = TRUE;
 
-  g_return_if_fail (path != NULL || iter != NULL);
-
   if (tree_view->priv->fixed_height_mode
       && tree_view->priv->fixed_height >= 0)
     height = tree_view->priv->fixed_height;
   else
     height = 0;
 
-  if (path == NULL)
-    {
-      path = gtk_tree_model_get_path (model, iter);
-      free_path = TRUE;
-    }
-  else if (iter == NULL)
-    gtk_tree_model_get_iter (model, iter, path);
+  gtk_tree_view_search_index_rows_inserted (tree_view, model, path, iter, 1);
 
   if (tree_view->priv->tree == NULL)
     tree_view->priv->tree = _gtk_rbtree_new ();
@@ -9032,7 +9083,21 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   tree = tree_view->priv->tree;
 
   /* Update all row-references */
-  gtk_tree_row_reference_inserted (G_OBJECT (data), path);
+  gtk_tree_row_reference_inserted (G_OBJECT (tree_view), path);
+
+  if (!batched)
+    gtk_tree_view_end_insert_batch (tree_view);
+  else if (tree_view->priv->batch_path &&
+           gtk_tree_path_compare (path, tree_view->priv->batch_path) == 0)
+    {
+      tree = tree_view->priv->batch_tree;
+
+      /* ref the node */
+      gtk_tree_model_ref_node (tree_view->priv->model, iter);
+      tmpnode = _gtk_rbtree_insert_after (tree, tree_view->priv->batch_node, height, FALSE);
+      goto inserted;
+    }
+
   depth = gtk_tree_path_get_depth (path);
   indices = gtk_tree_path_get_indices (path);
 
@@ -9061,7 +9126,7 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
 	   * try to catch it anyway, just to be safe, in case the model hasn't.
 	   */
 	  GtkTreePath *tmppath = _gtk_tree_path_new_from_rbtree (tree, tmpnode);
-	  gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, data);
+	  gtk_tree_view_row_has_child_toggled (model, tmppath, NULL, tree_view);
 	  gtk_tree_path_free (tmppath);
           goto done;
 	}
@@ -9089,25 +9154,87 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
       tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
     }
 
+ inserted:
   _gtk_tree_view_accessible_add (tree_view, tree, tmpnode);
 
+  if (batched)
+    {
+      g_clear_pointer (&tree_view->priv->batch_path, gtk_tree_path_free);
+      tree_view->priv->batch_path = gtk_tree_path_copy (path);
+      gtk_tree_path_next (tree_view->priv->batch_path);
+      tree_view->priv->batch_tree = tree;
+      tree_view->priv->batch_node = tmpnode;
+    }
+
  done:
   if (height > 0)
     {
       if (tree)
         _gtk_rbtree_node_mark_valid (tree, tmpnode);
 
+      if (batched)
+        return;
+
       if (node_visible && node_is_visible (tree_view, tree, tmpnode))
 	gtk_widget_queue_resize (GTK_WIDGET (tree_view));
       else
 	gtk_widget_queue_resize_no_redraw (GTK_WIDGET (tree_view));
     }
-  else
+  else if (!batched)
     install_presize_handler (tree_view);
+}
+
+static void
+gtk_tree_view_row_inserted (GtkTreeModel *model,
+			    GtkTreePath  *path,
+			    GtkTreeIter  *iter,
+			    gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *) data;
+  GtkTreeIter real_iter;
+  gboolean free_path = FALSE;
+
+  g_return_if_fail (path != NULL || iter != NULL);
+
+  if (path == NULL)
+    {
+      path = gtk_tree_model_get_path (model, iter);
+      free_path = TRUE;
+    }
+  else if (iter == NULL)
+    {
+      gtk_tree_model_get_iter (model, &real_iter, path);
+      iter = &real_iter;
+    }
+
+  gtk_tree_view_insert_row (tree_view, model, path, iter,
+                            _gtk_tree_model_is_batched_emission (model));
+
   if (free_path)
     gtk_tree_path_free (path);
 }
 
+static void
+gtk_tree_view_rows_inserted (GtkTreeModel *model,
+			     GtkTreePath  *path,
+			     GtkTreeIter  *iter,
+			     gint          n_rows,
+			     gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *) data;
+
+  /* The rows were added to the rbtree as they were inserted,
+   * only the size of the view is left to update
+   */
+  gtk_tree_view_end_insert_batch (tree_view);
+
+  if (tree_view->priv->fixed_height_mode
+      && tree_view->priv->fixed_height >= 0)
+    gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+  else
+    install_presize_handler (tree_view);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -9123,6 +9250,9 @@ gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 
   g_return_if_fail (path != NULL || iter != NULL);
 
+  /* The children of the row may be removed from the rbtree */
+  gtk_tree_view_end_insert_batch (tree_view);
+
   if (iter)
     real_iter = *iter;
 
@@ -9225,8 +9355,12 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
 
   g_return_if_fail (path != NULL);
 
+  gtk_tree_view_end_insert_batch (tree_view);
+
   gtk_tree_row_reference_deleted (G_OBJECT (data), path);
 
+  gtk_tree_view_search_index_row_deleted (tree_view, path);
+
   if (_gtk_tree_view_find_node (tree_view, path, &tree, &node))
     return;
 
@@ -9357,6 +9491,8 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
   GtkRBNode *node;
   gint len;
 
+  gtk_tree_view_end_insert_batch (tree_view);
+
   len = gtk_tree_model_iter_n_children (model, iter);
 
   if (len < 2)
@@ -9367,6 +9503,8 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
 				    iter,
 				    new_order);
 
+  gtk_tree_view_search_index_rows_reordered (tree_view, parent, new_order);
+
   if (_gtk_tree_view_find_node (tree_view,
 				parent,
 				&tree,
@@ -11418,6 +11556,9 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_rows_inserted,
+					    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_has_child_toggled,
 					    tree_view);
@@ -11428,6 +11569,8 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 					    gtk_tree_view_rows_reordered,
 					    tree_view);
 
+      gtk_tree_view_search_index_free (tree_view);
+
       for (; tmplist; tmplist = tmplist->next)
 	_gtk_tree_view_column_unset_model (tmplist->data,
 					   tree_view->priv->model);
@@ -11486,6 +11629,10 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-inserted",
 			G_CALLBACK (gtk_tree_view_row_inserted),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"rows-inserted",
+			G_CALLBACK (gtk_tree_view_rows_inserted),
+			tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-has-child-toggled",
 			G_CALLBACK (gtk_tree_view_row_has_child_toggled),
@@ -12842,12 +12989,16 @@ gtk_tree_view_real_expand_row (GtkTreeView *tree_view,
   if (expand)
     return FALSE;
 
+  /* Models that load children on demand may only find out now that
+   * the row has none, and emit ::row-has-child-toggled
+   */
+  if (!gtk_tree_model_iter_children (tree_view->priv->model, &temp, &iter))
+    return FALSE;
+
   node->children = _gtk_rbtree_new ();
   node->children->parent_tree = tree;
   node->children->parent_node = node;
 
-  gtk_tree_model_iter_children (tree_view->priv->model, &temp, &iter);
-
   gtk_tree_view_build_tree (tree_view,
 			    node->children,
 			    &temp,
@@ -12932,6 +13083,8 @@ gtk_tree_view_real_collapse_row (GtkTreeView *tree_view,
 
   if (node->children == NULL)
     return FALSE;
+
+  gtk_tree_view_end_insert_batch (tree_view);
   gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
 
   g_signal_emit (tree_view, tree_view_signals[TEST_COLLAPSE_ROW], 0, &iter, path, &collapse);
@@ -14894,6 +15047,7 @@ gtk_tree_view_set_search_column (GtkTreeView *tree_view,
     return;
 
   tree_view->priv->search_column = column;
+  gtk_tree_view_search_index_free (tree_view);
   g_object_notify (G_OBJECT (tree_view), "search-column");
 }
 
@@ -14942,6 +15096,8 @@ gtk_tree_view_set_search_equal_func (GtkTreeView                *tree_view,
   tree_view->priv->search_destroy = search_destroy;
   if (tree_view->priv->search_equal_func == NULL)
     tree_view->priv->search_equal_func = gtk_tree_view_search_equal_func;
+
+  gtk_tree_view_search_index_free (tree_view);
 }
 
 /**
@@ -15374,7 +15530,6 @@ gtk_tree_view_search_move (GtkWidget   *window,
 {
   gboolean ret;
   gint len;
-  gint count = 0;
   const gchar *text;
   GtkTreeIter iter;
   GtkTreeModel *model;
@@ -15400,8 +15555,8 @@ gtk_tree_view_search_move (GtkWidget   *window,
   if (!gtk_tree_model_get_iter_first (model, &iter))
     return TRUE;
 
-  ret = gtk_tree_view_search_iter (model, selection, &iter, text,
-				   &count, up?((tree_view->priv->selected_iter) - 1):((tree_view->priv->selected_iter + 1)));
+  ret = gtk_tree_view_search_nth (tree_view, selection, &iter, text,
+				  up?((tree_view->priv->selected_iter) - 1):((tree_view->priv->selected_iter + 1)));
 
   if (ret)
     {
@@ -15412,28 +15567,40 @@ gtk_tree_view_search_move (GtkWidget   *window,
   else
     {
       /* return to old iter */
-      count = 0;
       gtk_tree_model_get_iter_first (model, &iter);
-      gtk_tree_view_search_iter (model, selection,
-				 &iter, text,
-				 &count, tree_view->priv->selected_iter);
+      gtk_tree_view_search_nth (tree_view, selection,
+				&iter, text,
+				tree_view->priv->selected_iter);
       return FALSE;
     }
 }
 
-static gboolean
-gtk_tree_view_search_equal_func (GtkTreeModel *model,
-				 gint          column,
-				 const gchar  *key,
-				 GtkTreeIter  *iter,
-				 gpointer      search_data)
+/* Returns the normalized, case folded form of @str that the default
+ * equal function compares, or %NULL if @str can't be normalized.
+ */
+static gchar *
+gtk_tree_view_search_make_key (const gchar *str)
+{
+  gchar *normalized;
+  gchar *key;
+
+  normalized = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
+  if (!normalized)
+    return NULL;
+
+  key = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return key;
+}
+
+static gchar *
+gtk_tree_view_search_row_key (GtkTreeModel *model,
+                              gint          column,
+                              GtkTreeIter  *iter)
 {
-  gboolean retval = TRUE;
   const gchar *str;
-  gchar *normalized_string;
-  gchar *normalized_key;
-  gchar *case_normalized_string = NULL;
-  gchar *case_normalized_key = NULL;
+  gchar *key = NULL;
   GValue value = G_VALUE_INIT;
   GValue transformed = G_VALUE_INIT;
 
@@ -15441,42 +15608,58 @@ gtk_tree_view_search_equal_func (GtkTreeModel *model,
 
   g_value_init (&transformed, G_TYPE_STRING);
 
-  if (!g_value_transform (&value, &transformed))
+  if (g_value_transform (&value, &transformed))
     {
-      g_value_unset (&value);
-      return TRUE;
+      str = g_value_get_string (&transformed);
+      if (str)
+        key = gtk_tree_view_search_make_key (str);
     }
 
   g_value_unset (&value);
+  g_value_unset (&transformed);
 
-  str = g_value_get_string (&transformed);
-  if (!str)
-    {
-      g_value_unset (&transformed);
-      return TRUE;
-    }
+  return key;
+}
 
-  normalized_string = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
-  normalized_key = g_utf8_normalize (key, -1, G_NORMALIZE_ALL);
+static gboolean
+gtk_tree_view_search_equal_func (GtkTreeModel *model,
+				 gint          column,
+				 const gchar  *key,
+				 GtkTreeIter  *iter,
+				 gpointer      search_data)
+{
+  gboolean retval = TRUE;
+  gchar *case_normalized_string;
+  gchar *case_normalized_key;
 
-  if (normalized_string && normalized_key)
-    {
-      case_normalized_string = g_utf8_casefold (normalized_string, -1);
-      case_normalized_key = g_utf8_casefold (normalized_key, -1);
+  case_normalized_string = gtk_tree_view_search_row_key (model, column, iter);
+  if (!case_normalized_string)
+    return TRUE;
 
-      if (strncmp (case_normalized_key, case_normalized_string, strlen (case_normalized_key)) == 0)
-        retval = FALSE;
-    }
+  case_normalized_key = gtk_tree_view_search_make_key (key);
+
+  if (case_normalized_key &&
+      strncmp (case_normalized_key, case_normalized_string, strlen (case_normalized_key)) == 0)
+    retval = FALSE;
 
-  g_value_unset (&transformed);
-  g_free (normalized_key);
-  g_free (normalized_string);
   g_free (case_normalized_key);
   g_free (case_normalized_string);
 
   return retval;
 }
 
+static void
+gtk_tree_view_search_select (GtkTreeView      *tree_view,
+                             GtkTreeSelection *selection,
+                             GtkTreePath      *path,
+                             GtkTreeIter      *iter)
+{
+  gtk_tree_view_scroll_to_cell (tree_view, path, NULL,
+                                TRUE, 0.5, 0.0);
+  gtk_tree_selection_select_iter (selection, iter);
+  gtk_tree_view_real_set_cursor (tree_view, path, CLAMP_NODE);
+}
+
 static gboolean
 gtk_tree_view_search_iter (GtkTreeModel     *model,
 			   GtkTreeSelection *selection,
@@ -15501,10 +15684,7 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
           (*count)++;
           if (*count == n)
             {
-              gtk_tree_view_scroll_to_cell (tree_view, path, NULL,
-					    TRUE, 0.5, 0.0);
-              gtk_tree_selection_select_iter (selection, iter);
-              gtk_tree_view_real_set_cursor (tree_view, path, CLAMP_NODE);
+              gtk_tree_view_search_select (tree_view, selection, path, iter);
 
 	      if (path)
 		gtk_tree_path_free (path);
@@ -15582,12 +15762,347 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
   return FALSE;
 }
 
+/* Search index
+ *
+ * Walking the model and case folding every row for every key press
+ * gets slow on large models, so when the interactive search uses the
+ * default equal function on a list model, the keys of all rows are
+ * computed once and kept sorted. A prefix then matches a contiguous
+ * range of the sorted keys, which is found with two binary searches.
+ *
+ * The keys are kept up to date from the model signals; the sorted
+ * order is only recomputed on the next search after a change.
+ */
+
+static void
+gtk_tree_view_search_index_free (GtkTreeView *tree_view)
+{
+  GtkTreeViewSearchIndex *index = tree_view->priv->search_index;
+
+  if (index == NULL)
+    return;
+
+  g_ptr_array_unref (index->keys);
+  g_free (index->sorted);
+  g_slice_free (GtkTreeViewSearchIndex, index);
+
+  tree_view->priv->search_index = NULL;
+}
+
+static GtkTreeViewSearchIndex *
+gtk_tree_view_search_index_ensure (GtkTreeView *tree_view)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  GtkTreeViewSearchIndex *index;
+  GtkTreeIter iter;
+
+  if (priv->model == NULL ||
+      priv->search_column < 0 ||
+      priv->search_equal_func != gtk_tree_view_search_equal_func ||
+      !(gtk_tree_model_get_flags (priv->model) & GTK_TREE_MODEL_LIST_ONLY))
+    {
+      gtk_tree_view_search_index_free (tree_view);
+      return NULL;
+    }
+
+  if (priv->search_index)
+    return priv->search_index;
+
+  index = g_slice_new0 (GtkTreeViewSearchIndex);
+  index->keys = g_ptr_array_new_with_free_func (g_free);
+
+  if (gtk_tree_model_get_iter_first (priv->model, &iter))
+    {
+      do
+        g_ptr_array_add (index->keys,
+                         gtk_tree_view_search_row_key (priv->model, priv->search_column, &iter));
+      while (gtk_tree_model_iter_next (priv->model, &iter));
+    }
+
+  priv->search_index = index;
+
+  return index;
+}
+
+static gint
+gtk_tree_view_search_index_compare (gconstpointer a,
+                                    gconstpointer b,
+                                    gpointer      user_data)
+{
+  const gchar **keys = user_data;
+  guint row_a = *(const guint *) a;
+  guint row_b = *(const guint *) b;
+
+  /* Rows without a key never match, keep them out of the way */
+  if (keys[row_a] == NULL || keys[row_b] == NULL)
+    {
+      if (keys[row_a] != keys[row_b])
+        return keys[row_a] == NULL ? -1 : 1;
+    }
+  else
+    {
+      gint result = strcmp (keys[row_a], keys[row_b]);
+      if (result != 0)
+        return result;
+    }
+
+  return row_a < row_b ? -1 : (row_a > row_b);
+}
+
+static gint
+gtk_tree_view_search_index_compare_rows (gconstpointer a,
+                                         gconstpointer b)
+{
+  guint row_a = *(const guint *) a;
+  guint row_b = *(const guint *) b;
+
+  return row_a < row_b ? -1 : (row_a > row_b);
+}
+
+/* Finds the @n-th row, in model order, whose key starts with @text */
+static gboolean
+gtk_tree_view_search_index_find (GtkTreeViewSearchIndex *index,
+                                 const gchar            *text,
+                                 gint                    n,
+                                 guint                  *row)
+{
+  const gchar **keys = (const gchar **) index->keys->pdata;
+  guint n_keys = index->keys->len;
+  guint lo, hi, first, mid, i;
+  guint *matches;
+  gchar *key;
+  gsize len;
+
+  if (n < 1)
+    return FALSE;
+
+  if (index->sorted == NULL)
+    {
+      index->sorted = g_new (guint, MAX (n_keys, 1));
+      for (i = 0; i < n_keys; i++)
+        index->sorted[i] = i;
+      g_qsort_with_data (index->sorted, n_keys, sizeof (guint),
+                         gtk_tree_view_search_index_compare, keys);
+    }
+
+  key = gtk_tree_view_search_make_key (text);
+  if (key == NULL)
+    return FALSE;
+
+  len = strlen (key);
+
+  /* The first key that is not smaller than @key */
+  lo = 0;
+  hi = n_keys;
+  while (lo < hi)
+    {
+      const gchar *k;
+
+      mid = lo + (hi - lo) / 2;
+      k = keys[index->sorted[mid]];
+      if (k == NULL || strcmp (k, key) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  first = lo;
+
+  /* The first key after it that doesn't start with @key */
+  hi = n_keys;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (strncmp (keys[index->sorted[mid]], key, len) == 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  g_free (key);
+
+  if (lo - first < (guint) n)
+    return FALSE;
+
+  if (n == 1)
+    {
+      *row = index->sorted[first];
+      for (i = first + 1; i < lo; i++)
+        *row = MIN (*row, index->sorted[i]);
+
+      return TRUE;
+    }
+
+  matches = g_memdup (index->sorted + first, (lo - first) * sizeof (guint));
+  qsort (matches, lo - first, sizeof (guint), gtk_tree_view_search_index_compare_rows);
+  *row = matches[n - 1];
+  g_free (matches);
+
+  return TRUE;
+}
+
+static void
+gtk_tree_view_search_index_row_changed (GtkTreeView  *tree_view,
+                                        GtkTreeModel *model,
+                                        GtkTreePath  *path,
+                                        GtkTreeIter  *iter)
+{
+  GtkTreeViewSearchIndex *index = tree_view->priv->search_index;
+  GtkTreeIter real_iter;
+  gchar *key;
+  gchar **slot;
+  gint row;
+
+  if (index == NULL || gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  row = gtk_tree_path_get_indices (path)[0];
+  if ((guint) row >= index->keys->len)
+    return;
+
+  if (iter == NULL)
+    {
+      if (!gtk_tree_model_get_iter (model, &real_iter, path))
+        return;
+      iter = &real_iter;
+    }
+
+  key = gtk_tree_view_search_row_key (model, tree_view->priv->search_column, iter);
+  slot = (gchar **) &g_ptr_array_index (index->keys, row);
+
+  if (g_strcmp0 (*slot, key) == 0)
+    {
+      g_free (key);
+      return;
+    }
+
+  g_free (*slot);
+  *slot = key;
+  g_clear_pointer (&index->sorted, g_free);
+}
+
+static void
+gtk_tree_view_search_index_rows_inserted (GtkTreeView  *tree_view,
+                                          GtkTreeModel *model,
+                                          GtkTreePath  *path,
+                                          GtkTreeIter  *iter,
+                                          gint          n_rows)
+{
+  GtkTreeViewSearchIndex *index = tree_view->priv->search_index;
+  GtkTreeIter row_iter;
+  gint row, i;
+
+  if (index == NULL || gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  row = gtk_tree_path_get_indices (path)[0];
+  if ((guint) row > index->keys->len)
+    {
+      gtk_tree_view_search_index_free (tree_view);
+      return;
+    }
+
+  row_iter = *iter;
+  for (i = 0; i < n_rows; i++)
+    {
+      g_ptr_array_insert (index->keys, row + i,
+                          gtk_tree_view_search_row_key (model, tree_view->priv->search_column, &row_iter));
+
+      if (i + 1 < n_rows && !gtk_tree_model_iter_next (model, &row_iter))
+        break;
+    }
+
+  g_clear_pointer (&index->sorted, g_free);
+}
+
+static void
+gtk_tree_view_search_index_row_deleted (GtkTreeView *tree_view,
+                                        GtkTreePath *path)
+{
+  GtkTreeViewSearchIndex *index = tree_view->priv->search_index;
+  gint row;
+
+  if (index == NULL || gtk_tree_path_get_depth (path) != 1)
+    return;
+
+  row = gtk_tree_path_get_indices (path)[0];
+  if ((guint) row >= index->keys->len)
+    {
+      gtk_tree_view_search_index_free (tree_view);
+      return;
+    }
+
+  g_ptr_array_remove_index (index->keys, row);
+  g_clear_pointer (&index->sorted, g_free);
+}
+
+static void
+gtk_tree_view_search_index_rows_reordered (GtkTreeView *tree_view,
+                                           GtkTreePath *parent,
+                                           gint        *new_order)
+{
+  GtkTreeViewSearchIndex *index = tree_view->priv->search_index;
+  GPtrArray *keys;
+  guint i;
+
+  if (index == NULL || gtk_tree_path_get_depth (parent) != 0)
+    return;
+
+  /* new_order[new position] = old position */
+  keys = g_ptr_array_new_full (index->keys->len, g_free);
+  for (i = 0; i < index->keys->len; i++)
+    {
+      gpointer *old = &g_ptr_array_index (index->keys, new_order[i]);
+
+      g_ptr_array_add (keys, *old);
+      *old = NULL;
+    }
+
+  g_ptr_array_unref (index->keys);
+  index->keys = keys;
+  g_clear_pointer (&index->sorted, g_free);
+}
+
+/* Selects the @n-th row matching @text, starting at @iter, which
+ * must point to the first row of the model.
+ */
+static gboolean
+gtk_tree_view_search_nth (GtkTreeView      *tree_view,
+                          GtkTreeSelection *selection,
+                          GtkTreeIter      *iter,
+                          const gchar      *text,
+                          gint              n)
+{
+  GtkTreeViewSearchIndex *index;
+  GtkTreePath *path;
+  gint count = 0;
+  guint row;
+
+  index = gtk_tree_view_search_index_ensure (tree_view);
+  if (index == NULL)
+    return gtk_tree_view_search_iter (tree_view->priv->model, selection,
+                                      iter, text, &count, n);
+
+  if (!gtk_tree_view_search_index_find (index, text, n, &row))
+    return FALSE;
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+  if (!gtk_tree_model_get_iter (tree_view->priv->model, iter, path))
+    {
+      gtk_tree_path_free (path);
+      return FALSE;
+    }
+
+  gtk_tree_view_search_select (tree_view, selection, path, iter);
+  gtk_tree_path_free (path);
+
+  return TRUE;
+}
+
 static void
 gtk_tree_view_search_init (GtkWidget   *entry,
 			   GtkTreeView *tree_view)
 {
   gint ret;
-  gint count = 0;
   const gchar *text;
   GtkTreeIter iter;
   GtkTreeModel *model;
@@ -15620,9 +16135,8 @@ gtk_tree_view_search_init (GtkWidget   *entry,
   if (!gtk_tree_model_get_iter_first (model, &iter))
     return;
 
-  ret = gtk_tree_view_search_iter (model, selection,
-				   &iter, text,
-				   &count, 1);
+  ret = gtk_tree_view_search_nth (tree_view, selection,
+				  &iter, text, 1);
 
   if (ret)
     tree_view->priv->selected_iter = 1;
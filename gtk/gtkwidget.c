@@ -69,6 +69,8 @@
 #include "gtkapplicationprivate.h"
 #include "gtkgestureprivate.h"
 
+#include "gdk/gdk-private.h"
+
 /* for the use of round() */
 #include "fallback-c89.c"
 
@@ -6959,13 +6961,20 @@ _gtk_widget_draw_internal (GtkWidget *widget,
   if (gdk_cairo_get_clip_rectangle (cr, NULL))
     {
       gboolean result;
+      gint64 before = 0;
 
       gdk_window_mark_paint_from_clip (window, cr);
 
+      if (GDK_PRIVATE_CALL (gdk_profiler_is_running) ())
+        before = g_get_monotonic_time ();
+
       g_signal_emit (widget, widget_signals[DRAW],
                      0, cr,
                      &result);
 
+      GDK_PRIVATE_CALL (gdk_profiler_end_mark) (before, "widget draw",
+                                                G_OBJECT_TYPE_NAME (widget));
+
 #ifdef G_ENABLE_DEBUG
       if (G_UNLIKELY (gtk_get_debug_flags () & GTK_DEBUG_BASELINES))
 	{
@@ -30,6 +30,7 @@
 #include "gtkimage.h"
 #include "gtkadjustment.h"
 #include "gtkbox.h"
+#include "gtkiconthemeprivate.h"
 
 #ifdef GDK_WINDOWING_X11
 #include "x11/gdkx.h"
@@ -58,6 +59,7 @@ struct _GtkInspectorGeneralPrivate
   GtkWidget *version_box;
   GtkWidget *env_box;
   GtkWidget *gl_box;
+  GtkWidget *icon_cache_box;
   GtkWidget *gtk_version;
   GtkWidget *gdk_backend;
   GtkWidget *gl_version;
@@ -69,6 +71,8 @@ struct _GtkInspectorGeneralPrivate
   GtkWidget *gtk_exe_prefix;
   GtkWidget *gtk_data_prefix;
   GtkWidget *gsettings_schema_dir;
+  GtkWidget *icon_lookups;
+  GtkWidget *icon_cache;
   GtkSizeGroup *labels;
   GtkAdjustment *focus_adjustment;
 };
@@ -268,6 +272,29 @@ init_env (GtkInspectorGeneral *gen)
   set_path_label (gen->priv->gsettings_schema_dir, "GSETTINGS_SCHEMA_DIR");
 }
 
+static void
+update_icon_cache (GtkInspectorGeneral *gen)
+{
+  GtkIconThemeCacheStats stats;
+  gchar *text, *used, *budget;
+
+  _gtk_icon_theme_get_cache_stats (gtk_icon_theme_get_default (), &stats);
+
+  text = g_strdup_printf (_("%u cached, %u found earlier, %u searched"),
+                          stats.hits, stats.lookup_hits, stats.misses);
+  gtk_label_set_text (GTK_LABEL (gen->priv->icon_lookups), text);
+  g_free (text);
+
+  used = g_format_size (stats.unused_bytes);
+  budget = g_format_size (stats.unused_budget);
+  text = g_strdup_printf (_("%u icons, %s of %s, %u evicted"),
+                          stats.n_unused, used, budget, stats.evictions);
+  gtk_label_set_text (GTK_LABEL (gen->priv->icon_cache), text);
+  g_free (text);
+  g_free (used);
+  g_free (budget);
+}
+
 static void
 gtk_inspector_general_init (GtkInspectorGeneral *gen)
 {
@@ -293,9 +320,15 @@ keynav_failed (GtkWidget *widget, GtkDirectionType direction, GtkInspectorGenera
   else if (direction == GTK_DIR_UP &&
            widget == gen->priv->env_box)
     next = gen->priv->version_box;
+  else if (direction == GTK_DIR_DOWN &&
+      widget == gen->priv->gl_box)
+    next = gen->priv->icon_cache_box;
   else if (direction == GTK_DIR_UP &&
            widget == gen->priv->gl_box)
     next = gen->priv->env_box;
+  else if (direction == GTK_DIR_UP &&
+           widget == gen->priv->icon_cache_box)
+    next = gen->priv->gl_box;
   else
     next = NULL;
 
@@ -338,6 +371,10 @@ gtk_inspector_general_constructed (GObject *object)
    g_signal_connect (gen->priv->version_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
    g_signal_connect (gen->priv->env_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
    g_signal_connect (gen->priv->gl_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
+   g_signal_connect (gen->priv->icon_cache_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
+
+   /* The icon cache counters change all the time */
+   g_signal_connect_swapped (gen, "map", G_CALLBACK (update_icon_cache), gen);
 }
 
 static void
@@ -352,6 +389,7 @@ gtk_inspector_general_class_init (GtkInspectorGeneralClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, version_box);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, env_box);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gl_box);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, icon_cache_box);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gtk_version);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gdk_backend);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gl_version);
@@ -363,6 +401,8 @@ gtk_inspector_general_class_init (GtkInspectorGeneralClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gtk_exe_prefix);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gtk_data_prefix);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, gsettings_schema_dir);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, icon_lookups);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, icon_cache);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorGeneral, labels);
 }
 
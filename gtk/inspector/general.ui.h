@@ -3,3 +3,5 @@ N_("GDK Backend");
 N_("Prefix");
 N_("GL Version");
 N_("GL Vendor");
+N_("Icon Lookups");
+N_("Unused Icons");
@@ -31,6 +31,12 @@
 #ifdef _MSC_VER
 #include <io.h>
 #include <sys/utime.h>
+#ifndef S_ISDIR
+#define S_ISDIR(mode) ((mode)&_S_IFDIR)
+#endif
+#ifndef S_ISREG
+#define S_ISREG(mode) ((mode)&_S_IFREG)
+#endif
 #else
 #include <utime.h>
 #endif
@@ -45,7 +51,9 @@ static gboolean force_update = FALSE;
 static gboolean ignore_theme_index = FALSE;
 static gboolean quiet = FALSE;
 static gboolean index_only = TRUE;
+static gboolean include_surfaces = FALSE;
 static gboolean validate = FALSE;
+static gboolean incremental = FALSE;
 static gchar *var_name = "-";
 
 /* Quite ugly - if we just add the c file to the
@@ -64,6 +72,12 @@ static gchar *var_name = "-";
 #define MINOR_VERSION 0
 #define HASH_OFFSET 12
 
+/* Images bigger than this are not stored as surfaces */
+#define MAX_SURFACE_SIZE 256
+
+#define GET_UINT16(cache, offset) (GUINT16_FROM_BE (*(guint16 *)((cache) + (offset))))
+#define GET_UINT32(cache, offset) (GUINT32_FROM_BE (*(guint32 *)((cache) + (offset))))
+
 #define ALIGN_VALUE(this, boundary) \
   (( ((unsigned long)(this)) + (((unsigned long)(boundary)) -1)) & (~(((unsigned long)(boundary))-1)))
 
@@ -165,6 +179,20 @@ typedef struct
 {
   GdkPixdata pixdata;
   gboolean has_pixdata;
+
+  /* Premultiplied ARGB32, in host byte order */
+  guchar *surface_data;
+  gint width, height, stride;
+
+  /* Pixel data copied as is from the previous cache */
+  const gchar *old_data;
+  guint32 old_type;
+  guint32 old_length;
+
+  /* The file to load the pixels from, set once it is queued */
+  gchar *path;
+  gint render_size;
+
   guint32 offset;
   guint size;
 } ImageData;
@@ -180,17 +208,31 @@ typedef struct
   int n_display_names;
   char **display_names;
 
+  /* The .icon file to load */
+  gchar *path;
+
   guint32 offset;
   gint size;
 } IconData;
 
 static GHashTable *image_data_hash = NULL;
 static GHashTable *icon_data_hash = NULL;
+static GKeyFile *theme_index = NULL;
+
+/* Image and icon data that still has to be loaded from files,
+ * which is done in threads once all directories are scanned
+ */
+static GPtrArray *pending_image_data = NULL;
+static GPtrArray *pending_icon_data = NULL;
 
 typedef struct
 {
   int flags;
   int dir_index;
+  /* The newest modification or status change time of the
+   * files of the image
+   */
+  time_t mtime;
 
   ImageData *image_data;
   guint pixel_data_size;
@@ -230,9 +272,11 @@ foreach_remove_func (gpointer key, gpointer value, gpointer user_data)
   return TRUE;
 }
 
-static IconData *
-load_icon_data (const char *path)
+static void
+load_icon_data (gpointer job,
+                gpointer user_data)
 {
+  IconData *data = job;
   GKeyFile *icon_file;
   char **split;
   gsize length;
@@ -243,21 +287,18 @@ load_icon_data (const char *path)
   GError *error = NULL;
   gchar **keys;
   gsize n_keys;
-  IconData *data;
   
   icon_file = g_key_file_new ();
   g_key_file_set_list_separator (icon_file, ',');
-  g_key_file_load_from_file (icon_file, path, G_KEY_FILE_KEEP_TRANSLATIONS, &error);
+  g_key_file_load_from_file (icon_file, data->path, G_KEY_FILE_KEEP_TRANSLATIONS, &error);
   if (error)
     {
       g_error_free (error);
       g_key_file_free (icon_file);
 
-      return NULL;
+      return;
     }
 
-  data = g_new0 (IconData, 1);
-
   ivalues = g_key_file_get_integer_list (icon_file, 
 					 "Icon Data", "EmbeddedTextRectangle",
 					 &length, NULL);
@@ -342,14 +383,6 @@ load_icon_data (const char *path)
   g_strfreev (keys);
   
   g_key_file_free (icon_file);
-
-  /* -1 means not computed yet, the real value depends
-   * on string pool state, and will be computed 
-   * later 
-   */
-  data->size = -1;
-
-  return data;
 }
 
 /*
@@ -464,66 +497,297 @@ follow_links (const gchar *path)
   return path2;
 }
 
+static gboolean
+is_symbolic_svg (const gchar *path)
+{
+  return g_str_has_suffix (path, "-symbolic.svg") ||
+         g_str_has_suffix (path, "-symbolic-ltr.svg") ||
+         g_str_has_suffix (path, "-symbolic-rtl.svg");
+}
+
+/* Returns the size in pixels the icons in @subdir are loaded at
+ * when asked for the nominal size of the directory, or 0.
+ */
+static gint
+get_directory_pixel_size (const gchar *subdir)
+{
+  gint size, scale;
+
+  if (theme_index == NULL || subdir == NULL ||
+      !g_key_file_has_group (theme_index, subdir))
+    return 0;
+
+  size = g_key_file_get_integer (theme_index, subdir, "Size", NULL);
+  scale = g_key_file_get_integer (theme_index, subdir, "Scale", NULL);
+
+  return size * MAX (scale, 1);
+}
+
+/* Same as in gtkicontheme.c: strokes and images keep colors of their
+ * own, so GTK+ renders svgs using them with the final colors instead
+ * of recoloring a mask.
+ */
+static gboolean
+symbolic_svg_can_use_mask (const gchar *data,
+                           gsize        len)
+{
+  const gchar *p, *end;
+
+  end = data + len;
+  for (p = data; p < end; p++)
+    {
+      if (end - p >= 6 && strncmp (p, "<image", 6) == 0)
+        return FALSE;
+
+      if (end - p >= 6 && strncmp (p, "stroke", 6) == 0)
+        {
+          const gchar *value = p + 6;
+
+          while (value < end && g_ascii_isspace (*value))
+            value++;
+          if (value == end || (*value != '=' && *value != ':'))
+            continue;
+
+          value++;
+          while (value < end && (g_ascii_isspace (*value) || *value == '"' || *value == '\''))
+            value++;
+          if (end - value < 4 || strncmp (value, "none", 4) != 0)
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Renders a symbolic svg like GTK+ does before recoloring it, with
+ * the foreground in black and the success, warning and error colors
+ * each in a color channel of their own.
+ */
+static GdkPixbuf *
+load_symbolic_mask (const gchar *path,
+                    gint         size)
+{
+  GInputStream *stream;
+  GdkPixbuf *pixbuf;
+  gchar *file_data, *escaped_file_data;
+  gchar *data, *svg_size;
+  gsize file_len;
+  gint width, height;
+
+  if (!gdk_pixbuf_get_file_info (path, &width, &height))
+    return NULL;
+
+  if (!g_file_get_contents (path, &file_data, &file_len, NULL))
+    return NULL;
+
+  if (!symbolic_svg_can_use_mask (file_data, file_len))
+    {
+      g_free (file_data);
+      return NULL;
+    }
+
+  svg_size = g_strdup_printf ("%d", MAX (width, height));
+  escaped_file_data = g_markup_escape_text (file_data, file_len);
+  g_free (file_data);
+
+  data = g_strconcat ("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+                      "<svg version=\"1.1\"\n"
+                      "     xmlns=\"http://www.w3.org/2000/svg\"\n"
+                      "     xmlns:xi=\"http://www.w3.org/2001/XInclude\"\n"
+                      "     width=\"", svg_size, "\"\n"
+                      "     height=\"", svg_size, "\">\n"
+                      "  <style type=\"text/css\">\n"
+                      "    rect,circle,ellipse,line,polyline,polygon,path,text,tspan,textPath {\n"
+                      "      fill: rgb(0,0,0) !important;\n"
+                      "    }\n"
+                      "    .warning {\n"
+                      "      fill: rgb(0,255,0) !important;\n"
+                      "    }\n"
+                      "    .error {\n"
+                      "      fill: rgb(0,0,255) !important;\n"
+                      "    }\n"
+                      "    .success {\n"
+                      "      fill: rgb(255,0,0) !important;\n"
+                      "    }\n"
+                      "  </style>\n"
+                      "  <xi:include href=\"data:text/xml,", escaped_file_data, "\"/>\n"
+                      "</svg>",
+                      NULL);
+  g_free (escaped_file_data);
+  g_free (svg_size);
+
+  stream = g_memory_input_stream_new_from_data (data, -1, g_free);
+  pixbuf = gdk_pixbuf_new_from_stream_at_scale (stream, size, size, TRUE, NULL, NULL);
+  g_object_unref (stream);
+
+  return pixbuf;
+}
+
+/* Same as in gdk_cairo_surface_paint_pixbuf() */
+#define MULT(d,c,a,t) G_STMT_START { t = c * a + 0x80; d = ((t >> 8) + t) >> 8; } G_STMT_END
+
+static void
+image_data_set_surface (ImageData *idata,
+                        GdkPixbuf *pixbuf)
+{
+  gint n_channels, src_stride;
+  const guchar *src;
+  gint x, y;
+
+  idata->width = gdk_pixbuf_get_width (pixbuf);
+  idata->height = gdk_pixbuf_get_height (pixbuf);
+  idata->stride = idata->width * 4;
+  idata->surface_data = g_malloc (idata->stride * idata->height);
+
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+  src_stride = gdk_pixbuf_get_rowstride (pixbuf);
+  src = gdk_pixbuf_get_pixels (pixbuf);
+
+  for (y = 0; y < idata->height; y++)
+    {
+      const guchar *p = src + y * src_stride;
+      guint32 *q = (guint32 *) (idata->surface_data + y * idata->stride);
+
+      for (x = 0; x < idata->width; x++)
+        {
+          guint a = n_channels == 4 ? p[3] : 0xff;
+          guint r, g, b, t;
+
+          MULT (r, p[0], a, t);
+          MULT (g, p[1], a, t);
+          MULT (b, p[2], a, t);
+          q[x] = (a << 24) | (r << 16) | (g << 8) | b;
+
+          p += n_channels;
+        }
+    }
+
+  /* Type, length, width, height and stride, then the pixels */
+  idata->size = 20 + idata->stride * idata->height;
+}
+
+#undef MULT
+
+static void
+load_image_data (gpointer job,
+                 gpointer user_data)
+{
+  ImageData *idata = job;
+  GdkPixbuf *pixbuf;
+
+  if (idata->render_size > 0 && is_symbolic_svg (idata->path))
+    pixbuf = load_symbolic_mask (idata->path, idata->render_size);
+  else if (idata->render_size > 0)
+    pixbuf = gdk_pixbuf_new_from_file_at_size (idata->path,
+                                               idata->render_size,
+                                               idata->render_size,
+                                               NULL);
+  else
+    pixbuf = gdk_pixbuf_new_from_file (idata->path, NULL);
+
+  if (pixbuf == NULL)
+    return;
+
+  if (include_surfaces &&
+      gdk_pixbuf_get_width (pixbuf) <= MAX_SURFACE_SIZE &&
+      gdk_pixbuf_get_height (pixbuf) <= MAX_SURFACE_SIZE)
+    {
+      image_data_set_surface (idata, pixbuf);
+      g_object_unref (pixbuf);
+    }
+  else if (!index_only && idata->render_size == 0)
+    {
+      /* The pixdata points to the pixels of the pixbuf */
+      gdk_pixdata_from_pixbuf (&idata->pixdata, pixbuf, FALSE);
+      idata->size = idata->pixdata.length + 8;
+      idata->has_pixdata = TRUE;
+    }
+  else
+    g_object_unref (pixbuf);
+}
+
 static void
 maybe_cache_image_data (Image       *image, 
-			const gchar *path)
+			const gchar *path,
+			const gchar *subdir)
 {
-  if (!index_only && !image->image_data && 
-      (g_str_has_suffix (path, ".png") || g_str_has_suffix (path, ".xpm")))
+  ImageData *idata;
+  gchar *key, *path2, *key2;
+  gint render_size = 0;
+
+  if (image->image_data)
+    return;
+
+  if (include_surfaces && g_str_has_suffix (path, ".svg"))
     {
-      GdkPixbuf *pixbuf;
-      ImageData *idata;
-      gchar *path2;
+      /* Svgs are stored prerendered at the size of their
+       * directory, so the same svg can have different image
+       * data in each directory
+       */
+      render_size = get_directory_pixel_size (subdir);
+      if (render_size <= 0 || render_size > MAX_SURFACE_SIZE)
+        return;
+    }
+  else if (index_only && !include_surfaces)
+    return;
+  else if (!g_str_has_suffix (path, ".png") && !g_str_has_suffix (path, ".xpm"))
+    return;
 
-      idata = g_hash_table_lookup (image_data_hash, path);
-      path2 = follow_links (path);
+  if (render_size > 0)
+    key = g_strdup_printf ("%s@%d", path, render_size);
+  else
+    key = g_strdup (path);
 
-      if (path2)
-	{
-	  ImageData *idata2;
+  idata = g_hash_table_lookup (image_data_hash, key);
+  path2 = follow_links (path);
+  key2 = NULL;
 
-	  canonicalize_filename (path2);
-  
-	  idata2 = g_hash_table_lookup (image_data_hash, path2);
+  if (path2)
+    {
+      ImageData *idata2;
 
-	  if (idata && idata2 && idata != idata2)
-	    g_error ("different idatas found for symlinked '%s' and '%s'\n",
-		     path, path2);
+      canonicalize_filename (path2);
+      if (render_size > 0)
+        key2 = g_strdup_printf ("%s@%d", path2, render_size);
+      else
+        key2 = g_strdup (path2);
 
-	  if (idata && !idata2)
-	    g_hash_table_insert (image_data_hash, g_strdup (path2), idata);
+      idata2 = g_hash_table_lookup (image_data_hash, key2);
 
-	  if (!idata && idata2)
-	    {
-	      g_hash_table_insert (image_data_hash, g_strdup (path), idata2);
-	      idata = idata2;
-	    }
-	}
-      
-      if (!idata)
-	{
-	  idata = g_new0 (ImageData, 1);
-	  g_hash_table_insert (image_data_hash, g_strdup (path), idata);
-	  if (path2)
-	    g_hash_table_insert (image_data_hash, g_strdup (path2), idata);  
-	}
+      if (idata && idata2 && idata != idata2)
+        g_error ("different idatas found for symlinked '%s' and '%s'\n",
+                 path, path2);
 
-      if (!idata->has_pixdata)
-	{
-	  pixbuf = gdk_pixbuf_new_from_file (path, NULL);
-	  
-	  if (pixbuf) 
-	    {
-	      gdk_pixdata_from_pixbuf (&idata->pixdata, pixbuf, FALSE);
-	      idata->size = idata->pixdata.length + 8;
-	      idata->has_pixdata = TRUE;
-	    }
-	}
+      if (idata && !idata2)
+        g_hash_table_insert (image_data_hash, g_strdup (key2), idata);
 
-      image->image_data = idata;
+      if (!idata && idata2)
+        {
+          g_hash_table_insert (image_data_hash, g_strdup (key), idata2);
+          idata = idata2;
+        }
+    }
 
-      g_free (path2);
+  if (!idata)
+    {
+      idata = g_new0 (ImageData, 1);
+      g_hash_table_insert (image_data_hash, g_strdup (key), idata);
+      if (key2)
+        g_hash_table_insert (image_data_hash, g_strdup (key2), idata);
     }
+
+  if (idata->path == NULL)
+    {
+      idata->path = g_strdup (path);
+      idata->render_size = render_size;
+      g_ptr_array_add (pending_image_data, idata);
+    }
+
+  image->image_data = idata;
+
+  g_free (key);
+  g_free (key2);
+  g_free (path2);
 }
 
 static void
@@ -562,7 +826,14 @@ maybe_cache_icon_data (Image       *image,
       
       if (!idata)
 	{
-	  idata = load_icon_data (path);
+	  idata = g_new0 (IconData, 1);
+	  idata->path = g_strdup (path);
+	  /* -1 means not computed yet, the real value depends
+	   * on string pool state, and will be computed
+	   * later
+	   */
+	  idata->size = -1;
+	  g_ptr_array_add (pending_icon_data, idata);
 	  g_hash_table_insert (icon_data_hash, g_strdup (path), idata);
 	  if (path2)
 	    g_hash_table_insert (icon_data_hash, g_strdup (path2), idata);  
@@ -591,6 +862,278 @@ replace_backslashes_with_slashes (gchar *path)
       path[i] = '/';
 }
 
+/* The previous cache, to take the data of files that did not
+ * change from when updating it with --incremental
+ */
+static GMappedFile *old_cache = NULL;
+static const gchar *old_cache_data = NULL;
+static time_t old_cache_mtime;
+/* Directory -> (icon name -> OldImage) */
+static GHashTable *old_cache_dirs = NULL;
+/* Offset in the previous cache -> ImageData or IconData */
+static GHashTable *old_image_data_hash = NULL;
+static GHashTable *old_icon_data_hash = NULL;
+
+typedef struct
+{
+  int flags;
+  guint32 pixel_data_offset;
+  guint32 meta_data_offset;
+} OldImage;
+
+static void
+load_old_cache (const gchar *path)
+{
+  gchar *cache_path, *index_path;
+  GStatBuf cache_stat, index_stat;
+  CacheInfo info;
+  GHashTable **dirs;
+  guint32 hash_offset, dir_list_offset, chain_offset;
+  guint32 n_buckets, n_dirs;
+  guint32 i, j;
+
+  cache_path = g_build_filename (path, CACHE_NAME, NULL);
+  if (g_stat (cache_path, &cache_stat) == 0)
+    old_cache = g_mapped_file_new (cache_path, FALSE, NULL);
+  g_free (cache_path);
+
+  if (old_cache == NULL)
+    return;
+
+  info.cache = g_mapped_file_get_contents (old_cache);
+  info.cache_size = g_mapped_file_get_length (old_cache);
+  info.n_directories = 0;
+  info.flags = CHECK_OFFSETS|CHECK_STRINGS|CHECK_PIXBUFS;
+
+  if (!_gtk_icon_cache_validate (&info))
+    {
+      g_clear_pointer (&old_cache, g_mapped_file_unref);
+      return;
+    }
+
+  /* Svgs are rendered at the directory sizes from the index */
+  index_path = g_build_filename (path, "index.theme", NULL);
+  if (include_surfaces &&
+      g_stat (index_path, &index_stat) == 0 &&
+      MAX (index_stat.st_mtime, index_stat.st_ctime) >= cache_stat.st_mtime)
+    {
+      g_clear_pointer (&old_cache, g_mapped_file_unref);
+      g_free (index_path);
+      return;
+    }
+  g_free (index_path);
+
+  old_cache_data = info.cache;
+  old_cache_mtime = cache_stat.st_mtime;
+  old_cache_dirs = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                          (GDestroyNotify) g_hash_table_destroy);
+  old_image_data_hash = g_hash_table_new (NULL, NULL);
+  old_icon_data_hash = g_hash_table_new (NULL, NULL);
+
+  dir_list_offset = GET_UINT32 (old_cache_data, 8);
+  n_dirs = GET_UINT32 (old_cache_data, dir_list_offset);
+  dirs = g_new (GHashTable *, n_dirs);
+
+  for (i = 0; i < n_dirs; i++)
+    {
+      const gchar *dir;
+
+      dir = old_cache_data + GET_UINT32 (old_cache_data, dir_list_offset + 4 + 4 * i);
+      dirs[i] = g_hash_table_lookup (old_cache_dirs, dir);
+      if (dirs[i] == NULL)
+        {
+          dirs[i] = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+          g_hash_table_insert (old_cache_dirs, (gpointer) dir, dirs[i]);
+        }
+    }
+
+  hash_offset = GET_UINT32 (old_cache_data, 4);
+  n_buckets = GET_UINT32 (old_cache_data, hash_offset);
+
+  for (i = 0; i < n_buckets; i++)
+    {
+      chain_offset = GET_UINT32 (old_cache_data, hash_offset + 4 + 4 * i);
+      while (chain_offset != 0xffffffff)
+        {
+          const gchar *name;
+          guint32 image_list_offset, n_images;
+
+          name = old_cache_data + GET_UINT32 (old_cache_data, chain_offset + 4);
+          image_list_offset = GET_UINT32 (old_cache_data, chain_offset + 8);
+          n_images = GET_UINT32 (old_cache_data, image_list_offset);
+
+          for (j = 0; j < n_images; j++)
+            {
+              guint32 offset = image_list_offset + 4 + 8 * j;
+              guint32 image_data_offset;
+              OldImage *image;
+
+              image = g_new0 (OldImage, 1);
+              image->flags = GET_UINT16 (old_cache_data, offset + 2);
+              image_data_offset = GET_UINT32 (old_cache_data, offset + 4);
+              if (image_data_offset != 0)
+                {
+                  image->pixel_data_offset = GET_UINT32 (old_cache_data, image_data_offset);
+                  image->meta_data_offset = GET_UINT32 (old_cache_data, image_data_offset + 4);
+                }
+
+              g_hash_table_insert (dirs[GET_UINT16 (old_cache_data, offset)],
+                                   (gpointer) name, image);
+            }
+
+          chain_offset = GET_UINT32 (old_cache_data, chain_offset);
+        }
+    }
+
+  g_free (dirs);
+}
+
+static void
+free_old_cache (void)
+{
+  if (old_cache == NULL)
+    return;
+
+  g_clear_pointer (&old_cache_dirs, g_hash_table_destroy);
+  g_clear_pointer (&old_image_data_hash, g_hash_table_destroy);
+  g_clear_pointer (&old_icon_data_hash, g_hash_table_destroy);
+  g_clear_pointer (&old_cache, g_mapped_file_unref);
+  old_cache_data = NULL;
+}
+
+static ImageData *
+get_old_image_data (guint32 offset)
+{
+  ImageData *idata;
+
+  idata = g_hash_table_lookup (old_image_data_hash, GUINT_TO_POINTER (offset));
+  if (idata == NULL)
+    {
+      idata = g_new0 (ImageData, 1);
+      idata->old_type = GET_UINT32 (old_cache_data, offset);
+      idata->old_length = GET_UINT32 (old_cache_data, offset + 4);
+      idata->old_data = old_cache_data + offset + 8;
+      idata->size = idata->old_length + 8;
+      g_hash_table_insert (old_image_data_hash, GUINT_TO_POINTER (offset), idata);
+    }
+
+  return idata;
+}
+
+static IconData *
+get_old_icon_data (guint32 offset)
+{
+  IconData *data;
+  guint32 rect_offset, attach_offset, names_offset;
+  int i;
+
+  data = g_hash_table_lookup (old_icon_data_hash, GUINT_TO_POINTER (offset));
+  if (data)
+    return data;
+
+  data = g_new0 (IconData, 1);
+  data->size = -1;
+
+  rect_offset = GET_UINT32 (old_cache_data, offset);
+  attach_offset = GET_UINT32 (old_cache_data, offset + 4);
+  names_offset = GET_UINT32 (old_cache_data, offset + 8);
+
+  if (rect_offset != 0)
+    {
+      data->has_embedded_rect = TRUE;
+      data->x0 = GET_UINT16 (old_cache_data, rect_offset);
+      data->y0 = GET_UINT16 (old_cache_data, rect_offset + 2);
+      data->x1 = GET_UINT16 (old_cache_data, rect_offset + 4);
+      data->y1 = GET_UINT16 (old_cache_data, rect_offset + 6);
+    }
+
+  if (attach_offset != 0)
+    {
+      data->n_attach_points = GET_UINT32 (old_cache_data, attach_offset);
+      data->attach_points = g_new (int, 2 * data->n_attach_points);
+      for (i = 0; i < 2 * data->n_attach_points; i++)
+        data->attach_points[i] = GET_UINT16 (old_cache_data, attach_offset + 4 + 2 * i);
+    }
+
+  if (names_offset != 0)
+    data->n_display_names = GET_UINT32 (old_cache_data, names_offset);
+  data->display_names = g_new0 (gchar *, 2 * data->n_display_names + 1);
+  for (i = 0; i < 2 * data->n_display_names; i++)
+    data->display_names[i] = g_strdup (old_cache_data + GET_UINT32 (old_cache_data, names_offset + 4 + 4 * i));
+
+  g_hash_table_insert (old_icon_data_hash, GUINT_TO_POINTER (offset), data);
+
+  return data;
+}
+
+/* Whether the pixdata at @offset in the previous cache is too big
+ * to have been stored as a surface with --include-surface-data
+ */
+static gboolean
+old_pixdata_is_too_big (guint32 offset)
+{
+  /* The serialized pixdata has a magic number, length, type and
+   * rowstride before the width and height
+   */
+  return GET_UINT32 (old_cache_data, offset + 24) > MAX_SURFACE_SIZE ||
+         GET_UINT32 (old_cache_data, offset + 28) > MAX_SURFACE_SIZE;
+}
+
+/* Takes the data of @image from the previous cache if none of its
+ * files changed since the cache was written and the data there is
+ * what the current options would produce.
+ *
+ * Times have a resolution of a second, so files changed in the
+ * second the cache was written are treated as changed.
+ */
+static gboolean
+reuse_old_image (Image    *image,
+                 OldImage *old)
+{
+  if (old == NULL ||
+      old->flags != image->flags ||
+      image->mtime >= old_cache_mtime)
+    return FALSE;
+
+  if (old->pixel_data_offset != 0)
+    {
+      guint32 type = GET_UINT32 (old_cache_data, old->pixel_data_offset);
+
+      /* With --include-surface-data, pixdata is only
+       * written for images too big to be surfaces
+       */
+      if (type == 0 &&
+          (index_only ||
+           (include_surfaces && !old_pixdata_is_too_big (old->pixel_data_offset))))
+        return FALSE;
+      if (type != 0 && (!include_surfaces || type != (G_BYTE_ORDER == G_LITTLE_ENDIAN ? 1 : 2)))
+        return FALSE;
+
+      image->image_data = get_old_image_data (old->pixel_data_offset);
+    }
+  else if (!index_only || include_surfaces)
+    {
+      /* The image may not have been loaded with other options */
+      return FALSE;
+    }
+
+  if (old->meta_data_offset != 0)
+    image->icon_data = get_old_icon_data (old->meta_data_offset);
+
+  return TRUE;
+}
+
+static const struct
+{
+  int flag;
+  const gchar *suffix;
+} suffixes[] = {
+  { HAS_SUFFIX_PNG, ".png" },
+  { HAS_SUFFIX_SVG, ".svg" },
+  { HAS_SUFFIX_XPM, ".xpm" },
+  { HAS_ICON_FILE, ".icon" }
+};
+
 static GList *
 scan_directory (const gchar *base_path, 
 		const gchar *subdir, 
@@ -599,11 +1142,16 @@ scan_directory (const gchar *base_path,
 		gint         depth)
 {
   GHashTable *dir_hash;
+  GHashTable *old_images;
+  GHashTableIter iter;
   GDir *dir;
   const gchar *name;
   gchar *dir_path;
+  gchar *basename;
+  Image *image;
   gboolean dir_added = FALSE;
   guint dir_index = 0xffff;
+  gint i;
   
   dir_path = g_build_path ("/", base_path, subdir, NULL);
 
@@ -618,15 +1166,24 @@ scan_directory (const gchar *base_path,
   while ((name = g_dir_read_name (dir)))
     {
       gchar *path;
-      gboolean retval;
+      GStatBuf st;
       int flags = 0;
-      Image *image;
-      gchar *basename, *dot;
+      gchar *dot;
 
       path = g_build_filename (dir_path, name, NULL);
 
-      retval = g_file_test (path, G_FILE_TEST_IS_DIR);
-      if (retval)
+      /* One stat tells directories from files, and gives the
+       * times to compare with the previous cache
+       */
+      if (g_stat (path, &st) < 0)
+        {
+          g_free (path);
+          continue;
+        }
+
+      g_free (path);
+
+      if (S_ISDIR (st.st_mode))
 	{
 	  gchar *subsubdir;
 
@@ -645,58 +1202,89 @@ scan_directory (const gchar *base_path,
       if (subdir == NULL)
         continue;
 
-      retval = g_file_test (path, G_FILE_TEST_IS_REGULAR);
-      if (retval)
-	{
-	  if (g_str_has_suffix (name, ".png"))
-	    flags |= HAS_SUFFIX_PNG;
-	  else if (g_str_has_suffix (name, ".svg"))
-	    flags |= HAS_SUFFIX_SVG;
-	  else if (g_str_has_suffix (name, ".xpm"))
-	    flags |= HAS_SUFFIX_XPM;
-	  else if (g_str_has_suffix (name, ".icon"))
-	    flags |= HAS_ICON_FILE;
-	  
-	  if (flags == 0)
-	    continue;
-	  
-	  basename = g_strdup (name);
-	  dot = strrchr (basename, '.');
-	  *dot = '\0';
-	  
-	  image = g_hash_table_lookup (dir_hash, basename);
-	  if (!image)
-	    {
-	      if (!dir_added) 
-		{
-		  dir_added = TRUE;
-		  if (subdir)
-		    {
-		      dir_index = g_list_length (directories);
-		      directories = g_list_append (directories, g_strdup (subdir));
-		    }
-		  else
-		    dir_index = 0xffff;
-		}
-		
-	      image = g_new0 (Image, 1);
-	      image->dir_index = dir_index;
-	      g_hash_table_insert (dir_hash, g_strdup (basename), image);
-	    }
+      if (!S_ISREG (st.st_mode))
+        continue;
 
-	  image->flags |= flags;
-      
-	  maybe_cache_image_data (image, path);
-          maybe_cache_icon_data (image, path);
-       
-	  g_free (basename);
-	}
+      for (i = 0; i < G_N_ELEMENTS (suffixes); i++)
+        {
+          if (g_str_has_suffix (name, suffixes[i].suffix))
+            {
+              flags = suffixes[i].flag;
+              break;
+            }
+        }
 
-      g_free (path);
+      if (flags == 0)
+        continue;
+
+      basename = g_strdup (name);
+      dot = strrchr (basename, '.');
+      *dot = '\0';
+
+      image = g_hash_table_lookup (dir_hash, basename);
+      if (!image)
+        {
+          if (!dir_added) 
+            {
+              dir_added = TRUE;
+              dir_index = g_list_length (directories);
+              directories = g_list_append (directories, g_strdup (subdir));
+            }
+
+          image = g_new0 (Image, 1);
+          image->dir_index = dir_index;
+          g_hash_table_insert (dir_hash, g_strdup (basename), image);
+        }
+
+      image->flags |= flags;
+      /* Package managers keep the modification times of the
+       * files they install, but not their status change times
+       */
+      image->mtime = MAX (image->mtime, MAX (st.st_mtime, st.st_ctime));
+
+      g_free (basename);
     }
 
   g_dir_close (dir);
 
+  /* Now that all files of the images are known, take their data from
+   * the previous cache, or queue their files for loading
+   */
+  old_images = NULL;
+  if (old_cache_dirs && subdir)
+    old_images = g_hash_table_lookup (old_cache_dirs, subdir);
+
+  g_hash_table_iter_init (&iter, dir_hash);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &basename, (gpointer *) &image))
+    {
+      /* Just a .icon file, thrown away below */
+      if (image->flags == HAS_ICON_FILE)
+        continue;
+
+      if (old_images &&
+          reuse_old_image (image, g_hash_table_lookup (old_images, basename)))
+        continue;
+
+      for (i = 0; i < G_N_ELEMENTS (suffixes); i++)
+        {
+          gchar *filename, *path;
+
+          if ((image->flags & suffixes[i].flag) == 0)
+            continue;
+
+          filename = g_strconcat (basename, suffixes[i].suffix, NULL);
+          path = g_build_filename (dir_path, filename, NULL);
+
+          maybe_cache_image_data (image, path, subdir);
+          maybe_cache_icon_data (image, path);
+
+          g_free (filename);
+          g_free (path);
+        }
+    }
+
+  g_free (dir_path);
+
   /* Move dir into the big file hash */
   g_hash_table_foreach_remove (dir_hash, foreach_remove_func, files);
   
@@ -705,6 +1293,34 @@ scan_directory (const gchar *base_path,
   return directories;
 }
 
+/* Runs @func on all the items of @jobs, in as many threads as
+ * there are processors
+ */
+static void
+run_jobs (GPtrArray *jobs,
+          GFunc      func)
+{
+  GThreadPool *pool = NULL;
+  gint n_threads;
+  guint i;
+
+  n_threads = MIN (g_get_num_processors (), jobs->len);
+  if (n_threads > 1)
+    pool = g_thread_pool_new (func, NULL, n_threads, FALSE, NULL);
+
+  if (pool == NULL)
+    {
+      for (i = 0; i < jobs->len; i++)
+        func (g_ptr_array_index (jobs, i), NULL);
+      return;
+    }
+
+  for (i = 0; i < jobs->len; i++)
+    g_thread_pool_push (pool, g_ptr_array_index (jobs, i), NULL);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+}
+
 typedef struct _HashNode HashNode;
 
 struct _HashNode
@@ -821,6 +1437,37 @@ write_image_data (FILE *cache, ImageData *image_data, int offset)
   gint i;
   GdkPixdata *pixdata = &image_data->pixdata;
 
+  if (image_data->old_data)
+    {
+      /* Copied from the previous cache, with its type */
+      if (!write_card32 (cache, image_data->old_type) ||
+          !write_card32 (cache, image_data->old_length))
+        return FALSE;
+
+      i = fwrite (image_data->old_data, image_data->old_length, 1, cache);
+
+      return i == 1;
+    }
+
+  if (image_data->surface_data)
+    {
+      len = image_data->stride * image_data->height;
+
+      /* Types 1 and 2 are ARGB32 surfaces in little and
+       * big endian byte order
+       */
+      if (!write_card32 (cache, G_BYTE_ORDER == G_LITTLE_ENDIAN ? 1 : 2) ||
+          !write_card32 (cache, len + 12) ||
+          !write_card32 (cache, image_data->width) ||
+          !write_card32 (cache, image_data->height) ||
+          !write_card32 (cache, image_data->stride))
+        return FALSE;
+
+      i = fwrite (image_data->surface_data, len, 1, cache);
+
+      return i == 1;
+    }
+
   /* Type 0 is GdkPixdata */
   if (!write_card32 (cache, 0))
     return FALSE;
@@ -1039,7 +1686,9 @@ get_image_pixel_data_size (Image *image)
   if (image->pixel_data_size == 0)
     {
       if (image->image_data && 
-	  image->image_data->has_pixdata)
+	  (image->image_data->has_pixdata ||
+	   image->image_data->surface_data ||
+	   image->image_data->old_data))
 	{
 	  image->pixel_data_size = image->image_data->size;
 	  image->image_data->size = 0;
@@ -1513,7 +2162,24 @@ opentmp:
   image_data_hash = g_hash_table_new (g_str_hash, g_str_equal);
   icon_data_hash = g_hash_table_new (g_str_hash, g_str_equal);
   string_pool = g_hash_table_new (g_str_hash, g_str_equal);
+  pending_image_data = g_ptr_array_new ();
+  pending_icon_data = g_ptr_array_new ();
+
+  if (include_surfaces)
+    {
+      gchar *index_path;
+
+      /* The directory sizes tell at which size to render svgs */
+      index_path = g_build_filename (path, "index.theme", NULL);
+      theme_index = g_key_file_new ();
+      if (!g_key_file_load_from_file (theme_index, index_path, G_KEY_FILE_NONE, NULL))
+        g_clear_pointer (&theme_index, g_key_file_free);
+      g_free (index_path);
+    }
  
+  if (incremental)
+    load_old_cache (path);
+
   directories = scan_directory (path, NULL, files, NULL, 0);
 
   if (g_hash_table_size (files) == 0)
@@ -1525,6 +2191,12 @@ opentmp:
       g_unlink (cache_path);
       exit (0);
     }
+
+  /* Have gdk-pixbuf set up its loaders before using them in threads */
+  g_slist_free (gdk_pixbuf_get_formats ());
+
+  run_jobs (pending_icon_data, load_icon_data);
+  run_jobs (pending_image_data, load_image_data);
     
   /* FIXME: Handle failure */
   if (!write_file (cache, files, directories))
@@ -1533,6 +2205,8 @@ opentmp:
       exit (1);
     }
 
+  free_old_cache ();
+
   if (!safe_fclose (cache))
     {
       g_printerr (_("Failed to write cache file: %s\n"), g_strerror (errno));
@@ -1653,6 +2327,8 @@ static GOptionEntry args[] = {
   { "ignore-theme-index", 't', 0, G_OPTION_ARG_NONE, &ignore_theme_index, N_("Don't check for the existence of index.theme"), NULL },
   { "index-only", 'i', 0, G_OPTION_ARG_NONE, &index_only, N_("Don't include image data in the cache"), NULL },
   { "include-image-data", 0, G_OPTION_FLAG_REVERSE, G_OPTION_ARG_NONE, &index_only, N_("Include image data in the cache"), NULL },
+  { "include-surface-data", 0, 0, G_OPTION_ARG_NONE, &include_surfaces, N_("Include ready to draw image data in the cache"), NULL },
+  { "incremental", 0, 0, G_OPTION_ARG_NONE, &incremental, N_("Reuse the data of unchanged files from the existing cache"), NULL },
   { "source", 'c', 0, G_OPTION_ARG_STRING, &var_name, N_("Output a C header file"), "NAME" },
   { "quiet", 'q', 0, G_OPTION_ARG_NONE, &quiet, N_("Turn off verbose output"), NULL },
   { "validate", 'v', 0, G_OPTION_ARG_NONE, &validate, N_("Validate existing icon cache"), NULL },
@@ -17,6 +17,7 @@
  */
 
 #include <gtk/gtk.h>
+#include <glib/gstdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <locale.h>
@@ -31,6 +32,12 @@ usage (void)
 	   "usage: test-icon-theme display <theme name> <icon name> [size] [scale]\n"
 	   " or\n"
 	   "usage: test-icon-theme contexts <theme name>\n"
+	   " or\n"
+	   "usage: test-icon-theme startup <theme name> <icon name> [size]\n"
+	   " or\n"
+	   "usage: test-icon-theme map <theme name> [size] [count] [preload]\n"
+	   " or\n"
+	   "usage: test-icon-theme update-cache <directory> [count] [gtk-update-icon-cache]\n"
 	   );
 }
 
@@ -56,6 +63,124 @@ icon_loaded_cb (GObject *source_object,
   g_object_unref (pixbuf);
 }
 
+static gint64 map_start;
+
+static gboolean
+first_frame_cb (GtkWidget *window,
+                cairo_t   *cr,
+                gpointer   user_data)
+{
+  g_print ("first frame after %.3f ms\n", (g_get_monotonic_time () - map_start) / 1000.0);
+  g_signal_handlers_disconnect_by_func (window, first_frame_cb, user_data);
+
+  return FALSE;
+}
+
+static void
+preloaded_cb (GObject      *source_object,
+              GAsyncResult *res,
+              gpointer      user_data)
+{
+  gtk_icon_theme_preload_icons_finish (GTK_ICON_THEME (source_object), res, NULL);
+  g_print ("icons loaded after %.3f ms\n", (g_get_monotonic_time () - map_start) / 1000.0);
+}
+
+static const gint synthetic_sizes[] = { 16, 22, 24, 32, 48, 64, 96, 128 };
+
+static void
+add_synthetic_icon (const gchar *dir,
+                    gint         n)
+{
+  GdkPixbuf *pixbuf;
+  gchar *path;
+  gint size;
+
+  size = synthetic_sizes[n % G_N_ELEMENTS (synthetic_sizes)];
+  path = g_strdup_printf ("%s/%dx%d/apps/synthetic-%d.png", dir, size, size, n);
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, size, size);
+  gdk_pixbuf_fill (pixbuf, 0x3465a4ff);
+  gdk_pixbuf_save (pixbuf, path, "png", NULL, NULL);
+  g_object_unref (pixbuf);
+  g_free (path);
+}
+
+/* Creates a theme with @count icons spread over directories
+ * of different sizes
+ */
+static void
+create_synthetic_theme (const gchar *dir,
+                        gint         count)
+{
+  GString *index;
+  gchar *path;
+  gint i, j;
+
+  index = g_string_new ("[Icon Theme]\nName=Synthetic\nDirectories=");
+  for (i = 0; i < G_N_ELEMENTS (synthetic_sizes); i++)
+    g_string_append_printf (index, "%s%dx%d/apps", i > 0 ? "," : "",
+                            synthetic_sizes[i], synthetic_sizes[i]);
+  g_string_append (index, "\n");
+
+  for (i = 0; i < G_N_ELEMENTS (synthetic_sizes); i++)
+    {
+      GdkPixbuf *pixbuf;
+      gchar *subdir, *data;
+      gsize length;
+      gint size;
+
+      size = synthetic_sizes[i];
+      g_string_append_printf (index, "\n[%dx%d/apps]\nSize=%d\nType=Fixed\n", size, size, size);
+
+      subdir = g_strdup_printf ("%s/%dx%d/apps", dir, size, size);
+      g_mkdir_with_parents (subdir, 0755);
+
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, size, size);
+      gdk_pixbuf_fill (pixbuf, 0x3465a4ff);
+      gdk_pixbuf_save_to_buffer (pixbuf, &data, &length, "png", NULL, NULL);
+      g_object_unref (pixbuf);
+
+      for (j = i; j < count; j += G_N_ELEMENTS (synthetic_sizes))
+        {
+          path = g_strdup_printf ("%s/synthetic-%d.png", subdir, j);
+          g_file_set_contents (path, data, length, NULL);
+          g_free (path);
+        }
+
+      g_free (data);
+      g_free (subdir);
+    }
+
+  path = g_build_filename (dir, "index.theme", NULL);
+  g_file_set_contents (path, index->str, index->len, NULL);
+  g_string_free (index, TRUE);
+  g_free (path);
+}
+
+static void
+time_update_icon_cache (const gchar *program,
+                        const gchar *options,
+                        const gchar *dir)
+{
+  GError *error = NULL;
+  gchar *quoted, *command;
+  gint64 start;
+  gint status;
+
+  quoted = g_shell_quote (dir);
+  command = g_strdup_printf ("%s --quiet %s %s", program, options, quoted);
+
+  start = g_get_monotonic_time ();
+  if (!g_spawn_command_line_sync (command, NULL, NULL, &status, &error))
+    {
+      g_print ("%s\n", error->message);
+      exit (1);
+    }
+
+  g_print ("%-40s %10.3f ms\n", options, (g_get_monotonic_time () - start) / 1000.0);
+
+  g_free (command);
+  g_free (quoted);
+}
 
 int
 main (int argc, char *argv[])
@@ -166,6 +291,126 @@ main (int argc, char *argv[])
 
       gtk_main ();
     }
+  else if (strcmp (argv[1], "startup") == 0)
+    {
+      GtkIconTheme *default_theme;
+      gint64 start;
+
+      if (argc < 4)
+	{
+	  g_object_unref (icon_theme);
+	  usage ();
+	  return 1;
+	}
+
+      if (argc >= 5)
+	size = atoi (argv[4]);
+
+      /* Times loading the default icon theme, which can come
+       * from the snapshot of an earlier run */
+      g_object_set (gtk_settings_get_default (), "gtk-icon-theme-name", themename, NULL);
+
+      start = g_get_monotonic_time ();
+      default_theme = gtk_icon_theme_get_default ();
+      icon_info = gtk_icon_theme_lookup_icon (default_theme, argv[3], size, flags);
+      g_print ("first lookup took %.3f ms\n", (g_get_monotonic_time () - start) / 1000.0);
+
+      if (icon_info)
+        g_object_unref (icon_info);
+    }
+  else if (strcmp (argv[1], "map") == 0)
+    {
+      GtkIconTheme *default_theme;
+      GtkWidget *window, *flowbox;
+      GPtrArray *names;
+      int count = 200;
+      int i;
+
+      if (argc >= 4)
+	size = atoi (argv[3]);
+
+      if (argc >= 5)
+	count = atoi (argv[4]);
+
+      /* Times mapping a window full of icons with a cold icon
+       * cache, either loading the icons while drawing or preloading
+       * them in threads before the window is shown */
+      g_object_set (gtk_settings_get_default (), "gtk-icon-theme-name", themename, NULL);
+      default_theme = gtk_icon_theme_get_default ();
+
+      names = g_ptr_array_new_with_free_func (g_free);
+      list = gtk_icon_theme_list_icons (default_theme, NULL);
+      for (; list && names->len < count; list = g_list_delete_link (list, list))
+        g_ptr_array_add (names, list->data);
+      g_list_free_full (list, g_free);
+      g_ptr_array_add (names, NULL);
+
+      window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+      flowbox = gtk_flow_box_new ();
+      gtk_container_add (GTK_CONTAINER (window), flowbox);
+
+      map_start = g_get_monotonic_time ();
+
+      if (argc >= 6 && strcmp (argv[5], "preload") == 0)
+        gtk_icon_theme_preload_icons_async (default_theme,
+                                            (const gchar * const *) names->pdata,
+                                            size, 1,
+                                            flags | GTK_ICON_LOOKUP_FORCE_SIZE,
+                                            NULL, preloaded_cb, NULL);
+
+      for (i = 0; i + 1 < names->len; i++)
+        {
+          GtkWidget *image;
+
+          image = gtk_image_new_from_icon_name (g_ptr_array_index (names, i), GTK_ICON_SIZE_BUTTON);
+          gtk_image_set_pixel_size (GTK_IMAGE (image), size);
+          gtk_container_add (GTK_CONTAINER (flowbox), image);
+        }
+
+      g_signal_connect_after (window, "draw",
+                              G_CALLBACK (first_frame_cb), NULL);
+      g_signal_connect (window, "delete-event",
+                        G_CALLBACK (gtk_main_quit), window);
+      gtk_widget_show_all (window);
+
+      gtk_main ();
+
+      g_ptr_array_unref (names);
+    }
+  else if (strcmp (argv[1], "update-cache") == 0)
+    {
+      const gchar *program = "gtk-update-icon-cache";
+      const gchar *options[] = { "", "--include-image-data", "--include-surface-data" };
+      int count = 50000;
+      int i;
+
+      if (argc >= 4)
+        count = atoi (argv[3]);
+
+      if (argc >= 5)
+        program = argv[4];
+
+      /* Times building the cache of a large theme from scratch, and
+       * updating it incrementally after an icon was added */
+      create_synthetic_theme (argv[2], count);
+
+      for (i = 0; i < G_N_ELEMENTS (options); i++)
+        {
+          gchar *opts;
+
+          opts = g_strconcat ("--force ", options[i], NULL);
+          time_update_icon_cache (program, opts, argv[2]);
+          g_free (opts);
+
+          /* Cache times have a resolution of a second */
+          g_usleep (G_USEC_PER_SEC);
+          add_synthetic_icon (argv[2], count++);
+
+          opts = g_strconcat ("--incremental ", options[i], NULL);
+          time_update_icon_cache (program, opts, argv[2]);
+          g_free (opts);
+        }
+    }
   else if (strcmp (argv[1], "list") == 0)
     {
       if (argc >= 4)
@@ -6782,6 +6782,63 @@ specific_bug_679910 (void)
   g_object_unref (store);
 }
 
+static gboolean
+refilter_async_visible_func (GtkTreeModel *model,
+                             GtkTreeIter  *iter,
+                             gpointer      data)
+{
+  gint *threshold = data;
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value >= *threshold;
+}
+
+static void
+refilter_async (void)
+{
+  GtkTreeModel *filter;
+  GtkListStore *store;
+  gint threshold = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 10000; i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, i, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          refilter_async_visible_func,
+                                          &threshold, NULL);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 10000);
+
+  /* Nothing changes until the main loop runs */
+  threshold = 5000;
+  gtk_tree_model_filter_refilter_async (GTK_TREE_MODEL_FILTER (filter), TRUE);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 10000);
+
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 5000);
+
+  /* Widening needs a full refilter */
+  threshold = 2500;
+  gtk_tree_model_filter_refilter_async (GTK_TREE_MODEL_FILTER (filter), FALSE);
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 7500);
+
+  /* A pending refilter goes away with the filter */
+  threshold = 0;
+  gtk_tree_model_filter_refilter_async (GTK_TREE_MODEL_FILTER (filter), FALSE);
+  g_object_unref (filter);
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -7143,4 +7200,7 @@ register_filter_model_tests (void)
                    specific_bug_659022_row_deleted_free_level);
   g_test_add_func ("/TreeModelFilter/specific/bug-679910",
                    specific_bug_679910);
+
+  g_test_add_func ("/TreeModelFilter/refilter-async",
+                   refilter_async);
 }
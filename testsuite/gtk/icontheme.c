@@ -1,6 +1,7 @@
 #include <gtk/gtk.h>
 
 #include <string.h>
+#include <glib/gstdio.h>
 
 #define SCALABLE_IMAGE_SIZE (128)
 
@@ -467,6 +468,112 @@ test_symbolic_single_size (void)
                       "/icons/32x32/only32-symbolic.svg");
 }
 
+static void
+assert_pixel (GdkPixbuf *pixbuf,
+              gint       x,
+              gint       y,
+              guint      red,
+              guint      green,
+              guint      blue,
+              guint      alpha)
+{
+  guchar *pixel;
+
+  g_assert (gdk_pixbuf_get_has_alpha (pixbuf));
+
+  pixel = gdk_pixbuf_get_pixels (pixbuf)
+          + y * gdk_pixbuf_get_rowstride (pixbuf)
+          + x * gdk_pixbuf_get_n_channels (pixbuf);
+
+  g_assert_cmpuint (pixel[3], ==, alpha);
+  if (alpha > 0)
+    {
+      g_assert_cmpuint (pixel[0], ==, red);
+      g_assert_cmpuint (pixel[1], ==, green);
+      g_assert_cmpuint (pixel[2], ==, blue);
+    }
+}
+
+static void
+test_symbolic_recolor (void)
+{
+  GtkIconTheme *theme;
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+  GdkRGBA fg;
+
+  theme = get_test_icontheme (FALSE);
+  info = gtk_icon_theme_lookup_icon (theme, "everything-symbolic", SCALABLE_IMAGE_SIZE, 0);
+  g_assert (info != NULL);
+
+  /* The same icon recolored a few times, reusing its mask */
+  gdk_rgba_parse (&fg, "red");
+  pixbuf = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (pixbuf != NULL);
+  assert_pixel (pixbuf, 10, 10, 255, 0, 0, 255);
+  assert_pixel (pixbuf, 10, 100, 0, 0, 0, 0);
+  assert_pixel (pixbuf, 100, 100, 255, 0, 0, 255);
+  g_object_unref (pixbuf);
+
+  gdk_rgba_parse (&fg, "rgba(0,0,255,0.5)");
+  pixbuf = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (pixbuf != NULL);
+  assert_pixel (pixbuf, 10, 10, 0, 0, 255, 128);
+  assert_pixel (pixbuf, 10, 100, 0, 0, 0, 0);
+  g_object_unref (pixbuf);
+
+  g_object_unref (info);
+
+  /* Another info for the same icon gets the same result */
+  info = gtk_icon_theme_lookup_icon (theme, "everything-symbolic", SCALABLE_IMAGE_SIZE,
+                                     GTK_ICON_LOOKUP_FORCE_SIZE);
+  g_assert (info != NULL);
+
+  gdk_rgba_parse (&fg, "lime");
+  pixbuf = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (pixbuf != NULL);
+  assert_pixel (pixbuf, 100, 100, 0, 255, 0, 255);
+  g_object_unref (pixbuf);
+
+  g_object_unref (info);
+}
+
+static void
+test_symbolic_colored_shapes (void)
+{
+  GtkIconTheme *theme;
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+  GdkRGBA fg;
+
+  theme = get_test_icontheme (FALSE);
+  gdk_rgba_parse (&fg, "red");
+
+  /* A colored circle is drawn in the foreground color like the
+   * rect, its color is not mistaken for the warning color
+   */
+  info = gtk_icon_theme_lookup_icon (theme, "colored-circle-symbolic", SCALABLE_IMAGE_SIZE, 0);
+  g_assert (info != NULL);
+  pixbuf = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (pixbuf != NULL);
+  assert_pixel (pixbuf, 10, 10, 255, 0, 0, 255);
+  assert_pixel (pixbuf, 96, 96, 255, 0, 0, 255);
+  assert_pixel (pixbuf, 10, 100, 0, 0, 0, 0);
+  g_object_unref (pixbuf);
+  g_object_unref (info);
+
+  /* Strokes keep their own color */
+  info = gtk_icon_theme_lookup_icon (theme, "stroke-symbolic", SCALABLE_IMAGE_SIZE, 0);
+  g_assert (info != NULL);
+  pixbuf = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (pixbuf != NULL);
+  assert_pixel (pixbuf, 10, 10, 255, 0, 0, 255);
+  assert_pixel (pixbuf, 96, 100, 0, 0, 255, 255);
+  assert_pixel (pixbuf, 96, 32, 0, 0, 0, 0);
+  g_object_unref (pixbuf);
+  g_object_unref (info);
+}
+
 static void
 test_svg_size (void)
 {
@@ -669,6 +776,89 @@ test_async (void)
   g_assert (loaded == 2);
 }
 
+static void
+preloaded (GObject      *source,
+           GAsyncResult *res,
+           gpointer      data)
+{
+  GError *error = NULL;
+  gboolean *done = data;
+
+  g_assert (gtk_icon_theme_preload_icons_finish (GTK_ICON_THEME (source), res, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static void
+test_preload (void)
+{
+  const gchar *names[] = { "twosize-fixed", "only32-symbolic", "everything", "does-not-exist", NULL };
+  GtkIconTheme *theme;
+  GtkIconInfo *info1, *info2;
+  gboolean done = FALSE;
+  GdkPixbuf *pixbuf;
+
+  theme = get_test_icontheme (TRUE);
+  gtk_icon_theme_preload_icons_async (theme, names, 32, 1, 0, NULL, preloaded, &done);
+
+  /* Loads of an icon that is being preloaded share the running load */
+  info1 = gtk_icon_theme_lookup_icon (theme, "twosize-fixed", 32, 0);
+  g_assert (info1);
+  loaded = 0;
+  gtk_icon_info_load_icon_async (info1, NULL, load_icon, NULL);
+
+  while (!done || loaded == 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* The preloaded icons are now in the cache */
+  info2 = gtk_icon_theme_lookup_icon (theme, "everything", 32, 0);
+  g_assert (info2);
+  pixbuf = gtk_icon_info_load_icon (info2, NULL);
+  g_assert (pixbuf != NULL);
+  g_object_unref (pixbuf);
+
+  g_object_unref (info1);
+  g_object_unref (info2);
+}
+
+static void
+test_lookup_cache (void)
+{
+  GtkIconTheme *theme;
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+  gchar *filename;
+
+  theme = get_test_icontheme (TRUE);
+
+  /* Results of earlier lookups are reused once their info is gone */
+  info = gtk_icon_theme_lookup_icon (theme, "twosize-fixed", 16, 0);
+  g_assert (info);
+  filename = g_strdup (gtk_icon_info_get_filename (info));
+  g_object_unref (info);
+
+  info = gtk_icon_theme_lookup_icon (theme, "twosize-fixed", 16, 0);
+  g_assert (info);
+  g_assert_cmpstr (gtk_icon_info_get_filename (info), ==, filename);
+  g_object_unref (info);
+  g_free (filename);
+
+  /* Failed lookups are cached too, until a builtin icon is added */
+  info = gtk_icon_theme_lookup_icon (theme, "lookup-cache-builtin", 16, GTK_ICON_LOOKUP_USE_BUILTIN);
+  g_assert (info == NULL);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 16, 16);
+  G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+  gtk_icon_theme_add_builtin_icon ("lookup-cache-builtin", 16, pixbuf);
+  G_GNUC_END_IGNORE_DEPRECATIONS;
+  g_object_unref (pixbuf);
+
+  info = gtk_icon_theme_lookup_icon (theme, "lookup-cache-builtin", 16, GTK_ICON_LOOKUP_USE_BUILTIN);
+  g_assert (info != NULL);
+  g_object_unref (info);
+}
+
 static void
 test_inherit (void)
 {
@@ -698,6 +888,221 @@ test_inherit (void)
                       "/icons2/scalable/one-two-symbolic-rtl.svg");
 }
 
+#define SURFACE_TEST_RED   0xffff0000
+#define SURFACE_TEST_GREEN 0xff00ff00
+
+static gchar *
+create_surface_test_theme (void)
+{
+  const gchar *argv[5];
+  gchar *dir, *path;
+  GdkPixbuf *pixbuf;
+  gint status;
+  GError *error = NULL;
+
+  dir = g_dir_make_tmp ("icontheme-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  path = g_build_filename (dir, "surfacetest", "16x16", "apps", NULL);
+  g_assert_cmpint (g_mkdir_with_parents (path, 0755), ==, 0);
+  g_free (path);
+
+  path = g_build_filename (dir, "surfacetest", "index.theme", NULL);
+  g_file_set_contents (path,
+                       "[Icon Theme]\n"
+                       "Name=surfacetest\n"
+                       "Directories=16x16/apps\n"
+                       "\n"
+                       "[16x16/apps]\n"
+                       "Size=16\n"
+                       "Type=Fixed\n",
+                       -1, &error);
+  g_assert_no_error (error);
+  g_free (path);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 16, 16);
+  gdk_pixbuf_fill (pixbuf, 0xff0000ff);
+  path = g_build_filename (dir, "surfacetest", "16x16", "apps", "surface-test.png", NULL);
+  gdk_pixbuf_save (pixbuf, path, "png", &error, NULL);
+  g_assert_no_error (error);
+  g_object_unref (pixbuf);
+  g_free (path);
+
+  argv[0] = GTK_UPDATE_ICON_CACHE;
+  argv[1] = "--include-surface-data";
+  argv[2] = "--quiet";
+  argv[3] = g_build_filename (dir, "surfacetest", NULL);
+  argv[4] = NULL;
+  g_spawn_sync (NULL, (gchar **) argv, NULL, 0, NULL, NULL, NULL, NULL, &status, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (status, ==, 0);
+  g_free ((gchar *) argv[3]);
+
+  return dir;
+}
+
+static void
+remove_surface_test_theme (const gchar *dir)
+{
+  const gchar *files[] = {
+    "surfacetest/16x16/apps/surface-test.png",
+    "surfacetest/16x16/apps",
+    "surfacetest/16x16",
+    "surfacetest/index.theme",
+    "surfacetest/icon-theme.cache",
+    "surfacetest",
+  };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (files); i++)
+    {
+      gchar *path = g_build_filename (dir, files[i], NULL);
+      g_remove (path);
+      g_free (path);
+    }
+  g_rmdir (dir);
+}
+
+/* Changes the surface data header and first pixel of the 16x16 icon
+ * in the cache. Passing 0 keeps the current value.
+ */
+static void
+patch_surface_test_cache (const gchar *dir,
+                          guint32      type,
+                          guint32      height,
+                          guint32      pixel)
+{
+  guchar header[20] = {
+    0, 0, 0, G_BYTE_ORDER == G_LITTLE_ENDIAN ? 1 : 2,
+    0, 0, 4, 12,
+    0, 0, 0, 16,
+    0, 0, 0, 16,
+    0, 0, 0, 64
+  };
+  gchar *path, *contents;
+  gsize length, i;
+  GError *error = NULL;
+
+  path = g_build_filename (dir, "surfacetest", "icon-theme.cache", NULL);
+  g_file_get_contents (path, &contents, &length, &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i + sizeof (header) + 4 <= length; i++)
+    {
+      if (memcmp (contents + i, header, sizeof (header)) == 0)
+        break;
+    }
+  g_assert_cmpuint (i + sizeof (header) + 4, <=, length);
+
+  if (type)
+    *(guint32 *) (contents + i) = GUINT32_TO_BE (type);
+  if (height)
+    *(guint32 *) (contents + i + 12) = GUINT32_TO_BE (height);
+  if (pixel)
+    memcpy (contents + i + 20, &pixel, 4);
+
+  /* Rewriting the cache leaves it newer than the theme directory */
+  g_file_set_contents (path, contents, length, &error);
+  g_assert_no_error (error);
+
+  g_free (contents);
+  g_free (path);
+}
+
+static guint32
+load_surface_test_pixel (const gchar *dir)
+{
+  GtkIconTheme *theme;
+  cairo_surface_t *surface;
+  guint32 pixel;
+
+  theme = gtk_icon_theme_new ();
+  gtk_icon_theme_set_search_path (theme, &dir, 1);
+  gtk_icon_theme_set_custom_theme (theme, "surfacetest");
+
+  surface = gtk_icon_theme_load_surface (theme, "surface-test", 16, 1, NULL, 0, NULL);
+  g_assert (surface != NULL);
+  g_assert_cmpint (cairo_image_surface_get_width (surface), ==, 16);
+  g_assert_cmpint (cairo_image_surface_get_height (surface), ==, 16);
+
+  cairo_surface_flush (surface);
+  pixel = *(guint32 *) cairo_image_surface_get_data (surface);
+
+  cairo_surface_destroy (surface);
+  g_object_unref (theme);
+
+  return pixel;
+}
+
+static void
+test_surface_data (void)
+{
+  GtkIconTheme *theme;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gchar *dir;
+
+  if (!g_file_test (GTK_UPDATE_ICON_CACHE, G_FILE_TEST_IS_EXECUTABLE))
+    {
+      g_test_skip ("gtk-update-icon-cache not built");
+      return;
+    }
+
+  dir = create_surface_test_theme ();
+  g_assert_cmphex (load_surface_test_pixel (dir), ==, SURFACE_TEST_RED);
+
+  /* The pixels come from the cache */
+  patch_surface_test_cache (dir, 0, 0, SURFACE_TEST_GREEN);
+  g_assert_cmphex (load_surface_test_pixel (dir), ==, SURFACE_TEST_GREEN);
+
+  /* Surfaces from the cache can be drawn on without writing
+   * through to the cache file
+   */
+  theme = gtk_icon_theme_new ();
+  gtk_icon_theme_set_search_path (theme, (const gchar **) &dir, 1);
+  gtk_icon_theme_set_custom_theme (theme, "surfacetest");
+  surface = gtk_icon_theme_load_surface (theme, "surface-test", 16, 1, NULL, 0, NULL);
+  g_assert (surface != NULL);
+  cr = cairo_create (surface);
+  cairo_set_source_rgb (cr, 0, 0, 1);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+  g_assert_cmphex (load_surface_test_pixel (dir), ==, SURFACE_TEST_GREEN);
+  cairo_surface_destroy (surface);
+  g_object_unref (theme);
+
+  /* Surface data in the other byte order is not used, the
+   * icon is loaded from its file instead
+   */
+  patch_surface_test_cache (dir, G_BYTE_ORDER == G_LITTLE_ENDIAN ? 2 : 1, 0, 0);
+  g_assert_cmphex (load_surface_test_pixel (dir), ==, SURFACE_TEST_RED);
+
+  remove_surface_test_theme (dir);
+  g_free (dir);
+}
+
+static void
+test_surface_data_corrupt (void)
+{
+  gchar *dir;
+
+  if (!g_file_test (GTK_UPDATE_ICON_CACHE, G_FILE_TEST_IS_EXECUTABLE))
+    {
+      g_test_skip ("gtk-update-icon-cache not built");
+      return;
+    }
+
+  /* A height that reaches past the end of the cache makes
+   * the icon load from its file
+   */
+  dir = create_surface_test_theme ();
+  patch_surface_test_cache (dir, 0, 0x10000000, SURFACE_TEST_GREEN);
+  g_assert_cmphex (load_surface_test_pixel (dir), ==, SURFACE_TEST_RED);
+
+  remove_surface_test_theme (dir);
+  g_free (dir);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -710,12 +1115,18 @@ main (int argc, char *argv[])
   g_test_add_func ("/icontheme/force-regular", test_force_regular);
   g_test_add_func ("/icontheme/rtl", test_rtl);
   g_test_add_func ("/icontheme/symbolic-single-size", test_symbolic_single_size);
+  g_test_add_func ("/icontheme/symbolic-recolor", test_symbolic_recolor);
+  g_test_add_func ("/icontheme/symbolic-colored-shapes", test_symbolic_colored_shapes);
   g_test_add_func ("/icontheme/svg-size", test_svg_size);
   g_test_add_func ("/icontheme/size", test_size);
   g_test_add_func ("/icontheme/builtin", test_builtin);
   g_test_add_func ("/icontheme/list", test_list);
   g_test_add_func ("/icontheme/async", test_async);
+  g_test_add_func ("/icontheme/preload", test_preload);
+  g_test_add_func ("/icontheme/lookup-cache", test_lookup_cache);
   g_test_add_func ("/icontheme/inherit", test_inherit);
+  g_test_add_func ("/icontheme/surface-data", test_surface_data);
+  g_test_add_func ("/icontheme/surface-data-corrupt", test_surface_data_corrupt);
 
   return g_test_run();
 }
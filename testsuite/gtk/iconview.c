@@ -0,0 +1,129 @@
+/* Basic GtkIconView unit tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+static void
+allocate (GtkWidget *view,
+          gint       width)
+{
+  GtkAllocation allocation;
+  gint minimum, natural;
+
+  gtk_widget_get_preferred_width (view, &minimum, &natural);
+  allocation.x = 0;
+  allocation.y = 0;
+  allocation.width = MAX (width, minimum);
+  gtk_widget_get_preferred_height_for_width (view, allocation.width, &minimum, &natural);
+  allocation.height = minimum;
+
+  gtk_widget_size_allocate (view, &allocation);
+}
+
+static void
+check_items (GtkIconView *view,
+             gint         n_items)
+{
+  gint i;
+
+  for (i = 0; i < n_items; i++)
+    {
+      GtkTreePath *path, *found;
+      GdkRectangle rect;
+
+      path = gtk_tree_path_new_from_indices (i, -1);
+      g_assert (gtk_icon_view_get_cell_rect (view, path, NULL, &rect));
+
+      found = gtk_icon_view_get_path_at_pos (view,
+                                             rect.x + rect.width / 2,
+                                             rect.y + rect.height / 2);
+      g_assert (found != NULL);
+      g_assert_cmpint (gtk_tree_path_compare (path, found), ==, 0);
+
+      gtk_tree_path_free (found);
+      gtk_tree_path_free (path);
+    }
+}
+
+static gint
+get_item_y (GtkIconView *view,
+            gint         index)
+{
+  GtkTreePath *path;
+  GdkRectangle rect;
+
+  path = gtk_tree_path_new_from_indices (index, -1);
+  gtk_icon_view_get_cell_rect (view, path, NULL, &rect);
+  gtk_tree_path_free (path);
+
+  return rect.y;
+}
+
+static void
+test_relayout (void)
+{
+  GtkListStore *store;
+  GtkWidget *view;
+  GtkTreeIter iter;
+  gint i, y;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 100; i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, "Item", -1);
+
+  view = gtk_icon_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_ref_sink (view);
+  gtk_icon_view_set_text_column (GTK_ICON_VIEW (view), 0);
+  gtk_icon_view_set_columns (GTK_ICON_VIEW (view), 5);
+
+  allocate (view, 400);
+  check_items (GTK_ICON_VIEW (view), 100);
+
+  /* Changing a single item only makes its row grow and
+   * moves the rows below it */
+  y = get_item_y (GTK_ICON_VIEW (view), 99);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 52);
+  gtk_list_store_set (store, &iter, 0, "Item\nwith\nmany\nlines", -1);
+  allocate (view, 400);
+  check_items (GTK_ICON_VIEW (view), 100);
+  g_assert_cmpint (get_item_y (GTK_ICON_VIEW (view), 99), >, y);
+  g_assert_cmpint (get_item_y (GTK_ICON_VIEW (view), 50), ==, get_item_y (GTK_ICON_VIEW (view), 52));
+
+  /* Inserted and removed items move the following items around */
+  gtk_list_store_insert_with_values (store, NULL, 7, 0, "New", -1);
+  allocate (view, 400);
+  check_items (GTK_ICON_VIEW (view), 101);
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 53);
+  gtk_list_store_remove (store, &iter);
+  allocate (view, 400);
+  check_items (GTK_ICON_VIEW (view), 100);
+  g_assert_cmpint (get_item_y (GTK_ICON_VIEW (view), 99), ==, y);
+
+  g_object_unref (view);
+  g_object_unref (store);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/iconview/relayout", test_relayout);
+
+  return g_test_run ();
+}
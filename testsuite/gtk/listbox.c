@@ -434,6 +434,94 @@ test_header (void)
   g_object_unref (list);
 }
 
+static GtkWidget *
+create_virtual_row (gpointer data)
+{
+  gint *n_created = data;
+
+  (*n_created)++;
+
+  return gtk_label_new ("");
+}
+
+static void
+bind_virtual_row (GtkListBoxRow *row,
+                  guint          index,
+                  gpointer       data)
+{
+  GtkWidget *label;
+  gchar *s;
+
+  label = gtk_bin_get_child (GTK_BIN (row));
+  s = g_strdup_printf ("%u", index);
+  gtk_label_set_label (GTK_LABEL (label), s);
+  g_object_set_data (G_OBJECT (label), "data", GUINT_TO_POINTER (index));
+  g_free (s);
+}
+
+static guint
+get_virtual_row_data (GtkListBox *list,
+                      gint        index)
+{
+  GtkListBoxRow *row;
+  GtkWidget *label;
+
+  row = gtk_list_box_get_row_at_index (list, index);
+  g_assert (row != NULL);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, index);
+
+  label = gtk_bin_get_child (GTK_BIN (row));
+
+  return GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (label), "data"));
+}
+
+static void
+test_virtual_rows (void)
+{
+  GtkListBox *list;
+  GtkAdjustment *adjustment;
+  GList *children;
+  gint n_created = 0;
+  gint n_bound;
+
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  g_object_ref_sink (list);
+
+  adjustment = gtk_adjustment_new (0, 0, 0, 10, 300, 300);
+  gtk_list_box_set_adjustment (list, adjustment);
+
+  gtk_list_box_set_virtual_rows (list, 100000,
+                                 create_virtual_row, bind_virtual_row,
+                                 &n_created, NULL);
+
+  /* Only rows close to the visible area get a widget */
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  n_bound = g_list_length (children);
+  g_list_free (children);
+  g_assert_cmpint (n_bound, >, 0);
+  g_assert_cmpint (n_bound, <, 100);
+  g_assert_cmpint (n_created, ==, n_bound);
+  g_assert_cmpuint (get_virtual_row_data (list, 0), ==, 0);
+
+  /* Scrolling far away reuses the same widgets */
+  gtk_adjustment_configure (adjustment, 320000, 0, 3200000, 10, 300, 300);
+  gtk_list_box_virtual_rows_changed (list, 0, 0, 0);
+  g_assert (gtk_list_box_get_row_at_index (list, 0) == NULL);
+  g_assert_cmpuint (get_virtual_row_data (list, 10000), ==, 10000);
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  g_assert_cmpint (n_created, ==, MAX (n_bound, (gint) g_list_length (children)));
+  g_list_free (children);
+
+  /* Removing the rows unbinds everything */
+  gtk_list_box_virtual_rows_changed (list, 0, 100000, 0);
+  children = gtk_container_get_children (GTK_CONTAINER (list));
+  g_assert (children == NULL);
+
+  gtk_list_box_set_virtual_rows (list, 0, NULL, NULL, NULL, NULL);
+
+  g_object_unref (list);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -444,6 +532,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/listbox/multi-selection", test_multi_selection);
   g_test_add_func ("/listbox/filter", test_filter);
   g_test_add_func ("/listbox/header", test_header);
+  g_test_add_func ("/listbox/virtual-rows", test_virtual_rows);
 
   return g_test_run ();
 }
@@ -455,6 +455,72 @@ list_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+static void
+rows_inserted_cb (GtkTreeModel *model,
+                  GtkTreePath  *path,
+                  GtkTreeIter  *iter,
+                  gint          n_rows,
+                  gpointer      data)
+{
+  gint *counts = data;
+
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 1);
+  counts[1] += n_rows;
+}
+
+static void
+row_inserted_cb (GtkTreeModel *model,
+                 GtkTreePath  *path,
+                 GtkTreeIter  *iter,
+                 gpointer      data)
+{
+  gint *counts = data;
+
+  counts[0]++;
+}
+
+static void
+list_store_test_insert_rows (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gint columns[1] = { 0 };
+  GValue values[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
+  gint counts[2] = { 0, 0 };
+  gint i, value;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 0, -1);
+  gtk_list_store_insert_with_values (store, NULL, 1, 0, 4, -1);
+
+  g_signal_connect (store, "row-inserted", G_CALLBACK (row_inserted_cb), counts);
+  g_signal_connect (store, "rows-inserted", G_CALLBACK (rows_inserted_cb), counts);
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i + 1);
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (store, 1, 3, columns, values, 1);
+
+  /* Every row is still announced on its own */
+  g_assert_cmpint (counts[0], ==, 3);
+  g_assert_cmpint (counts[1], ==, 3);
+
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  for (i = 0; i < 5; i++)
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, i);
+      g_assert (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter) == (i < 4));
+    }
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+  g_object_unref (store);
+}
+
 /* setting values */
 static void
 list_store_set_gvalue_to_transform (void)
@@ -472,6 +538,115 @@ list_store_set_gvalue_to_transform (void)
   gtk_list_store_set_value (store, &iter, 0, &value);
 }
 
+static void
+list_store_set_sparse_columns (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gint i;
+  gchar *str;
+  gdouble d;
+
+  store = gtk_list_store_new (3, G_TYPE_INT, G_TYPE_STRING, G_TYPE_DOUBLE);
+  gtk_list_store_append (store, &iter);
+
+  /* Unset cells read back as defaults */
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &i, 1, &str, 2, &d, -1);
+  g_assert_cmpint (i, ==, 0);
+  g_assert (str == NULL);
+  g_assert_cmpfloat (d, ==, 0.0);
+
+  /* Setting only the last column leaves the others at their defaults */
+  gtk_list_store_set (store, &iter, 2, 1.5, -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &i, 1, &str, 2, &d, -1);
+  g_assert_cmpint (i, ==, 0);
+  g_assert (str == NULL);
+  g_assert_cmpfloat (d, ==, 1.5);
+
+  gtk_list_store_set (store, &iter, 1, "foo", 0, 7, -1);
+  gtk_list_store_set (store, &iter, 1, "bar", -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &i, 1, &str, 2, &d, -1);
+  g_assert_cmpint (i, ==, 7);
+  g_assert_cmpstr (str, ==, "bar");
+  g_assert_cmpfloat (d, ==, 1.5);
+  g_free (str);
+
+  gtk_list_store_remove (store, &iter);
+  g_object_unref (store);
+}
+
+static void
+rows_reordered_count_cb (GtkTreeModel *model,
+                         GtkTreePath  *path,
+                         GtkTreeIter  *iter,
+                         gint         *new_order,
+                         gpointer      data)
+{
+  gint *count = data;
+
+  (*count)++;
+}
+
+static void
+list_store_test_sort_large (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gint i, n_reordered = 0;
+  gint value, prev_value;
+  gchar *str, *prev_str;
+
+  store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+
+  /* Enough rows for the sort to be split across threads */
+  for (i = 0; i < 20000; i++)
+    {
+      gchar *name = g_strdup_printf ("row %d", g_test_rand_int_range (0, 5000));
+
+      gtk_list_store_insert_with_values (store, NULL, -1,
+                                         0, g_test_rand_int_range (-1000, 1000),
+                                         1, i % 7 ? name : NULL,
+                                         -1);
+      g_free (name);
+    }
+
+  g_signal_connect (store, "rows-reordered",
+                    G_CALLBACK (rows_reordered_count_cb), &n_reordered);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 1,
+                                        GTK_SORT_ASCENDING);
+  g_assert_cmpint (n_reordered, ==, 1);
+
+  prev_str = NULL;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 1, &str, -1);
+      if (prev_str)
+        g_assert_cmpint (g_utf8_collate (prev_str, str ? str : ""), <=, 0);
+      g_free (prev_str);
+      prev_str = str ? str : g_strdup ("");
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+  g_free (prev_str);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0,
+                                        GTK_SORT_DESCENDING);
+  g_assert_cmpint (n_reordered, ==, 2);
+
+  prev_value = G_MAXINT;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &value, -1);
+      g_assert_cmpint (value, <=, prev_value);
+      prev_value = value;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+
+  g_object_unref (store);
+}
+
 /* removal */
 static void
 list_store_test_remove_begin (ListStore     *fixture,
@@ -1033,10 +1208,18 @@ register_list_store_tests (void)
 		   list_store_test_insert_before);
   g_test_add_func ("/ListStore/insert-before-NULL",
 		   list_store_test_insert_before_NULL);
+  g_test_add_func ("/ListStore/insert-rows",
+                   list_store_test_insert_rows);
 
   /* setting values (FIXME) */
   g_test_add_func ("/ListStore/set-gvalue-to-transform",
                    list_store_set_gvalue_to_transform);
+  g_test_add_func ("/ListStore/set-sparse-columns",
+                   list_store_set_sparse_columns);
+
+  /* sorting */
+  g_test_add_func ("/ListStore/sort-large",
+                   list_store_test_sort_large);
 
   /* removal */
   g_test_add ("/ListStore/remove-begin", ListStore, NULL,
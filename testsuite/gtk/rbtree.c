@@ -144,6 +144,26 @@ _gtk_rbtree_test_dirty (GtkRBTree *tree,
     _gtk_rbtree_test_dirty (node->children, node->children->root, GTK_RBNODE_FLAG_SET (node->children->root, GTK_RBNODE_DESCENDANTS_INVALID));
 }
 
+static gboolean
+_gtk_rbtree_test_selected (GtkRBTree *tree,
+                           GtkRBNode *node)
+{
+  gboolean selected;
+
+  if (_gtk_rbtree_is_nil (node))
+    return FALSE;
+
+  selected = GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED);
+  selected |= _gtk_rbtree_test_selected (tree, node->left);
+  selected |= _gtk_rbtree_test_selected (tree, node->right);
+  if (node->children)
+    selected |= _gtk_rbtree_test_selected (node->children, node->children->root);
+
+  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_SELECTED) == selected);
+
+  return selected;
+}
+
 static void _gtk_rbtree_test_structure (GtkRBTree *tree);
 
 static guint
@@ -222,6 +242,7 @@ _gtk_rbtree_test (GtkRBTree *tree)
   _gtk_rbtree_test_height (tmp_tree, tmp_tree->root);
   _gtk_rbtree_test_dirty (tmp_tree, tmp_tree->root, GTK_RBNODE_FLAG_SET (tmp_tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
   g_assert (count_total (tmp_tree, tmp_tree->root) == tmp_tree->root->total_count);
+  _gtk_rbtree_test_selected (tmp_tree, tmp_tree->root);
 }
 
 /* gtk_rbtree_print() - unused, for debugging only */
@@ -507,6 +528,65 @@ test_reorder (void)
   _gtk_rbtree_free (tree);
 }
 
+static void
+count_selected (GtkRBTree *tree,
+                GtkRBNode *node,
+                gpointer   data)
+{
+  (*(guint *) data)++;
+}
+
+static void
+test_selection (void)
+{
+  GtkRBTree *tree, *find_tree;
+  GtkRBNode *find_node;
+  guint i, n_changed;
+
+  tree = create_rbtree (3, 16, FALSE);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_SELECTED));
+
+  for (i = 0; i < 50; i++)
+    {
+      if (!_gtk_rbtree_find_index (tree,
+                                   g_test_rand_int_range (0, tree->root->total_count),
+                                   &find_tree, &find_node))
+        g_assert_not_reached ();
+
+      _gtk_rbtree_node_set_selected (find_tree, find_node,
+                                     !GTK_RBNODE_FLAG_SET (find_node, GTK_RBNODE_IS_SELECTED));
+      _gtk_rbtree_test (tree);
+    }
+
+  /* Removing nodes keeps the flags consistent */
+  for (i = 0; i < 50; i++)
+    {
+      if (!_gtk_rbtree_find_index (tree,
+                                   g_test_rand_int_range (0, tree->root->total_count),
+                                   &find_tree, &find_node))
+        g_assert_not_reached ();
+
+      if (find_tree->root->count > 1)
+        _gtk_rbtree_remove_node (find_tree, find_node);
+      else if (find_tree != tree)
+        _gtk_rbtree_remove (find_tree);
+      _gtk_rbtree_test (tree);
+    }
+
+  n_changed = 0;
+  _gtk_rbtree_set_all_selected (tree, TRUE, count_selected, &n_changed);
+  _gtk_rbtree_test (tree);
+  g_assert (GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_SELECTED));
+
+  n_changed = 0;
+  _gtk_rbtree_set_all_selected (tree, FALSE, count_selected, &n_changed);
+  _gtk_rbtree_test (tree);
+  g_assert (n_changed == tree->root->total_count);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_SELECTED));
+
+  _gtk_rbtree_free (tree);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -520,6 +600,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/rbtree/remove_node", test_remove_node);
   g_test_add_func ("/rbtree/remove_root", test_remove_root);
   g_test_add_func ("/rbtree/reorder", test_reorder);
+  g_test_add_func ("/rbtree/selection", test_selection);
 
   return g_test_run ();
 }
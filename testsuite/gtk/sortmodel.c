@@ -16,6 +16,7 @@
  */
 
 #include <gtk/gtk.h>
+#include <string.h>
 
 #include "treemodel.h"
 #include "gtktreemodelrefcount.h"
@@ -1202,6 +1203,150 @@ specific_bug_698846 (void)
   g_assert_cmpuint (count, ==, 2);
 }
 
+static gboolean
+even_visible_func (GtkTreeModel *model,
+                   GtkTreeIter  *iter,
+                   gpointer      data)
+{
+  gint value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value % 2 == 0;
+}
+
+typedef struct
+{
+  GtkTreeView *tree_view;
+  gint row_inserted;
+  gint rows_inserted;
+  gint first_row;
+} RangeCounts;
+
+static void
+range_row_inserted_cb (GtkTreeModel *model,
+                       GtkTreePath  *path,
+                       GtkTreeIter  *iter,
+                       gpointer      data)
+{
+  RangeCounts *counts = data;
+  GtkTreeSelection *selection;
+
+  counts->row_inserted++;
+
+  /* The view has the row as soon as it is announced, even in a batch */
+  selection = gtk_tree_view_get_selection (counts->tree_view);
+  gtk_tree_selection_select_path (selection, path);
+  g_assert (gtk_tree_selection_path_is_selected (selection, path));
+  gtk_tree_selection_unselect_all (selection);
+}
+
+static void
+range_rows_inserted_cb (GtkTreeModel *model,
+                        GtkTreePath  *path,
+                        GtkTreeIter  *iter,
+                        gint          n_rows,
+                        gpointer      data)
+{
+  RangeCounts *counts = data;
+
+  counts->first_row = gtk_tree_path_get_indices (path)[0];
+  counts->rows_inserted += n_rows;
+}
+
+static void
+insert_rows_through_filter (gboolean sorted)
+{
+  GtkListStore *store;
+  GtkTreeModel *filter;
+  GtkTreeModel *sort;
+  GtkWidget *tree_view;
+  GtkTreeIter iter;
+  RangeCounts counts = { NULL, 0, 0, -1 };
+  gint columns[1] = { 0 };
+  GValue values[10];
+  gint i, value;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 100, -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          even_visible_func, NULL, NULL);
+  sort = gtk_tree_model_sort_new_with_model (filter);
+  if (sorted)
+    gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort), 0,
+                                          GTK_SORT_ASCENDING);
+
+  tree_view = gtk_tree_view_new_with_model (sort);
+  g_object_ref_sink (tree_view);
+  counts.tree_view = GTK_TREE_VIEW (tree_view);
+
+  g_signal_connect (sort, "row-inserted",
+                    G_CALLBACK (range_row_inserted_cb), &counts);
+  g_signal_connect (sort, "rows-inserted",
+                    G_CALLBACK (range_rows_inserted_cb), &counts);
+
+  for (i = 0; i < 10; i++)
+    {
+      memset (&values[i], 0, sizeof (GValue));
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i);
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (store, -1, 10, columns, values, 1);
+
+  /* The visible rows stay consecutive unless the sort model sorts */
+  g_assert_cmpint (counts.row_inserted, ==, 5);
+  if (sorted)
+    {
+      g_assert_cmpint (counts.rows_inserted, ==, 0);
+
+      g_assert (gtk_tree_model_get_iter_first (sort, &iter));
+      for (i = 0; i < 5; i++)
+        {
+          gtk_tree_model_get (sort, &iter, 0, &value, -1);
+          g_assert_cmpint (value, ==, 2 * i);
+          g_assert (gtk_tree_model_iter_next (sort, &iter));
+        }
+    }
+  else
+    {
+      g_assert_cmpint (counts.rows_inserted, ==, 5);
+      g_assert_cmpint (counts.first_row, ==, 1);
+
+      g_assert (gtk_tree_model_iter_nth_child (sort, &iter, NULL, 1));
+      for (i = 0; i < 5; i++)
+        {
+          gtk_tree_model_get (sort, &iter, 0, &value, -1);
+          g_assert_cmpint (value, ==, 2 * i);
+          gtk_tree_model_iter_next (sort, &iter);
+        }
+    }
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (sort, NULL), ==, 6);
+
+  for (i = 0; i < 10; i++)
+    g_value_unset (&values[i]);
+
+  g_object_unref (tree_view);
+  g_object_unref (sort);
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
+static void
+rows_inserted_unsorted (void)
+{
+  insert_rows_through_filter (FALSE);
+}
+
+static void
+rows_inserted_sorted (void)
+{
+  insert_rows_through_filter (TRUE);
+}
+
 /* main */
 
 void
@@ -1230,6 +1375,10 @@ register_sort_model_tests (void)
                    rows_reordered_two_levels);
   g_test_add_func ("/TreeModelSort/sorted-insert",
                    sorted_insert);
+  g_test_add_func ("/TreeModelSort/rows-inserted/unsorted",
+                   rows_inserted_unsorted);
+  g_test_add_func ("/TreeModelSort/rows-inserted/sorted",
+                   rows_inserted_sorted);
 
   g_test_add_func ("/TreeModelSort/specific/bug-300089",
                    specific_bug_300089);
@@ -22,6 +22,8 @@
 
 #include <gtk/gtk.h>
 #include "gtk/gtktexttypes.h" /* Private header, for UNKNOWN_CHAR */
+#define GTK_TEXT_USE_INTERNAL_UNSUPPORTED_API
+#include "gtk/gtktextlayout.h" /* Semi-private header, to watch the layout */
 
 static void
 gtk_text_iter_spew (const GtkTextIter *iter, const gchar *desc)
@@ -1434,6 +1436,502 @@ test_clipboard (void)
   g_object_unref (buffer);
 }
 
+static void
+collect_matches (GtkTextBuffer     *buffer,
+                 const GtkTextIter *matches,
+                 guint              n_matches,
+                 gdouble            fraction,
+                 gpointer           user_data)
+{
+  GArray *offsets = user_data;
+  guint i;
+
+  for (i = 0; i < 2 * n_matches; i++)
+    {
+      gint offset = gtk_text_iter_get_offset (&matches[i]);
+      g_array_append_val (offsets, offset);
+    }
+}
+
+static void
+collect_match_iters (GtkTextBuffer     *buffer,
+                     const GtkTextIter *matches,
+                     guint              n_matches,
+                     gdouble            fraction,
+                     gpointer           user_data)
+{
+  GArray *iters = user_data;
+
+  g_array_append_vals (iters, matches, 2 * n_matches);
+}
+
+static void
+check_find_all (GtkTextBuffer      *buffer,
+                const gchar        *str,
+                GtkTextSearchFlags  flags,
+                const GtkTextIter  *start,
+                const GtkTextIter  *end)
+{
+  GtkTextIter iter, limit, match_start, match_end;
+  GArray *offsets;
+  gint n_matches = 0;
+  gint n;
+
+  offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+  n = gtk_text_buffer_find_all (buffer, str, flags, start, end,
+                                collect_matches, offsets, NULL);
+
+  if (start)
+    iter = *start;
+  else
+    gtk_text_buffer_get_start_iter (buffer, &iter);
+  if (end)
+    limit = *end;
+  else
+    gtk_text_buffer_get_end_iter (buffer, &limit);
+
+  while (gtk_text_iter_forward_search (&iter, str, flags,
+                                       &match_start, &match_end, &limit))
+    {
+      g_assert_cmpint (2 * n_matches + 1, <, offsets->len);
+      g_assert_cmpint (g_array_index (offsets, gint, 2 * n_matches), ==,
+                       gtk_text_iter_get_offset (&match_start));
+      g_assert_cmpint (g_array_index (offsets, gint, 2 * n_matches + 1), ==,
+                       gtk_text_iter_get_offset (&match_end));
+      n_matches++;
+      iter = match_end;
+    }
+
+  g_assert_cmpint (n, ==, n_matches);
+  g_assert_cmpint (offsets->len, ==, 2 * n_matches);
+
+  g_array_unref (offsets);
+}
+
+static void
+test_find_all (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *tag;
+  GtkTextIter start, end;
+  GdkPixbuf *pixbuf;
+  GArray *offsets;
+  GError *error = NULL;
+  gint n;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer,
+                            "foo bar foofoo\n"
+                            "Foo FOO fOo\n"
+                            "\n"
+                            "caf\xc3\xa9 CAF\xc3\x89 foo\n"
+                            "ffoo foo", -1);
+
+  /* Split lines in several segments */
+  tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 9);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 12);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 1, 1);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 4, 4);
+  gtk_text_buffer_insert_pixbuf (buffer, &start, pixbuf);
+  g_object_unref (pixbuf);
+
+  check_find_all (buffer, "foo", 0, NULL, NULL);
+  check_find_all (buffer, "o", 0, NULL, NULL);
+  check_find_all (buffer, "foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE, NULL, NULL);
+  check_find_all (buffer, "caf\xc3\xa9", GTK_TEXT_SEARCH_CASE_INSENSITIVE, NULL, NULL);
+  check_find_all (buffer, "\xef\xbf\xbc", 0, NULL, NULL);
+  check_find_all (buffer, "o foo", GTK_TEXT_SEARCH_TEXT_ONLY, NULL, NULL);
+  check_find_all (buffer, "foo\nfoo", GTK_TEXT_SEARCH_CASE_INSENSITIVE, NULL, NULL);
+  check_find_all (buffer, "foo", GTK_TEXT_SEARCH_VISIBLE_ONLY, NULL, NULL);
+  check_find_all (buffer, "missing", 0, NULL, NULL);
+
+  /* Ranges ending in the middle of a line */
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, 2);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, 13);
+  check_find_all (buffer, "foo", 0, &start, &end);
+  check_find_all (buffer, "fo", 0, &start, &end);
+  check_find_all (buffer, "FOO", GTK_TEXT_SEARCH_CASE_INSENSITIVE, &start, &end);
+
+  /* Regular expressions */
+  offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+  n = gtk_text_buffer_find_all (buffer, "f+o+$", GTK_TEXT_SEARCH_REGEX,
+                                NULL, NULL, collect_matches, offsets, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 3);
+  g_assert_cmpint (g_array_index (offsets, gint, 0), ==, 11);
+  g_assert_cmpint (g_array_index (offsets, gint, 1), ==, 14);
+  g_array_unref (offsets);
+
+  n = gtk_text_buffer_find_all (buffer, "fo+",
+                                GTK_TEXT_SEARCH_REGEX | GTK_TEXT_SEARCH_CASE_INSENSITIVE,
+                                NULL, NULL, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 9);
+
+  n = gtk_text_buffer_find_all (buffer, "x*", GTK_TEXT_SEARCH_REGEX,
+                                NULL, NULL, NULL, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 0);
+
+  n = gtk_text_buffer_find_all (buffer, "(", GTK_TEXT_SEARCH_REGEX,
+                                NULL, NULL, NULL, NULL, &error);
+  g_assert_error (error, G_REGEX_ERROR, G_REGEX_ERROR_MISSING_PARENTHESIS);
+  g_assert_cmpint (n, ==, -1);
+  g_clear_error (&error);
+
+  g_assert_cmpint (gtk_text_buffer_find_all (buffer, "", 0, NULL, NULL,
+                                             NULL, NULL, NULL), ==, 0);
+
+  g_object_unref (buffer);
+}
+
+typedef struct
+{
+  GMainLoop *loop;
+  gint n_found;
+  gint n_matches;
+  gdouble fraction;
+} FindAllAsyncData;
+
+static void
+count_matches (GtkTextBuffer     *buffer,
+               const GtkTextIter *matches,
+               guint              n_matches,
+               gdouble            fraction,
+               gpointer           user_data)
+{
+  FindAllAsyncData *data = user_data;
+  guint i;
+
+  for (i = 0; i < n_matches; i++)
+    {
+      gchar *text;
+
+      text = gtk_text_iter_get_text (&matches[2 * i], &matches[2 * i + 1]);
+      g_assert_cmpstr (text, ==, "needle");
+      g_free (text);
+    }
+
+  g_assert_cmpfloat (fraction, >=, data->fraction);
+  data->fraction = fraction;
+  data->n_found += n_matches;
+}
+
+static void
+find_all_done (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  FindAllAsyncData *data = user_data;
+  GError *error = NULL;
+
+  data->n_matches = gtk_text_buffer_find_all_finish (GTK_TEXT_BUFFER (source), result, &error);
+  g_assert_no_error (error);
+
+  g_main_loop_quit (data->loop);
+}
+
+static void
+test_find_all_async (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  FindAllAsyncData data = { NULL, };
+  gint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  for (i = 0; i < 5000; i++)
+    gtk_text_buffer_insert (buffer, &iter, "hay hay needle hay\n", -1);
+
+  data.loop = g_main_loop_new (NULL, FALSE);
+  gtk_text_buffer_find_all_async (buffer, "needle", 0, NULL, NULL, NULL,
+                                  count_matches, &data, NULL,
+                                  find_all_done, &data);
+  g_main_loop_run (data.loop);
+
+  g_assert_cmpint (data.n_matches, ==, 5000);
+  g_assert_cmpint (data.n_found, ==, 5000);
+  g_assert_cmpfloat (data.fraction, ==, 1.0);
+
+  g_main_loop_unref (data.loop);
+  g_object_unref (buffer);
+}
+
+static void
+test_find_all_perf (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter, match_start, match_end;
+  gdouble elapsed_iter, elapsed_all;
+  gint i, n_iter, n_all;
+
+  if (!g_test_perf ())
+    return;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  for (i = 0; i < 100000; i++)
+    gtk_text_buffer_insert (buffer, &iter,
+                            "Lorem ipsum dolor sit amet, consectetur adipiscing elit, "
+                            "sed do eiusmod tempor incididunt ut labore et dolore\n", -1);
+
+  g_test_timer_start ();
+  n_iter = 0;
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  while (gtk_text_iter_forward_search (&iter, "dolor", GTK_TEXT_SEARCH_CASE_INSENSITIVE,
+                                       &match_start, &match_end, NULL))
+    {
+      n_iter++;
+      iter = match_end;
+    }
+  elapsed_iter = g_test_timer_elapsed ();
+
+  g_test_timer_start ();
+  n_all = gtk_text_buffer_find_all (buffer, "dolor", GTK_TEXT_SEARCH_CASE_INSENSITIVE,
+                                    NULL, NULL, NULL, NULL, NULL);
+  elapsed_all = g_test_timer_elapsed ();
+
+  g_assert_cmpint (n_all, ==, n_iter);
+
+  g_test_minimized_result (elapsed_all, "find all: %gs", elapsed_all);
+  g_test_message ("forward search: %gs", elapsed_iter);
+
+  g_object_unref (buffer);
+}
+
+typedef struct
+{
+  GMainLoop *loop;
+  gboolean loaded;
+  GError *error;
+  gint n_inserts;
+} LoadStreamData;
+
+static void
+load_stream_done (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  LoadStreamData *data = user_data;
+
+  data->loaded = gtk_text_buffer_load_stream_finish (GTK_TEXT_BUFFER (source),
+                                                     result, &data->error);
+  g_main_loop_quit (data->loop);
+}
+
+static void
+count_inserts (GtkTextBuffer *buffer,
+               GtkTextIter   *location,
+               gchar         *text,
+               gint           len,
+               gpointer       user_data)
+{
+  LoadStreamData *data = user_data;
+
+  data->n_inserts++;
+}
+
+static gboolean
+load_stream (GtkTextBuffer  *buffer,
+             const gchar    *text,
+             gsize           len,
+             GError        **error)
+{
+  LoadStreamData data = { NULL, };
+  GInputStream *stream;
+  gulong id;
+
+  stream = g_memory_input_stream_new_from_data (text, len, NULL);
+  id = g_signal_connect (buffer, "insert-text", G_CALLBACK (count_inserts), &data);
+
+  data.loop = g_main_loop_new (NULL, FALSE);
+  gtk_text_buffer_load_stream_async (buffer, stream, G_PRIORITY_DEFAULT, NULL,
+                                     load_stream_done, &data);
+  g_main_loop_run (data.loop);
+  g_main_loop_unref (data.loop);
+
+  g_signal_handler_disconnect (buffer, id);
+  g_object_unref (stream);
+
+  g_assert_cmpint (data.n_inserts, ==, data.loaded && len > 0 ? 1 : 0);
+  if (data.error)
+    g_propagate_error (error, data.error);
+
+  return data.loaded;
+}
+
+static void
+test_load_stream (void)
+{
+  /* Every kind of paragraph delimiter and multibyte characters, which
+   * end up split between the reads at the various offsets below
+   */
+  const gchar pattern[] = "x\r\n\xe2\x82\xac\xe2\x80\xa9\xc3\xa9\r\ra\n";
+  GtkTextBuffer *buffer, *expected;
+  GtkTextIter start, end;
+  GString *text;
+  gchar *loaded;
+  GError *error = NULL;
+  gint offset;
+
+  buffer = gtk_text_buffer_new (NULL);
+  expected = gtk_text_buffer_new (NULL);
+
+  for (offset = 0; offset < (gint) sizeof (pattern) - 1; offset++)
+    {
+      text = g_string_new (NULL);
+      while (text->len < (gsize) offset)
+        g_string_append_c (text, 'p');
+      while (text->len < 1024 * 1024 + 100)
+        g_string_append (text, pattern);
+
+      gtk_text_buffer_set_text (buffer, "previous contents\n", -1);
+      g_assert (load_stream (buffer, text->str, text->len, &error));
+      g_assert_no_error (error);
+
+      gtk_text_buffer_set_text (expected, text->str, text->len);
+
+      gtk_text_buffer_get_bounds (buffer, &start, &end);
+      loaded = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+      g_assert (strcmp (loaded, text->str) == 0);
+      g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==,
+                       gtk_text_buffer_get_line_count (expected));
+      g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==,
+                       gtk_text_buffer_get_char_count (expected));
+      g_free (loaded);
+
+      g_string_free (text, TRUE);
+    }
+
+  /* Short texts, with and without a trailing delimiter */
+  g_assert (load_stream (buffer, "abc\r", 4, NULL));
+  check_buffer_contents (buffer, "abc\r");
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 2);
+
+  g_assert (load_stream (buffer, "abc", 3, NULL));
+  check_buffer_contents (buffer, "abc");
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 1);
+
+  g_assert (load_stream (buffer, "", 0, NULL));
+  check_buffer_contents (buffer, "");
+
+  /* Invalid text leaves the buffer alone */
+  gtk_text_buffer_set_text (buffer, "previous contents", -1);
+  g_assert (!load_stream (buffer, "abc\xff", 4, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_clear_error (&error);
+
+  g_assert (!load_stream (buffer, "abc\xc3", 4, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+  g_clear_error (&error);
+  check_buffer_contents (buffer, "previous contents");
+
+  g_object_unref (expected);
+  g_object_unref (buffer);
+}
+
+static void
+count_tag_signals (GtkTextBuffer     *buffer,
+                   GtkTextTag        *tag,
+                   const GtkTextIter *start,
+                   const GtkTextIter *end,
+                   gpointer           user_data)
+{
+  gint *count = user_data;
+
+  (*count)++;
+}
+
+static void
+count_invalidations (GtkTextLayout *layout,
+                     gpointer       user_data)
+{
+  gint *count = user_data;
+
+  (*count)++;
+}
+
+static void
+check_tagged (GtkTextBuffer *buffer,
+              GtkTextTag    *tag,
+              const gchar   *expected)
+{
+  GtkTextIter iter;
+  gint i;
+
+  for (i = 0; expected[i]; i++)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, i);
+      g_assert_cmpint (gtk_text_iter_has_tag (&iter, tag), ==, expected[i] == 'x');
+    }
+}
+
+static void
+test_tag_ranges (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextLayout *layout;
+  GtkTextTag *tag;
+  GtkTextIter ranges[8];
+  GArray *matches;
+  gint n_signals = 0;
+  gint n_invalidations = 0;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "0123456789\nabcdefghij", -1);
+  tag = gtk_text_buffer_create_tag (buffer, NULL, "weight", PANGO_WEIGHT_BOLD, NULL);
+  g_signal_connect (buffer, "apply-tag", G_CALLBACK (count_tag_signals), &n_signals);
+  g_signal_connect (buffer, "remove-tag", G_CALLBACK (count_tag_signals), &n_signals);
+
+  /* A view of the buffer, to check that it is invalidated once per batch */
+  layout = gtk_text_layout_new ();
+  gtk_text_layout_set_buffer (layout, buffer);
+  g_signal_connect (layout, "invalidated", G_CALLBACK (count_invalidations), &n_invalidations);
+
+  /* Unsorted, reversed, overlapping, touching and empty ranges */
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[0], 14);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[1], 17);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[2], 4);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[3], 1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[4], 3);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[5], 6);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[6], 8);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[7], 8);
+
+  gtk_text_buffer_apply_tag_ranges (buffer, tag, ranges, 8);
+  g_assert_cmpint (n_signals, ==, 2);
+  g_assert_cmpint (n_invalidations, ==, 1);
+  check_tagged (buffer, tag, "-xxxxx-----" "---xxx----");
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[0], 2);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[1], 3);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[2], 15);
+  gtk_text_buffer_get_iter_at_offset (buffer, &ranges[3], 21);
+
+  n_signals = 0;
+  n_invalidations = 0;
+  gtk_text_buffer_remove_tag_ranges (buffer, tag, ranges, 4);
+  g_assert_cmpint (n_signals, ==, 2);
+  g_assert_cmpint (n_invalidations, ==, 1);
+  check_tagged (buffer, tag, "-x-xxx-----" "---x------");
+
+  /* Matches from gtk_text_buffer_find_all() can be passed as they are */
+  matches = g_array_new (FALSE, FALSE, sizeof (GtkTextIter));
+  gtk_text_buffer_find_all (buffer, "6", 0, NULL, NULL, collect_match_iters, matches, NULL);
+  gtk_text_buffer_apply_tag_ranges (buffer, tag,
+                                    (GtkTextIter *) matches->data, matches->len);
+  check_tagged (buffer, tag, "-x-xxxx----" "---x------");
+  g_array_unref (matches);
+
+  gtk_text_layout_set_buffer (layout, NULL);
+  g_object_unref (layout);
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1452,6 +1950,11 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
   g_test_add_func ("/TextBuffer/Clipboard", test_clipboard);
+  g_test_add_func ("/TextBuffer/Find all", test_find_all);
+  g_test_add_func ("/TextBuffer/Find all async", test_find_all_async);
+  g_test_add_func ("/TextBuffer/Find all perf", test_find_all_perf);
+  g_test_add_func ("/TextBuffer/Load stream", test_load_stream);
+  g_test_add_func ("/TextBuffer/Tag ranges", test_tag_ranges);
 
   return g_test_run();
 }
@@ -699,6 +699,78 @@ test_sentence_boundaries (void)
   check_backward_sentence_start (" Hi.", 0, 0, FALSE);
 }
 
+static void
+check_long_line_offsets (GtkTextBuffer *buffer,
+                         gint           line)
+{
+  GtkTextIter start, end, iter;
+  gchar *text;
+  const gchar *p;
+  gint n_chars, offset, step;
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, line);
+  end = start;
+  gtk_text_iter_forward_to_line_end (&end);
+  text = gtk_text_iter_get_text (&start, &end);
+  n_chars = g_utf8_strlen (text, -1);
+
+  for (step = 1; step < n_chars; step *= 7)
+    {
+      for (offset = 0, p = text;
+           offset < n_chars;
+           p = g_utf8_offset_to_pointer (p, MIN (step, n_chars - offset)), offset += step)
+        {
+          gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, line, offset);
+          g_assert_cmpint (gtk_text_iter_get_line_index (&iter), ==, p - text);
+
+          gtk_text_buffer_get_iter_at_line_index (buffer, &iter, line, p - text);
+          g_assert_cmpint (gtk_text_iter_get_line_offset (&iter), ==, offset);
+
+          iter = end;
+          gtk_text_iter_backward_chars (&iter, n_chars - offset);
+          g_assert_cmpint (gtk_text_iter_get_line_index (&iter), ==, p - text);
+        }
+    }
+
+  g_free (text);
+}
+
+static void
+test_long_line_offsets (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  GString *line;
+  gint i;
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  /* Lines with characters of every UTF-8 length */
+  line = g_string_new (NULL);
+  while (line->len < 20000)
+    g_string_append (line, "a\xc3\xa9\xe2\x82\xac{\xf0\x9d\x84\x9e\"");
+  g_string_append_c (line, '\n');
+
+  /* More lines than indexes are kept for */
+  for (i = 0; i < 10; i++)
+    gtk_text_buffer_insert_at_cursor (buffer, line->str, line->len);
+
+  for (i = 0; i < 10; i++)
+    check_long_line_offsets (buffer, i);
+
+  /* Edited lines get new segments */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 3, 5000);
+  gtk_text_buffer_insert (buffer, &iter, "\xe2\x82\xac", -1);
+  check_long_line_offsets (buffer, 3);
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &iter, 3, 100);
+  gtk_text_buffer_backspace (buffer, &iter, FALSE, TRUE);
+  check_long_line_offsets (buffer, 3);
+
+  g_string_free (line, TRUE);
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -714,6 +786,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Cursor Positions", test_cursor_positions);
   g_test_add_func ("/TextIter/Visible Cursor Positions", test_visible_cursor_positions);
   g_test_add_func ("/TextIter/Sentence Boundaries", test_sentence_boundaries);
+  g_test_add_func ("/TextIter/Long Line Offsets", test_long_line_offsets);
 
   return g_test_run();
 }
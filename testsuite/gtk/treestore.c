@@ -1066,6 +1066,200 @@ specific_bug_698396 (void)
   g_object_unref (tree_store);
 }
 
+/* lazy loading */
+
+static void
+load_children (GtkTreeStore *tree_store,
+               GtkTreeIter  *iter,
+               gpointer      data)
+{
+  gint *n_loads = data;
+  GtkTreeIter child;
+  gint i;
+
+  (*n_loads)++;
+
+  for (i = 0; i < 3; i++)
+    gtk_tree_store_insert_with_values (tree_store, &child, iter, -1, 0, i, -1);
+
+  gtk_tree_store_set_lazy (tree_store, &child, TRUE);
+}
+
+static void
+count_signal (GtkTreeModel *model,
+              GtkTreePath  *path,
+              GtkTreeIter  *iter,
+              gpointer      data)
+{
+  gint *count = data;
+
+  (*count)++;
+}
+
+static void
+tree_store_test_lazy_load (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *model;
+  GtkTreeIter iter, child, grandchild;
+  gint n_loads = 0, n_inserted = 0;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  model = GTK_TREE_MODEL (store);
+  gtk_tree_store_set_load_func (store, load_children, &n_loads, NULL);
+
+  gtk_tree_store_insert_with_values (store, &iter, NULL, -1, 0, 42, -1);
+  gtk_tree_store_set_lazy (store, &iter, TRUE);
+
+  g_signal_connect (model, "row-inserted",
+                    G_CALLBACK (count_signal), &n_inserted);
+
+  /* Lazy rows claim to have children without loading them */
+  g_assert (gtk_tree_model_iter_has_child (model, &iter));
+  g_assert_cmpint (n_loads, ==, 0);
+
+  /* Asking for the children loads them, silently */
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, &iter), ==, 3);
+  g_assert_cmpint (n_loads, ==, 1);
+  g_assert_cmpint (n_inserted, ==, 0);
+
+  g_assert (gtk_tree_model_iter_nth_child (model, &child, &iter, 2));
+  g_assert (gtk_tree_model_iter_has_child (model, &child));
+  g_assert_cmpint (n_loads, ==, 1);
+
+  /* Loading happens only once per row */
+  g_assert (gtk_tree_model_iter_children (model, &child, &iter));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, &iter), ==, 3);
+  g_assert_cmpint (n_loads, ==, 1);
+
+  g_assert (gtk_tree_model_iter_nth_child (model, &child, &iter, 2));
+  g_assert (gtk_tree_model_iter_children (model, &grandchild, &child));
+  g_assert_cmpint (n_loads, ==, 2);
+  g_assert_cmpint (n_inserted, ==, 0);
+
+  /* Rows added outside of the load function are announced */
+  gtk_tree_store_append (store, &grandchild, &iter);
+  g_assert_cmpint (n_inserted, ==, 1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, &iter), ==, 4);
+
+  g_object_unref (store);
+}
+
+static void
+load_no_children (GtkTreeStore *tree_store,
+                  GtkTreeIter  *iter,
+                  gpointer      data)
+{
+  gint *n_loads = data;
+
+  (*n_loads)++;
+}
+
+static void
+tree_store_test_lazy_load_empty (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *model;
+  GtkWidget *view;
+  GtkTreeIter iter, child;
+  GtkTreePath *path;
+  gint n_loads = 0, n_toggled = 0;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  model = GTK_TREE_MODEL (store);
+  gtk_tree_store_set_load_func (store, load_no_children, &n_loads, NULL);
+
+  gtk_tree_store_insert_with_values (store, &iter, NULL, -1, 0, 42, -1);
+  gtk_tree_store_set_lazy (store, &iter, TRUE);
+
+  g_signal_connect (model, "row-has-child-toggled",
+                    G_CALLBACK (count_signal), &n_toggled);
+
+  /* A load that adds no rows takes back the claim to have children */
+  g_assert (gtk_tree_model_iter_has_child (model, &iter));
+  g_assert (!gtk_tree_model_iter_children (model, &child, &iter));
+  g_assert_cmpint (n_loads, ==, 1);
+  g_assert_cmpint (n_toggled, ==, 1);
+  g_assert (!gtk_tree_model_iter_has_child (model, &iter));
+
+  /* Views don't expand the row then */
+  gtk_tree_store_insert_with_values (store, &iter, NULL, -1, 0, 43, -1);
+  gtk_tree_store_set_lazy (store, &iter, TRUE);
+  n_toggled = 0;
+
+  view = gtk_tree_view_new_with_model (model);
+  g_object_ref_sink (view);
+  path = gtk_tree_model_get_path (model, &iter);
+  g_assert (!gtk_tree_view_expand_row (GTK_TREE_VIEW (view), path, FALSE));
+  g_assert (!gtk_tree_view_row_expanded (GTK_TREE_VIEW (view), path));
+  g_assert_cmpint (n_loads, ==, 2);
+  g_assert_cmpint (n_toggled, ==, 1);
+  gtk_tree_path_free (path);
+
+  g_object_unref (view);
+  g_object_unref (store);
+}
+
+static void
+check_nth_children (GtkTreeModel *model,
+                    GtkTreeIter  *parent)
+{
+  GtkTreeIter iter, child;
+  gint n;
+
+  n = 0;
+  if (gtk_tree_model_iter_children (model, &iter, parent))
+    do
+      {
+        g_assert (gtk_tree_model_iter_nth_child (model, &child, parent, n));
+        g_assert (iters_equal (&iter, &child));
+        n++;
+      }
+    while (gtk_tree_model_iter_next (model, &iter));
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, parent), ==, n);
+  g_assert (!gtk_tree_model_iter_nth_child (model, &child, parent, n));
+}
+
+static void
+tree_store_test_nth_child_many (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *model;
+  GtkTreeIter parent, iter, other;
+  gint i;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  model = GTK_TREE_MODEL (store);
+
+  gtk_tree_store_append (store, &parent, NULL);
+  for (i = 0; i < 100; i++)
+    gtk_tree_store_insert_with_values (store, NULL, &parent, -1, 0, i, -1);
+  check_nth_children (model, &parent);
+
+  gtk_tree_store_insert_with_values (store, NULL, &parent, 10, 0, -1, -1);
+  check_nth_children (model, &parent);
+
+  gtk_tree_model_iter_nth_child (model, &iter, &parent, 50);
+  gtk_tree_store_remove (store, &iter);
+  check_nth_children (model, &parent);
+
+  gtk_tree_model_iter_nth_child (model, &iter, &parent, 3);
+  gtk_tree_model_iter_nth_child (model, &other, &parent, 90);
+  gtk_tree_store_swap (store, &iter, &other);
+  check_nth_children (model, &parent);
+
+  gtk_tree_model_iter_nth_child (model, &iter, &parent, 99);
+  gtk_tree_store_move_after (store, &iter, NULL);
+  check_nth_children (model, &parent);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0,
+                                        GTK_SORT_DESCENDING);
+  check_nth_children (model, &parent);
+
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -1190,6 +1384,14 @@ register_tree_store_tests (void)
               tree_store_setup, tree_store_test_iter_parent_invalid,
               tree_store_teardown);
 
+  /* lazy loading */
+  g_test_add_func ("/TreeStore/lazy-load",
+                   tree_store_test_lazy_load);
+  g_test_add_func ("/TreeStore/lazy-load-empty",
+                   tree_store_test_lazy_load_empty);
+  g_test_add_func ("/TreeStore/nth-child-many",
+                   tree_store_test_nth_child_many);
+
   /* specific bugs */
   g_test_add_func ("/TreeStore/bug-77977", specific_bug_77977);
   g_test_add_func ("/TreeStore/bug-698396", specific_bug_698396);
@@ -289,6 +289,175 @@ test_selection_count (void)
   gtk_widget_destroy (view);
 }
 
+static void
+test_cell_size_cache (void)
+{
+  GtkCellRenderer *renderer;
+  GtkWidget *view;
+  gint short_width, long_width, width;
+  gint height, wrapped_height;
+
+  view = gtk_tree_view_new ();
+  g_object_ref_sink (view);
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_ref_sink (renderer);
+
+  g_object_set (renderer, "text", "Row", NULL);
+  gtk_cell_renderer_get_preferred_width (renderer, view, NULL, &short_width);
+
+  g_object_set (renderer, "text", "A much longer row content", NULL);
+  gtk_cell_renderer_get_preferred_width (renderer, view, NULL, &long_width);
+  g_assert_cmpint (long_width, >, short_width);
+
+  /* Measuring the same content again must give the same result,
+   * while a different font must not be served from the cache.
+   */
+  g_object_set (renderer, "text", "Row", NULL);
+  gtk_cell_renderer_get_preferred_width (renderer, view, NULL, &width);
+  g_assert_cmpint (width, ==, short_width);
+
+  g_object_set (renderer, "scale", 3.0, NULL);
+  gtk_cell_renderer_get_preferred_width (renderer, view, NULL, &width);
+  g_assert_cmpint (width, >, short_width);
+
+  g_object_set (renderer,
+                "scale-set", FALSE,
+                "text", "A much longer row content",
+                "wrap-width", 10,
+                "wrap-mode", PANGO_WRAP_WORD,
+                NULL);
+  gtk_cell_renderer_get_preferred_height_for_width (renderer, view, long_width, NULL, &height);
+  gtk_cell_renderer_get_preferred_height_for_width (renderer, view, short_width, NULL, &wrapped_height);
+  g_assert_cmpint (wrapped_height, >, height);
+
+  gtk_cell_renderer_get_preferred_height_for_width (renderer, view, long_width, NULL, &width);
+  g_assert_cmpint (width, ==, height);
+
+  g_object_unref (renderer);
+  g_object_unref (view);
+}
+
+static void
+test_selection_select_all (void)
+{
+  GtkListStore *list_store;
+  GtkTreeSelection *selection;
+  GtkTreePath *path;
+  GList *rows;
+  GtkWidget *view;
+  gint i;
+
+  list_store = gtk_list_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 1000; i++)
+    gtk_list_store_insert_with_values (list_store, NULL, i, 0, i, -1);
+
+  view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (list_store));
+  g_object_ref_sink (view);
+
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (view));
+  gtk_tree_selection_set_mode (selection, GTK_SELECTION_MULTIPLE);
+
+  gtk_tree_selection_select_all (selection);
+  g_assert_cmpint (gtk_tree_selection_count_selected_rows (selection), ==, 1000);
+
+  path = gtk_tree_path_new_from_indices (500, -1);
+  gtk_tree_selection_unselect_path (selection, path);
+  g_assert (!gtk_tree_selection_path_is_selected (selection, path));
+  gtk_tree_path_free (path);
+
+  rows = gtk_tree_selection_get_selected_rows (selection, NULL);
+  g_assert_cmpint (g_list_length (rows), ==, 999);
+  g_assert_cmpint (gtk_tree_path_get_indices (g_list_nth_data (rows, 499))[0], ==, 499);
+  g_assert_cmpint (gtk_tree_path_get_indices (g_list_nth_data (rows, 500))[0], ==, 501);
+  g_list_free_full (rows, (GDestroyNotify) gtk_tree_path_free);
+
+  gtk_tree_selection_unselect_all (selection);
+  g_assert_cmpint (gtk_tree_selection_count_selected_rows (selection), ==, 0);
+
+  path = gtk_tree_path_new_from_indices (10, -1);
+  gtk_tree_selection_select_path (selection, path);
+  gtk_tree_path_free (path);
+
+  rows = gtk_tree_selection_get_selected_rows (selection, NULL);
+  g_assert_cmpint (g_list_length (rows), ==, 1);
+  g_assert_cmpint (gtk_tree_path_get_indices (rows->data)[0], ==, 10);
+  g_list_free_full (rows, (GDestroyNotify) gtk_tree_path_free);
+
+  g_object_unref (view);
+  g_object_unref (list_store);
+}
+
+static gint
+get_cursor_row (GtkTreeView *view)
+{
+  GtkTreePath *path;
+  gint row;
+
+  gtk_tree_view_get_cursor (view, &path, NULL);
+  if (path == NULL)
+    return -1;
+
+  row = gtk_tree_path_get_indices (path)[0];
+  gtk_tree_path_free (path);
+
+  return row;
+}
+
+static void
+test_search_index (void)
+{
+  GtkListStore *store;
+  GtkWidget *view;
+  GtkWidget *entry;
+  GtkTreeIter iter;
+  gchar *text;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 1000; i++)
+    {
+      text = g_strdup_printf ("Item %04d", 999 - i);
+      gtk_list_store_insert_with_values (store, NULL, i, 0, text, -1);
+      g_free (text);
+    }
+
+  view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_ref_sink (view);
+  gtk_tree_view_set_search_column (GTK_TREE_VIEW (view), 0);
+
+  entry = gtk_entry_new ();
+  g_object_ref_sink (entry);
+  gtk_tree_view_set_search_entry (GTK_TREE_VIEW (view), GTK_ENTRY (entry));
+
+  gtk_entry_set_text (GTK_ENTRY (entry), "ITEM 0042");
+  g_assert_cmpint (get_cursor_row (GTK_TREE_VIEW (view)), ==, 999 - 42);
+
+  /* The first match in model order wins */
+  gtk_entry_set_text (GTK_ENTRY (entry), "item 00");
+  g_assert_cmpint (get_cursor_row (GTK_TREE_VIEW (view)), ==, 900);
+
+  /* Changes to the model are picked up */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, "Item 0042 again", -1);
+  gtk_entry_set_text (GTK_ENTRY (entry), "item 0042");
+  g_assert_cmpint (get_cursor_row (GTK_TREE_VIEW (view)), ==, 0);
+
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_list_store_set (store, &iter, 0, "Something else", -1);
+  gtk_entry_set_text (GTK_ENTRY (entry), "item 0042");
+  g_assert_cmpint (get_cursor_row (GTK_TREE_VIEW (view)), ==, 1000 - 42);
+
+  gtk_list_store_remove (store, &iter);
+  gtk_entry_set_text (GTK_ENTRY (entry), "SOMETHING");
+  g_assert_cmpint (get_cursor_row (GTK_TREE_VIEW (view)), ==, 999 - 42);
+  gtk_entry_set_text (GTK_ENTRY (entry), "item 0042");
+  g_assert_cmpint (get_cursor_row (GTK_TREE_VIEW (view)), ==, 999 - 42);
+
+  g_object_unref (entry);
+  g_object_unref (view);
+  g_object_unref (store);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -302,7 +471,11 @@ main (int    argc,
                    test_select_collapsed_row);
   g_test_add_func ("/TreeView/sizing/row-separator-height",
                    test_row_separator_height);
+  g_test_add_func ("/TreeView/sizing/cell-size-cache",
+                   test_cell_size_cache);
   g_test_add_func ("/TreeView/selection/count", test_selection_count);
+  g_test_add_func ("/TreeView/selection/select-all", test_selection_select_all);
+  g_test_add_func ("/TreeView/search/index", test_search_index);
 
   return g_test_run ();
 }